@@ -169,7 +169,9 @@
 # include "bios.h"
 # include "info.h"
 # include "k_prot.h"
+# include "kmem_cache.h"
 # include "kmemory.h"
+# include "ktrace.h"
 # include "pun.h"
 # include "proc.h"
 # include "random.h"
@@ -384,6 +386,9 @@ static UNIT *	bio_unit_get		(DI *di, ulong sector, ulong size, long *err);
 /****************************************************************************/
 /* BEGIN rwabs wrapper */
 
+# define BIO_KTRACE(di, rw, n, recno) \
+	KTRACE (((rw) & 1) ? KT_BIOWRITE : KT_BIOREAD, ((long) (di)->drv << 16) | (n), (recno))
+
 static long _cdecl
 rwabs_log (DI *di, ushort rw, void *buf, ulong size, ulong rec)
 {
@@ -413,6 +418,8 @@ rwabs_log (DI *di, ushort rw, void *buf, ulong size, ulong rec)
 		return ESECTOR;
 	}
 
+	BIO_KTRACE (di, rw, n, recno);
+
 	return sys_b_rwabs (rw, buf, n, recno, di->drv, 0L);
 }
 
@@ -445,6 +452,8 @@ rwabs_log_lrec (DI *di, ushort rw, void *buf, ulong size, ulong rec)
 		return ESECTOR;
 	}
 
+	BIO_KTRACE (di, rw, n, recno);
+
 	return sys_b_rwabs (rw, buf, n, -1, di->drv, recno);
 }
 
@@ -478,6 +487,8 @@ rwabs_xhdi (DI *di, ushort rw, void *buf, ulong size, ulong rec)
 		return ESECTOR;
 	}
 
+	BIO_KTRACE (di, rw, n, recno);
+
 	recno += di->start;
 
 	while (n > 65535UL)
@@ -1067,6 +1078,9 @@ static struct
 
 } cache;
 
+/* UNIT descriptors */
+static KMEM_CACHE (unit_cache, "UNIT", sizeof (UNIT), NULL);
+
 static void
 bio_unit_remove_cache (register UNIT *u)
 {
@@ -1110,7 +1124,7 @@ bio_unit_remove_cache (register UNIT *u)
 	}
 
 	/* free the memory */
-	kfree (u);
+	kmem_cache_free (&unit_cache, u);
 }
 
 /*
@@ -1211,7 +1225,7 @@ retry:
 
 	BIO_DEBUG (("bio_unit_get: use CBL %li", found));
 
-	new = kmalloc (sizeof (*new));
+	new = kmem_cache_alloc (&unit_cache);
 	if (new)
 	{
 		CBL * const b = cache.blocks + found;
@@ -1300,8 +1314,8 @@ retry:
 	}
 	else
 	{
-		BIO_DEBUG (("bio_unit_get: leave can't get free UNIT (kmalloc (%lu) fail)", sizeof (*new)));
-		BIO_ALERT (("block_IO [%c]: bio_unit_get: kmalloc (%lu) fail, out of memory?", DriveToLetter(di->drv), sizeof (*new)));
+		BIO_DEBUG (("bio_unit_get: leave can't get free UNIT (kmem_cache_alloc (%lu) fail)", sizeof (*new)));
+		BIO_ALERT (("block_IO [%c]: bio_unit_get: kmem_cache_alloc (%lu) fail, out of memory?", DriveToLetter(di->drv), sizeof (*new)));
 
 		*err = ENOMEM;
 	}
@@ -2473,7 +2487,7 @@ bio_get_resident (DI *di, ulong sector, ulong blocksize)
 
 	BIO_DEBUG (("bio_get_resident: entry (sector = %lu, drv = %u, size = %lu)", sector, di->drv, blocksize));
 
-	u = kmalloc (sizeof (*u));
+	u = kmem_cache_alloc (&unit_cache);
 	if (u)
 	{
 		u->data = kmalloc (blocksize);
@@ -2521,7 +2535,7 @@ bio_get_resident (DI *di, ulong sector, ulong blocksize)
 					BIO_DEBUG (("bio_read: rwabs fail (ret = %li)", r));
 
 					kfree (u->data);
-					kfree (u);
+					kmem_cache_free (&unit_cache, u);
 
 					u = NULL;
 				}
@@ -2529,7 +2543,7 @@ bio_get_resident (DI *di, ulong sector, ulong blocksize)
 		}
 		else
 		{
-			kfree (u);
+			kmem_cache_free (&unit_cache, u);
 
 			u = NULL;
 		}
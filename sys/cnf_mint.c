@@ -37,6 +37,7 @@
 #include "dosdir.h"
 #include "dosfile.h"
 #include "dosmem.h"
+#include "exec_cache.h"
 #include "fatfs.h"
 #include "filesys.h"
 #include "info.h"						/* messages */
@@ -136,6 +137,7 @@ char init_tail[128];
  * KERN_BIOSBUF=[yn] ............ turn on/off bios buffer feature
  * KERN_DEBUG_DEVNO=n ........... set debug device number to (decimal number) n
  * KERN_DEBUG_LEVEL=n ........... set debug level to (decimal number) n
+ * KERN_EXEC_CACHE=n ............ set size of the exec image cache in kb
  * KERN_MPFLAGS=bitvector ....... set flags for mem protection, bit 0: strict mode on/off
  * KERN_SECURITY_LEVEL=n ........ enables the appropriate security level, range 0-2
  * KERN_SLICES=n ................ set multitasking granularity
@@ -324,6 +326,15 @@ static void pCB_exec(const char *path, const char *line, struct parsinf *inf)
 
 /*----------------------------------------------------------------------------*/
 
+/* KERN_EXEC_CACHE=n */
+static void pCB_exec_cache(long size)
+{
+	if (size >= 0)
+		exec_cache_max = size * 1024l;
+}
+
+/*----------------------------------------------------------------------------*/
+
 /* GEM=file | INIT=file */
 static void pCB_gem_init(const char *path, const char *line, long val)
 {
@@ -649,6 +660,7 @@ static struct parser_item parser_tab[] = {
 	{ "KERN_BIOSBUF", PI_V_B, pCB_biosbuf, { { 0, 0 } } },
 	{ "KERN_DEBUG_DEVNO", PI_R_S, &out_device, Range(0, 9) },
 	{ "KERN_DEBUG_LEVEL", PI_R_S, &debug_level, Range(0, 9) },
+	{ "KERN_EXEC_CACHE", PI_V_L, pCB_exec_cache, { { 0, 0 } } },
 #ifdef WITH_MMU_SUPPORT
 	{ "KERN_MPFLAGS", PI_R_L, &mem_prot_flags, { { 0, 0 } } },
 #endif
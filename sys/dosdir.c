@@ -1367,6 +1367,40 @@ sys_d_xreaddir (int len, long handle, char *buf, XATTR *xattr, long *xret)
 	return r;
 }
 
+/* read as many directory entries together with their attributes
+ * as fit into buf; each is a struct dirplus, the stat is done
+ * without following links and its result is in sret. Returns the
+ * number of records, 0 at the end of the directory.
+ */
+long _cdecl
+sys_d_readdirplus (long len, long handle, char *buf)
+{
+	struct proc *p = get_curproc();
+	DIR *dirh = (DIR *) handle;
+	DIR **where;
+
+	where = &p->p_fd->searches;
+	while (*where && *where != dirh)
+		where = &((*where)->next);
+
+	if (!*where)
+	{
+		DEBUG(("Dreaddirplus: not an open directory"));
+		return EBADF;
+	}
+
+	if (!dirh->fc.fs)
+		return EBADF;
+
+	if (len < DIRPLUS_RECMAX || ((long) buf & 1))
+	{
+		DEBUG(("Dreaddirplus: buffer too small or unaligned"));
+		return EBADARG;
+	}
+
+	return xfs_readdirplus (dirh->fc.fs, dirh, buf, len);
+}
+
 
 long _cdecl
 sys_d_rewind (long handle)
@@ -35,6 +35,7 @@ long _cdecl sys_d_pathconf	(const char *name, int which);
 long _cdecl sys_d_opendir	(const char *path, int flags);
 long _cdecl sys_d_readdir	(int len, long handle, char *buf);
 long _cdecl sys_d_xreaddir	(int len, long handle, char *buf, XATTR *xattr, long *xret);
+long _cdecl sys_d_readdirplus	(long len, long handle, char *buf);
 long _cdecl sys_d_rewind	(long handle);
 long _cdecl sys_d_closedir	(long handle);
 long _cdecl sys_f_xattr		(int flag, const char *name, XATTR *xattr);
@@ -0,0 +1,399 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Exec image cache.
+ *
+ * Keeps the unrelocated TEXT and DATA image of recently executed
+ * programs together with the already decoded fixup table in kernel
+ * memory. The cache is keyed on (dev, inode, mtime/mdate, size) like the
+ * AF_UNIX lookup cache in ipc_unix_cache.c; the program header must
+ * match too. The time only has a resolution of 2 seconds, so closing
+ * a file that was open for writing also drops its image
+ * (exec_cache_written). On a hit load_region() does one bulk copy and a simple
+ * loop over the fixup offsets instead of reading the file and decoding
+ * the GEMDOS relocation table byte by byte.
+ *
+ * load_region() places DATA and BSS directly behind TEXT, so every
+ * fixup of such an image is relocated by the same value (p_tbase).
+ * That's all we need to store per fixup: its offset.
+ *
+ * Entries are kept in LRU order; the cache size is limited by
+ * exec_cache_max (KERN_EXEC_CACHE in mint.cnf, kern.execcache sysctl).
+ */
+
+# include "exec_cache.h"
+
+# include "libkern/libkern.h"
+
+# include "arch/cpu.h"		/* cpushi */
+
+# include "xfs_xdd.h"	/* xfs_getxattr */
+# include "kmemory.h"
+
+
+struct exec_image
+{
+	struct exec_image *next;	/* LRU chain, most recently used first */
+	long	links;			/* load_region() calls copying from us */
+
+	short	dev;
+	long	inode;
+	long	stamp;
+# define MK_STAMP(time, date)	((((long)(date)) << 16) | (time))
+	long	size;			/* file size */
+	FILEHEAD fh;
+
+	long	nbytes;			/* TEXT + DATA */
+	long	nfixups;
+	long	*fixups;		/* offsets into image */
+	char	*image;			/* unrelocated TEXT + DATA */
+};
+
+# ifdef M68000
+# define EXEC_CACHE_DEFAULT	0L
+# else
+# define EXEC_CACHE_DEFAULT	(512L * 1024L)
+# endif
+
+/* initial number of fixups recorded before the table is grown */
+# define FIXUPS_CHUNK	256
+
+long exec_cache_max = EXEC_CACHE_DEFAULT;
+
+static struct exec_image *cache;
+static long cache_used;
+static long cache_hits;
+static long cache_misses;
+
+
+/* a single image may use at most half the cache; otherwise one big
+ * program would throw out everything else
+ */
+INLINE long
+cache_limit (void)
+{
+	return exec_cache_max >> 1;
+}
+
+static bool
+cacheable (const XATTR *xattr, const FILEHEAD *fh)
+{
+	if (exec_cache_max <= 0 || !xattr)
+		return false;
+
+	/* filesystems without real inode numbers can't be trusted */
+	if (xattr->index == 0 || !S_ISREG (xattr->mode))
+		return false;
+
+	if (fh->ftext + fh->fdata > cache_limit ())
+		return false;
+
+	return true;
+}
+
+static bool
+same_header (const FILEHEAD *a, const FILEHEAD *b)
+{
+	return (a->ftext == b->ftext
+		&& a->fdata == b->fdata
+		&& a->fbss == b->fbss
+		&& a->fsym == b->fsym
+		&& a->flag == b->flag
+		&& a->reloc == b->reloc);
+}
+
+static void
+cache_remove (struct exec_image *e)
+{
+	struct exec_image **prev = &cache;
+
+	while (*prev && *prev != e)
+		prev = &((*prev)->next);
+
+	assert (*prev == e);
+	*prev = e->next;
+
+	cache_used -= sizeof (*e) + e->nbytes + e->nfixups * sizeof (long);
+	kfree (e);
+}
+
+/*
+ * Look up the image of the file described by xattr. On a hit the entry
+ * is moved to the head of the LRU chain and locked; the caller must call
+ * exec_cache_release() when done with it. Stale entries are thrown away.
+ */
+struct exec_image *
+exec_cache_lookup (const XATTR *xattr, const FILEHEAD *fh)
+{
+	struct exec_image *e, **prev;
+	long stamp;
+
+	if (!cacheable (xattr, fh))
+		return NULL;
+
+	stamp = MK_STAMP (xattr->mtime, xattr->mdate);
+
+	for (prev = &cache; (e = *prev) != NULL; prev = &e->next)
+	{
+		if (e->inode != xattr->index || e->dev != xattr->dev)
+			continue;
+
+		if (e->stamp != stamp || e->size != xattr->size || !same_header (&e->fh, fh))
+		{
+			DEBUG (("exec_cache_lookup: stale image for %i:%li", e->dev, e->inode));
+
+			if (!e->links)
+				cache_remove (e);
+
+			break;
+		}
+
+		/* move to front */
+		*prev = e->next;
+		e->next = cache;
+		cache = e;
+
+		e->links++;
+		cache_hits++;
+
+		TRACE (("exec_cache_lookup: hit %i:%li (%ld/%ld)", e->dev, e->inode, cache_hits, cache_misses));
+		return e;
+	}
+
+	cache_misses++;
+	return NULL;
+}
+
+void
+exec_cache_release (struct exec_image *e)
+{
+	assert (e->links > 0);
+	e->links--;
+
+	/* the file was written meanwhile */
+	if (!e->links && !e->inode)
+		cache_remove (e);
+}
+
+/*
+ * A file that was open for writing is closed; forget its image.
+ * Images in use are marked stale (inode 0 never matches) and go
+ * away in exec_cache_release().
+ */
+void
+exec_cache_written (fcookie *fc)
+{
+	struct exec_image *e, *next;
+	XATTR xattr;
+
+	if (!cache || xfs_getxattr (fc->fs, fc, &xattr))
+		return;
+
+	for (e = cache; e; e = next)
+	{
+		next = e->next;
+
+		if (e->inode != xattr.index || e->dev != xattr.dev)
+			continue;
+
+		DEBUG (("exec_cache_written: dropping image of %i:%li", e->dev, e->inode));
+
+		if (e->links)
+			e->inode = 0;
+		else
+			cache_remove (e);
+	}
+}
+
+/*
+ * Copy the cached image to "where" (== base->p_tbase) and relocate it.
+ */
+void
+exec_cache_load (struct exec_image *e, char *where, BASEPAGE *base)
+{
+	const long *fix = e->fixups;
+	long delta = base->p_tbase;
+	long n = e->nfixups;
+
+	TRACE (("exec_cache_load: %ld bytes, %ld fixups to %p", e->nbytes, n, where));
+
+	quickmove (where, e->image, e->nbytes);
+
+	/* unrolled; fixup tables of a few thousand entries are common */
+	while (n >= 4)
+	{
+		*(long *)(where + fix[0]) += delta;
+		*(long *)(where + fix[1]) += delta;
+		*(long *)(where + fix[2]) += delta;
+		*(long *)(where + fix[3]) += delta;
+
+		fix += 4;
+		n -= 4;
+	}
+	while (n--)
+		*(long *)(where + *fix++) += delta;
+
+	cpushi ((void *)base->p_tbase, base->p_tlen);
+}
+
+
+/*
+ * Fixup recording; load_and_reloc() calls exec_fixups_add() for every
+ * fixup it applies. If anything goes wrong the recording is silently
+ * dropped and the image simply isn't cached.
+ */
+void
+exec_fixups_init (struct exec_fixups *fx, const XATTR *xattr, const FILEHEAD *fh)
+{
+	fx->tab = NULL;
+	fx->num = 0;
+	fx->max = 0;
+
+	if (!cacheable (xattr, fh))
+		return;
+
+	fx->tab = kmalloc (FIXUPS_CHUNK * sizeof (long));
+	if (fx->tab)
+		fx->max = FIXUPS_CHUNK;
+}
+
+void
+exec_fixups_add (struct exec_fixups *fx, long fixup)
+{
+	if (!fx->tab)
+		return;
+
+	if (fx->num == fx->max)
+	{
+		long *tab = NULL;
+
+		if ((fx->max << 3) <= cache_limit ())
+			tab = kmalloc (fx->max * 2 * sizeof (long));
+
+		if (!tab)
+		{
+			exec_fixups_free (fx);
+			return;
+		}
+
+		quickmove (tab, fx->tab, fx->num * sizeof (long));
+		kfree (fx->tab);
+
+		fx->tab = tab;
+		fx->max <<= 1;
+	}
+
+	fx->tab[fx->num++] = fixup;
+}
+
+void
+exec_fixups_free (struct exec_fixups *fx)
+{
+	if (fx->tab)
+		kfree (fx->tab);
+
+	fx->tab = NULL;
+	fx->num = 0;
+	fx->max = 0;
+}
+
+/*
+ * Called by load_region() right after the image at "where" has been
+ * loaded and relocated for the first time, before the program runs.
+ * The relocation is undone on the cached copy.
+ */
+void
+exec_cache_enter (const XATTR *xattr, const FILEHEAD *fh,
+		  const char *where, const BASEPAGE *base,
+		  struct exec_fixups *fx)
+{
+	struct exec_image *e;
+	long nbytes, total, delta, i;
+
+	if (!fx->tab)
+		return;
+
+	nbytes = fh->ftext + fh->fdata;
+	total = sizeof (*e) + nbytes + fx->num * sizeof (long);
+	if (total > cache_limit ())
+		return;
+
+	/* someone else may have entered it while we were loading */
+	for (e = cache; e; e = e->next)
+	{
+		if (e->inode == xattr->index && e->dev == xattr->dev)
+			return;
+	}
+
+	exec_cache_trim (exec_cache_max - total);
+
+	e = kmalloc (total);
+	if (!e)
+		return;
+
+	e->links = 0;
+	e->dev = xattr->dev;
+	e->inode = xattr->index;
+	e->stamp = MK_STAMP (xattr->mtime, xattr->mdate);
+	e->size = xattr->size;
+	e->fh = *fh;
+	e->nbytes = nbytes;
+	e->nfixups = fx->num;
+	e->fixups = (long *)(e + 1);
+	e->image = (char *)(e->fixups + fx->num);
+
+	quickmove (e->fixups, fx->tab, fx->num * sizeof (long));
+	quickmove (e->image, where, nbytes);
+
+	delta = base->p_tbase;
+	for (i = 0; i < e->nfixups; i++)
+		*(long *)(e->image + e->fixups[i]) -= delta;
+
+	e->next = cache;
+	cache = e;
+	cache_used += total;
+
+	DEBUG (("exec_cache_enter: %i:%li, %ld bytes, %ld fixups, cache %ld/%ld",
+		e->dev, e->inode, nbytes, e->nfixups, cache_used, exec_cache_max));
+}
+
+/*
+ * Throw away least recently used images until at most "max" bytes
+ * are in use. exec_cache_trim(0) flushes the cache.
+ */
+void
+exec_cache_trim (long max)
+{
+	while (cache_used > max)
+	{
+		struct exec_image *e, *victim = NULL;
+
+		for (e = cache; e; e = e->next)
+		{
+			if (!e->links)
+				victim = e;
+		}
+
+		if (!victim)
+			break;
+
+		cache_remove (victim);
+	}
+}
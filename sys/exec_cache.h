@@ -0,0 +1,59 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+# ifndef _exec_cache_h
+# define _exec_cache_h
+
+# include "mint/mint.h"
+# include "mint/basepage.h"
+# include "mint/mem.h"
+# include "mint/stat.h"
+
+
+struct exec_image;
+
+/* decoded fixup offsets, collected while an image is relocated
+ * the first time
+ */
+struct exec_fixups
+{
+	long	*tab;		/* fixup offsets, relative to the text start */
+	long	num;		/* used entries */
+	long	max;		/* allocated entries; 0 means don't record */
+};
+
+extern long exec_cache_max;
+
+struct exec_image *exec_cache_lookup (const XATTR *xattr, const FILEHEAD *fh);
+void	exec_cache_release (struct exec_image *e);
+void	exec_cache_written (fcookie *fc);
+void	exec_cache_load (struct exec_image *e, char *where, BASEPAGE *base);
+
+void	exec_fixups_init (struct exec_fixups *fx, const XATTR *xattr, const FILEHEAD *fh);
+void	exec_fixups_add (struct exec_fixups *fx, long fixup);
+void	exec_fixups_free (struct exec_fixups *fx);
+
+void	exec_cache_enter (const XATTR *xattr, const FILEHEAD *fh,
+			  const char *where, const BASEPAGE *base,
+			  struct exec_fixups *fx);
+void	exec_cache_trim (long max);
+
+# endif /* _exec_cache_h */
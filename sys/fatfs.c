@@ -372,6 +372,7 @@
 # include "proc.h"
 # include "time.h"
 # include "unicode.h"
+# include "xfs_xdd.h"
 
 
 /*
@@ -557,6 +558,7 @@ static long	_cdecl fatfs_rename	(fcookie *olddir, char *oldname, fcookie *newdir
 
 static long	_cdecl fatfs_opendir	(DIR *dirh, int flags);
 static long	_cdecl fatfs_readdir	(DIR *dirh, char *nm, int nmlen, fcookie *);
+static long	_cdecl fatfs_readdirplus(DIR *dirh, char *buf, long len);
 static long	_cdecl fatfs_rewinddir	(DIR *dirh);
 static long	_cdecl fatfs_closedir	(DIR *dirh);
 
@@ -594,6 +596,7 @@ FILESYS fatfs_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_NOXBIT		|
@@ -602,7 +605,8 @@ FILESYS fatfs_filesys =
 	FS_DO_SYNC		|
 	FS_OWN_MEDIACHANGE	|
 	FS_EXT_1		|
-	FS_EXT_2		,
+	FS_EXT_2		|
+	FS_EXT_4		,
 
 	root:			fatfs_root,
 	lookup:			fatfs_lookup,
@@ -643,7 +647,9 @@ FILESYS fatfs_filesys =
 
 	/* FS_EXT_3 */
 	stat64:			NULL,
-	res1:			0,
+
+	/* FS_EXT_4 */
+	readdirplus:		fatfs_readdirplus,
 	res2:			0,
 	res3:			0,
 
@@ -6996,6 +7002,34 @@ fatfs_readdir (DIR *dirh, char *nm, int nmlen, fcookie *fc)
 	return ENOMEM;
 }
 
+/* the attributes of an entry come from the cookie that readdir
+ * just set up, so no directory lookup is needed for them
+ */
+static long _cdecl
+fatfs_dirplus_stat (fcookie *fc, STAT *st)
+{
+	XATTR xattr;
+	long r;
+
+	r = fatfs_getxattr (fc, &xattr);
+	if (r == E_OK)
+		xattr2stat64 (&xattr, st);
+
+	fatfs_release (fc);
+	return r;
+}
+
+static long _cdecl
+fatfs_readdirplus (DIR *dirh, char *buf, long len)
+{
+	long count;
+
+	count = dirplus_read (dirh, buf, len, fatfs_readdir, fatfs_dirplus_stat);
+
+	FAT_DEBUG (("fatfs_readdirplus: leave ok (%li entries)", count));
+	return count;
+}
+
 static long _cdecl
 fatfs_rewinddir (DIR *dirh)
 {
@@ -70,6 +70,7 @@
 # include "unicode.h"		/* init_unicode() */
 # include "update.h"		/* start_sysupdate */
 # include "util.h"		/* */
+# include "workqueue.h"		/* init_workqueues */
 # include "xbios.h"		/* has_bconmap, curbconmap */
 
 # ifdef OLDTOSFS
@@ -790,6 +791,9 @@ init (void)
 	boot_print(MSG_init_loading_modules);
 # endif
 
+	/* kernel threads for deferred work, modules may use them */
+	init_workqueues();
+
 	/* set cwd to sysdir for modules */
 	sys_d_setpath(sysdir);
 	/* load the kernel modules */
@@ -28,8 +28,13 @@
 # include "proc.h"
 
 
+/* Buffers start small and grow up to UN_AUTOBUF while the reader
+ * keeps up with a writer that fills them, see un_autosize().
+ * setsockopt() may ask for up to UN_MAXBUF.
+ */
 # define UN_MINBUF	8192
-# define UN_MAXBUF	32000
+# define UN_AUTOBUF	65536L
+# define UN_MAXBUF	262144L
 
 
 static long	unix_attach	(struct socket *, short);
@@ -121,6 +126,8 @@ unix_attach (struct socket *so, short protocol)
 	undata->head =    0;
 	undata->tail =    0;
 	undata->buflen =  UN_MINBUF;
+	undata->nread =   0;
+	undata->reader =  NULL;
 	undata->backlog = 0;
 	undata->next =    0;
 	undata->addrlen = 0;
@@ -521,6 +528,7 @@ unix_setsockopt (struct socket *so, short level, short optname, char *optval, lo
 			if (newsize < UN_MINBUF) newsize = UN_MINBUF;
 			else if (newsize > UN_MAXBUF) newsize = UN_MAXBUF;
 
+			undata->flags |= UN_BUFSET;
 			return un_resize (undata, newsize);
 		}
 		case SO_RCVBUF:
@@ -534,6 +542,7 @@ unix_setsockopt (struct socket *so, short level, short optname, char *optval, lo
 			if (newsize < UN_MINBUF) newsize = UN_MINBUF;
 			else if (newsize > UN_MAXBUF) newsize = UN_MAXBUF;
 
+			undata->flags |= UN_BUFSET;
 			return un_resize (undata, newsize);
 		}
 		case SO_DEBUG:
@@ -653,16 +662,36 @@ un_remove (struct un_data *undata)
 	}
 }
 
+/* A process killed while it sleeps in recv() doesn't get to take its
+ * un_reader (on its stack, pointing to its memory) back; terminate()
+ * calls this to do it.
+ */
+void
+un_reader_exit (struct proc *p)
+{
+	struct un_data *undata;
+	int i;
+
+	for (i = 0; i < UN_HASH_SIZE; i++)
+	{
+		for (undata = allundatas[i]; undata; undata = undata->next)
+		{
+			if (undata->reader && undata->reader->p == p)
+				undata->reader = NULL;
+		}
+	}
+}
+
 /* Resize `un's buffer to `newsize' bytes. Before calling this
  * you must validate `newsize' and `un'.
  */
 long
 un_resize (struct un_data *un, long newsize)
 {
-	short head = un->head, tail = un->tail;
+	long head = un->head, tail = un->tail;
 	char *newbuf;
 
-	newsize = (((newsize) + 1) & ~1);
+	newsize = (((newsize) + 1) & ~1L);
 	if (newsize < UN_USED (un))
 		return EINVAL;
 
@@ -684,7 +713,7 @@ un_resize (struct un_data *un, long newsize)
 	}
 	else
 	{
-		short done = un->buflen - head;
+		long done = un->buflen - head;
 		memcpy (newbuf, &un->buf[head], done);
 		memcpy (newbuf + done, un->buf, tail);
 		un->head = 0;
@@ -704,6 +733,26 @@ un_resize (struct un_data *un, long newsize)
 	return 0;
 }
 
+/* Called by a writer that finds the buffer of `un' full. If the
+ * reader has taken a whole buffer since the last time, the buffer
+ * limits the throughput and we double it; a reader that doesn't keep
+ * up wouldn't profit from a larger one. Sizes set with setsockopt()
+ * are left alone, and failing to get the memory doesn't matter.
+ */
+void
+un_autosize (struct un_data *un)
+{
+	if (!(un->flags & UN_BUFSET)
+		&& un->buflen < UN_AUTOBUF
+		&& un->nread >= un->buflen)
+	{
+		DEBUG (("unix: un_autosize: growing to %ld", un->buflen * 2));
+		un_resize (un, un->buflen * 2);
+	}
+
+	un->nread = 0;
+}
+
 /* Convert a file name to a index. */
 long
 un_namei (const struct sockaddr *addr, short addrlen, long *index)
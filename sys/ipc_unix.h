@@ -44,27 +44,43 @@ struct un_data
 	struct socket	*sock;		/* socket this un_data belongs to */
 	long		index;
 	long		index2;		/* index of the peer address (dgram) */
-	short		head;		/* buffer head */
-	short		tail;		/* buffer tail */
-	short		buflen;		/* current buffer size */
+	long		head;		/* buffer head */
+	long		tail;		/* buffer tail */
+	long		buflen;		/* current buffer size */
 	char		*buf;		/* buffer data */
+	long		nread;		/* bytes read since the buffer was last full */
+	struct un_reader *reader;	/* recv() waiting for data (stream) */
 	struct un_data	*next;		/* link to next un_data */
 	short		backlog;	/* max. # of pending connections */
 	struct sockaddr_un addr;	/* local address */
 	short		addrlen;	/* length of local address */
 };
 
+/* A stream reader that sleeps for data leaves its iovec here, so
+ * the writer can copy into it directly instead of through the buffer.
+ */
+struct un_reader
+{
+	struct proc	*p;		/* the reader, see un_reader_exit() */
+	const struct iovec *iov;
+	short		niov;
+	long		nbytes;		/* what the writer has given us */
+};
+
+/* un_data flags, besides the UN_* socket flags */
+# define UN_BUFSET	0x0100		/* buffer size set by setsockopt() */
+
 /* datagram header */
 struct dgram_hdr
 {
-	short	nbytes;			/* # of bytes in the datagram */
+	long	nbytes;			/* # of bytes in the datagram */
 	long	sender;			/* index of sender of this dgram */
 };
 
 INLINE void
 un_store_header (struct un_data *un, struct dgram_hdr *hdr)
 {
-	short i, tail;
+	long i, tail;
 	char *d, *s;
 	
 	tail = un->tail;
@@ -85,7 +101,7 @@ un_store_header (struct un_data *un, struct dgram_hdr *hdr)
 INLINE void
 un_read_header (struct un_data *un, struct dgram_hdr *hdr, short modify)
 {
-	short head, i;
+	long head, i;
 	char *s, *d;
 	
 	head = un->head;
@@ -104,10 +120,10 @@ un_read_header (struct un_data *un, struct dgram_hdr *hdr, short modify)
 		un->head = head;
 }
 
-INLINE short
+INLINE long
 UN_USED (struct un_data *un)
 {
-	register short space;
+	register long space;
 	
 	space = un->tail - un->head;
 	if (space < 0)
@@ -127,7 +143,9 @@ UN_USED (struct un_data *un)
 struct un_data *	un_lookup (long, enum so_type);
 void			un_put (struct un_data *);
 void			un_remove (struct un_data *);
+void			un_reader_exit (struct proc *);
 long			un_resize (struct un_data *, long);
+void			un_autosize (struct un_data *);
 long			un_namei (const struct sockaddr *, short, long *);
 
 
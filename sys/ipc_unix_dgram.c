@@ -56,7 +56,7 @@ unix_dgram_send (struct socket *so, const struct iovec *iov, short niov, short n
 	struct un_data *dstdata, *srcdata = so->data;
 	struct dgram_hdr header;
 	long index, r, nbytes;
-	short head, tail;
+	long head, tail;
 
 	if (so->state != SS_ISUNCONNECTED)
 		return ENOTCONN;
@@ -139,7 +139,7 @@ check:
 	/* Store the length and sender of the message, 'cuz the reader will
 	 * need it. Note that buf, head, tail and buflen are word aligned.
 	 */
-	header.nbytes = (short)nbytes;
+	header.nbytes = nbytes;
 	header.sender = UN_INDEX (srcdata);
 	un_store_header (dstdata, &header);
 
@@ -150,7 +150,7 @@ check:
 	{
 		long todo = iov->iov_len;
 		char *buf = iov->iov_base;
-		short cando;
+		long cando;
 
 		while (todo > 0)
 		{
@@ -160,7 +160,7 @@ check:
 				cando = head - tail - 1;
 
 			if (cando > todo)
-				cando = (short)todo;
+				cando = todo;
 
 			memcpy (&dstdata->buf[tail], buf, cando);
 			tail += cando;
@@ -185,7 +185,7 @@ unix_dgram_recv (struct socket *so, const struct iovec *iov, short niov, short n
 {
 	struct un_data *undata = so->data;
 	struct dgram_hdr header;
-	short head, tail, cando;
+	long head, tail, cando;
 	long nbytes;
 	char *buf;
 
@@ -245,7 +245,7 @@ unix_dgram_recv (struct socket *so, const struct iovec *iov, short niov, short n
 				cando = undata->buflen - head;
 
 			if (cando > todo)
-				cando = (short)todo;
+				cando = todo;
 
 			memcpy (buf, &undata->buf[head], cando);
 			buf  += cando;
@@ -261,7 +261,7 @@ unix_dgram_recv (struct socket *so, const struct iovec *iov, short niov, short n
 		long newhead = undata->head + header.nbytes;
 		if (newhead >= undata->buflen)
 			newhead -= undata->buflen;
-		undata->head = (short)newhead;
+		undata->head = newhead;
 	}
 
 	if (addr && addrlen)
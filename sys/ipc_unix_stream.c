@@ -14,12 +14,84 @@
 # include "mint/pathconf.h"
 # include "mint/signal.h"
 
+# include "arch/mprot.h"
+
 # include "ipc_socketutil.h"
 # include "ipc_unix.h"
+# include "memory.h"
 # include "proc.h"
 # include "signal.h"
 
 
+/* A reader that has to wait for data lets the writer copy into its
+ * buffers directly. The writer does that in its own context, so the
+ * buffers must be visible from there: not without memory protection,
+ * and not in a region that is swapped with a forked process.
+ */
+static int
+un_direct_ok (const struct iovec *iov, short niov)
+{
+	PROC *p = get_curproc ();
+	
+	if (!no_mem_prot)
+		return 0;
+	
+	for (; niov; ++iov, --niov)
+	{
+		MEMREGION *m;
+		
+		if (!iov->iov_len)
+			continue;
+		
+		m = proc_addr2region (p, (unsigned long) iov->iov_base);
+		if (!m || m->shadow
+			|| (unsigned long) iov->iov_base + iov->iov_len > m->loc + m->len)
+		{
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+/* Copy as much of the writer's data as fits into the buffers of a
+ * waiting reader, returns the number of bytes copied.
+ */
+static long
+un_direct (struct un_reader *rd, const struct iovec *iov, short niov)
+{
+	const struct iovec *riov = rd->iov;
+	short rniov = rd->niov;
+	long off = 0, roff = 0;
+	long done = 0;
+	
+	while (niov && rniov)
+	{
+		long n = MIN (iov->iov_len - off, riov->iov_len - roff);
+		
+		memcpy (riov->iov_base + roff, iov->iov_base + off, n);
+		done += n;
+		off += n;
+		roff += n;
+		
+		if (off >= iov->iov_len)
+		{
+			++iov; --niov;
+			off = 0;
+		}
+		
+		if (roff >= riov->iov_len)
+		{
+			++riov; --rniov;
+			roff = 0;
+		}
+	}
+	
+	rd->nbytes = done;
+	return done;
+}
+
+
 long
 unix_stream_socketpair (struct socket *so1, struct socket *so2)
 {
@@ -61,7 +133,7 @@ unix_stream_send (struct socket *so, const struct iovec *iov, short niov, short
 			short flags, const struct sockaddr *addr, short addrlen)
 {
 	struct un_data *undata;
-	long nbytes;
+	long nbytes, skip;
 	
 	switch (so->state)
 	{
@@ -97,6 +169,10 @@ unix_stream_send (struct socket *so, const struct iovec *iov, short niov, short
 	/* Now we know `iov' is valid, since iov_size returns < 0 if not */
 	while (!UN_FREE (undata))
 	{
+		un_autosize (undata);
+		if (UN_FREE (undata))
+			break;
+		
 		if (nonblock)
 		{
 			DEBUG (("unix_stream_send: EAGAIN"));
@@ -119,16 +195,38 @@ unix_stream_send (struct socket *so, const struct iovec *iov, short niov, short
 		}
 	}
 	
+	/* A reader waits for data, so the buffer is empty:
+	 * give it what it can take without copying twice.
+	 */
+	skip = 0;
+	if (undata->reader)
+	{
+		struct un_reader *rd = undata->reader;
+		
+		undata->reader = NULL;
+		if (!UN_USED (undata))
+			skip = un_direct (rd, iov, niov);
+	}
+	
 	for (nbytes = 0; niov; --niov, ++iov)
 	{
 		long todo = iov->iov_len;
 		char *buf = iov->iov_base;
-		short cando;
+		long cando;
 
 		nbytes += todo;
+		
+		if (skip)
+		{
+			cando = MIN (skip, todo);
+			todo -= cando;
+			buf  += cando;
+			skip -= cando;
+		}
+		
 		while (todo > 0)
 		{
-			short tail = undata->tail, head = undata->head;
+			long tail = undata->tail, head = undata->head;
 			if (tail >= head)
 			{
 				cando = undata->buflen - tail;
@@ -138,7 +236,7 @@ unix_stream_send (struct socket *so, const struct iovec *iov, short niov, short
 				cando = head - tail - 1;
 			
 			if (cando > todo)
-				cando = (short)todo;
+				cando = todo;
 			
 			if (cando)
 			{
@@ -152,6 +250,10 @@ unix_stream_send (struct socket *so, const struct iovec *iov, short niov, short
 			}
 			else
 			{
+				un_autosize (undata);
+				if (UN_FREE (undata))
+					continue;
+				
 				if (nonblock)
 					break;
 				
@@ -223,6 +325,8 @@ unix_stream_recv (struct socket *so, const struct iovec *iov, short niov, short
 	
 	while (!UN_USED (undata))
 	{
+		struct un_reader rd;
+		
 		if (so->state != SS_ISCONNECTED)
 			return 0; /* EOF */
 		
@@ -232,12 +336,31 @@ unix_stream_recv (struct socket *so, const struct iovec *iov, short niov, short
 			return EAGAIN;
 		}
 		
+		/* let the writer copy directly to us */
+		rd.nbytes = 0;
+		if (!undata->reader && un_direct_ok (iov, niov))
+		{
+			rd.p = get_curproc ();
+			rd.iov = iov;
+			rd.niov = niov;
+			undata->reader = &rd;
+		}
+		
 		if (sleep (IO_Q, (long) so))
 		{
 			DEBUG (("unix_stream_recv: interrupted"));
 			// return EINTR;
 		}
 		
+		if (undata->reader == &rd)
+			undata->reader = NULL;
+		
+		if (rd.nbytes)
+		{
+			nbytes = rd.nbytes;
+			goto done;
+		}
+		
 		if (so->state == SS_ISDISCONNECTED ||
 		    so->flags & SO_CANTRCVMORE)
 			return 0; /* EOF */
@@ -247,19 +370,19 @@ unix_stream_recv (struct socket *so, const struct iovec *iov, short niov, short
 	{
 		long todo = iov->iov_len;
 		char *buf = iov->iov_base;
-		short cando;
+		long cando;
 
 		nbytes += todo;
 		while (todo > 0)
 		{
-			short tail = undata->tail, head = undata->head;
+			long tail = undata->tail, head = undata->head;
 			if (tail >= head)
 				cando = tail - head;
 			else
 				cando = undata->buflen - head;
 			
 			if (cando > todo)
-				cando = (short)todo;
+				cando = todo;
 			
 			if (cando)
 			{
@@ -281,6 +404,9 @@ unix_stream_recv (struct socket *so, const struct iovec *iov, short niov, short
 		}
 	}
 	
+done:
+	undata->nread += nbytes;
+	
 	if (addr && addrlen)
 	{
 		long r = unix_stream_getname (so, addr, addrlen, PEER_ADDR);
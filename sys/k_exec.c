@@ -58,6 +58,7 @@
 # include "proc_help.h"
 # include "procfs.h"
 # include "signal.h"
+# include "sysv_shm.h"
 # include "time.h"
 # include "timeout.h"
 # include "util.h"
@@ -170,6 +171,7 @@ sys_pexec(short mode, const void *p1, const void *p2, const void *p3)
 	union { const void *v; const char *cc; char *c; long l; } ptr_1, ptr_2, ptr_3;
 	MEMREGION *base;
 	MEMREGION *env = NULL;	/* assignment suppresses spurious warning */
+	MEMREGION *text = NULL;	/* shared text, if any */
 	struct proc *p = NULL;
 	long flags = 0;
 	char mkbase = 0, mkload = 0, mkgo = 0, mkwait = 0, mkfree = 0;
@@ -357,6 +359,10 @@ sys_pexec(short mode, const void *p1, const void *p2, const void *p3)
 		}
 	}
 
+	/* a shared TEXT region held by the basepage goes to the child */
+	if (mkgo)
+		text = shtext_region(base);
+
 	if (mkload || mkbase)
 	{
 		/* Now that the file's loaded, flags is set to the prgflags
@@ -487,6 +493,8 @@ sys_pexec(short mode, const void *p1, const void *p2, const void *p3)
 		exec_region(p, base, thread);
 		attach_region(p, env);
 		attach_region(p, base);
+		if (text)
+			attach_region(p, text);
 
 		if (mkname)
 		{
@@ -742,8 +750,9 @@ exec_region(struct proc *p, MEMREGION *mem, int thread)
 		 * compiler (or assembler, or whatever) goes to the trouble of making
 		 * separate text, data, and bss regions, then the text region is code
 		 * and isn't modified and fork doesn't have to save it.
+		 * A shared TEXT isn't part of the basepage region at all.
 		 */
-		if (b->p_blen != 0 || b->p_dlen != 0)
+		if ((b->p_blen != 0 || b->p_dlen != 0) && b->p_tbase == b->p_lowtpa + 256)
 			p->p_mem->txtsize = b->p_tlen;
 		else
 			p->p_mem->txtsize = 0;
@@ -778,6 +787,11 @@ exec_region(struct proc *p, MEMREGION *mem, int thread)
 			}
 		}
 
+		/* SysV segments of the old image went with it,
+		 * removed ones may have lost their last user
+		 */
+		shm_reap();
+
 		/*
 		 * If the proc struct has a larger mem array than
 		 * the default, then free it and allocate a
@@ -880,6 +894,7 @@ create_process(const void *filename, const void *cmdline, const void *newenv,
 	char localname[PNAMSIZ+1];
 	MEMREGION *env = NULL;
 	MEMREGION *base = NULL;
+	MEMREGION *text = NULL;
 	BASEPAGE *b;
 	struct proc *p;
 	long r;
@@ -907,6 +922,7 @@ create_process(const void *filename, const void *cmdline, const void *newenv,
 	TRACE(("create_process: basepage region(%p) is %ld bytes at $%08lx", base, base->len, base->loc));
 
 	b = (BASEPAGE *) base->loc;
+	text = shtext_region(base);
 
 	DEBUG(("create_process: p_flags=$%08lx", b->p_flags));
 
@@ -991,6 +1007,8 @@ create_process(const void *filename, const void *cmdline, const void *newenv,
 	exec_region(p, base, 0);
 	attach_region(p, env);
 	attach_region(p, base);
+	if (text)
+		attach_region(p, text);
 
 	/* interesting coincidence:
 	 * if a process needs a name, it usually needs to have
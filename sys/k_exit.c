@@ -40,6 +40,7 @@
 # include "bios.h"
 # include "dosdir.h"
 # include "filesys.h"
+# include "ipc_unix.h"	/* un_reader_exit */
 # include "k_exec.h"	/* rts */
 # include "k_prot.h"	/* free_cred */
 # include "kmemory.h"
@@ -50,6 +51,8 @@
 # include "rendez.h"
 # include "signal.h"
 # include "slb.h"
+# include "sysv_sem.h"
+# include "sysv_shm.h"
 # include "time.h"
 # include "timeout.h"
 # include "util.h"
@@ -110,6 +113,16 @@ terminate(struct proc *pcurproc, short code, short que)
 	/* release all semaphores owned by this process */
 	free_semaphores (pcurproc->pid);
 
+	/* in case we were killed while blocked in Pmsg or Pfutex */
+	free_mbox (pcurproc);
+	free_futex (pcurproc);
+
+	/* or in recv() on a unix stream socket */
+	un_reader_exit (pcurproc);
+
+	/* apply SEM_UNDO adjustments */
+	semexit (pcurproc);
+
 	/* make sure that any open files that refer to this process are
 	 * closed
 	 */
@@ -130,7 +143,12 @@ terminate(struct proc *pcurproc, short code, short que)
 
 	/* attention, this invalidates the MMU table */
 	if (que == ZOMBIE_Q)
+	{
 		free_mem (pcurproc);
+
+		/* removed SysV segments may have lost their last user */
+		shm_reap ();
+	}
 	/* else
 		 make TSR process non-swappable */
 
@@ -39,9 +39,11 @@
 
 # include "biosfs.h"
 # include "dosfile.h"
+# include "exec_cache.h"
 # include "filesys.h"
 # include "k_prot.h"
 # include "kerinfo.h"
+# include "kmem_cache.h"
 # include "kmemory.h"
 # include "pipefs.h"
 # include "proc.h"
@@ -95,12 +97,14 @@ fd_remove (struct proc *p, short fd, const char *func)
 }
 
 
+static KMEM_CACHE (fp_cache, "FILEPTR", sizeof (FILEPTR), NULL);
+
 long
 fp_alloc (struct proc *p, FILEPTR **resultfp, const char *func)
 {
 	FILEPTR *fp;
 
-	fp = kmalloc (sizeof (*fp));
+	fp = kmem_cache_alloc (&fp_cache);
 	if (!fp)
 	{
 		DEBUG (("%s: out of memory for FP_ALLOC", func));
@@ -116,7 +120,7 @@ fp_alloc (struct proc *p, FILEPTR **resultfp, const char *func)
 
 	*resultfp = fp;
 
-	TRACE (("%s: fp_alloc: kmalloc %p", func, fp));
+	TRACE (("%s: fp_alloc: %p", func, fp));
 	return 0;
 }
 
@@ -142,8 +146,8 @@ fp_free (FILEPTR *fp, const char *func)
 	// later
 	// free_cred (fp->cred);
 
-	TRACE (("%s: fp_free: kfree %p", func, fp));
-	kfree (fp);
+	TRACE (("%s: fp_free: %p", func, fp));
+	kmem_cache_free (&fp_cache, fp);
 }
 
 long
@@ -713,6 +717,10 @@ do_close (struct proc *p, FILEPTR *f)
 
 	if (f->links <= 0)
 	{
+		/* an exec image cached of it may be out of date now */
+		if ((f->flags & O_RWMODE) != O_RDONLY && f->fc.fs)
+			exec_cache_written (&f->fc);
+
 		release_cookie (&f->fc);
 		FP_FREE (f);
 	}
@@ -32,6 +32,7 @@
 # include "buildinfo/version.h"
 # include "libkern/libkern.h"
 # include "mint/credentials.h"
+# include "mint/dcntl.h"
 # include "mint/endian.h"
 # include "mint/iov.h"
 # include "mint/pathconf.h"
@@ -39,13 +40,20 @@
 # include "mint/time.h"
 # include "sys/param.h"
 
+# include "exec_cache.h"
+# include "filesys.h"
 # include "global.h"
 # include "info.h"
 # include "k_prot.h"
 # include "keyboard.h"
+# include "ktrace.h"
 # include "memory.h"
 # include "proc.h"
+# include "syscall_stat.h"
+# include "sysv_msg.h"
 # include "time.h"
+# include "unifs.h"
+# include "xfs_xdd.h"
 
 
 static long kern_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
@@ -60,6 +68,9 @@ static long proc_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
 static long kbd_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
 		       const void *newp, ulong newlen, struct proc *p);
 
+static long vfs_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
+		       const void *newp, ulong newlen, struct proc *p);
+
 long _cdecl
 sys_p_sysctl (long *name, ulong namelen, void *old, ulong *oldlenp,
 	      const void *new, ulong newlen)
@@ -117,6 +128,9 @@ sys_p_sysctl (long *name, ulong namelen, void *old, ulong *oldlenp,
 		case CTL_KBD:
 			fn = kbd_sysctl;
 			break;
+		case CTL_VFS:
+			fn = vfs_sysctl;
+			break;
 		default:
 			return EOPNOTSUPP;
 	}
@@ -219,6 +233,97 @@ kern_sysctl (long *name, ulong namelen, void *oldp, ulong *oldlenp,
 
 		case KERN_SYSDIR:
 			return sysctl_rdstring (oldp, oldlenp, newp, sysdir);
+
+		case KERN_EXECCACHE:
+		{
+			long size = exec_cache_max;
+
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &size);
+			if (newp && !ret)
+			{
+				if (size < 0)
+					return EINVAL;
+
+				exec_cache_max = size;
+				exec_cache_trim (size);
+			}
+			return ret;
+		}
+
+		case KERN_MSGMAX:
+		case KERN_MSGMNB:
+		case KERN_MSGTQL:
+		{
+			long *valp;
+			long val;
+
+			valp = (name[0] == KERN_MSGMAX) ? &msginfo.msgmax :
+			       (name[0] == KERN_MSGMNB) ? &msginfo.msgmnb : &msginfo.msgtql;
+
+			val = *valp;
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &val);
+			if (newp && !ret)
+			{
+				if (val < 1)
+					return EINVAL;
+
+				*valp = val;
+			}
+			return ret;
+		}
+
+		case KERN_MSGMNI:
+		{
+			long val = msginfo.msgmni;
+
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &val);
+			if (newp && !ret)
+			{
+				/* bounded by the static queue table */
+				if (val < 1 || val > MSGMNI)
+					return EINVAL;
+
+				msginfo.msgmni = val;
+			}
+			return ret;
+		}
+
+		case KERN_TRACEMASK:
+		{
+			long val = ktrace_mask;
+
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &val);
+			if (newp && !ret)
+				ret = ktrace_setmask (val);
+
+			return ret;
+		}
+
+		case KERN_TRACESIZE:
+		{
+			long val = ktrace_size;
+
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &val);
+			if (newp && !ret)
+			{
+				if (val < 0)
+					return EINVAL;
+
+				ret = ktrace_setsize (val);
+			}
+			return ret;
+		}
+
+		case KERN_SYSCALLSTAT:
+		{
+			long val = (syscall_hooks & SYSCALL_HOOK_STAT) ? 1 : 0;
+
+			ret = sysctl_long (oldp, oldlenp, newp, newlen, &val);
+			if (newp && !ret)
+				ret = syscall_stat_set (val);
+
+			return ret;
+		}
 	}
 
 	return EOPNOTSUPP;
@@ -357,6 +462,51 @@ kbd_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
 	return EOPNOTSUPP;
 }
 
+/*
+ * filesystem related information;
+ * the filesystem on the drive takes care of the rest of the name
+ */
+static long
+vfs_sysctl(long *name, ulong namelen, void *oldp, ulong *oldlenp,
+	   const void *newp, ulong newlen, struct proc *p)
+{
+	struct fs_sysctl args;
+	FILESYS *fs;
+	fcookie root;
+	long r;
+
+	if (namelen < 2)
+		/* overloaded */
+		return ENOTDIR;
+
+	if (name[0] < 0 || name[0] >= NUM_DRIVES)
+		return EINVAL;
+
+	fs = get_filesys (name[0]);
+	if (!fs)
+		return EOPNOTSUPP;
+
+	r = xfs_root (fs, name[0], &root);
+	if (r)
+		return r;
+
+	args.name = name + 1;
+	args.namelen = namelen - 1;
+	args.oldp = oldp;
+	args.oldlenp = oldlenp;
+	args.newp = newp;
+	args.newlen = newlen;
+
+	r = xfs_fscntl (fs, &root, "", FS_SYSCTL, (long) &args);
+	release_cookie (&root);
+
+	/* filesystems that don't know it */
+	if (r == ENOSYS || r == EINVAL)
+		r = EOPNOTSUPP;
+
+	return r;
+}
+
 
 static long copyout(const void *src, void *dst, ulong len) { memcpy (dst, src, len); return 0; }
 static long copyin(const void *src, void *dst, ulong len) { memcpy (dst, src, len); return 0; }
@@ -46,6 +46,7 @@
 # include "k_exec.h"		/* create_process */
 # include "k_kthread.h"		/* kthread_create, kthread_exit */
 # include "k_prot.h"		/* proc_setuid/proc_setgid */
+# include "kmem_cache.h"		/* kmem_cache_* */
 # include "kmemory.h"		/* kmalloc, kfree */
 # include "memory.h"		/* addr2mem, attach_region, detach_region */
 # include "module.h"		/* load_modules */
@@ -41,11 +41,14 @@
 # include "filesys.h"		/* changedrv, denyshare, denylock */
 # include "ipc_socketutil.h"	/* so_* */
 # include "k_kthread.h"		/* kthread_create, kthread_exit */
+# include "kmem_cache.h"		/* kmem_cache_ops */
 # include "kmemory.h"		/* kmalloc, kfree */
+# include "ktrace.h"		/* ktrace_ops */
 # include "module.h"		/* load_modules */
 # include "proc.h"		/* sleep, wake, wakeselect, iwake */
 # include "signal.h"		/* ikill */
 # include "syscall_vectors.h"	/* bios_tab, dos_tab */
+# include "workqueue.h"		/* workqueue_ops */
 # include "time.h"		/* xtime */
 # include "timeout.h"		/* nap, addtimeout, canceltimeout, addroottimeout, cancelroottimeout */
 # include "umemory.h"		/* umalloc, ufree */
@@ -89,7 +92,7 @@ struct kerinfo kernelinfo =
 	MINT_MAJ_VERSION,
 	MINT_MIN_VERSION,
 	DEFAULT_MODE,
-	2, /* MINT_KVERSION */
+	3, /* MINT_KVERSION */
 	&bios_tab, &dos_tab,
 	m_changedrv,
 	Trace, Debug, ALERT, FATAL,
@@ -141,7 +144,12 @@ struct kerinfo kernelinfo =
 
 	remaining_proc_time,
 
-	{
-		0
-	}
+	&kmem_cache_ops,
+
+	/* version 3
+	 */
+
+	&ktrace_ops,
+
+	&workqueue_ops
 };
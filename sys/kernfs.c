@@ -234,6 +234,10 @@ struct ktab
 # define ROOTDIR_BUILDINFO	0x12
 # define ROOTDIR_STAT       	0x13
 # define ROOTDIR_SYSDIR		0x14
+# define ROOTDIR_SLABINFO	0x15
+# define ROOTDIR_TRACE		0x16
+# define ROOTDIR_SYSCALLS	0x17
+# define ROOTDIR_WORKQUEUES	0x18
 
 static KENTRY __rootdir [] =
 {
@@ -253,12 +257,16 @@ static KENTRY __rootdir [] =
 # endif
 	{ ROOTDIR_MEMINFO,	S_IFREG | 0444,	"meminfo",	kern_get_meminfo	},
 	{ ROOTDIR_SELF,		S_IFLNK | 0777,	"self",		kern_get_unimplemented	},
+	{ ROOTDIR_SLABINFO,	S_IFREG | 0444,	"slabinfo",	kern_get_slabinfo	},
 	{ ROOTDIR_STAT,		S_IFREG | 0444,	"stat",		kern_get_stat		},
+	{ ROOTDIR_SYSCALLS,	S_IFREG | 0444,	"syscalls",	kern_get_syscalls	},
 	{ ROOTDIR_SYSDIR,	S_IFREG | 0444, "sysdir",	kern_get_sysdir		},
 	{ ROOTDIR_TIME,		S_IFREG | 0444,	"time",		kern_get_time		},
+	{ ROOTDIR_TRACE,	S_IFREG | 0400,	"trace",	kern_get_trace		},
 	{ ROOTDIR_UPTIME,	S_IFREG | 0444,	"uptime",	kern_get_uptime		},
 	{ ROOTDIR_VERSION,	S_IFREG | 0444,	"version",	kern_get_version	},
-	{ ROOTDIR_WELCOME,	S_IFREG | 0444,	"welcome",	kern_get_welcome	}
+	{ ROOTDIR_WELCOME,	S_IFREG | 0444,	"welcome",	kern_get_welcome	},
+	{ ROOTDIR_WORKQUEUES,	S_IFREG | 0444,	"workqueues",	kern_get_workqueues	}
 };
 
 static KTAB _rootdir =
@@ -63,17 +63,21 @@
 # include "filesys.h"
 # include "info.h"
 # include "kernfs.h"
+# include "kmem_cache.h"
 # include "kmemory.h"
+# include "ktrace.h"
 # include "memory.h"
 # include "pipefs.h"
 # include "proc.h"
 # include "procfs.h"
 # include "random.h"
 # include "shmfs.h"
+# include "syscall_stat.h"
 # include "time.h"
 # include "timeout.h"
 # include "unifs.h"
 # include "util.h"
+# include "workqueue.h"
 # include "xbios.h"
 
 
@@ -440,6 +444,51 @@ kern_get_meminfo (SIZEBUF **buffer, const struct proc *p)
 	return 0;
 }
 
+/**
+ * /kern/slabinfo
+ * One line per typed object cache (see kmem_cache.c).
+ */
+long
+kern_get_slabinfo (SIZEBUF **buffer, const struct proc *p)
+{
+	SIZEBUF *info;
+	ulong len = 128;
+	ulong i;
+	char *crs;
+	struct kmem_cache *c;
+
+	UNUSED(p);
+	for (c = kmem_caches; c; c = c->next)
+		len += 128;
+
+	info = kmalloc (sizeof (*info) + len);
+	if (!info)
+		return ENOMEM;
+
+	crs = info->buf;
+
+	i = ksprintf (crs, len,
+		      "%-16s %5s %5s %4s %6s %6s %5s %9s %9s %6s %6s %5s\n",
+		      "name", "size", "obj", "slab", "inuse", "total", "slabs",
+		      "allocs", "frees", "grows", "shrink", "fails");
+	crs += i; len -= i;
+
+	for (c = kmem_caches; c; c = c->next)
+	{
+		i = ksprintf (crs, len,
+			      "%-16s %5lu %5lu %4u %6lu %6lu %5lu %9lu %9lu %6lu %6lu %5lu\n",
+			      c->name, c->size, c->objsize, c->perslab,
+			      c->inuse, c->total, c->slabs,
+			      c->allocs, c->frees, c->grows, c->shrinks, c->fails);
+		crs += i; len -= i;
+	}
+
+	info->len = crs - info->buf;
+
+	*buffer = info;
+	return 0;
+}
+
 
 /**
  * /kern/stat
@@ -533,6 +582,30 @@ kern_get_time (SIZEBUF **buffer, const struct proc *p)
 	return 0;
 }
 
+/**
+ * /kern/syscalls
+ * Per system call statistics (see syscall_stat.c),
+ * tools/sysstat prints the top N.
+ */
+long
+kern_get_syscalls (SIZEBUF **buffer, const struct proc *p)
+{
+	UNUSED(p);
+	return syscall_stat_read (buffer);
+}
+
+/**
+ * /kern/trace
+ * The binary trace buffer (see ktrace.c and mint/ktrace.h),
+ * decoded by tools/ktrace.
+ */
+long
+kern_get_trace (SIZEBUF **buffer, const struct proc *p)
+{
+	UNUSED(p);
+	return ktrace_read (buffer);
+}
+
 
 long
 kern_get_uptime (SIZEBUF **buffer, const struct proc *p)
@@ -907,7 +980,6 @@ kern_procdir_get_meminfo (SIZEBUF **buffer, const struct proc *p)
 		if (!m)
 			continue;
 
-# define M_SHTEXT	0x0010	/* XXX */
 # define M_SHTEXT_T	0x0020	/* XXX */
 
 		crs += ksprintf (crs, len - (crs - info->buf),
@@ -1387,4 +1459,15 @@ kern_procdir_get_status (SIZEBUF **buffer, const struct proc *p)
 	return 0;
 }
 
+/**
+ * /kern/workqueues
+ * Per work queue counters (see workqueue.c), one line per queue.
+ */
+long
+kern_get_workqueues (SIZEBUF **buffer, const struct proc *p)
+{
+	UNUSED(p);
+	return workqueue_read (buffer);
+}
+
 # endif /* WITH_KERNFS */
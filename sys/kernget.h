@@ -49,12 +49,16 @@ long kern_get_filesystems	(SIZEBUF **buffer, const struct proc *p);
 long kern_get_hz		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_loadavg		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_meminfo		(SIZEBUF **buffer, const struct proc *p);
+long kern_get_slabinfo		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_stat              (SIZEBUF **buffer, const struct proc *p);
+long kern_get_syscalls		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_sysdir		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_time		(SIZEBUF **buffer, const struct proc *p);
+long kern_get_trace		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_uptime		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_version		(SIZEBUF **buffer, const struct proc *p);
 long kern_get_welcome		(SIZEBUF **buffer, const struct proc *p);
+long kern_get_workqueues	(SIZEBUF **buffer, const struct proc *p);
 
 long kern_procdir_get_cmdline	(SIZEBUF **buffer, const struct proc *p);
 long kern_procdir_get_environ	(SIZEBUF **buffer,       const struct proc *p);
@@ -0,0 +1,293 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - every object is preceded by one long; while the object is allocated
+ *   it points to the slab, while it is free it links the free list of
+ *   the slab (so the object itself is never touched and keeps whatever
+ *   state the constructor or the last user left in it)
+ *
+ * - slabs are kept on three lists (partial, empty, full); allocations
+ *   are served from partially used slabs first so empty slabs can be
+ *   given back to kmalloc
+ *
+ * - at most one empty slab is kept per cache
+ *
+ * - like kmalloc/kfree this must not be called from interrupts
+ */
+
+# include "kmem_cache.h"
+
+# include "libkern/libkern.h"
+
+# include "kmemory.h"
+
+
+# define KMEM_SLABSIZE	4096	/* target size of one slab */
+# define KMEM_MINOBJ	4	/* minimum number of objects per slab */
+
+struct kmem_slab
+{
+	struct kmem_slab *next;
+	struct kmem_slab **prev;	/* pointer to the link pointing to us */
+	struct kmem_cache *cache;
+	void	*free;			/* first free object header */
+	ulong	inuse;			/* objects allocated */
+};
+
+struct kmem_cache *kmem_caches = NULL;
+
+struct kmem_cache_ops kmem_cache_ops =
+{
+	kmem_cache_create,
+	kmem_cache_destroy,
+	kmem_cache_alloc,
+	kmem_cache_free
+};
+
+
+INLINE void
+slab_remove (struct kmem_slab *s)
+{
+	*s->prev = s->next;
+	if (s->next)
+		s->next->prev = s->prev;
+}
+
+INLINE void
+slab_insert (struct kmem_slab **list, struct kmem_slab *s)
+{
+	s->next = *list;
+	s->prev = list;
+	if (s->next)
+		s->next->prev = &s->next;
+	*list = s;
+}
+
+static void
+kmem_cache_setup (struct kmem_cache *c)
+{
+	ulong perslab;
+
+	/* room for the slab link, long aligned */
+	c->objsize = (sizeof (long) + c->size + sizeof (long) - 1) & ~(sizeof (long) - 1);
+
+	perslab = (KMEM_SLABSIZE - sizeof (struct kmem_slab)) / c->objsize;
+	if (perslab < KMEM_MINOBJ)
+		perslab = KMEM_MINOBJ;
+	c->perslab = perslab;
+
+	c->flags |= KC_SETUP;
+
+	c->next = kmem_caches;
+	kmem_caches = c;
+
+	DEBUG (("kmem_cache_setup: %s, %lu objects of %lu bytes per slab", c->name, perslab, c->objsize));
+}
+
+static struct kmem_slab *
+kmem_cache_grow (struct kmem_cache *c)
+{
+	struct kmem_slab *s;
+	char *ptr;
+	void **last;
+	long i;
+
+	if (!(c->flags & KC_SETUP))
+		kmem_cache_setup (c);
+
+	s = kmalloc (sizeof (*s) + c->perslab * c->objsize);
+	if (!s)
+		return NULL;
+
+	s->cache = c;
+	s->inuse = 0;
+
+	ptr = (char *) (s + 1);
+	last = &s->free;
+
+	for (i = c->perslab; i; i--)
+	{
+		*last = ptr;
+		last = (void **) ptr;
+
+		if (c->ctor)
+			(*c->ctor)(ptr + sizeof (long));
+
+		ptr += c->objsize;
+	}
+
+	*last = NULL;
+
+	slab_insert (&c->empty, s);
+
+	c->slabs++;
+	c->total += c->perslab;
+	c->grows++;
+
+	return s;
+}
+
+static void
+kmem_cache_shrink (struct kmem_cache *c, struct kmem_slab *s)
+{
+	slab_remove (s);
+
+	c->slabs--;
+	c->total -= c->perslab;
+	c->shrinks++;
+
+	kfree (s);
+}
+
+struct kmem_cache * _cdecl
+kmem_cache_create (const char *name, ulong size, void _cdecl (*ctor)(void *))
+{
+	struct kmem_cache *c;
+
+	c = kmalloc (sizeof (*c));
+	if (!c)
+		return NULL;
+
+	mint_bzero (c, sizeof (*c));
+
+	strncpy_f (c->name, name, sizeof (c->name));
+	c->size = size;
+	c->ctor = ctor;
+	c->flags = KC_DYNAMIC;
+
+	kmem_cache_setup (c);
+
+	return c;
+}
+
+void _cdecl
+kmem_cache_destroy (struct kmem_cache *c)
+{
+	struct kmem_cache **list;
+
+	if (c->inuse)
+	{
+		/* the objects still point into the slabs */
+		ALERT ("kmem_cache_destroy: %s: %lu objects in use", c->name, c->inuse);
+		return;
+	}
+
+	while (c->empty)
+		kmem_cache_shrink (c, c->empty);
+
+	if (c->flags & KC_SETUP)
+	{
+		for (list = &kmem_caches; *list; list = &(*list)->next)
+		{
+			if (*list == c)
+			{
+				*list = c->next;
+				break;
+			}
+		}
+
+		c->flags &= ~KC_SETUP;
+	}
+
+	if (c->flags & KC_DYNAMIC)
+		kfree (c);
+}
+
+void * _cdecl
+kmem_cache_alloc (struct kmem_cache *c)
+{
+	struct kmem_slab *s;
+	void **obj;
+
+	s = c->partial;
+	if (!s)
+	{
+		s = c->empty;
+		if (!s)
+		{
+			s = kmem_cache_grow (c);
+			if (!s)
+			{
+				c->fails++;
+				DEBUG (("kmem_cache_alloc: %s: out of memory", c->name));
+				return NULL;
+			}
+		}
+
+		slab_remove (s);
+		slab_insert (&c->partial, s);
+	}
+
+	obj = s->free;
+	s->free = *obj;
+	*obj = s;
+
+	s->inuse++;
+	if (!s->free)
+	{
+		slab_remove (s);
+		slab_insert (&c->full, s);
+	}
+
+	c->inuse++;
+	c->allocs++;
+
+	return obj + 1;
+}
+
+void _cdecl
+kmem_cache_free (struct kmem_cache *c, void *place)
+{
+	void **obj = (void **) place - 1;
+	struct kmem_slab *s = *obj;
+
+	if (!s || s->cache != c)
+	{
+		ALERT ("kmem_cache_free: %s: %p not allocated from this cache", c->name, place);
+		return;
+	}
+
+	if (!s->free)
+	{
+		slab_remove (s);
+		slab_insert (&c->partial, s);
+	}
+
+	*obj = s->free;
+	s->free = obj;
+
+	c->inuse--;
+	c->frees++;
+
+	if (--s->inuse == 0)
+	{
+		slab_remove (s);
+		slab_insert (&c->empty, s);
+
+		/* keep one empty slab, give back the rest */
+		if (s->next)
+			kmem_cache_shrink (c, s);
+	}
+}
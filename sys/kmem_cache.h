@@ -0,0 +1,82 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Typed object caches (slab allocator) on top of kmalloc.
+ *
+ * A cache hands out objects of one fixed size. Objects are carved
+ * out of slabs (one kmalloc'ed chunk each) and go back to the free
+ * list of their slab on kmem_cache_free; the optional constructor
+ * runs once for every object when its slab is set up, so a freed
+ * object must be returned in its constructed state.
+ *
+ * Kernel internal caches are defined statically with KMEM_CACHE and
+ * set up on their first allocation, modules use kmem_cache_create.
+ */
+
+# ifndef _kmem_cache_h
+# define _kmem_cache_h
+
+# include "mint/mint.h"
+
+
+struct kmem_slab;
+
+struct kmem_cache
+{
+	struct kmem_cache *next;	/* list of all caches */
+	char	name[16];
+	ulong	size;			/* object size as requested */
+	void	_cdecl (*ctor)(void *);	/* constructor or NULL */
+
+	ushort	flags;
+# define KC_SETUP	0x0001		/* objsize/perslab are valid */
+# define KC_DYNAMIC	0x0002		/* from kmem_cache_create */
+	ushort	perslab;		/* objects per slab */
+	ulong	objsize;		/* size including the slab link */
+
+	struct kmem_slab *partial;	/* slabs with used and free objects */
+	struct kmem_slab *empty;	/* completely free slabs */
+	struct kmem_slab *full;		/* completely used slabs */
+
+	/* statistics, see /kern/slabinfo */
+	ulong	inuse;			/* objects allocated */
+	ulong	total;			/* objects in all slabs */
+	ulong	slabs;			/* number of slabs */
+	ulong	allocs;			/* kmem_cache_alloc calls */
+	ulong	frees;			/* kmem_cache_free calls */
+	ulong	grows;			/* slabs allocated */
+	ulong	shrinks;		/* slabs given back */
+	ulong	fails;			/* failed allocations */
+};
+
+# define KMEM_CACHE(var, name, size, ctor) \
+	struct kmem_cache var = { NULL, name, size, ctor }
+
+extern struct kmem_cache *kmem_caches;
+
+struct kmem_cache * _cdecl kmem_cache_create (const char *name, ulong size, void _cdecl (*ctor)(void *));
+void _cdecl kmem_cache_destroy (struct kmem_cache *c);
+void * _cdecl kmem_cache_alloc (struct kmem_cache *c);
+void _cdecl kmem_cache_free (struct kmem_cache *c, void *obj);
+
+extern struct kmem_cache_ops kmem_cache_ops;
+
+
+# endif /* _kmem_cache_h */
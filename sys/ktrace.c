@@ -0,0 +1,254 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - the ring buffer is kmalloc'ed when tracing is first enabled and
+ *   holds a power of two number of records; ktrace_total counts all
+ *   records ever written, its low bits are the write position
+ *
+ * - ktrace_log only writes one record at spl7, so it may be called
+ *   from interrupts; buffer changes (kern.tracesize) swap the buffer
+ *   at spl7 too and free the old one afterwards
+ *
+ * - the readers don't block the writers: /kern/trace copies the ring
+ *   and afterwards drops the records that were overwritten meanwhile
+ *
+ * - timestamps are the 200 Hz tick plus the MFP timer C count down
+ *   (192 steps per tick), like in time.c
+ */
+
+# include "ktrace.h"
+
+# include "global.h"
+
+# include "libkern/libkern.h"
+# include "mint/arch/mfp.h"
+# include "mint/asm.h"
+# include "arch/timer.h"
+
+# include "kmemory.h"
+# include "proc.h"
+# include "syscall_stat.h"
+
+
+# define KTRACE_DEFSIZE	1024	/* default number of records */
+# define KTRACE_MAXSIZE	65536L	/* upper limit for kern.tracesize */
+
+ulong ktrace_mask = 0;
+ulong ktrace_size = KTRACE_DEFSIZE;
+
+static struct ktrace_rec *ktrace_buf = NULL;
+static ulong ktrace_bufsize = 0;	/* records in ktrace_buf */
+static ulong ktrace_total = 0;
+
+struct ktrace_ops ktrace_ops =
+{
+	&ktrace_mask,
+	ktrace_log
+};
+
+
+/* 200 Hz ticks and the 1/192 steps of the current tick */
+INLINE ulong
+read_clock (ulong *sub)
+{
+	ulong ticks;
+	long n;
+
+	do {
+		ticks = *hz_200;
+
+		if (machine == machine_unknown)
+			n = 192;
+		else
+		{
+			n = _mfpregs->tbdr & 0xff;
+			if (n > 192)
+				n = 192;
+		}
+	}
+	while (ticks != *hz_200);
+
+	*sub = 192 - n;
+	return ticks;
+}
+
+/* the same in 1/192 ticks, for measuring short intervals */
+ulong
+ktrace_clock (void)
+{
+	ulong ticks, sub;
+
+	ticks = read_clock (&sub);
+
+	return ticks * 192 + sub;
+}
+
+void _cdecl
+ktrace_log (long event, long arg1, long arg2)
+{
+	struct ktrace_rec *r;
+	struct proc *p;
+	ulong sub;
+	ushort sr;
+
+	sr = spl7 ();
+
+	if (ktrace_buf)
+	{
+		r = &ktrace_buf[ktrace_total & (ktrace_bufsize - 1)];
+		ktrace_total++;
+
+		p = get_curproc ();
+
+		r->ticks = read_clock (&sub);
+		r->sub = sub;
+		r->event = event;
+		r->pid = p ? p->pid : -1;
+		r->arg[0] = arg1;
+		r->arg[1] = arg2;
+	}
+
+	spl (sr);
+}
+
+static long
+ktrace_alloc (ulong size)
+{
+	struct ktrace_rec *buf, *old;
+	ushort sr;
+
+	buf = NULL;
+	if (size)
+	{
+		buf = kmalloc (size * sizeof (*buf));
+		if (!buf)
+			return ENOMEM;
+	}
+
+	sr = spl7 ();
+	old = ktrace_buf;
+	ktrace_buf = buf;
+	ktrace_bufsize = size;
+	ktrace_total = 0;
+	spl (sr);
+
+	if (old)
+		kfree (old);
+
+	return E_OK;
+}
+
+long
+ktrace_setmask (ulong mask)
+{
+	if (mask && !ktrace_buf)
+	{
+		long r = ktrace_alloc (ktrace_size);
+		if (r)
+			return r;
+	}
+
+	ktrace_mask = mask;
+
+	if (mask & KT_SYSCALL)
+		syscall_hooks |= SYSCALL_HOOK_TRACE;
+	else
+		syscall_hooks &= ~SYSCALL_HOOK_TRACE;
+
+	TRACE (("ktrace_setmask: mask %lx, %lu records", mask, ktrace_bufsize));
+	return E_OK;
+}
+
+long
+ktrace_setsize (ulong size)
+{
+	ulong n;
+
+	if (size > KTRACE_MAXSIZE)
+		return EINVAL;
+
+	/* round up to a power of two */
+	for (n = 1; n < size; n <<= 1)
+		;
+
+	ktrace_size = size ? n : 0;
+
+	/* a new buffer also starts a new trace */
+	if (ktrace_buf || ktrace_mask)
+		return ktrace_alloc (ktrace_size);
+
+	return E_OK;
+}
+
+long
+ktrace_read (SIZEBUF **buffer)
+{
+	SIZEBUF *info;
+	struct ktrace_hdr *hdr;
+	struct ktrace_rec *rec;
+	ulong size, total, first, done, skip, i;
+
+	size = ktrace_bufsize;
+
+	info = kmalloc (sizeof (*info) + sizeof (*hdr) + size * sizeof (*rec));
+	if (!info)
+		return ENOMEM;
+
+	hdr = (struct ktrace_hdr *) info->buf;
+	rec = (struct ktrace_rec *) (hdr + 1);
+
+	/* kmalloc doesn't sleep, nobody changed the buffer meanwhile */
+	total = ktrace_total;
+	first = (total > size) ? total - size : 0;
+
+	for (i = first; i < total; i++)
+		rec[i - first] = ktrace_buf[i & (size - 1)];
+
+	/* drop what the interrupts overwrote while we copied */
+	done = ktrace_total;
+	skip = 0;
+	if (done - first > size)
+	{
+		skip = done - first - size;
+		if (skip > total - first)
+			skip = total - first;
+
+		for (i = 0; i < total - first - skip; i++)
+			rec[i] = rec[i + skip];
+	}
+
+	hdr->magic = KTRACE_MAGIC;
+	hdr->version = KTRACE_VERSION;
+	hdr->recsize = sizeof (*rec);
+	hdr->size = size;
+	hdr->count = total - first - skip;
+	hdr->total = done;
+	hdr->mask = ktrace_mask;
+
+	info->len = sizeof (*hdr) + hdr->count * sizeof (*rec);
+
+	*buffer = info;
+	return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Static tracepoints. A disabled tracepoint costs one test of
+ * ktrace_mask; enabled ones append a record to the ring buffer
+ * behind /kern/trace. KTRACE may be used at interrupt level.
+ */
+
+# ifndef _ktrace_h
+# define _ktrace_h
+
+# include "mint/mint.h"
+# include "mint/ktrace.h"
+
+
+# define KTRACE(ev, a1, a2) \
+	do { \
+		if (ktrace_mask & KT_CLASS (ev)) \
+			ktrace_log ((ev), (long) (a1), (long) (a2)); \
+	} while (0)
+
+extern ulong ktrace_mask;
+extern ulong ktrace_size;
+
+extern struct ktrace_ops ktrace_ops;
+
+void _cdecl ktrace_log (long event, long arg1, long arg2);
+long ktrace_setmask (ulong mask);
+long ktrace_setsize (ulong size);
+long ktrace_read (SIZEBUF **buffer);
+ulong ktrace_clock (void);
+
+
+# endif /* _ktrace_h */
@@ -261,6 +261,8 @@ extern struct kentry *kentry;
 #define _f_chdir         (*KENTRY->vec_dos->p_f_chdir)
 #define _f_opendir       (*KENTRY->vec_dos->p_f_opendir)
 #define _f_dirfd         (*KENTRY->vec_dos->p_f_dirfd)
+#define _d_readdirplus   (*KENTRY->vec_dos->p_d_readdirplus)
+#define _p_futex         (*KENTRY->vec_dos->p_p_futex)
 
 INLINE long c_conws(const char *str)
 { return _c_conws(str); }
@@ -688,6 +690,11 @@ check_kentry_version(void)
 #define attach_region      (*KENTRY->vec_mem.attach_region)
 #define detach_region      (*KENTRY->vec_mem.detach_region)
 
+#define kmem_cache_create  (*KENTRY->vec_mem.kmem_cache_create)
+#define kmem_cache_destroy (*KENTRY->vec_mem.kmem_cache_destroy)
+#define kmem_cache_alloc   (*KENTRY->vec_mem.kmem_cache_alloc)
+#define kmem_cache_free    (*KENTRY->vec_mem.kmem_cache_free)
+
 
 /*
  * kentry_fs
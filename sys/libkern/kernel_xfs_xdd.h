@@ -30,6 +30,8 @@
 #define _libkern_kernel_xfs_xdd_h
 
 #include "mint/kerinfo.h"
+#include "mint/ktrace.h"
+#include "mint/workqueue.h"
 
 
 /* Macros for kernel, bios and gemdos functions
@@ -258,6 +260,8 @@ extern struct kerinfo *KERNEL;
 #define _f_chdir         (*KERNEL->dos_tab->p_f_chdir)
 #define _f_opendir       (*KERNEL->dos_tab->p_f_opendir)
 #define _f_dirfd         (*KERNEL->dos_tab->p_f_dirfd)
+#define _d_readdirplus   (*KERNEL->dos_tab->p_d_readdirplus)
+#define _p_futex         (*KERNEL->dos_tab->p_p_futex)
 
 INLINE long c_conws(const char *str)
 { return _c_conws(str); }
@@ -523,5 +527,27 @@ INLINE long p_sysctl(long *name, unsigned long namelen, void *old, unsigned long
 #define load_modules       (*KERNEL->load_modules)
 #define kthread_create     (*KERNEL->kthread_create)
 #define kthread_exit       (*KERNEL->kthread_exit)
+#define kmem_cache_interface ( KERNEL->kmem_cache)
+#define kmem_cache_create  (*KERNEL->kmem_cache->create)
+#define kmem_cache_destroy (*KERNEL->kmem_cache->destroy)
+#define kmem_cache_alloc   (*KERNEL->kmem_cache->alloc)
+#define kmem_cache_free    (*KERNEL->kmem_cache->free)
+/* version 3 kernels only, NULL otherwise */
+#define ktrace_interface   (MINT_KVERSION >= 3 ? KERNEL->ktrace : NULL)
+#define workqueue_interface (MINT_KVERSION >= 3 ? KERNEL->workqueue : NULL)
+#define workqueue_create   (*KERNEL->workqueue->create)
+#define queue_work         (*KERNEL->workqueue->queue_work)
+#define queue_delayed_work (*KERNEL->workqueue->queue_delayed_work)
+#define cancel_work        (*KERNEL->workqueue->cancel_work)
+#define system_wq          (*KERNEL->workqueue->system)
+
+/* static tracepoints, event numbers in mint/ktrace.h;
+ * nothing happens on kernels without them
+ */
+#define KTRACE(ev, a1, a2) \
+	do { \
+		if (ktrace_interface && (*KERNEL->ktrace->mask & KT_CLASS (ev))) \
+			(*KERNEL->ktrace->log)((ev), (long) (a1), (long) (a2)); \
+	} while (0)
 
 #endif /* _libkern_kernel_xfs_xdd_h */
@@ -12,6 +12,7 @@
 # include "memory.h"
 # include "global.h"
 # include "cookie.h"
+# include "exec_cache.h"
 
 # include "libkern/libkern.h"
 # include "mint/basepage.h"
@@ -86,6 +87,10 @@ static unsigned long dp_all = 0;
 
 static long core_malloc(long, short);
 static void core_free(long);
+static long _load_and_reloc (FILEPTR *f, FILEHEAD *fh, char *where, long start,
+			     long nbytes, BASEPAGE *base, struct exec_fixups *fx);
+static void shtext_forget (MEMREGION *text);
+static void shtext_unbase (MEMREGION *base);
 
 # if 1
 # ifdef DEBUG_INFO
@@ -114,6 +119,215 @@ unsigned long initialmem = 1024;	/* ditto */
 # define ISFREE(m) ((m)->links == 0)
 
 
+/*
+ * size indexed free lists
+ *
+ * The free regions of the core and alt maps are kept on segregated
+ * lists as well, one list per power of two of the length in QUANTUMs,
+ * each of them sorted by address like the map itself. _get_region
+ * finds the first (or for kernel allocations the last) fitting free
+ * region there instead of walking all the used regions in between.
+ *
+ * Whoever links a free region into a map, frees a region or changes
+ * the length of a free one has to keep the lists in sync: take the
+ * region off with mfree_remove before and put it back with
+ * mfree_insert afterwards.
+ */
+
+# define MFREE_CLASSES	20
+
+struct mfree
+{
+	MEMREGION *head[MFREE_CLASSES];
+	MEMREGION *tail[MFREE_CLASSES];
+};
+
+static struct mfree mfree_core;
+static struct mfree mfree_alt;
+
+static struct mfree *
+mfree_map (MMAP map)
+{
+	if (map == core)
+		return &mfree_core;
+	if (map == alt)
+		return &mfree_alt;
+
+	return NULL;
+}
+
+static short
+mfree_class (ulong len)
+{
+	register ulong n = len / QUANTUM;
+	register short c = 0;
+
+	while (n > 1 && c < MFREE_CLASSES - 1)
+	{
+		n >>= 1;
+		c++;
+	}
+
+	return c;
+}
+
+static void
+mfree_insert (MEMREGION *m)
+{
+	struct mfree *f;
+	MEMREGION *p;
+	short c;
+
+	if (!ISFREE (m) || !m->len || m->fclass)
+		return;
+
+	f = mfree_map ((m->mflags & M_CORE) ? core : ((m->mflags & M_ALT) ? alt : NULL));
+	if (!f)
+		return;
+
+	c = mfree_class (m->len);
+
+	/* keep the list sorted by address; searching from the end is
+	 * shorter for the regions the kernel gives back at the top
+	 */
+	for (p = f->tail[c]; p && p->loc > m->loc; p = p->fprev)
+		;
+
+	m->fprev = p;
+	if (p)
+	{
+		m->fnext = p->fnext;
+		p->fnext = m;
+	}
+	else
+	{
+		m->fnext = f->head[c];
+		f->head[c] = m;
+	}
+
+	if (m->fnext)
+		m->fnext->fprev = m;
+	else
+		f->tail[c] = m;
+
+	m->fclass = c + 1;
+}
+
+static void
+mfree_remove (MEMREGION *m)
+{
+	struct mfree *f;
+	short c;
+
+	if (!m->fclass)
+		return;
+
+	f = mfree_map ((m->mflags & M_CORE) ? core : alt);
+	c = m->fclass - 1;
+
+	if (m->fprev)
+		m->fprev->fnext = m->fnext;
+	else
+		f->head[c] = m->fnext;
+
+	if (m->fnext)
+		m->fnext->fprev = m->fprev;
+	else
+		f->tail[c] = m->fprev;
+
+	m->fnext = m->fprev = NULL;
+	m->fclass = 0;
+}
+
+/*
+ * Return the free region that ends where "reg" starts and directly
+ * precedes it in the map, or NULL if there is none.
+ */
+static MEMREGION *
+mfree_before (MMAP map, MEMREGION *reg)
+{
+	struct mfree *f = mfree_map (map);
+	MEMREGION *m;
+	short i;
+
+	if (!f)
+	{
+		for (m = *map; m && m->next != reg; m = m->next)
+			;
+
+		if (m && ISFREE (m) && m->loc + m->len == reg->loc)
+			return m;
+
+		return NULL;
+	}
+
+	for (i = 0; i < MFREE_CLASSES; i++)
+	{
+		for (m = f->head[i]; m && m->loc < reg->loc; m = m->fnext)
+		{
+			if (m->loc + m->len == reg->loc)
+				return (m->next == reg) ? m : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Return the free region with at least "size" bytes at the lowest
+ * address or, if "last" is set, at the highest address in the map.
+ */
+static MEMREGION *
+mfree_find (MMAP map, ulong size, short last)
+{
+	struct mfree *f = mfree_map (map);
+	MEMREGION *m, *best = NULL;
+	short c, i;
+
+	if (!f)
+	{
+		/* not indexed, walk the map */
+		for (m = *map; m; m = m->next)
+		{
+			if (ISFREE (m) && m->len >= size)
+			{
+				best = m;
+				if (!last)
+					break;
+			}
+		}
+
+		return best;
+	}
+
+	/* regions in the own class may be too small */
+	c = mfree_class (size);
+	if (last)
+	{
+		for (m = f->tail[c]; m; m = m->fprev)
+			if (m->len >= size)
+				break;
+	}
+	else
+	{
+		for (m = f->head[c]; m; m = m->fnext)
+			if (m->len >= size)
+				break;
+	}
+	best = m;
+
+	/* everything in the bigger classes fits */
+	for (i = c + 1; i < MFREE_CLASSES; i++)
+	{
+		m = last ? f->tail[i] : f->head[i];
+		if (m && (!best || (last ? m->loc > best->loc : m->loc < best->loc)))
+			best = m;
+	}
+
+	return best;
+}
+
+
 /**
  * Initialize memory routines.
  */
@@ -222,7 +436,7 @@ MMAP alt  = &_alt_regions;
 int
 add_region (MMAP map, ulong place, ulong size, ushort mflags)
 {
-  	MEMREGION *m;
+  	MEMREGION *m, **prev;
 	ulong trimsize;
 
 	// Just for testing the lose of Memory
@@ -274,9 +488,16 @@ add_region (MMAP map, ulong place, ulong size, ushort mflags)
 		dp_all += dp_diff;
 		m->len = size;
 		m->loc = place;
-		m->next = *map;
 		m->mflags = mflags;
-		*map = m;
+
+		/* keep the map sorted by address */
+		for (prev = map; *prev && (*prev)->loc < place; prev = &(*prev)->next)
+			;
+
+		m->next = *prev;
+		*prev = m;
+
+		mfree_insert (m);
 	}
 	else
 	{
@@ -536,7 +757,8 @@ retry:
 			mem->addr[i] = reg->loc;
 
 			reg->links++;
-			mark_proc_region (p->p_mem, reg, PROT_P, p->pid);
+			/* nobody writes to shared text */
+			mark_proc_region (p->p_mem, reg, (reg->mflags & M_SHTEXT) ? PROT_PR : PROT_P, p->pid);
 			DEBUG(("attach_region: reg %d, return loc %lx (%lx)", i, reg->loc, mem->addr[i]));
 			return mem->addr[i];
 		}
@@ -728,14 +950,11 @@ _get_region (MMAP map, ulong s, short mode, short cmode, MEMREGION *m, short ker
 		size = ROUND (size);
 	}
 #endif
-	n = *map;
 	if (kernel_flag) {
-		while (n) {
-			if (ISFREE(n) && n->len >= size)
-				k = n;
-			n = n->next;
-		}
+		/* last fit */
+		k = mfree_find (map, size, 1);
 		if (k) {
+			mfree_remove (k);
 			if (k->len == size) {
 				kmr_free(m);
 				n = k;
@@ -750,6 +969,8 @@ _get_region (MMAP map, ulong s, short mode, short cmode, MEMREGION *m, short ker
 				m->len = size;
 				m->loc = k->loc + k->len;
 				n = m;
+
+				mfree_insert (k);
 			}
 			goto win;
 		} else {
@@ -757,31 +978,32 @@ _get_region (MMAP map, ulong s, short mode, short cmode, MEMREGION *m, short ker
 			goto fail;
 		}
 	} else {
-		while (n) {
-			if (ISFREE(n)) {
-				if (n->len == size) {
-					if (m) kmr_free(m);
-					goto win;
-				}
-				if (n->len > size) {
-					if (m) {
-						mint_bzero(m, sizeof(*m));
-						m->mflags = n->mflags & M_MAP;
-
-						m->next = n->next;
-						n->next = m;
-						m->loc = n->loc + size;
-						m->len = n->len - size;
-						n->len = size;
-						assert(n->loc + n->len == m->loc);
-						goto win;
-					} else {
-						DEBUG(("_get_region: no regions left"));
-						goto fail;
-					}
-				}
+		/* first fit */
+		n = mfree_find (map, size, 0);
+		if (n) {
+			if (n->len == size) {
+				mfree_remove (n);
+				if (m) kmr_free(m);
+				goto win;
+			}
+			if (m) {
+				mfree_remove (n);
+				mint_bzero(m, sizeof(*m));
+				m->mflags = n->mflags & M_MAP;
+
+				m->next = n->next;
+				n->next = m;
+				m->loc = n->loc + size;
+				m->len = n->len - size;
+				n->len = size;
+				assert(n->loc + n->len == m->loc);
+
+				mfree_insert (m);
+				goto win;
+			} else {
+				DEBUG(("_get_region: no regions left"));
+				goto fail;
 			}
-			n = n->next;
 		}
 	}
 fail:
@@ -824,6 +1046,9 @@ free_region (MEMREGION *reg)
 
 	assert (ISFREE (reg));
 
+	if (reg->mflags & M_SHTEXT_BASE)
+		shtext_unbase (reg);
+
 	/*
 	 * Check for shadows being present. If the shadow ring is non-empty, free
 	 * the save region of the first member from the shadow region (which is
@@ -913,6 +1138,9 @@ free_region (MEMREGION *reg)
 	else
 		FATAL ("free_region: region flags not valid (%x)", reg->mflags);
 
+	if (reg->mflags & M_SHTEXT)
+		shtext_forget (reg);
+
 	reg->mflags &= M_MAP;
 
 # if 0
@@ -946,8 +1174,22 @@ free_region (MEMREGION *reg)
 	}
 
 	/* merge previous region if it's free and contiguous with 'reg' */
+	if (reg->len)
+	{
+		m = mfree_before (map, reg);
+		if (m)
+		{
+			mfree_remove (m);
+			m->len += reg->len;
+			m->next = reg->next;
+			reg->next = NULL;
+			kmr_free (reg);
+			reg = m;
+		}
+		goto merge_after;
+	}
 
-	/* first, we find the region */
+	/* a zero length descriptor goes away, find the region before it */
 	while (m && m->next != reg)
 		m = m->next;
 
@@ -955,42 +1197,33 @@ free_region (MEMREGION *reg)
 		FATAL ("couldn't find region %lx: loc: %lx len: %ld",
 			(unsigned long)reg, reg->loc, reg->len);
 
-	if (reg->len == 0)
-	{
-		m->next = reg->next;
+	m->next = reg->next;
 
-		reg->next = NULL;
-		kmr_free (reg);
+	reg->next = NULL;
+	kmr_free (reg);
 
-		if (ISFREE (m))
-		{
-			reg = m;
-			goto merge_after;
-		}
-		goto end;
-	}
-
-	if (ISFREE (m) && ((m->loc + m->len) == reg->loc))
+	if (ISFREE (m))
 	{
-		m->len += reg->len;
-		assert(m->next == reg);
-		m->next = reg->next;
-		reg->next = NULL;
-		kmr_free (reg);
 		reg = m;
+		mfree_remove (reg);
+		goto merge_after;
 	}
+	goto end;
 
 merge_after:
 	/* merge next region if it's free and contiguous with 'reg' */
 	m = reg->next;
 	if (m && ISFREE (m) && ((reg->loc + reg->len) == m->loc))
 	{
+		mfree_remove (m);
 		reg->len += m->len;
 		reg->next = m->next;
 		m->next = 0;
 		kmr_free (m);
 	}
 
+	mfree_insert (reg);
+
 end:
 	SANITY_CHECK_MAPS ();
 }
@@ -1067,9 +1300,11 @@ shrink_region (MEMREGION *reg, unsigned long nsize)
 	if (n && ISFREE(n) && reg->loc + reg->len == n->loc)
 	{
 		DEBUG(("shrink_region: newsize %ld, diff %ld", newsize, diff));
+		mfree_remove (n);
 		reg->len = newsize;
 		n->loc -= diff;
 		n->len += diff;
+		mfree_insert (n);
 		/* MEMPROT: invalidate the second half
 		 * (part of it is already invalid; that's OK)
 		 */
@@ -1092,6 +1327,7 @@ shrink_region (MEMREGION *reg, unsigned long nsize)
 		n->mflags = reg->mflags & M_MAP;
 		n->next = reg->next;
 		reg->next = n;
+		mfree_insert (n);
 
 		/* MEMPROT: invalidate the new, free region */
 		mark_region (n, PROT_I, 0);
@@ -1537,6 +1773,212 @@ leave:
 	return m;
 }
 
+/*
+ * Shared text segments.
+ *
+ * Programs with F_SHTEXT set in their prgflags get their TEXT segment
+ * loaded into a region of its own, which is attached to every process
+ * running the same binary; the basepage region only holds the basepage,
+ * DATA and BSS. This only works if no fixup in TEXT refers to DATA or
+ * BSS (e.g. code compiled with -mbaserel), otherwise the program is
+ * loaded the ordinary way.
+ *
+ * The table below maps (dev, inode, mtime/mdate, size) to the loaded
+ * TEXT region. It doesn't hold a link on the region: as soon as the
+ * last process running the program goes away, free_region() drops the
+ * entry. Programs whose TEXT turned out not to be sharable get an entry
+ * without a region, so they aren't relocated for nothing on every exec.
+ * Shared text regions are also M_SHARED, so fork() never copies them.
+ *
+ * Until the program runs, the TEXT is held by the basepage region that
+ * load_region() created, not by the process that loaded it; freeing the
+ * basepage (Mfree after Pexec 3, or the exit of the child) drops it.
+ */
+
+struct shtext
+{
+	struct shtext	*next;
+	MEMREGION	*text;
+	short		dev;
+	long		inode;
+	long		stamp;
+# define MK_STAMP(time, date)	((((long)(date)) << 16) | (time))
+	long		size;
+	FILEHEAD	fh;
+};
+
+static struct shtext *shtexts;
+
+struct shtext_base
+{
+	struct shtext_base	*next;
+	MEMREGION		*base;
+	MEMREGION		*text;
+};
+
+static struct shtext_base *shtext_bases;
+
+static void
+shtext_forget (MEMREGION *text)
+{
+	struct shtext *s, **prev;
+
+	for (prev = &shtexts; (s = *prev) != NULL; prev = &s->next)
+	{
+		if (s->text == text)
+		{
+			*prev = s->next;
+			kfree (s);
+			break;
+		}
+	}
+}
+
+/*
+ * Find or load the shared TEXT of the program open at f. The returned
+ * region has an extra link the caller must drop again (after attaching
+ * it to a process). Returns NULL if the TEXT can't be shared.
+ */
+static MEMREGION *
+get_shtext (FILEPTR *f, const XATTR *xp, FILEHEAD *fh)
+{
+	struct shtext *s, **prev;
+	MEMREGION *text;
+	BASEPAGE tb;
+	long stamp, r;
+
+	if (xp->index == 0 || fh->ftext == 0 || (fh->fdata == 0 && fh->fbss == 0))
+		return NULL;
+
+	stamp = MK_STAMP (xp->mtime, xp->mdate);
+
+	for (prev = &shtexts; (s = *prev) != NULL; prev = &s->next)
+	{
+		if (s->inode != xp->index || s->dev != xp->dev)
+			continue;
+
+		if (s->stamp == stamp && s->size == xp->size
+		    && s->fh.ftext == fh->ftext && s->fh.fdata == fh->fdata
+		    && s->fh.fbss == fh->fbss && s->fh.fsym == fh->fsym
+		    && s->fh.flag == fh->flag)
+		{
+			if (!s->text)
+				return NULL;
+
+			TRACE (("get_shtext: reusing text at %lx", s->text->loc));
+			s->text->links++;
+			return s->text;
+		}
+
+		/* the file was changed; running processes keep the old
+		 * text, new ones get a fresh copy
+		 */
+		DEBUG (("get_shtext: stale shared text at %lx", s->text ? s->text->loc : 0));
+		*prev = s->next;
+		kfree (s);
+		break;
+	}
+
+	s = kmalloc (sizeof (*s));
+	if (!s)
+		return NULL;
+
+	text = NULL;
+	if (fh->flag & F_ALTLOAD)
+		text = get_region (alt, fh->ftext, PROT_S);
+	if (!text)
+		text = get_region (core, fh->ftext, PROT_S);
+	if (!text)
+	{
+		kfree (s);
+		return NULL;
+	}
+
+	/* relocate against a basepage without DATA and BSS;
+	 * _load_and_reloc() rejects any fixup pointing there
+	 */
+	mint_bzero (&tb, sizeof (tb));
+	tb.p_tbase = text->loc;
+	tb.p_tlen = fh->ftext;
+
+	r = _load_and_reloc (f, fh, (char *)text->loc, 0, fh->ftext, &tb, NULL);
+	if (r)
+	{
+		DEBUG (("get_shtext: text not sharable (%ld)", r));
+		text->links--;
+		free_region (text);
+		text = NULL;
+	}
+	else
+	{
+		mark_region (text, PROT_PR, 0);
+		text->mflags |= M_SHTEXT | M_SHARED;
+	}
+
+	s->text = text;
+	s->dev = xp->dev;
+	s->inode = xp->index;
+	s->stamp = stamp;
+	s->size = xp->size;
+	s->fh = *fh;
+	s->next = shtexts;
+	shtexts = s;
+
+	if (text)
+		TRACE (("get_shtext: loaded %ld bytes shared text at %lx", fh->ftext, text->loc));
+	return text;
+}
+
+static void
+put_shtext (MEMREGION *text)
+{
+	text->links--;
+	if (!text->links)
+		free_region (text);
+}
+
+/* drop the TEXT held by a basepage region that is being freed */
+static void
+shtext_unbase (MEMREGION *base)
+{
+	struct shtext_base *sb, **prev;
+
+	base->mflags &= ~M_SHTEXT_BASE;
+
+	for (prev = &shtext_bases; (sb = *prev) != NULL; prev = &sb->next)
+	{
+		if (sb->base == base)
+		{
+			*prev = sb->next;
+			put_shtext (sb->text);
+			kfree (sb);
+			break;
+		}
+	}
+}
+
+/*
+ * Return the shared TEXT region belonging to the program whose basepage
+ * is in "base", or NULL if it has none. Pexec uses this to attach the
+ * TEXT to the new process along with the basepage region.
+ */
+MEMREGION *
+shtext_region (MEMREGION *base)
+{
+	struct shtext_base *sb;
+
+	if (!(base->mflags & M_SHTEXT_BASE))
+		return NULL;
+
+	for (sb = shtext_bases; sb; sb = sb->next)
+	{
+		if (sb->base == base)
+			return sb->text;
+	}
+
+	return NULL;
+}
+
 /**
  * Loads the program with the given file name
  * into a new region, and returns a pointer to that region. On
@@ -1562,6 +2004,14 @@ load_region (const char *filename, MEMREGION *env, const char *cmdlin, XATTR *xp
 	BASEPAGE *b;
 	long size, start;
 	FILEHEAD fh;
+	XATTR xattr;
+	struct exec_image *cached;
+	MEMREGION *text;
+	struct shtext_base *sb = NULL;
+
+	/* the exec cache needs the file attributes */
+	if (!xp)
+		xp = &xattr;
 
 	*err = FP_ALLOC (get_curproc(), &f);
 	if (*err) return NULL;
@@ -1604,18 +2054,45 @@ failed:
 
 	if (fp) *fp = fh.flag;
 
+	text = NULL;
+	if (fh.flag & F_SHTEXT)
+	{
+		sb = kmalloc (sizeof (*sb));
+		if (sb)
+			text = get_shtext (f, xp, &fh);
+		if (!text && sb)
+		{
+			kfree (sb);
+			sb = NULL;
+		}
+	}
+
 	size = fh.ftext + fh.fdata + fh.fbss;
+	if (text)
+		size -= fh.ftext;
 
 	if (env) env->links++;
 	reg = create_base (cmdlin, env, fh.flag, size, err);
 	if (env) env->links--;
 
 	if (!reg)
+	{
+		if (text)
+		{
+			put_shtext (text);
+			kfree (sb);
+		}
 		goto failed;
+	}
 
 	if ((size + 1024) > reg->len)
 	{
 		DEBUG (("load_region: insufficient memory to load"));
+		if (text)
+		{
+			put_shtext (text);
+			kfree (sb);
+		}
 		detach_region (get_curproc(), reg);
 		reg = NULL;
 		*err = ENOMEM;
@@ -1624,9 +2101,18 @@ failed:
 
 	b = (BASEPAGE *)reg->loc;
 	b->p_flags = fh.flag;
-	b->p_tbase = b->p_lowtpa + 256;
-	b->p_tlen = fh.ftext;
-	b->p_dbase = b->p_tbase + b->p_tlen;
+	if (text)
+	{
+		b->p_tbase = text->loc;
+		b->p_tlen = fh.ftext;
+		b->p_dbase = b->p_lowtpa + 256;
+	}
+	else
+	{
+		b->p_tbase = b->p_lowtpa + 256;
+		b->p_tlen = fh.ftext;
+		b->p_dbase = b->p_tbase + b->p_tlen;
+	}
 	b->p_dlen = fh.fdata;
 	b->p_bbase = b->p_dbase + b->p_dlen;
 	b->p_blen = fh.fbss;
@@ -1634,11 +2120,45 @@ failed:
 	size = fh.ftext + fh.fdata;
 	start = 0;
 
-	*err = load_and_reloc (f, &fh, (char *)b + 256, start, size, b);
-	if (*err)
+	if (text)
 	{
-		detach_region (get_curproc(), reg);
-		goto failed;
+		/* TEXT is already there, only DATA needs to be loaded;
+		 * the basepage region keeps the link get_shtext() gave us
+		 */
+		sb->base = reg;
+		sb->text = text;
+		sb->next = shtext_bases;
+		shtext_bases = sb;
+		reg->mflags |= M_SHTEXT_BASE;
+
+		*err = load_and_reloc (f, &fh, (char *)b->p_dbase, fh.ftext, fh.fdata, b);
+		if (*err)
+		{
+			detach_region (get_curproc(), reg);
+			goto failed;
+		}
+	}
+	else if ((cached = exec_cache_lookup (xp, &fh)) != NULL)
+	{
+		exec_cache_load (cached, (char *)b + 256, b);
+		exec_cache_release (cached);
+	}
+	else
+	{
+		struct exec_fixups fx;
+
+		exec_fixups_init (&fx, xp, &fh);
+
+		*err = _load_and_reloc (f, &fh, (char *)b + 256, start, size, b, &fx);
+		if (*err)
+		{
+			exec_fixups_free (&fx);
+			detach_region (get_curproc(), reg);
+			goto failed;
+		}
+
+		exec_cache_enter (xp, &fh, (char *)b + 256, b, &fx);
+		exec_fixups_free (&fx);
 	}
 
 	/* Draco: if the user has set FASTLOAD=YES in the CNF file, the actual
@@ -1697,6 +2217,17 @@ failed:
 
 long
 load_and_reloc (FILEPTR *f, FILEHEAD *fh, char *where, long start, long nbytes, BASEPAGE *base)
+{
+	return _load_and_reloc (f, fh, where, start, nbytes, base, NULL);
+}
+
+/*
+ * As above; if "fx" is non-NULL every applied fixup is recorded
+ * there for the exec cache.
+ */
+static long
+_load_and_reloc (FILEPTR *f, FILEHEAD *fh, char *where, long start, long nbytes, BASEPAGE *base,
+		 struct exec_fixups *fx)
 {
 	uchar c, *next;
 	long r;
@@ -1776,6 +2307,9 @@ load_and_reloc (FILEPTR *f, FILEHEAD *fh, char *where, long start, long nbytes,
 				    return ENOEXEC;
 			}
 			*((long *)(where + fixup - start)) = reloc;
+
+			if (fx)
+				exec_fixups_add (fx, fixup - start);
 		}
 		do {
 			if (!bytes_read)
@@ -2031,27 +2565,39 @@ realloc_region (MEMREGION *reg, long newsize)
 
 		DEBUG(("realloc_region: reg is NULL"));
 
-		for (m = *map; m; m = m->next)
+		if (newsize == -1L)
 		{
-			if (ISFREE(m))
+			for (m = *map; m; m = m->next)
 			{
-				if (newsize == -1L && lastfit
-					&& m->len >= lastfit->len)
-				{
-					lastfit = m;
-				}
-				else if (m->len >= newsize)
+				if (ISFREE(m))
 				{
-					lastfit = m;
+					if (lastfit && m->len >= lastfit->len)
+					{
+						lastfit = m;
+					}
+					else if (m->len >= newsize)
+					{
+						lastfit = m;
+					}
 				}
 			}
 		}
+		else
+			lastfit = mfree_find (map, newsize, 1);
 
 		if (!lastfit)
+		{
+			if (newm) kmr_free (newm);
 			return 0;
+		}
 
 		if (newsize == -1L)
+		{
+			if (newm) kmr_free (newm);
 			return lastfit->len;
+		}
+
+		mfree_remove (lastfit);
 
 		/* if the sizes match exactly, we save a bit of work */
 		if (lastfit->len == newsize)
@@ -2061,12 +2607,17 @@ realloc_region (MEMREGION *reg, long newsize)
 			mark_region (lastfit, PROT_G, 0);
 			return (long) lastfit;
 		}
-		if (!newm) return 0;	/* can't get a new region */
+		if (!newm)
+		{
+			mfree_insert (lastfit);
+			return 0;	/* can't get a new region */
+		}
 
 		/* chop off the top "newsize" bytes from lastfit
 		 * and add it to "newm"
 		 */
 		lastfit->len -= newsize;
+		mfree_insert (lastfit);
 		newm->loc = lastfit->loc + lastfit->len;
 		newm->len = newsize;
 		newm->mflags = lastfit->mflags & M_MAP;
@@ -2115,9 +2666,11 @@ realloc_region (MEMREGION *reg, long newsize)
 			DEBUG(("reg = %p", reg));
 			DEBUG(("loc = %lx", reg->loc));
 
+			mfree_remove (prevptr);
 			prevptr->len += oldsize - newsize;
 			reg->loc += oldsize - newsize;
 			reg->len -= oldsize - newsize;
+			mfree_insert (prevptr);
 
 			mark_region (prevptr, PROT_I, 0);
 			mark_region (reg, PROT_G, 0);
@@ -2154,6 +2707,7 @@ realloc_region (MEMREGION *reg, long newsize)
 		else
 			*map = m;
 		m->next = reg;
+		mfree_insert (m);
 		mark_region (m, PROT_I, 0);
 		mark_region (reg, PROT_G, 0);
 		SANITY_CHECK (map);
@@ -2199,6 +2753,7 @@ realloc_region (MEMREGION *reg, long newsize)
 	{
 		MEMREGION *foo = reg->next;
 
+		mfree_remove (foo);
 		reg->len += foo->len;
 		reg->next = foo->next;
 		kmr_free (foo);
@@ -2212,9 +2767,11 @@ realloc_region (MEMREGION *reg, long newsize)
 
 	if (newsize > oldsize)
 	{
+		mfree_remove (prevptr);
 		reg->loc -= (newsize - oldsize);
 		reg->len += (newsize - oldsize);
 		prevptr->len -= (newsize - oldsize);
+		mfree_insert (prevptr);
 		if (prevptr->len == 0)
 		{
 			/* hmmm, we used up the whole region -- we must dispose of the
@@ -2423,6 +2980,13 @@ sanity_check (MMAP map, ulong line)
 	while (m)
 	{
 		MEMREGION *next = m->next;
+
+		if ((ISFREE (m) && m->len) != (m->fclass != 0)
+			|| (m->fclass && m->fclass - 1 != mfree_class (m->len)))
+		{
+			FATAL ("%s, %lu: FREE LIST INDEX CORRUPTED", __FILE__, line);
+		}
+
 		if (next)
 		{
 			long end = m->loc + m->len;
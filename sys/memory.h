@@ -46,6 +46,7 @@ MEMREGION *load_region (const char *name, MEMREGION *env, const char *cmdlin, XA
 			long *fp, long *err);
 long	load_and_reloc (FILEPTR *f, FILEHEAD *fh, char *where, long start,
 			long nbytes, BASEPAGE *base);
+MEMREGION *shtext_region (MEMREGION *base);
 long	memused (const struct proc *p);
 void	recalc_maxmem (struct proc *p, long size);
 int	valid_address (long addr);
@@ -0,0 +1,110 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Word parallel helpers for allocation bitmaps.
+ *
+ * The filesystems number the bits of their bitmaps differently
+ * (ext2 bytewise little endian, minixfs in native 16 bit words), so
+ * these work on 32 bit words whose bits are already in the bit order
+ * of the bitmap, or on raw memory where the order doesn't matter:
+ * skipping full or empty words and counting set bits.
+ *
+ * Everything is inline; the xfs modules use it as well as the kernel.
+ */
+
+# ifndef _mint_bitmap_h
+# define _mint_bitmap_h
+
+# include "ktypes.h"
+
+
+/* number of set bits */
+INLINE long
+bitmap_weight32 (register __u32 x)
+{
+	x = x - ((x >> 1) & 0x55555555UL);
+	x = (x & 0x33333333UL) + ((x >> 2) & 0x33333333UL);
+	x = (x + (x >> 4)) & 0x0f0f0f0fUL;
+	x = x + (x >> 8);
+	x = x + (x >> 16);
+
+	return x & 0x3f;
+}
+
+/* number of the lowest set bit, 32 if none */
+INLINE long
+bitmap_ffs32 (register __u32 x)
+{
+	register long n = 0;
+
+	if (!x)
+		return 32;
+
+	if (!(x & 0x0000ffffUL)) { n += 16; x >>= 16; }
+	if (!(x & 0x000000ffUL)) { n +=  8; x >>=  8; }
+	if (!(x & 0x0000000fUL)) { n +=  4; x >>=  4; }
+	if (!(x & 0x00000003UL)) { n +=  2; x >>=  2; }
+	if (!(x & 0x00000001UL)) { n +=  1; }
+
+	return n;
+}
+
+/* number of the lowest clear bit, 32 if none */
+INLINE long
+bitmap_ffz32 (register __u32 x)
+{
+	return bitmap_ffs32 (~x);
+}
+
+/* index of the first word in [from, to) that isn't equal to
+ * "pattern" (0 to skip empty, ~0 to skip full words), "to" if none
+ */
+INLINE long
+bitmap_skip (const __u32 *map, long from, long to, __u32 pattern)
+{
+	register const __u32 *p = map + from;
+	register const __u32 *end = map + to;
+
+	while (p < end && *p == pattern)
+		p++;
+
+	return p - map;
+}
+
+/* number of set bits in n words */
+INLINE long
+bitmap_weight (const __u32 *map, long n)
+{
+	register long count = 0;
+
+	while (n--)
+	{
+		register __u32 x = *map++;
+
+		if (x == 0xffffffffUL)
+			count += 32;
+		else if (x)
+			count += bitmap_weight32 (x);
+	}
+
+	return count;
+}
+
+# endif /* _mint_bitmap_h */
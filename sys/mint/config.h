@@ -34,11 +34,6 @@
 # ifndef _mint_config_h
 # define _mint_config_h
 
-/*
- * define if you want a daemon process for sync'ing (otherwise uses timeout)
- */
-# define SYSUPDATE_DAEMON
-
 /*
  * include old style socket device emulation
  */
@@ -275,4 +275,17 @@ struct fs_usage
 # define FS_UNLIMITED	-1
 };
 
+
+# define FS_SYSCTL	0xf102		/* sysctl below CTL_VFS.<drive> */
+
+struct fs_sysctl
+{
+	long	*name;		/* the name below the drive number */
+	unsigned long namelen;
+	void	*oldp;		/* as in Psysctl() */
+	unsigned long *oldlenp;
+	const void *newp;
+	unsigned long newlen;
+};
+
 # endif /* _mint_dcntl_h */
@@ -434,8 +434,8 @@ typedef struct {
 	long _cdecl (*p_f_chdir)(short fd);
 	long _cdecl (*p_f_opendir)(short fd);
 	long _cdecl (*p_f_dirfd)(long handle);
-	long _cdecl (*_res_184)(void);
-	long _cdecl (*_res_185)(void);
+	long _cdecl (*p_d_readdirplus)(long len, long handle, char *buf);
+	long _cdecl (*p_p_futex)(long *addr, long op, long val, long timeout);
 	long _cdecl (*_res_186)(void);
 	long _cdecl (*_res_187)(void);
 	long _cdecl (*_res_188)(void);
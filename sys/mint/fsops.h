@@ -14,6 +14,8 @@
 
 # include "kcompiler.h"
 # include "ktypes.h"
+# include "errno.h"
+# include "stat.h"
 
 
 typedef long fs_ino_t;
@@ -40,6 +42,81 @@ struct dirstruct
 	short	fd;		/* associated fd, for use with dirfd */
 };
 
+/* helpers for readdirplus: readdir puts the name (and in non-TOS
+ * mode the index before it) straight into the record, dirplus_fill
+ * completes it and returns its length
+ */
+# define DIRPLUS_NM(dirh, dp)	\
+	(((dirh)->flags & TOS_SEARCH) ? (dp)->name : (char *) &(dp)->index)
+# define DIRPLUS_NMLEN(dirh)	\
+	(((dirh)->flags & TOS_SEARCH) ? DIRPLUS_NAMEMAX + 1 : DIRPLUS_NAMEMAX + 1 + 4)
+
+INLINE long
+dirplus_fill (DIR *dirh, struct dirplus *dp, long sret)
+{
+	register const char *s = dp->name;
+
+	while (*s)
+		s++;
+
+	if (dirh->flags & TOS_SEARCH)
+		dp->index = 0;
+
+	dp->namelen = s - dp->name;
+	dp->sret = sret;
+	dp->reclen = DIRPLUS_RECLEN (dp->namelen);
+
+	return dp->reclen;
+}
+
+/* the loop of a readdirplus; stat gets the attributes of an entry
+ * and releases its cookie. readdir has moved past an entry it fails
+ * for already, so such an entry is passed on with the error in sret
+ * and ends the batch; if it is the first one, the error is returned.
+ */
+INLINE long
+dirplus_read (DIR *dirh, char *buf, long len,
+	      long _cdecl (*readdir)(DIR *, char *, int, fcookie *),
+	      long _cdecl (*stat)(fcookie *, STAT *))
+{
+	long count = 0;
+
+	while (len >= DIRPLUS_RECMAX)
+	{
+		struct dirplus *dp = (struct dirplus *) buf;
+		fcookie fc;
+		long r;
+
+		dp->name[0] = '\0';
+
+		r = (*readdir)(dirh, DIRPLUS_NM (dirh, dp), DIRPLUS_NMLEN (dirh), &fc);
+		if (r)
+		{
+			if (r == ENMFILES)
+				break;
+
+			if (!count)
+				return r;
+
+			if (dp->name[0])
+			{
+				dirplus_fill (dirh, dp, r);
+				count++;
+			}
+
+			break;
+		}
+
+		r = dirplus_fill (dirh, dp, (*stat)(&fc, &dp->st));
+
+		buf += r;
+		len -= r;
+		count++;
+	}
+
+	return count;
+}
+
 struct devdrv
 {
 	long _cdecl (*open)	(FILEPTR *f);
@@ -92,6 +169,7 @@ struct filesys
 # define FS_EXT_1		0x0200	/* extensions level 1 - mknod & unmount */
 # define FS_EXT_2		0x0400	/* extensions level 2 - additional place at the end */
 # define FS_EXT_3		0x0800	/* extensions level 3 - stat & native UTC timestamps */
+# define FS_EXT_4		0x1000	/* extensions level 4 - readdirplus */
 	
 	/* filesystem functions
 	 */
@@ -128,7 +206,9 @@ struct filesys
 	long	_cdecl (*unmount)	(int drv);
 	long	_cdecl (*stat64)	(fcookie *file, STAT *stat);
 	
-	long	res1, res2, res3;	/* reserved */
+	long	_cdecl (*readdirplus)	(DIR *dirh, char *buf, long len);
+	
+	long	res2, res3;		/* reserved */
 	
 	/* experimental extension
 	 */
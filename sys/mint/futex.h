@@ -0,0 +1,37 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Pfutex(long *addr, long op, long val, long timeout) operations.
+ *
+ * A user space lock keeps its state in a long; only when the lock is
+ * contended the loser calls Pfutex(FUTEX_WAIT) to sleep until the
+ * holder releases it with Pfutex(FUTEX_WAKE). The long can live in
+ * any memory the processes involved share.
+ */
+
+# ifndef _mint_futex_h
+# define _mint_futex_h
+
+
+# define FUTEX_WAIT	0	/* sleep if *addr == val, up to timeout ms (-1: forever) */
+# define FUTEX_WAKE	1	/* wake up to val sleepers on addr */
+
+
+# endif /* _mint_futex_h */
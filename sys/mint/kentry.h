@@ -61,6 +61,7 @@ struct file;
 struct global;
 struct ilock;
 struct kerinfo;
+struct kmem_cache;
 struct memregion;
 struct mfp;
 struct module_callback;
@@ -118,7 +119,7 @@ struct timeval;
  * versions are enough :-)
  */
 #define KENTRY_MAJ_VERSION	0
-#define KENTRY_MIN_VERSION	22
+#define KENTRY_MIN_VERSION	23
 
 /* hardware dependant vector
  */
@@ -358,6 +359,13 @@ struct kentry_mem
 	struct memregion *_cdecl (*addr2mem)(struct proc *p, long addr);
 	long  _cdecl (*attach_region)(struct proc *proc, struct memregion *reg);
 	void  _cdecl (*detach_region)(struct proc *proc, struct memregion *reg);
+
+	/* typed object caches, see kmem_cache.c
+	 */
+	struct kmem_cache *_cdecl (*kmem_cache_create)(const char *name, unsigned long size, void _cdecl (*ctor)(void *));
+	void  _cdecl (*kmem_cache_destroy)(struct kmem_cache *c);
+	void *_cdecl (*kmem_cache_alloc)(struct kmem_cache *c);
+	void  _cdecl (*kmem_cache_free)(struct kmem_cache *c, void *place);
 };
 #define DEFAULTS_kentry_mem \
 { \
@@ -373,6 +381,11 @@ struct kentry_mem
 	addr2mem, \
 	attach_region, \
 	detach_region, \
+	\
+	kmem_cache_create, \
+	kmem_cache_destroy, \
+	kmem_cache_alloc, \
+	kmem_cache_free, \
 }
 
 
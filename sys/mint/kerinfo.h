@@ -23,7 +23,10 @@
 # include "dosvecs.h"
 
 struct basepage;
+struct kmem_cache_ops;
+struct ktrace_ops;
 struct nf_ops;
+struct workqueue_ops;
 
 #define MOD_LOADED	1
 
@@ -324,8 +327,21 @@ struct kerinfo
 	 */
 	ulong	_cdecl	(*remaining_proc_time)(void);
 
-	/* reserved, set to 0 */
-	long	res2 [1];
+	/* typed object caches, see kmem_cache.c
+	 * (NULL on older kernels)
+	 */
+	struct kmem_cache_ops *kmem_cache;
+
+	/* version 3 extension
+	 * the struct ends above on older kernels, test the
+	 * version before looking at these
+	 */
+
+	/* static tracepoints, see ktrace.c */
+	struct ktrace_ops *ktrace;
+
+	/* deferred work on kernel threads, see workqueue.c */
+	struct workqueue_ops *workqueue;
 };
 
 
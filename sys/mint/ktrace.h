@@ -0,0 +1,86 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Binary kernel trace records, as read from /kern/trace.
+ *
+ * The file is a struct ktrace_hdr followed by hdr.count records,
+ * oldest first, all big endian. tools/ktrace decodes it; keep the
+ * numbers there in sync.
+ */
+
+# ifndef _mint_ktrace_h
+# define _mint_ktrace_h
+
+# include "ktypes.h"
+
+
+/* events, the high nibble is the class (one bit in the trace mask) */
+# define KT_CLASS(ev)		(1UL << ((ev) >> 4))
+
+# define KT_SCHED		0x01UL	/* kern.tracemask bits */
+# define KT_SYSCALL		0x02UL
+# define KT_BIO			0x04UL
+# define KT_NET			0x08UL
+
+# define KT_SLEEP		0x01	/* que, cond */
+# define KT_SWITCH		0x02	/* pid of the next process, que */
+# define KT_WAKE		0x03	/* que, cond */
+# define KT_PREEMPT		0x04	/* priority, 0 */
+
+# define KT_SYSENTER		0x11	/* trap << 16 | function, 0 */
+# define KT_SYSEXIT		0x12	/* trap << 16 | function, return value */
+
+# define KT_BIOREAD		0x21	/* drive << 16 | sectors, record */
+# define KT_BIOWRITE		0x22	/* drive << 16 | sectors, record */
+
+# define KT_NETIN		0x31	/* packet length, packet type */
+# define KT_NETOUT		0x32	/* packet length, next hop */
+
+struct ktrace_rec
+{
+	ulong	ticks;		/* 200 Hz timer */
+	uchar	sub;		/* 1/192 of a tick */
+	uchar	event;
+	short	pid;		/* current process, -1 if none */
+	long	arg[2];
+};
+
+# define KTRACE_MAGIC		0x4b545243L	/* 'KTRC' */
+# define KTRACE_VERSION		1
+
+struct ktrace_hdr
+{
+	long	magic;
+	ushort	version;
+	ushort	recsize;	/* sizeof (struct ktrace_rec) */
+	ulong	size;		/* records in the ring buffer */
+	ulong	count;		/* records that follow */
+	ulong	total;		/* records logged since the buffer was set up */
+	ulong	mask;		/* active kern.tracemask */
+};
+
+/* module interface, see kerinfo */
+struct ktrace_ops
+{
+	ulong	*mask;
+	void	_cdecl (*log)(long event, long arg1, long arg2);
+};
+
+# endif /* _mint_ktrace_h */
@@ -74,6 +74,7 @@ typedef long _cdecl (*Func)(void);
  */
 struct dom_ops;
 struct iovec;
+struct kmem_cache;
 struct module_callback;
 struct proc_ext;
 struct sigaction;
@@ -171,6 +172,15 @@ struct dma
 	void	_cdecl (*deblock)	(ulong, void *);
 };
 
+/* typed object caches, see kmem_cache.c */
+struct kmem_cache_ops
+{
+	struct kmem_cache * _cdecl (*create)	(const char *, ulong, void _cdecl (*)(void *));
+	void	_cdecl (*destroy)	(struct kmem_cache *);
+	void *	_cdecl (*alloc)		(struct kmem_cache *);
+	void	_cdecl (*free)		(struct kmem_cache *, void *);
+};
+
 # include "poll.h"
 
 struct sizebuf
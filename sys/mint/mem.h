@@ -31,6 +31,9 @@ struct memregion
         MEMREGION *save;	///< Used to save inactive shadows.
         MEMREGION *shadow;	///< Ring of shadows or 0.
         MEMREGION *next;	///< Next region in memory map.
+        MEMREGION *fnext;	///< Next free region of the same size class.
+        MEMREGION *fprev;	///< Previous free region of the same size class.
+        short		fclass;		///< Size class + 1 while on a free list, else 0.
 };
 
 # define M_CORE		0x0001	///< Region came from core map.
@@ -38,13 +41,13 @@ struct memregion
 # define M_SWAP		0x0004	///< Region came from swap map.
 # define M_KER		0x0008	///< Region came from kernel map.
 # define M_MAP		0x000f	///< AND with this to pick out map
-/* obsolete M_SHTEXT	0x0010	 * region is a shared text region */
+# define M_SHTEXT	0x0010	///< Region is a shared text region
 /* obsolete M_SHTEXT_T	0x0020	 * `sticky bit' for shared text regions */
 # define M_FSAVED	0x0040	///< Region is saved memory of a forked process
 # define M_SHARED	0x0080	///< Region is shared memory region
 # define M_KEEP		0x0100	///< don't free region on process termination
-                     /* 0x0200  unused */
-                     /* 0x0400  unused */
+# define M_SYSVSHM	0x0200	///< Region is a SysV shared memory segment
+# define M_SHTEXT_BASE	0x0400	///< Basepage region holding a link on a shared text region
                      /* 0x0800  unused */
 # define M_UMALLOC	0x1000	///< Region used by umalloc
 # define M_KMALLOC	0x4000	///< Region used by kmalloc
@@ -95,7 +98,7 @@ typedef struct fileheader FILEHEAD;
 					 * rather than the biggest free memory
 					 * block */
 # define F_MEMFLAGS	0xf0		/* reserved for future use */
-/* obsolete F_SHTEXT	0x800		 * program's text may be shared */
+# define F_SHTEXT	0x800		/* program's text may be shared */
 
 # define F_MINALT	0xf0000000L	/* used to decide which type of RAM to load in */
 
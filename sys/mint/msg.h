@@ -33,9 +33,23 @@
 # define _mint_msg_h
 
 # include "ktypes.h"
+# include "ipc.h"
 
 
-struct msqid_ds;
+struct msqid_ds
+{
+	struct ipc_perm	msg_perm;	/* msg queue permission bits */
+	ulong		msg_cbytes;	/* number of bytes in use on the queue */
+	ulong		msg_qnum;	/* number of msgs in the queue */
+	ulong		msg_qbytes;	/* max # of bytes on the queue */
+	short		msg_lspid;	/* pid of last msgsnd() */
+	short		msg_lrpid;	/* pid of last msgrcv() */
+	long		msg_stime;	/* time of last msgsnd() */
+	long		msg_rtime;	/* time of last msgrcv() */
+	long		msg_ctime;	/* time of last msgctl() */
+};
+
+# define MSG_NOERROR	010000	/* don't complain about too long msgs */
 
 
 # endif /* _mint_msg_h */
@@ -266,7 +266,7 @@ struct proc
 
 
 	/* GEMDOS extension: Pmsg() */
-	char	*mb_ptr;		/* p_msg buffer ptr		*/
+	PROC	*mb_next;		/* p_msg wait list		*/
 	long	mb_long1, mb_long2;	/* p_msg storage		*/
 	long	mb_mbid;		/* p_msg id being waited for	*/
 	short	mb_mode;		/* p_msg mode being waiting in	*/
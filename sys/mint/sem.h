@@ -32,7 +32,17 @@
 # include "ktypes.h"
 # include "ipc.h"
 
-union __semun;
+struct semid_ds;
+
+/*
+ * semctl's arg parameter
+ */
+union __semun
+{
+	long		val;		/* value for SETVAL */
+	struct semid_ds	*buf;		/* buffer for IPC_STAT & IPC_SET */
+	ushort		*array;		/* array for GETALL & SETALL */
+};
 
 struct __sem
 {
@@ -81,6 +91,12 @@ struct sembuf
 # define SETVAL		8		/* Set the value of semval to arg.val {ALTER} */
 # define SETALL		9		/* Set semvals from arg.array {ALTER} */
 
+/*
+ * commands for semconfig
+ */
+# define SEM_CONFIG_FREEZE	0	/* freeze internal state */
+# define SEM_CONFIG_THAW	1	/* thaw internal state */
+
 /*
  * semaphore info struct
  */
@@ -33,9 +33,31 @@
 # define _mint_shm_h
 
 # include "ktypes.h"
+# include "ipc.h"
 
 
-struct shmid_ds;
+struct shmid_ds
+{
+	struct ipc_perm	shm_perm;	/* operation permission structure */
+	long		shm_segsz;	/* size of segment in bytes */
+	short		shm_lpid;	/* process ID of last shm op */
+	short		shm_cpid;	/* process ID of creator */
+	short		shm_nattch;	/* number of current attaches */
+	short		_pad;
+	long		shm_atime;	/* time of last shmat() */
+	long		shm_dtime;	/* time of last shmdt() */
+	long		shm_ctime;	/* time of last change by shmctl() */
+	
+	/*
+	 * This member is private and used only in the internal
+	 * implementation of this interface.
+	 */
+	void		*_shm_internal;
+};
+
+# define SHM_RDONLY	010000	/* attach read-only (else read-write) */
+# define SHM_RND	020000	/* round attach address to SHMLBA */
+# define SHMLBA		4	/* segment low boundary address multiple */
 
 
 # endif /* _mint_shm_h */
@@ -58,6 +58,24 @@ struct stat
 	long		res[7];		/* sizeof = 128 bytes */
 };
 
+/* record filled in by Dreaddirplus; records follow each other
+ * directly, reclen is always a multiple of 4
+ */
+struct dirplus
+{
+	ushort		reclen;		/* length of this record */
+	ushort		namelen;	/* length of name, without the '\0' */
+	long		sret;		/* result of the stat, E_OK if st is valid */
+	struct stat	st;		/* attributes, links are not followed */
+	long		index;		/* file index, 0 in TOS mode */
+	char		name[4];	/* '\0' terminated, padded */
+};
+
+# define DIRPLUS_NAMEMAX	255
+# define DIRPLUS_HDRSIZE	(sizeof (struct dirplus) - 4)
+# define DIRPLUS_RECLEN(n)	((DIRPLUS_HDRSIZE + (n) + 1 + 3) & ~3)
+# define DIRPLUS_RECMAX		DIRPLUS_RECLEN (DIRPLUS_NAMEMAX)
+
 
 /* file types */
 # define S_IFMT		0170000		/* file type mask */
@@ -92,7 +92,8 @@ struct ctlname
 # define CTL_DEBUG	4		/* debugging parameters */
 # define CTL_PROC	5		/* per-proc attr */
 # define CTL_KBD	6		/* keyboard configuration */
-# define CTL_MAXID	7		/* number of valid top-level ids */
+# define CTL_VFS	7		/* filesystem, per drive */
+# define CTL_MAXID	8		/* number of valid top-level ids */
 
 # define CTL_NAMES \
 { \
@@ -103,6 +104,7 @@ struct ctlname
 	{ "debug", CTLTYPE_NODE }, \
 	{ "proc", CTLTYPE_NODE }, \
 	{ "keyboard", CTLTYPE_NODE }, \
+	{ "vfs", CTLTYPE_NODE }, \
 }
 
 
@@ -124,7 +126,15 @@ struct ctlname
 # define KERN_BOOTTIME		13	/* struct: time kernel was booted */
 # define KERN_INITIALTPA	14	/* int: max TPA size of a process */
 # define KERN_SYSDIR		15	/* the system directory */
-# define KERN_MAXID		16	/* number of valid kern ids */
+# define KERN_EXECCACHE		16	/* int: size of the exec image cache */
+# define KERN_MSGMAX		17	/* int: max size of a SysV message */
+# define KERN_MSGMNB		18	/* int: default max bytes of a SysV msg queue */
+# define KERN_MSGMNI		19	/* int: max number of SysV msg queues */
+# define KERN_MSGTQL		20	/* int: max number of SysV messages */
+# define KERN_TRACEMASK		21	/* int: enabled kernel trace classes */
+# define KERN_TRACESIZE		22	/* int: records in the kernel trace buffer */
+# define KERN_SYSCALLSTAT	23	/* int: syscall statistics on, set resets */
+# define KERN_MAXID		24	/* number of valid kern ids */
 
 # define CTL_KERN_NAMES \
 { \
@@ -144,6 +154,14 @@ struct ctlname
 	{ "boottime", CTLTYPE_STRUCT }, \
 	{ "initialtpa", CTLTYPE_LONG }, \
 	{ "sysdir", CTLTYPE_STRING }, \
+	{ "execcache", CTLTYPE_LONG }, \
+	{ "msgmax", CTLTYPE_LONG }, \
+	{ "msgmnb", CTLTYPE_LONG }, \
+	{ "msgmni", CTLTYPE_LONG }, \
+	{ "msgtql", CTLTYPE_LONG }, \
+	{ "tracemask", CTLTYPE_LONG }, \
+	{ "tracesize", CTLTYPE_LONG }, \
+	{ "syscallstat", CTLTYPE_LONG }, \
 }
 
 
@@ -222,6 +240,12 @@ struct ctlname
 }
 
 
+/*
+ * CTL_VFS subtype. The drive number (0 = A:), the rest of the name
+ * is passed to the filesystem on that drive (FS_SYSCTL).
+ */
+
+
 # ifndef __KERNEL__
 
 int __sysctl(int *name, unsigned long namelen, void *old, unsigned long *oldlenp,
@@ -0,0 +1,68 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Deferred work, run by kernel threads (see workqueue.c).
+ *
+ * A struct work is usually embedded in the owner's data; the function
+ * gets the work pointer back. A work item is on at most one queue at
+ * a time, queueing it again while it is pending does nothing.
+ */
+
+# ifndef _mint_workqueue_h
+# define _mint_workqueue_h
+
+# include "ktypes.h"
+
+
+struct workqueue;
+
+struct work
+{
+	struct work	*next;
+	void		_cdecl (*func)(struct work *);
+	struct workqueue *wq;		/* queue it was last queued on */
+	TIMEOUT		*timer;		/* pending queue_delayed_work */
+	ulong		stamp;		/* when it was queued */
+	ushort		flags;
+# define WORK_PENDING	0x0001		/* on the queue */
+# define WORK_DELAYED	0x0002		/* timer running */
+	ushort		res;
+};
+
+# define INIT_WORK(w, f) \
+	do { \
+		(w)->next = NULL; \
+		(w)->func = (f); \
+		(w)->wq = NULL; \
+		(w)->timer = NULL; \
+		(w)->flags = 0; \
+	} while (0)
+
+/* module interface, see kerinfo */
+struct workqueue_ops
+{
+	struct workqueue * _cdecl (*create)(const char *name, short pri, short nthreads);
+	long	_cdecl (*queue_work)(struct workqueue *wq, struct work *w);
+	long	_cdecl (*queue_delayed_work)(struct workqueue *wq, struct work *w, long ms);
+	long	_cdecl (*cancel_work)(struct work *w);
+	struct workqueue **system;	/* the shared default queue */
+};
+
+# endif /* _mint_workqueue_h */
@@ -36,6 +36,7 @@
 # include "filesys.h"
 # include "k_exit.h"
 # include "kmemory.h"
+# include "ktrace.h"
 # include "memory.h"
 # include "proc_help.h"
 # include "proc_wakeup.h"
@@ -364,6 +365,8 @@ preempt(void)
 			curproc->curpri -= 1;
 	}
 
+	KTRACE(KT_PREEMPT, curproc->curpri, 0);
+
 	sleep(READY_Q, curproc->wait_cond);
 }
 
@@ -496,6 +499,8 @@ sleep(int _que, long cond)
 	unsigned long onsigs = curproc->nsigs;
 	int newslice = 1;
 
+	KTRACE(KT_SLEEP, _que, cond);
+
 	/* save condition, checkbttys may just wake() it right away ...
 	 * note this assumes the condition will never be waked from interrupts
 	 * or other than thru wake() before we really went to sleep, otherwise
@@ -643,6 +648,9 @@ sleep(int _que, long cond)
 	 * save per-process variables here
 	 */
 	curproc->ctxt[CURRENT].regs[0] = 1;
+
+	KTRACE(KT_SWITCH, p->pid, que);
+
 	curproc = p;
 
 	proc_clock = time_slice;			/* fresh time */
@@ -712,6 +720,8 @@ wake(int que, long cond)
 	if (sleepcond == cond)
 		sleepcond = 0;
 
+	KTRACE(KT_WAKE, que, cond);
+
 	do_wake(que, cond);
 }
 
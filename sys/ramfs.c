@@ -289,6 +289,7 @@ static long	_cdecl ram_rename	(fcookie *olddir, char *oldname, fcookie *newdir,
 
 static long	_cdecl ram_opendir	(DIR *dirh, int flags);
 static long	_cdecl ram_readdir	(DIR *dirh, char *nm, int nmlen, fcookie *);
+static long	_cdecl ram_readdirplus	(DIR *dirh, char *buf, long len);
 static long	_cdecl ram_rewinddir	(DIR *dirh);
 static long	_cdecl ram_closedir	(DIR *dirh);
 
@@ -325,6 +326,7 @@ FILESYS ramfs_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_LONGPATH		|
@@ -333,7 +335,8 @@ FILESYS ramfs_filesys =
 	FS_REENTRANT_L1		|
 	FS_REENTRANT_L2		|
 	FS_EXT_2		|
-	FS_EXT_3		,
+	FS_EXT_3		|
+	FS_EXT_4		,
 
 	root:			ram_root,
 	lookup:			ram_lookup,
@@ -374,7 +377,9 @@ FILESYS ramfs_filesys =
 
 	/* FS_EXT_3 */
 	stat64:			ram_stat64,
-	res1:			0,
+
+	/* FS_EXT_4 */
+	readdirplus:		ram_readdirplus,
 	res2:			0,
 	res3:			0,
 
@@ -1521,6 +1526,67 @@ ram_readdir (DIR *dirh, char *nm, int nmlen, fcookie *fc)
 	return r;
 }
 
+/* walk the directory list directly; no cookie is handed out
+ * and nothing has to be released per entry. A name that doesn't
+ * fit into a record ends the batch; as the first entry it is
+ * skipped and ENAMETOOLONG returned, like readdir does.
+ */
+static long _cdecl
+ram_readdirplus (DIR *dirh, char *buf, long len)
+{
+	union { char *c; DIRLST **d;} ptr;
+	DIRLST *l;
+	long count = 0;
+	long r;
+
+	ptr.c = dirh->fsstuff;
+	l = *ptr.d;
+
+	while (l && len >= DIRPLUS_RECMAX)
+	{
+		struct dirplus *dp = (struct dirplus *) buf;
+		fcookie fc;
+
+		if (l->len > DIRPLUS_NAMEMAX + 1)
+		{
+			if (count)
+				break;
+
+			RAM_DEBUG (("ramfs: ram_readdirplus: name too long: %s", l->name));
+
+			l->lock = 0;
+			l = __dir_next ((COOKIE *) dirh->fc.index, l);
+			if (l) l->lock = 1;
+			*ptr.d = l;
+
+			return ENAMETOOLONG;
+		}
+
+		l->lock = 0;
+
+		strcpy (dp->name, l->name);
+		dp->index = (dirh->flags & TOS_SEARCH) ? 0 : (long) l->cookie;
+
+		fc.fs = &ramfs_filesys;
+		fc.dev = l->cookie->stat.dev;
+		fc.aux = 0;
+		fc.index = (long) l->cookie;
+
+		r = dirplus_fill (dirh, dp, ram_stat64 (&fc, &dp->st));
+		buf += r;
+		len -= r;
+		count++;
+
+		l = __dir_next ((COOKIE *) dirh->fc.index, l);
+		if (l) l->lock = 1;
+	}
+
+	*ptr.d = l;
+
+	RAM_DEBUG (("ramfs: ram_readdirplus: %li entries", count));
+	return count;
+}
+
 static long _cdecl
 ram_rewinddir (DIR *dirh)
 {
@@ -99,6 +99,10 @@ dosleep:
  * need to remember what somebody else wrote to you, and the mode field for
  * what kind of operation you're doing (read, write, write/read).
  *
+ * Blocked readers and writers are kept on wait lists hashed by mbid
+ * (linked through mb_next, oldest first), so finding the other end of a
+ * rendezvous doesn't depend on the number of processes in the system.
+ *
  * The beauty of this is that mailboxes don't need to be created or
  * destroyed, and the blocking and turnaround are atomic, and it's a way to
  * do rendezvous and interprocess communication without lots of system
@@ -116,12 +120,47 @@ dosleep:
 # include "rendez.h"
 
 # include "mint/asm.h"
+# include "mint/futex.h"
 
 # include "kmemory.h"
 # include "proc.h"
 # include "timeout.h"
 
 
+# define MB_HASH	32
+# define MB_BUCKET(mbid)	((((ulong) (mbid) >> 16) ^ (ulong) (mbid)) & (MB_HASH - 1))
+
+static PROC *mb_hash[MB_HASH];
+
+/* put p on the wait list of p->mb_mbid */
+static void
+mb_enqueue(PROC *p)
+{
+    PROC **q;
+
+    for (q = &mb_hash[MB_BUCKET(p->mb_mbid)]; *q; q = &(*q)->mb_next)
+	;
+
+    p->mb_next = NULL;
+    *q = p;
+}
+
+/* take the oldest reader (or writer) of mbid off its wait list */
+static PROC *
+mb_dequeue(long mbid, int reader)
+{
+    PROC *p, **q;
+
+    for (q = &mb_hash[MB_BUCKET(mbid)]; (p = *q); q = &p->mb_next) {
+	if (p->mb_mbid == mbid && (reader ? p->mb_mode == 0 : p->mb_mode > 0)) {
+	    *q = p->mb_next;
+	    return p;
+	}
+    }
+
+    return NULL;
+}
+
 long _cdecl
 sys_p_msg(int mode, long mbid, char *ptr)
 {
@@ -135,25 +174,19 @@ sys_p_msg(int mode, long mbid, char *ptr)
 
     if (mode == 0) {
 	/* read */
-	/* walk the whole process list looking for a writer */
-	for (p = proclist; p; p = p->gl_next) {
-	    if ((p->mb_mode == 1 || p->mb_mode == 2) && p->mb_mbid == mbid) {
-		/* this process is trying to write this mbox */
-		goto got_rendezvous;
-	    }
-	}
+	/* look for a writer waiting on this mbox */
+	p = mb_dequeue(mbid, 0);
+	if (p)
+	    goto got_rendezvous;
 	/* nobody is writing just now */
 	goto dosleep;
     }
     else if (mode == 1 || mode == 2) {
 	/* write, or write/read */
-	/* walk the whole process list looking for a reader */
-	for (p = proclist; p; p = p->gl_next) {
-	    if (p->mb_mode == 0 && p->mb_mbid == mbid) {
-		/* this process is reading this mbox */
-		goto got_rendezvous;
-	    }
-	}
+	/* look for a reader waiting on this mbox */
+	p = mb_dequeue(mbid, 1);
+	if (p)
+	    goto got_rendezvous;
 	/* nobody is reading just now */
 	get_curproc()->mb_long1 = *(long *)ptr;	/* copy the message */
 	get_curproc()->mb_long2 = *(long *)(ptr+4);	/* into my proc struct */
@@ -179,6 +212,7 @@ got_rendezvous:
 	     */
 	    p->mb_mbid = 0xFFFF0000L | p->pid;
 	    p->mb_mode = 0;
+	    mb_enqueue(p);
 	}
 	else {
 	    short sr = spl7();
@@ -232,6 +266,7 @@ dosleep:
 	}
 	get_curproc()->mb_mbid = mbid;	/* and ID waited for */
 	get_curproc()->mb_mode = mode;	/* save mode */
+	mb_enqueue(get_curproc());
 
 /*
  * OK: now we sleep until a rendezvous has occured. The loop is because we
@@ -262,6 +297,30 @@ dosleep:
 	return 0;
 }
 
+/*
+ * Take a terminating process off the Pmsg wait lists. This function
+ * is called from terminate() during process termination.
+ */
+void
+free_mbox(PROC *p)
+{
+	PROC **q;
+
+	if (p->mb_mode < 0)
+		return;
+
+	for (q = &mb_hash[MB_BUCKET(p->mb_mbid)]; *q; q = &(*q)->mb_next)
+	{
+		if (*q == p)
+		{
+			*q = p->mb_next;
+			break;
+		}
+	}
+
+	p->mb_mode = -1;
+}
+
 /*
  * more mutex: this time a semaphore.
  *
@@ -325,7 +384,29 @@ struct sema
 	short owner; /* -1 means "available" */
 };
 
-static struct sema *semalist;
+/*
+ * Semaphores are hashed by id; processes waiting for one sleep on
+ * the address of its struct sema, so a release only wakes the
+ * waiters of that semaphore.
+ */
+# define SEMA_HASH	32
+# define SEMA_BUCKET(id)	((((ulong) (id) >> 16) ^ (ulong) (id)) & (SEMA_HASH - 1))
+
+static struct sema *semahash[SEMA_HASH];
+
+static struct sema **
+sema_lookup(long id)
+{
+	struct sema **q;
+
+	for (q = &semahash[SEMA_BUCKET(id)]; *q; q = &(*q)->next)
+	{
+		if ((*q)->id == id)
+			break;
+	}
+
+	return q;
+}
 
 long _cdecl
 sys_p_semaphore(int mode, long id, long timeout)
@@ -336,15 +417,13 @@ sys_p_semaphore(int mode, long id, long timeout)
 	{
 		case 0:	/* create */
 		{
-			struct sema *s;
+			struct sema *s, **q;
 
-			for (s = semalist; s; s = s->next)
+			q = sema_lookup(id);
+			if (*q)
 			{
-				if (s->id == id)
-				{
-					DEBUG(("Psemaphore(%d,%lx): already exists", mode, id));
-					return EACCES;
-				}
+				DEBUG(("Psemaphore(%d,%lx): already exists", mode, id));
+				return EACCES;
 			}
 
 			/* get a new one */
@@ -354,8 +433,8 @@ sys_p_semaphore(int mode, long id, long timeout)
 
 			s->id = id;
 			s->owner = get_curproc()->pid;
-			s->next = semalist;
-			semalist = s;
+			s->next = NULL;
+			*q = s;
 
 			return E_OK;
 		}
@@ -364,54 +443,54 @@ sys_p_semaphore(int mode, long id, long timeout)
 			TIMEOUT *timeout_ptr = NULL;
 			struct sema *s;
 loop:
-			for (s = semalist; s; s = s->next)
+			s = *sema_lookup(id);
+			if (s)
 			{
-				if (s->id == id)
+				/* found your semaphore */
+				if (s->owner == get_curproc()->pid)
 				{
-					/* found your semaphore */
-					if (s->owner == get_curproc()->pid)
-					{
-						DEBUG(("Psemaphore(%d,%lx): curproc already owns it!",
-							mode, id));
-						return EERROR;
-					}
+					DEBUG(("Psemaphore(%d,%lx): curproc already owns it!",
+						mode, id));
+					return EERROR;
+				}
 
-					if (s->owner == -1)
+				if (s->owner == -1)
+				{
+					/* it's free; you get it */
+					s->owner = get_curproc()->pid;
+					if (timeout_ptr)
+						canceltimeout(timeout_ptr);
+					
+					return 0;
+				}
+				else
+				{
+					/* not free */
+					if (timeout == 0)
 					{
-						/* it's free; you get it */
-						s->owner = get_curproc()->pid;
-						if (timeout_ptr)
-							canceltimeout(timeout_ptr);
-						
-						return 0;
+						/* non-blocking mode */
+						return EACCES;
 					}
 					else
 					{
-						/* not free */
-						if (timeout == 0)
+						if (timeout != -1 && !timeout_ptr)
 						{
-							/* non-blocking mode */
-							return EACCES;
+							/* schedule a timeout */
+							timeout_ptr = addtimeout(get_curproc(), timeout, unsemame);
 						}
-						else
+
+						/* block until it's released, then try again;
+						 * `s' may be gone when we wake up
+						 */
+						sleep(WAIT_Q, (long) s);
+						if (get_curproc()->wait_cond != (long) s)
 						{
-							if (timeout != -1 && !timeout_ptr)
-							{
-								/* schedule a timeout */
-								timeout_ptr = addtimeout(get_curproc(), timeout, unsemame);
-							}
-
-							/* block until it's released, then try again */
-							sleep(WAIT_Q, WAIT_SEMA);
-							if (get_curproc()->wait_cond != WAIT_SEMA)
-							{
-								TRACE(("Psemaphore(%d,%lx) timed out",
-									mode, id));
-								return EACCES;
-							}
-							
-							goto loop;
+							TRACE(("Psemaphore(%d,%lx) timed out",
+								mode, id));
+							return EACCES;
 						}
+						
+						goto loop;
 					}
 				}
 			}
@@ -429,43 +508,34 @@ loop:
 		{
 			struct sema *s, **q;
 
-			/*
-			 * Style note: this is a handy way to chain down a linked list.
-			 * q follows along behind s pointing at the "next" field of the
-			 * previous list element.  To start, q points to the semalist
-			 * variable itself.  At all times, then, *q is the place to
-			 * write s->next when you want to remove an element 's' from
-			 * the list.
-			 */
-			for (s = *(q = &semalist); s; s = *(q = &s->next))
+			q = sema_lookup(id);
+			s = *q;
+			if (s)
 			{
-				if (s->id == id)
-				{
-					/* found your semaphore */
+				/* found your semaphore */
 
-					if (s->owner != get_curproc()->pid
-					    && s->owner != -1)
-					{
-						DEBUG(("Psemaphore(%d,%lx): access denied, locked by pid %i",
-							mode, id, s->owner));
-						return EACCES;
-					}
-
-					if (mode == 3)
-					{
-						s->owner = -1;	/* make it free */
-					}
-					else
-					{
-						*q = s->next;	/* delete from list */
-						kfree(s);	/* and free it */
-					}
+				if (s->owner != get_curproc()->pid
+				    && s->owner != -1)
+				{
+					DEBUG(("Psemaphore(%d,%lx): access denied, locked by pid %i",
+						mode, id, s->owner));
+					return EACCES;
+				}
 
-					/* wake up anybody who's waiting for a semaphore */
-					wake(WAIT_Q, WAIT_SEMA);
+				/* wake up anybody who's waiting for this semaphore */
+				wake(WAIT_Q, (long) s);
 
-					return E_OK;
+				if (mode == 3)
+				{
+					s->owner = -1;	/* make it free */
+				}
+				else
+				{
+					*q = s->next;	/* delete from list */
+					kfree(s);	/* and free it */
 				}
+
+				return E_OK;
 			}
 
 			/* no such semaphore */
@@ -486,23 +556,170 @@ loop:
 void
 free_semaphores(int pid)
 {
-	int didsomething = 0;
 	struct sema *s;
+	int i;
+
+	for (i = 0; i < SEMA_HASH; i++)
+	{
+		for (s = semahash[i]; s; s = s->next)
+		{
+			if (s->owner == pid)
+			{
+				s->owner = -1; /* mark the semaphore as free */
+
+				/* wake up anybody waiting for it */
+				wake(WAIT_Q, (long) s);
+			}
+		}
+	}
+}
+
+/*
+ * long Pfutex(long *addr, long op, long val, long timeout)
+ *
+ * Wait/wake on an address, for user space locks that only enter the
+ * kernel when they are contended.
+ *
+ * FUTEX_WAIT: if *addr still contains val, sleep until somebody calls
+ * FUTEX_WAKE on addr (returns 0), the timeout in milliseconds expires
+ * (ETIMEDOUT; -1 waits forever) or a signal arrives (EINTR). If *addr
+ * has changed already, return EAGAIN at once.
+ *
+ * FUTEX_WAKE: wake up at most val processes waiting on addr, oldest
+ * first; returns the number of processes woken.
+ *
+ * There is no address translation, so the address alone identifies
+ * the lock for all processes. The kernel isn't preemptive: nobody
+ * can change *addr between the test and going to sleep in the kernel,
+ * and the waiter records live on the stack of the sleeping process;
+ * terminate() unlinks them through free_futex() when a sleeper is
+ * killed.
+ */
+
+struct futex_waiter
+{
+	struct futex_waiter *next;
+	struct proc *p;
+	long *addr;
+	short woken;
+};
+
+# define FUTEX_HASH	32
+# define FUTEX_BUCKET(addr)	(((ulong) (addr) >> 2) & (FUTEX_HASH - 1))
+
+static struct futex_waiter *futex_hash[FUTEX_HASH];
+
+static void
+futex_unlink(struct futex_waiter *w)
+{
+	struct futex_waiter **q;
+
+	for (q = &futex_hash[FUTEX_BUCKET(w->addr)]; *q; q = &(*q)->next)
+	{
+		if (*q == w)
+		{
+			*q = w->next;
+			break;
+		}
+	}
+}
 
-	for (s = semalist; s; s = s->next)
+/* in case we were killed while blocked in Pfutex */
+void
+free_futex(PROC *p)
+{
+	struct futex_waiter *w, **q;
+	int i;
+
+	for (i = 0; i < FUTEX_HASH; i++)
 	{
-		if (s->owner == pid)
+		for (q = &futex_hash[i]; (w = *q) != NULL; )
 		{
-			s->owner = -1; /* mark the semaphore as free */
-			didsomething = 1;
+			if (w->p == p)
+				*q = w->next;
+			else
+				q = &w->next;
 		}
 	}
+}
 
-	if (didsomething)
+long _cdecl
+sys_p_futex(long *addr, long op, long val, long timeout)
+{
+	TRACELOW(("Pfutex(%p,%ld,%lx,%ld)", addr, op, val, timeout));
+
+	if (!addr || ((long) addr & 1))
+		return EINVAL;
+
+	switch (op)
 	{
-		/* wake up anybody waiting for a semaphore, in case it's one of
-		 * the ones we just freed
-		 */
-		wake(WAIT_Q, WAIT_SEMA);
+		case FUTEX_WAIT:
+		{
+			struct futex_waiter w, **q;
+			TIMEOUT *timeout_ptr = NULL;
+			long r;
+
+			if (*addr != val)
+				return EAGAIN;
+
+			if (timeout == 0)
+				return ETIMEDOUT;
+
+			/* append, so FUTEX_WAKE goes oldest first */
+			w.next = NULL;
+			w.p = get_curproc();
+			w.addr = addr;
+			w.woken = 0;
+
+			for (q = &futex_hash[FUTEX_BUCKET(addr)]; *q; q = &(*q)->next)
+				;
+			*q = &w;
+
+			if (timeout > 0)
+				timeout_ptr = addtimeout(get_curproc(), timeout, unsemame);
+
+			sleep(WAIT_Q, (long) &w);
+
+			if (timeout_ptr)
+				canceltimeout(timeout_ptr);
+
+			if (w.woken)
+				r = E_OK;
+			else
+			{
+				futex_unlink(&w);
+
+				if (get_curproc()->wait_cond != (long) &w)
+					r = ETIMEDOUT;
+				else
+					r = EINTR;
+			}
+
+			return r;
+		}
+		case FUTEX_WAKE:
+		{
+			struct futex_waiter *w, **q;
+			long n = 0;
+
+			q = &futex_hash[FUTEX_BUCKET(addr)];
+			while (n < val && (w = *q))
+			{
+				if (w->addr == addr)
+				{
+					*q = w->next;
+					w->woken = 1;
+					wake(WAIT_Q, (long) w);
+					n++;
+				}
+				else
+					q = &w->next;
+			}
+
+			return n;
+		}
 	}
+
+	DEBUG(("Pfutex: invalid op %ld", op));
+	return ENOSYS;
 }
@@ -12,6 +12,9 @@
 long _cdecl sys_p_msg (int mode, long mbid, char *ptr);
 long _cdecl sys_p_semaphore (int mode, long id, long timeout);
 void free_semaphores (int pid);
+void free_mbox (PROC *p);
+void free_futex (PROC *p);
+long _cdecl sys_p_futex (long *addr, long op, long val, long timeout);
 
 
 # endif /* _rendez_h */
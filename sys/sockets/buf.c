@@ -32,11 +32,14 @@ static short	buf_free_block	(void);
 static long failed_allocs = 0;
 static long mem_used = 0;
 static BUF pool[BUF_NSPLIT+1];
-static TIMEOUT *tmout = NULL;
 
+/* both run on system_wq, not from the timeout list */
+static struct work gc_work;
+static struct work addmem_work;
 
-static void
-gc (PROC *proc, long arg)
+
+static void _cdecl
+gc (struct work *w)
 {
 	long mem = mem_used;
 	
@@ -50,13 +53,12 @@ gc (PROC *proc, long arg)
 			mem/1024, mem_used/1024));
 	}
 	
-	addroottimeout (GC_TIMEOUT, gc, 0);
+	queue_delayed_work (system_wq, w, GC_TIMEOUT);
 }
 
-static void
-addmem (PROC *proc, long arg)
+static void _cdecl
+addmem (struct work *w)
 {
-	tmout = 0;
 	buf_add_block ();
 }
 
@@ -83,11 +85,8 @@ buf_add_block (void)
 	mem_used += new->buflen;
 	spl (sr);
 	
-	if (tmout)
-	{
-		cancelroottimeout (tmout);
-		tmout = 0;
-	}
+	/* no need for the one an atomic allocation queued */
+	cancel_work (&addmem_work);
 	
 	return 0;
 }
@@ -120,6 +119,9 @@ buf_init (void)
 {
 	int i;
 	
+	INIT_WORK (&gc_work, gc);
+	INIT_WORK (&addmem_work, addmem);
+	
 	for (i = 0; i <= BUF_NSPLIT; ++i)
 	{
 		pool[i].buflen = 0;
@@ -143,7 +145,7 @@ buf_init (void)
 		return -1;
 	}
 	
-	addroottimeout (GC_TIMEOUT, gc, 0);
+	queue_delayed_work (system_wq, &gc_work, GC_TIMEOUT);
 	return 0;
 }
 
@@ -310,8 +312,7 @@ try_again:
 	{
 		if (mode == BUF_ATOMIC)
 		{
-			if (!tmout)
-				tmout = addroottimeout (0, addmem, 1);
+			queue_work (system_wq, &addmem_work);
 			failed_allocs++;
 			spl (sr);
 			return 0;
@@ -14,40 +14,22 @@
 # include "igmp.h"
 
 # include "mint/asm.h"
+# include "mint/resource.h"	/* MAX_NICE */
 # include "mint/sockio.h"
 
 
 /*
- * Pending timeout
+ * Receive processing runs on its own work queue, ahead of
+ * everything else (see if_doinput)
  */
-static TIMEOUT *tmout = 0;
+static struct workqueue *netin_wq;
+static struct work input_work;
 
 /*
  * List of all registered interfaces, loopback and primary interface.
  */
 struct netif *allinterfaces, *if_lo;
 
-/*
- * Stack used while processing incoming packets
- */
-static char stack[8192];
-
-INLINE void *
-setstack (register void *sp)
-{
-	register void *osp __asm__("d0") = 0;
-	
-	__asm__ volatile
-	(
-		"movel %%sp,%0;"
-		"movel %2,%%sp;"
-		: "=a" (osp)
-		: "0" (osp), "a" (sp)
-	);
-	
-	return osp;
-}
-
 short
 if_enqueue (struct ifq *q, BUF *buf, short pri)
 {
@@ -190,94 +172,170 @@ if_flushq (struct ifq *q)
 	spl (sr);
 }
 
-static void
-if_doinput (PROC *proc, long arg)
+/*
+ * Receive processing.
+ *
+ * Drivers queue the packets they receive with if_input(). Drivers
+ * with a poll function may instead only tell us with if_schedule()
+ * that the hardware has packets (and turn their receive interrupt
+ * off); poll() then fetches them when there is room for them.
+ *
+ * if_doinput() shares a budget of IF_BUDGET packets per run round
+ * robin among the interfaces, each getting at most its weight per
+ * round, so that a flooding interface doesn't starve the others.
+ * Interfaces that still have work after that are polled: the work
+ * is queued again instead of waiting for them to interrupt. A poll
+ * function that does less than it was asked for is drained and has
+ * to turn its receive interrupt on again.
+ */
+
+/*
+ * Interface the next round starts with
+ */
+static struct netif *rx_next;
+
+static long
+if_rxpoll (struct netif *nif, long quota)
 {
-	struct netif *nif;
-	char *sp;
-	short comeagain = 0;
+	long done;
 	
-	UNUSED(proc);
-	UNUSED(arg);
-	tmout = 0;
-	sp = setstack (stack + sizeof (stack));
+	if (nif->rx_sched && nif->poll)
+	{
+		long n = quota - nif->rcv.qlen;
+		
+		/*
+		 * if_schedule() may set it again while we poll
+		 */
+		nif->rx_sched = 0;
+		if (n > 0 && (*nif->poll) (nif, n) >= n)
+			nif->rx_sched = 1;
+	}
 	
-	for (nif = allinterfaces; nif; nif = nif->next)
+	for (done = 0; done < quota; done++)
 	{
-		register short todo;
+		register BUF *buf;
 		
-		if ((nif->flags & (IFF_UP|IFF_RUNNING)) != (IFF_UP|IFF_RUNNING))
-			continue;
+		buf = if_dequeue (&nif->rcv);
+		if (!buf)
+			break;
 		
-		for (todo = nif->rcv.maxqlen; todo; --todo)
+		switch ((short) buf->info)
 		{
-			register BUF *buf;
+			case PKTYPE_IP:
+				ip_input (nif, buf);
+				break;
+			
+			case PKTYPE_ARP:
+				arp_input (nif, buf);
+				break;
 			
-			buf = if_dequeue (&nif->rcv);
-			if (!buf)
+			case PKTYPE_RARP:
+				rarp_input (nif, buf);
 				break;
 			
-			switch ((short) buf->info)
+			default:
+				DEBUG (("if_input: unknown pktype 0x%x",
+					(short)buf->info));
+				buf_deref (buf, BUF_NORMAL);
+				break;
+		}
+	}
+	
+	return done;
+}
+
+static void _cdecl
+if_doinput (struct work *w)
+{
+	struct netif *nif, *first;
+	long budget = IF_BUDGET;
+	short busy = 0;
+	
+	UNUSED(w);
+	
+	while (budget > 0 && allinterfaces)
+	{
+		first = rx_next ? rx_next : allinterfaces;
+		nif = first;
+		busy = 0;
+		
+		do {
+			if ((nif->flags & (IFF_UP|IFF_RUNNING)) == (IFF_UP|IFF_RUNNING))
 			{
-				case PKTYPE_IP:
-					ip_input (nif, buf);
-					break;
-				
-				case PKTYPE_ARP:
-					arp_input (nif, buf);
-					break;
+				long quota = MIN (nif->weight, budget);
 				
-				case PKTYPE_RARP:
-					rarp_input (nif, buf);
-					break;
+				budget -= if_rxpoll (nif, quota);
 				
-				default:
-					DEBUG (("if_input: unknown pktype 0x%x",
-						(short)buf->info));
-					buf_deref (buf, BUF_NORMAL);
-					break;
+				if (nif->rcv.qlen > 0 || nif->rx_sched)
+					busy = 1;
 			}
+			
+			nif = nif->next ? nif->next : allinterfaces;
 		}
+		while (budget > 0 && nif != first);
+		
+		rx_next = nif;
 		
-		if (!todo)
-			comeagain = 1;
+		if (!busy)
+			break;
 	}
 	
-	if (comeagain)
+	if (busy || budget <= 0)
 	{
 		/*
-		 * Come again at next context switch, since we did
-		 * not check all interfaces, there might be packets
-		 * waiting for us.
+		 * There are packets waiting for us; let the other
+		 * ready processes have their turn before we come again.
 		 */
-		if_input (0, 0, 100, 0);
+		s_yield ();
+		queue_work (netin_wq, &input_work);
 	}
-	
-	setstack (sp);
 }
 
+/*
+ * delay is ignored, the packets are processed as soon as
+ * the netin thread gets to run
+ */
 short
 if_input (struct netif *nif, BUF *buf, long delay, short type)
 {
 	register ushort sr;
 	register short r = 0;
 	
+	UNUSED(delay);
 	sr = spl7 ();
 	
 	if (buf)
 	{
+		KTRACE (KT_NETIN, buf->dend - buf->dstart, type);
+		
 		buf->info = type;
 		r = if_enqueue (&nif->rcv, buf, IF_PRIORITIES-1);
 	}
 	
-	if (tmout == 0)
-		tmout = addroottimeout (delay, if_doinput, 1);
+	queue_work (netin_wq, &input_work);
 	
 	spl (sr);
 	
 	return r;
 }
 
+/*
+ * Called by drivers with a poll function, usually from interrupt,
+ * when the hardware has received packets.
+ */
+void
+if_schedule (struct netif *nif)
+{
+	register ushort sr;
+	
+	sr = spl7 ();
+	
+	nif->rx_sched = 1;
+	queue_work (netin_wq, &input_work);
+	
+	spl (sr);
+}
+
 static void
 if_slowtimeout (PROC *proc, long arg)
 {
@@ -302,6 +360,8 @@ if_deregister (struct netif *nif)
 	for (ifp = allinterfaces; ifp; ifp = ifp->next)
 	{
 		if (ifp == nif) {
+			if (rx_next == nif)
+				rx_next = NULL;
 			/* HEAD REMOVAL */
 			if (ifpb == NULL) {
 				allinterfaces = ifp->next;
@@ -327,6 +387,13 @@ if_register (struct netif *nif)
 	nif->rcv.qlen = 0;
 	nif->snd.curr = 0;
 	nif->rcv.curr = 0;
+	nif->rx_sched = 0;
+	
+	/*
+	 * Drivers that don't know about it leave garbage here
+	 */
+	if (nif->weight <= 0 || nif->weight > IF_BUDGET)
+		nif->weight = IF_WEIGHT;
 	
 	for (i = 0; i < IF_PRIORITIES; ++i)
 	{
@@ -498,6 +565,8 @@ if_send (struct netif *nif, BUF *buf, ulong nexthop, short addrtype)
 		return ENETUNREACH;
 	}
 	
+	KTRACE (KT_NETOUT, buf->dend - buf->dstart, nexthop);
+	
 	if (nif->hwtype >= HWTYPE_NONE)
 	{
 		DEBUG (("if_send(%s): >= HWTYPE_NONE", nif->name));
@@ -1178,6 +1247,14 @@ if_init (void)
 {
 	struct netif *nif;
 	
+	/*
+	 * Drivers may call if_input() as soon as they are loaded
+	 */
+	INIT_WORK (&input_work, if_doinput);
+	netin_wq = workqueue_create ("netin", MAX_NICE, 1);
+	if (!netin_wq)
+		netin_wq = system_wq;
+	
 	if_load ();
 	loopback_init (); /* must be last */
 	arp_init ();
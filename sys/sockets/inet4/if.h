@@ -27,6 +27,8 @@
 # define IF_SLOWTIMEOUT		1000	/* one second */
 # define IF_PRIORITY_BITS	1
 # define IF_PRIORITIES		(1 << IF_PRIORITY_BITS)
+# define IF_BUDGET		64	/* packets received per if_doinput() */
+# define IF_WEIGHT		16	/* default packets per if per round */
 
 /*
  * socket address carrying a hardware address
@@ -151,7 +153,14 @@ struct netif
 					 * depends on the device driver)
 					 */
 	void		(*igmp_mac_filter)(struct netif *, ulong, char action);
-	long		reserved[2];
+	long		(*poll)(struct netif *, long budget);
+					/* optional: fetch up to `budget'
+					 * packets from the hardware with
+					 * if_input() and return how many,
+					 * see if_schedule()
+					 */
+	short		rx_sched;	/* poll() has work, set by if_schedule() */
+	short		weight;		/* packets per round of if_doinput() */
 };
 
 /* interface statistics */
@@ -243,6 +252,7 @@ long		if_register	(struct netif *);
 long		if_deregister	(struct netif *);
 long		if_init		(void);
 short		if_input	(struct netif *, BUF *, long, short);
+void		if_schedule	(struct netif *);
 
 /*
  * These must match ethernet protcol types
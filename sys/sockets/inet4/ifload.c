@@ -44,7 +44,11 @@ struct netinfo netinfo =
 	
 	_bpf_input:		bpf_input,
 
-	_if_deregister:         if_deregister
+	_if_deregister:         if_deregister,
+
+	slip_pd:		NULL,
+
+	_if_schedule:		if_schedule
 };
 
 #if 0
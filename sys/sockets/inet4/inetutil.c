@@ -23,6 +23,7 @@
 
 
 struct in_proto *allinetprotos = NULL;
+static struct kmem_cache *in_data_cache = NULL;
 
 void
 in_proto_register (short protonum, struct in_proto *proto)
@@ -47,12 +48,20 @@ in_proto_lookup (short protocol)
 	return p;
 }
 
+void
+in_data_init (void)
+{
+	in_data_cache = kmem_cache_create ("in_data", sizeof (struct in_data), NULL);
+	if (!in_data_cache)
+		ALERT (("in_data_init: cannot create in_data cache"));
+}
+
 struct in_data *
 in_data_create (void)
 {
 	struct in_data *data;
 	
-	data = kmalloc (sizeof (*data));
+	data = in_data_cache ? kmem_cache_alloc (in_data_cache) : NULL;
 	if (!data)
 	{
 		DEBUG (("in_data_create: Out of mem"));
@@ -129,7 +138,7 @@ in_data_destroy (struct in_data *data, short wait)
 		in_data_remove (data);
 	
 	in_data_flush (data);
-	kfree (data);
+	kmem_cache_free (in_data_cache, data);
 	return 0;
 }
 
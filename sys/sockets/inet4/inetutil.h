@@ -42,6 +42,7 @@
 void			in_proto_register (short, struct in_proto *);
 struct in_proto *	in_proto_lookup (short);
 
+void			in_data_init (void);
 struct in_data	*	in_data_create (void);
 long			in_data_destroy (struct in_data *, short);
 void			in_data_flush (struct in_data *);
@@ -51,6 +51,9 @@
 void
 inet4_init (void)
 {
+	/* socket data cache */
+	in_data_init ();
+	
 	/* install packetfilter */
 	bpf_init ();
 	
@@ -84,6 +84,7 @@ struct in_proto tcp_proto =
 void
 tcp_init (void)
 {
+	tcb_init ();
 	in_proto_register (IPPROTO_TCP, &tcp_proto);
 }
 
@@ -26,12 +26,22 @@ tcp_isn (void)
 	return isn;
 }
 
+static struct kmem_cache *tcb_cache = NULL;
+
+void
+tcb_init (void)
+{
+	tcb_cache = kmem_cache_create ("tcb", sizeof (struct tcb), NULL);
+	if (!tcb_cache)
+		ALERT (("tcb_init: cannot create tcb cache"));
+}
+
 struct tcb *
 tcb_alloc (void)
 {
 	struct tcb *tcb;
 	
-	tcb = kmalloc (sizeof (*tcb));
+	tcb = tcb_cache ? kmem_cache_alloc (tcb_cache) : NULL;
 	if (!tcb)
 	{
 		DEBUG (("tcb_alloc: out of kernel memory"));
@@ -78,7 +88,7 @@ void
 tcb_free (struct tcb *tcb)
 {
 	tcb_deltimers (tcb);
-	kfree (tcb);
+	kmem_cache_free (tcb_cache, tcb);
 }
 
 void
@@ -38,6 +38,7 @@
 
 
 long		tcp_isn		(void);
+void		tcb_init	(void);
 struct tcb *	tcb_alloc	(void);
 void		tcb_free	(struct tcb *);
 void		tcb_delete	(struct tcb *);
@@ -153,7 +153,11 @@ init (struct kerinfo *k)
 # endif
 	c_conws ("\r\n");
 	
-	if (MINT_MAJOR != 1 || MINT_MINOR != 19 || MINT_KVERSION != 2 || !so_register)
+	/* the kmem_cache and workqueue interfaces are a must,
+	 * the tracepoints are used when they are there
+	 */
+	if (MINT_MAJOR != 1 || MINT_MINOR != 19 || MINT_KVERSION < 3 || !so_register
+	    || !kmem_cache_interface || !workqueue_interface)
 	{
 		c_conws (MSG_OLDMINT);
 		return NULL;
@@ -35,7 +35,10 @@ struct netinfo
 	/* used by MagiCNet */
 	void *slip_pd;
 
-	long	reserved[3];
+	/* receive by polling, see if_schedule() */
+	void	(*_if_schedule) (struct netif *);
+
+	long	reserved[2];
 };
 
 # ifndef NETINFO
@@ -62,6 +65,7 @@ extern struct netinfo *NETINFO;
 
 # define bpf_input	(*NETINFO->_bpf_input)
 # define if_deregister	(*NETINFO->_if_deregister)
+# define if_schedule	(*NETINFO->_if_schedule)
 # endif
 
 
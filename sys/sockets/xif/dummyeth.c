@@ -166,6 +166,7 @@ dummy_close (struct netif *nif)
  *	if_enqueue ();
  *	if_dequeue ();
  *	if_input ();
+ *	if_schedule ();
  *	eth_remove_hdr ();
  *	addroottimeout (..., ..., 1);
  */
@@ -261,6 +262,15 @@ dummy_output (struct netif *nif, BUF *buf, const char *hwaddr, short hwlen, shor
 	 *
 	 * if_input takes `buf' over, so after calling if_input() on it
 	 * you can no longer access it.
+	 *
+	 * Drivers for busy hardware may set nif->poll instead and only
+	 * call if_schedule (nif) from their receive interrupt, turning
+	 * it off. MintNet then calls poll (nif, budget) when it has room
+	 * for packets; it passes at most `budget' of them to if_input()
+	 * and returns how many. If that is less than `budget', the
+	 * hardware is drained and the interrupt must be turned on again.
+	 * nif->weight is the number of packets the interface gets per
+	 * round when several interfaces are busy (0 for the default).
 	 */
 	r = if_input (nif, nbuf, 0, type);
 	if (r)
@@ -0,0 +1,211 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - arch/syscall.S calls syscall_enter() and syscall_exit() around the
+ *   function if syscall_hooks is nonzero; statistics are on from boot
+ *
+ * - the latency is wall time in MFP timer C steps (see ktrace_clock),
+ *   so it includes the time a call spent sleeping
+ *
+ * - unused table entries (NULL) never get here, they are passed
+ *   through to TOS in syscall.S
+ */
+
+# include "syscall_stat.h"
+
+# include "libkern/libkern.h"
+
+# include "kmemory.h"
+# include "ktrace.h"
+# include "syscall_vectors.h"
+
+
+# define STEPS_PER_SEC	(200UL * 192)
+
+# define DOS_ENTRIES	(sizeof (dos_tab) / sizeof (void *))
+# define BIOS_ENTRIES	(sizeof (bios_tab) / sizeof (void *))
+# define XBIOS_ENTRIES	(sizeof (xbios_tab) / sizeof (void *))
+
+short syscall_hooks = SYSCALL_HOOK_STAT;
+
+static struct sysstat dos_stat[DOS_ENTRIES];
+static struct sysstat bios_stat[BIOS_ENTRIES];
+static struct sysstat xbios_stat[XBIOS_ENTRIES];
+
+
+INLINE long
+syscall_id (void *tab, ulong func)
+{
+	if (tab == &dos_tab)
+		return 0x10000L | func;
+	if (tab == &bios_tab)
+		return 0xd0000L | func;
+
+	return 0xe0000L | func;
+}
+
+INLINE struct sysstat *
+syscall_stat (void *tab, ulong func)
+{
+	if (tab == &dos_tab)
+		return (func < DOS_ENTRIES) ? &dos_stat[func] : NULL;
+	if (tab == &bios_tab)
+		return (func < BIOS_ENTRIES) ? &bios_stat[func] : NULL;
+	if (tab == &xbios_tab)
+		return (func < XBIOS_ENTRIES) ? &xbios_stat[func] : NULL;
+
+	return NULL;
+}
+
+long _cdecl
+syscall_enter (void *tab, ulong func)
+{
+	KTRACE (KT_SYSENTER, syscall_id (tab, func), 0);
+
+	return ktrace_clock ();
+}
+
+void _cdecl
+syscall_exit (void *tab, ulong func, long ret, long stamp)
+{
+	KTRACE (KT_SYSEXIT, syscall_id (tab, func), ret);
+
+	if (syscall_hooks & SYSCALL_HOOK_STAT)
+	{
+		struct sysstat *s = syscall_stat (tab, func);
+		ulong delta = ktrace_clock () - (ulong) stamp;
+		ulong steps;
+		long b;
+
+		if (!s)
+			return;
+
+		s->calls++;
+
+		s->sec += delta / STEPS_PER_SEC;
+		s->usec += (delta % STEPS_PER_SEC) * 625 / 24;
+		if (s->usec >= 1000000UL)
+		{
+			s->usec -= 1000000UL;
+			s->sec++;
+		}
+
+		/* log2 bucket */
+		for (b = 0, steps = delta; steps && b < SYSSTAT_BUCKETS - 1; b++)
+			steps >>= 1;
+
+		s->hist[b]++;
+	}
+}
+
+/*
+ * 0 switches the statistics off, anything else on;
+ * either way the counters start from zero again
+ */
+long
+syscall_stat_set (long on)
+{
+	mint_bzero (dos_stat, sizeof (dos_stat));
+	mint_bzero (bios_stat, sizeof (bios_stat));
+	mint_bzero (xbios_stat, sizeof (xbios_stat));
+
+	if (on)
+		syscall_hooks |= SYSCALL_HOOK_STAT;
+	else
+		syscall_hooks &= ~SYSCALL_HOOK_STAT;
+
+	return E_OK;
+}
+
+static char *
+syscall_stat_table (char *crs, ulong *len, const char *name, struct sysstat *s, ulong n)
+{
+	ulong func;
+	long i, b;
+
+	for (func = 0; func < n; func++, s++)
+	{
+		if (!s->calls)
+			continue;
+
+		i = ksprintf (crs, *len, "%-6s 0x%03lx %9lu %6lu.%06lu",
+			      name, func, s->calls, s->sec, s->usec);
+		crs += i; *len -= i;
+
+		for (b = 0; b < SYSSTAT_BUCKETS; b++)
+		{
+			i = ksprintf (crs, *len, " %lu", s->hist[b]);
+			crs += i; *len -= i;
+		}
+
+		*crs++ = '\n';
+		(*len)--;
+	}
+
+	return crs;
+}
+
+/*
+ * /kern/syscalls: one line per call that was used,
+ * trap, function, calls, seconds, histogram
+ */
+long
+syscall_stat_read (SIZEBUF **buffer)
+{
+	SIZEBUF *info;
+	ulong len, n, i;
+	char *crs;
+
+	n = 0;
+	for (i = 0; i < DOS_ENTRIES; i++)
+		n += (dos_stat[i].calls != 0);
+	for (i = 0; i < BIOS_ENTRIES; i++)
+		n += (bios_stat[i].calls != 0);
+	for (i = 0; i < XBIOS_ENTRIES; i++)
+		n += (xbios_stat[i].calls != 0);
+
+	/* fixed part and SYSSTAT_BUCKETS numbers of up to 11 chars */
+	len = 128 + n * (48 + SYSSTAT_BUCKETS * 11);
+
+	info = kmalloc (sizeof (*info) + len);
+	if (!info)
+		return ENOMEM;
+
+	crs = info->buf;
+
+	i = ksprintf (crs, len, "# trap func calls seconds"
+		      " histogram (%d buckets: n-th < 2^n * 26 us, last longer)\n",
+		      SYSSTAT_BUCKETS);
+	crs += i; len -= i;
+
+	crs = syscall_stat_table (crs, &len, "GEMDOS", dos_stat, DOS_ENTRIES);
+	crs = syscall_stat_table (crs, &len, "BIOS", bios_stat, BIOS_ENTRIES);
+	crs = syscall_stat_table (crs, &len, "XBIOS", xbios_stat, XBIOS_ENTRIES);
+
+	info->len = crs - info->buf;
+
+	*buffer = info;
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Per system call counters and latency histograms, collected in
+ * arch/syscall.S around every GEMDOS/BIOS/XBIOS function the kernel
+ * implements; see /kern/syscalls and kern.syscallstat.
+ */
+
+# ifndef _syscall_stat_h
+# define _syscall_stat_h
+
+# include "mint/mint.h"
+
+
+/* bucket b counts calls of less than 2^b MFP timer C steps (26 us),
+ * the last one everything longer
+ */
+# define SYSSTAT_BUCKETS	12
+
+struct sysstat
+{
+	ulong	calls;
+	ulong	sec;		/* total wall time */
+	ulong	usec;
+	ulong	hist[SYSSTAT_BUCKETS];
+};
+
+/* syscall_hooks bits, tested by arch/syscall.S */
+# define SYSCALL_HOOK_TRACE	0x0001	/* ktrace KT_SYSCALL */
+# define SYSCALL_HOOK_STAT	0x0002	/* statistics */
+
+extern short syscall_hooks;
+
+long syscall_stat_set (long on);
+long syscall_stat_read (SIZEBUF **buffer);
+
+long _cdecl syscall_enter (void *tab, ulong func);
+void _cdecl syscall_exit (void *tab, ulong func, long ret, long stamp);
+
+
+# endif /* _syscall_stat_h */
@@ -504,14 +504,14 @@ dos_vecs dos_tab =
 	/* 0x171 */		sys_p_shmctl,
 	/* 0x172 */		sys_p_shmat,
 	/* 0x173 */		sys_p_shmdt,
-	/* 0x174 */		sys_p_semget,	/* not implemented */
-	/* 0x175 */		sys_p_semctl,	/* not implemented */
-	/* 0x176 */		sys_p_semop,	/* not implemented */
-	/* 0x177 */		sys_p_semconfig,/* not implemented */
-	/* 0x178 */		sys_p_msgget,	/* not implemented */
-	/* 0x179 */		sys_p_msgctl,	/* not implemented */
-	/* 0x17a */		sys_p_msgsnd,	/* not implemented */
-	/* 0x17b */		sys_p_msgrcv,	/* not implemented */
+	/* 0x174 */		sys_p_semget,
+	/* 0x175 */		sys_p_semctl,
+	/* 0x176 */		sys_p_semop,
+	/* 0x177 */		sys_p_semconfig,
+	/* 0x178 */		sys_p_msgget,
+	/* 0x179 */		sys_p_msgctl,
+	/* 0x17a */		sys_p_msgsnd,
+	/* 0x17b */		sys_p_msgrcv,
 	/* 0x17c */		sys_enosys,		/* reserved */
 	/* 0x17d */		sys_m_access,	/* 1.15.12 */
 	/* 0x17e */		sys_enosys,		/* sys_mmap */
@@ -521,8 +521,8 @@ dos_vecs dos_tab =
 	/* 0x181 */		sys_f_chdir,	/* 1.17 */
 	/* 0x182 */		sys_f_opendir,	/* 1.17 */
 	/* 0x183 */		sys_f_dirfd,	/* 1.17 */
-	/* 0x184 */		sys_enosys,		/* reserved */
-	/* 0x185 */		sys_enosys,		/* reserved */
+	/* 0x184 */		sys_d_readdirplus,	/* 1.19 */
+	/* 0x185 */		sys_p_futex,	/* 1.19 */
 	/* 0x186 */		sys_enosys,		/* reserved */
 	/* 0x187 */		sys_enosys,		/* reserved */
 	/* 0x188 */		sys_enosys,		/* reserved */
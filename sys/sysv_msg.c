@@ -29,29 +29,524 @@
  * 
  */
 
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - every queue keeps its messages twice: on the queue list in the
+ *   order they were sent, and on a sub-queue per message type; the
+ *   sub-queues are sorted by type, so msgrcv() never has to look at
+ *   more than one message, whatever msgtyp is
+ *
+ * - message headers and sub-queues come from kmem caches, the text
+ *   is kmalloc'ed
+ *
+ * - blocked senders and receivers sleep on the swait/rwait fields of
+ *   their queue; the queue table is static, so a sleeper can safely
+ *   look at its queue again after IPC_RMID
+ */
+
 # include "sysv_msg.h"
 
+# include "libkern/libkern.h"
+# include "mint/credentials.h"
+
+# include "k_prot.h"
+# include "kmem_cache.h"
+# include "kmemory.h"
+# include "proc.h"
+# include "sysv_ipc.h"
+# include "time.h"
+
+
+struct msgtype;
+
+struct msg
+{
+	struct msg	*next;		/* queue list */
+	struct msg	*prev;
+	struct msg	*tnext;		/* sub-queue of the same type */
+	struct msgtype	*mt;		/* our sub-queue */
+	long		size;		/* size of the text */
+	char		*text;
+};
+
+struct msgtype
+{
+	struct msgtype	*next;		/* sorted by type */
+	long		type;
+	struct msg	*head;
+	struct msg	*tail;
+};
+
+struct msqueue
+{
+	struct msqid_ds	ds;
+	struct msg	*first;		/* oldest message */
+	struct msg	*last;
+	struct msgtype	*types;		/* sub-queues, lowest type first */
+	short		rwait;		/* sleeping receivers */
+	short		swait;		/* sleeping senders */
+};
+
+/* private mode bit in msg_perm.mode */
+# define MSQ_ALLOCATED	0x0800
+
+struct msginfo msginfo =
+{
+	MSGMAX,
+	MSGMNB,
+	MSGMNI,
+	MSGTQL
+};
+
+static struct msqueue msqueues[MSGMNI];
+static long msg_total;		/* messages in all queues */
+
+static KMEM_CACHE (msg_cache, "MSG", sizeof (struct msg), NULL);
+static KMEM_CACHE (msgtype_cache, "MSGTYPE", sizeof (struct msgtype), NULL);
+
+
+static struct msqueue *
+msq_lookup (long msqid)
+{
+	struct msqueue *q;
+	long ix = IPCID_TO_IX (msqid);
+
+	if (ix < 0 || ix >= MSGMNI)
+		return NULL;
+
+	q = &msqueues[ix];
+	if (!(q->ds.msg_perm.mode & MSQ_ALLOCATED)
+	    || q->ds.msg_perm._seq != IPCID_TO_SEQ (msqid))
+		return NULL;
+
+	return q;
+}
+
+INLINE long
+msq_id (struct msqueue *q)
+{
+	return (q - msqueues) | (q->ds.msg_perm._seq << 16);
+}
+
+/* append a message to the queue and its sub-queue */
+static long
+msg_enqueue (struct msqueue *q, struct msg *m, long type)
+{
+	struct msgtype **list, *mt;
+
+	for (list = &q->types; (mt = *list) && mt->type < type; list = &mt->next)
+		;
+
+	if (!mt || mt->type != type)
+	{
+		mt = kmem_cache_alloc (&msgtype_cache);
+		if (!mt)
+			return ENOMEM;
+
+		mt->type = type;
+		mt->head = mt->tail = NULL;
+		mt->next = *list;
+		*list = mt;
+	}
+
+	m->mt = mt;
+	m->tnext = NULL;
+	if (mt->tail)
+		mt->tail->tnext = m;
+	else
+		mt->head = m;
+	mt->tail = m;
+
+	m->next = NULL;
+	m->prev = q->last;
+	if (q->last)
+		q->last->next = m;
+	else
+		q->first = m;
+	q->last = m;
+
+	q->ds.msg_cbytes += m->size;
+	q->ds.msg_qnum++;
+	msg_total++;
+
+	return E_OK;
+}
+
+/* remove a message, it's always the head of its sub-queue */
+static void
+msg_dequeue (struct msqueue *q, struct msg *m)
+{
+	struct msgtype *mt = m->mt;
+
+	assert (mt->head == m);
+
+	mt->head = m->tnext;
+	if (!mt->head)
+	{
+		struct msgtype **list;
+
+		for (list = &q->types; *list != mt; list = &(*list)->next)
+			;
+
+		*list = mt->next;
+		kmem_cache_free (&msgtype_cache, mt);
+	}
+
+	if (m->prev)
+		m->prev->next = m->next;
+	else
+		q->first = m->next;
+	if (m->next)
+		m->next->prev = m->prev;
+	else
+		q->last = m->prev;
+
+	q->ds.msg_cbytes -= m->size;
+	q->ds.msg_qnum--;
+	msg_total--;
+}
+
+static void
+msg_free (struct msg *m)
+{
+	if (m->text)
+		kfree (m->text);
+
+	kmem_cache_free (&msg_cache, m);
+}
+
+/* the message msgrcv() with this msgtyp would get, or NULL */
+static struct msg *
+msg_find (struct msqueue *q, long msgtyp)
+{
+	struct msgtype *mt;
+
+	if (msgtyp == 0)
+		return q->first;
+
+	mt = q->types;
+
+	if (msgtyp > 0)
+	{
+		while (mt && mt->type < msgtyp)
+			mt = mt->next;
+
+		if (mt && mt->type == msgtyp)
+			return mt->head;
+
+		return NULL;
+	}
+
+	/* lowest type less than or equal to -msgtyp */
+	if (mt && mt->type + msgtyp <= 0)
+		return mt->head;
+
+	return NULL;
+}
+
+static void
+msq_remove (struct msqueue *q)
+{
+	TRACE (("msq_remove: id %lx, %lu messages", msq_id (q), q->ds.msg_qnum));
+
+	while (q->first)
+	{
+		struct msg *m = q->first;
+
+		msg_dequeue (q, m);
+		msg_free (m);
+	}
+
+	q->ds.msg_perm.mode = 0;
+	q->ds.msg_perm._seq = (q->ds.msg_perm._seq + 1) & 0x7fff;
+
+	/* sleepers find out the queue is gone */
+	if (q->rwait)
+		wake (IO_Q, (long) &q->rwait);
+	if (q->swait)
+		wake (IO_Q, (long) &q->swait);
+}
+
 
 long _cdecl
 sys_p_msgctl (long msqid, long cmd, struct msqid_ds *buf)
 {
-	return ENOSYS;
+	struct ucred *cred = get_curproc()->p_cred->ucr;
+	struct msqueue *q;
+	long r;
+
+	TRACE (("Pmsgctl(%lx, %ld, %p)", msqid, cmd, buf));
+
+	q = msq_lookup (msqid);
+	if (!q)
+		return EINVAL;
+
+	switch (cmd)
+	{
+		case IPC_STAT:
+		{
+			r = ipcperm (cred, &q->ds.msg_perm, IPC_R);
+			if (r)
+				return r;
+
+			if (!buf)
+				return EFAULT;
+
+			*buf = q->ds;
+			buf->msg_perm.mode &= 0777;
+			break;
+		}
+		case IPC_SET:
+		{
+			r = ipcperm (cred, &q->ds.msg_perm, IPC_M);
+			if (r)
+				return r;
+
+			if (!buf)
+				return EFAULT;
+
+			if (buf->msg_qbytes > q->ds.msg_qbytes && !suser (cred))
+				return EPERM;
+
+			if (buf->msg_qbytes == 0)
+				return EINVAL;
+
+			q->ds.msg_perm.uid = buf->msg_perm.uid;
+			q->ds.msg_perm.gid = buf->msg_perm.gid;
+			q->ds.msg_perm.mode = (q->ds.msg_perm.mode & ~0777)
+					    | (buf->msg_perm.mode & 0777);
+			q->ds.msg_qbytes = buf->msg_qbytes;
+			q->ds.msg_ctime = xtime.tv_sec;
+
+			/* there may be room now */
+			if (q->swait)
+				wake (IO_Q, (long) &q->swait);
+			break;
+		}
+		case IPC_RMID:
+		{
+			r = ipcperm (cred, &q->ds.msg_perm, IPC_M);
+			if (r)
+				return r;
+
+			msq_remove (q);
+			break;
+		}
+		default:
+			return EINVAL;
+	}
+
+	return E_OK;
 }
 
 long _cdecl
 sys_p_msgget (long key, long msgflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct ucred *cred = p->p_cred->ucr;
+	struct msqueue *q = NULL;
+	long i;
+
+	TRACE (("Pmsgget(%lx, %lx)", key, msgflg));
+
+	if (key != IPC_PRIVATE)
+	{
+		for (i = 0; i < MSGMNI; i++)
+		{
+			q = &msqueues[i];
+
+			if ((q->ds.msg_perm.mode & MSQ_ALLOCATED) && q->ds.msg_perm._key == key)
+			{
+				long r;
+
+				if ((msgflg & (IPC_CREAT | IPC_EXCL)) == (IPC_CREAT | IPC_EXCL))
+					return EEXIST;
+
+				r = ipcperm (cred, &q->ds.msg_perm, msgflg & 0700);
+				if (r)
+					return r;
+
+				return msq_id (q);
+			}
+		}
+
+		if (!(msgflg & IPC_CREAT))
+			return ENOENT;
+	}
+
+	for (i = 0, q = NULL; i < msginfo.msgmni; i++)
+	{
+		if (!(msqueues[i].ds.msg_perm.mode & MSQ_ALLOCATED))
+		{
+			q = &msqueues[i];
+			break;
+		}
+	}
+
+	if (!q)
+		return ENOSPC;
+
+	q->ds.msg_perm.uid = q->ds.msg_perm.cuid = cred->euid;
+	q->ds.msg_perm.gid = q->ds.msg_perm.cgid = cred->egid;
+	q->ds.msg_perm.mode = (msgflg & 0777) | MSQ_ALLOCATED;
+	q->ds.msg_perm._key = key;
+	q->ds.msg_cbytes = 0;
+	q->ds.msg_qnum = 0;
+	q->ds.msg_qbytes = msginfo.msgmnb;
+	q->ds.msg_lspid = q->ds.msg_lrpid = 0;
+	q->ds.msg_stime = q->ds.msg_rtime = 0;
+	q->ds.msg_ctime = xtime.tv_sec;
+	q->first = q->last = NULL;
+	q->types = NULL;
+
+	TRACE (("Pmsgget: new queue %lx", msq_id (q)));
+	return msq_id (q);
 }
 
 long _cdecl
 sys_p_msgsnd (long msqid, const void *msgp, long msgsz, long msgflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct msqueue *q;
+	struct msg *m;
+	long type;
+	long r;
+
+	TRACE (("Pmsgsnd(%lx, %p, %ld, %lx)", msqid, msgp, msgsz, msgflg));
+
+	q = msq_lookup (msqid);
+	if (!q)
+		return EINVAL;
+
+	r = ipcperm (p->p_cred->ucr, &q->ds.msg_perm, IPC_W);
+	if (r)
+		return r;
+
+	if (!msgp)
+		return EFAULT;
+
+	type = *(const long *) msgp;
+	if (msgsz < 0 || msgsz > msginfo.msgmax || type < 1)
+		return EINVAL;
+
+	while (q->ds.msg_cbytes + msgsz > q->ds.msg_qbytes || msg_total >= msginfo.msgtql)
+	{
+		int sig;
+
+		if (msgflg & IPC_NOWAIT)
+			return EAGAIN;
+
+		q->swait++;
+		sig = sleep (IO_Q, (long) &q->swait);
+		q->swait--;
+
+		if (msq_lookup (msqid) != q)
+			return EIDRM;
+
+		if (sig)
+			return EINTR;
+	}
+
+	m = kmem_cache_alloc (&msg_cache);
+	if (!m)
+		return ENOMEM;
+
+	m->size = msgsz;
+	m->text = NULL;
+
+	if (msgsz)
+	{
+		m->text = kmalloc (msgsz);
+		if (!m->text)
+		{
+			kmem_cache_free (&msg_cache, m);
+			return ENOMEM;
+		}
+
+		memcpy (m->text, (const char *) msgp + sizeof (long), msgsz);
+	}
+
+	r = msg_enqueue (q, m, type);
+	if (r)
+	{
+		msg_free (m);
+		return r;
+	}
+
+	q->ds.msg_lspid = p->pid;
+	q->ds.msg_stime = xtime.tv_sec;
+
+	if (q->rwait)
+		wake (IO_Q, (long) &q->rwait);
+
+	return E_OK;
 }
 
 long _cdecl
 sys_p_msgrcv (long msqid, void *msgp, long msgsz, long msgtyp, long msgflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct msqueue *q;
+	struct msg *m;
+	long r;
+
+	TRACE (("Pmsgrcv(%lx, %p, %ld, %ld, %lx)", msqid, msgp, msgsz, msgtyp, msgflg));
+
+	q = msq_lookup (msqid);
+	if (!q)
+		return EINVAL;
+
+	r = ipcperm (p->p_cred->ucr, &q->ds.msg_perm, IPC_R);
+	if (r)
+		return r;
+
+	if (msgsz < 0)
+		return EINVAL;
+
+	if (!msgp)
+		return EFAULT;
+
+	while (!(m = msg_find (q, msgtyp)))
+	{
+		int sig;
+
+		if (msgflg & IPC_NOWAIT)
+			return ENOMSG;
+
+		q->rwait++;
+		sig = sleep (IO_Q, (long) &q->rwait);
+		q->rwait--;
+
+		if (msq_lookup (msqid) != q)
+			return EIDRM;
+
+		if (sig)
+			return EINTR;
+	}
+
+	if (m->size > msgsz)
+	{
+		/* the message stays on the queue */
+		if (!(msgflg & MSG_NOERROR))
+			return E2BIG;
+	}
+	else
+		msgsz = m->size;
+
+	*(long *) msgp = m->mt->type;
+	if (msgsz)
+		memcpy ((char *) msgp + sizeof (long), m->text, msgsz);
+
+	msg_dequeue (q, m);
+	msg_free (m);
+
+	q->ds.msg_lrpid = p->pid;
+	q->ds.msg_rtime = xtime.tv_sec;
+
+	if (q->swait)
+		wake (IO_Q, (long) &q->swait);
+
+	return msgsz;
 }
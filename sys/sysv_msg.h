@@ -36,6 +36,22 @@
 # include "mint/msg.h"
 
 
+/* default limits, tunable through kern.msg* */
+# define MSGMAX		8192	/* max chars in a message */
+# define MSGMNB		16384	/* default max chars in a queue */
+# define MSGMNI		128	/* max number of queues (table size) */
+# define MSGTQL		1024	/* max number of messages in the system */
+
+struct msginfo
+{
+	long	msgmax;
+	long	msgmnb;
+	long	msgmni;
+	long	msgtql;
+};
+
+extern struct msginfo msginfo;
+
 long _cdecl sys_p_msgctl (long msqid, long cmd, struct msqid_ds *buf);
 long _cdecl sys_p_msgget (long key, long msgflg);
 long _cdecl sys_p_msgsnd (long msqid, const void *msgp, long msgsz, long msgflg);
@@ -29,29 +29,692 @@
  * 
  */
 
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - the table of semaphore sets is static, the semaphores of a set
+ *   are kmalloc'ed; blocked semop() calls sleep on their set and look
+ *   it up again by id when they wake up
+ *
+ * - semop() applies all operations or none: it tries them in order
+ *   and rolls back the ones done so far when one of them would block
+ *
+ * - SEM_UNDO adjustments are kept in one sem_undo structure per
+ *   process and applied by semexit() when the process terminates
+ */
+
 # include "sysv_sem.h"
 
+# include "libkern/libkern.h"
+# include "mint/credentials.h"
+
+# include "k_prot.h"
+# include "kmemory.h"
+# include "proc.h"
+# include "sysv_ipc.h"
+# include "time.h"
+
+
+struct semset
+{
+	struct semid_ds	ds;
+	short		waiters;	/* processes sleeping in semop */
+};
+
+struct seminfo seminfo =
+{
+	0,		/* semmap, unused */
+	SEMMNI,
+	SEMMNS,
+	SEMMNU,
+	SEMMSL,
+	MAX_SOPS,
+	SEMUME,
+	sizeof (struct sem_undo) + (SEMUME - 1) * sizeof (struct undo),
+	SEMVMX,
+	SEMAEM
+};
+
+static struct semset semsets[SEMMNI];
+static long semtot;			/* semaphores in all sets */
+
+static struct sem_undo *semu_list;	/* undo structures in use */
+static long semu_cnt;
+
+/* processes sleeping in semop, so semexit() can take back their
+ * counts when they are killed in sleep(); the records live on the
+ * sleepers' stacks
+ */
+struct sem_sleeper
+{
+	struct sem_sleeper	*next;
+	struct proc		*p;
+	long			semid;
+	struct __sem		*semptr;
+	short			zero;	/* counted in semzcnt, not semncnt */
+};
+
+static struct sem_sleeper *sem_sleepers;
+
+
+static struct semset *
+sem_lookup (long semid)
+{
+	struct semset *set;
+	long ix = IPCID_TO_IX (semid);
+
+	if (ix < 0 || ix >= SEMMNI)
+		return NULL;
+
+	set = &semsets[ix];
+	if (!(set->ds.sem_perm.mode & SEM_ALLOC)
+	    || set->ds.sem_perm._seq != IPCID_TO_SEQ (semid))
+		return NULL;
+
+	return set;
+}
+
+INLINE long
+sem_id (struct semset *set)
+{
+	return (set - semsets) | (set->ds.sem_perm._seq << 16);
+}
+
+INLINE void
+sem_wakeup (struct semset *set)
+{
+	if (set->waiters)
+		wake (IO_Q, (long) set);
+}
+
+static void
+sem_unsleep (struct sem_sleeper *sl)
+{
+	struct sem_sleeper **q;
+	struct semset *set;
+
+	for (q = &sem_sleepers; *q; q = &(*q)->next)
+	{
+		if (*q == sl)
+		{
+			*q = sl->next;
+			break;
+		}
+	}
+
+	/* the set may have been removed meanwhile */
+	set = sem_lookup (sl->semid);
+	if (!set)
+		return;
+
+	set->waiters--;
+
+	if (sl->zero)
+		sl->semptr->semzcnt--;
+	else
+		sl->semptr->semncnt--;
+}
+
+
+/*
+ * undo bookkeeping
+ */
+
+static struct sem_undo *
+semu_find (struct proc *p, int create)
+{
+	struct sem_undo *suptr;
+
+	for (suptr = semu_list; suptr; suptr = suptr->un_next)
+		if (suptr->un_proc == p)
+			return suptr;
+
+	if (!create || semu_cnt >= seminfo.semmnu)
+		return NULL;
+
+	suptr = kmalloc (seminfo.semusz);
+	if (!suptr)
+		return NULL;
+
+	suptr->un_proc = p;
+	suptr->un_cnt = 0;
+	suptr->un_next = semu_list;
+	semu_list = suptr;
+	semu_cnt++;
+
+	return suptr;
+}
+
+static void
+semu_free (struct sem_undo *suptr)
+{
+	struct sem_undo **list;
+
+	for (list = &semu_list; *list != suptr; list = &(*list)->un_next)
+		;
+
+	*list = suptr->un_next;
+	semu_cnt--;
+
+	kfree (suptr);
+}
+
+/* add adjval to the undo entry of one semaphore */
+static long
+semundo_adjust (struct proc *p, long semid, long semnum, long adjval)
+{
+	struct sem_undo *suptr;
+	struct undo *sunptr;
+	long i;
+
+	suptr = semu_find (p, 1);
+	if (!suptr)
+		return ENOSPC;
+
+	for (i = 0, sunptr = suptr->un_ent; i < suptr->un_cnt; i++, sunptr++)
+	{
+		if (sunptr->un_id == semid && sunptr->un_num == semnum)
+		{
+			adjval += sunptr->un_adjval;
+			if (adjval > seminfo.semaem || adjval < -seminfo.semaem)
+				return ERANGE;
+
+			sunptr->un_adjval = adjval;
+			if (adjval == 0)
+			{
+				/* drop the entry, keep the array packed */
+				*sunptr = suptr->un_ent[--suptr->un_cnt];
+				if (suptr->un_cnt == 0)
+					semu_free (suptr);
+			}
+
+			return E_OK;
+		}
+	}
+
+	if (adjval == 0)
+		return E_OK;
+
+	if (adjval > seminfo.semaem || adjval < -seminfo.semaem)
+		return ERANGE;
+
+	if (suptr->un_cnt >= seminfo.semume)
+		return EINVAL;
+
+	sunptr = &suptr->un_ent[suptr->un_cnt++];
+	sunptr->un_adjval = adjval;
+	sunptr->un_num = semnum;
+	sunptr->un_id = semid;
+
+	return E_OK;
+}
+
+/* forget the undo entries of one semaphore (semnum >= 0) or a whole set */
+static void
+semundo_clear (long semid, long semnum)
+{
+	struct sem_undo *suptr, *next;
+
+	for (suptr = semu_list; suptr; suptr = next)
+	{
+		struct undo *sunptr = suptr->un_ent;
+		long i = 0;
+
+		next = suptr->un_next;
+
+		while (i < suptr->un_cnt)
+		{
+			if (sunptr[i].un_id == semid
+			    && (semnum < 0 || sunptr[i].un_num == semnum))
+				sunptr[i] = sunptr[--suptr->un_cnt];
+			else
+				i++;
+		}
+
+		if (suptr->un_cnt == 0)
+			semu_free (suptr);
+	}
+}
+
+/*
+ * apply the SEM_UNDO adjustments of a terminating process;
+ * called from terminate()
+ */
+void
+semexit (struct proc *p)
+{
+	struct sem_undo *suptr;
+	struct sem_sleeper *sl;
+	long i;
+
+	/* killed while sleeping in semop */
+	for (sl = sem_sleepers; sl; sl = sl->next)
+	{
+		if (sl->p == p)
+		{
+			sem_unsleep (sl);
+			break;
+		}
+	}
+
+	suptr = semu_find (p, 0);
+	if (!suptr)
+		return;
+
+	TRACE (("semexit: pid %d, %d undo entries", p->pid, suptr->un_cnt));
+
+	for (i = 0; i < suptr->un_cnt; i++)
+	{
+		struct undo *sunptr = &suptr->un_ent[i];
+		struct semset *set;
+		struct __sem *semptr;
+		long val;
+
+		set = sem_lookup (sunptr->un_id);
+		if (!set || sunptr->un_num >= set->ds.sem_nsems)
+			continue;
+
+		semptr = &set->ds.sem_base[sunptr->un_num];
+
+		val = (long) semptr->semval + sunptr->un_adjval;
+		if (val < 0)
+			val = 0;
+		else if (val > seminfo.semvmx)
+			val = seminfo.semvmx;
+
+		semptr->semval = val;
+		semptr->sempid = p->pid;
+
+		sem_wakeup (set);
+	}
+
+	semu_free (suptr);
+}
+
 
 long _cdecl
 sys_p_semctl (long semid, long semnum, long cmd, union __semun *arg)
 {
-	return ENOSYS;
+	struct ucred *cred = get_curproc()->p_cred->ucr;
+	struct semset *set;
+	long nsems;
+	long i, r;
+
+	TRACE (("Psemctl(%lx, %ld, %ld, %p)", semid, semnum, cmd, arg));
+
+	set = sem_lookup (semid);
+	if (!set)
+		return EINVAL;
+
+	nsems = set->ds.sem_nsems;
+
+	switch (cmd)
+	{
+		case IPC_RMID:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_M);
+			if (r)
+				return r;
+
+			semundo_clear (semid, -1);
+
+			semtot -= nsems;
+			kfree (set->ds.sem_base);
+			set->ds.sem_base = NULL;
+			set->ds.sem_perm.mode = 0;
+			set->ds.sem_perm._seq = (set->ds.sem_perm._seq + 1) & 0x7fff;
+
+			/* sleepers find out the set is gone and
+			 * leave the counts alone
+			 */
+			sem_wakeup (set);
+			set->waiters = 0;
+			return E_OK;
+		}
+		case IPC_SET:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_M);
+			if (r)
+				return r;
+
+			if (!arg || !arg->buf)
+				return EFAULT;
+
+			set->ds.sem_perm.uid = arg->buf->sem_perm.uid;
+			set->ds.sem_perm.gid = arg->buf->sem_perm.gid;
+			set->ds.sem_perm.mode = (set->ds.sem_perm.mode & ~0777)
+					      | (arg->buf->sem_perm.mode & 0777);
+			set->ds.sem_ctime = xtime.tv_sec;
+			return E_OK;
+		}
+		case IPC_STAT:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_R);
+			if (r)
+				return r;
+
+			if (!arg || !arg->buf)
+				return EFAULT;
+
+			*arg->buf = set->ds;
+			arg->buf->sem_perm.mode &= 0777;
+			arg->buf->sem_base = NULL;
+			return E_OK;
+		}
+		case GETNCNT:
+		case GETPID:
+		case GETVAL:
+		case GETZCNT:
+		{
+			struct __sem *semptr;
+
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_R);
+			if (r)
+				return r;
+
+			if (semnum < 0 || semnum >= nsems)
+				return EINVAL;
+
+			semptr = &set->ds.sem_base[semnum];
+
+			switch (cmd)
+			{
+				case GETNCNT:	return semptr->semncnt;
+				case GETPID:	return semptr->sempid;
+				case GETVAL:	return semptr->semval;
+				default:	return semptr->semzcnt;
+			}
+		}
+		case GETALL:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_R);
+			if (r)
+				return r;
+
+			if (!arg || !arg->array)
+				return EFAULT;
+
+			for (i = 0; i < nsems; i++)
+				arg->array[i] = set->ds.sem_base[i].semval;
+
+			return E_OK;
+		}
+		case SETVAL:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_W);
+			if (r)
+				return r;
+
+			if (semnum < 0 || semnum >= nsems)
+				return EINVAL;
+
+			if (!arg)
+				return EFAULT;
+
+			if (arg->val < 0 || arg->val > seminfo.semvmx)
+				return ERANGE;
+
+			set->ds.sem_base[semnum].semval = arg->val;
+			semundo_clear (semid, semnum);
+			set->ds.sem_ctime = xtime.tv_sec;
+
+			sem_wakeup (set);
+			return E_OK;
+		}
+		case SETALL:
+		{
+			r = ipcperm (cred, &set->ds.sem_perm, IPC_W);
+			if (r)
+				return r;
+
+			if (!arg || !arg->array)
+				return EFAULT;
+
+			for (i = 0; i < nsems; i++)
+				if (arg->array[i] > seminfo.semvmx)
+					return ERANGE;
+
+			for (i = 0; i < nsems; i++)
+				set->ds.sem_base[i].semval = arg->array[i];
+
+			semundo_clear (semid, -1);
+			set->ds.sem_ctime = xtime.tv_sec;
+
+			sem_wakeup (set);
+			return E_OK;
+		}
+	}
+
+	return EINVAL;
 }
 
 long _cdecl
 sys_p_semget (long key, long nsems, long semflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct ucred *cred = p->p_cred->ucr;
+	struct semset *set = NULL;
+	long i;
+
+	TRACE (("Psemget(%lx, %ld, %lx)", key, nsems, semflg));
+
+	if (key != IPC_PRIVATE)
+	{
+		for (i = 0; i < SEMMNI; i++)
+		{
+			set = &semsets[i];
+
+			if ((set->ds.sem_perm.mode & SEM_ALLOC) && set->ds.sem_perm._key == key)
+			{
+				long r;
+
+				if ((semflg & (IPC_CREAT | IPC_EXCL)) == (IPC_CREAT | IPC_EXCL))
+					return EEXIST;
+
+				r = ipcperm (cred, &set->ds.sem_perm, semflg & 0700);
+				if (r)
+					return r;
+
+				if (nsems > set->ds.sem_nsems)
+					return EINVAL;
+
+				return sem_id (set);
+			}
+		}
+
+		if (!(semflg & IPC_CREAT))
+			return ENOENT;
+	}
+
+	if (nsems <= 0 || nsems > seminfo.semmsl)
+		return EINVAL;
+
+	if (semtot + nsems > seminfo.semmns)
+		return ENOSPC;
+
+	for (i = 0, set = NULL; i < seminfo.semmni && i < SEMMNI; i++)
+	{
+		if (!(semsets[i].ds.sem_perm.mode & SEM_ALLOC))
+		{
+			set = &semsets[i];
+			break;
+		}
+	}
+
+	if (!set)
+		return ENOSPC;
+
+	set->ds.sem_base = kmalloc (nsems * sizeof (struct __sem));
+	if (!set->ds.sem_base)
+		return ENOMEM;
+
+	mint_bzero (set->ds.sem_base, nsems * sizeof (struct __sem));
+
+	set->ds.sem_perm.uid = set->ds.sem_perm.cuid = cred->euid;
+	set->ds.sem_perm.gid = set->ds.sem_perm.cgid = cred->egid;
+	set->ds.sem_perm.mode = (semflg & 0777) | SEM_ALLOC;
+	set->ds.sem_perm._key = key;
+	set->ds.sem_nsems = nsems;
+	set->ds.sem_otime = 0;
+	set->ds.sem_ctime = xtime.tv_sec;
+
+	semtot += nsems;
+
+	TRACE (("Psemget: new set %lx with %ld semaphores", sem_id (set), nsems));
+	return sem_id (set);
 }
 
 long _cdecl
 sys_p_semop (long semid, struct sembuf *sops, long nsops)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct sembuf kops[MAX_SOPS];
+	struct semset *set;
+	long i, j, r;
+	int alter = 0;
+
+	TRACE (("Psemop(%lx, %p, %ld)", semid, sops, nsops));
+
+	set = sem_lookup (semid);
+	if (!set)
+		return EINVAL;
+
+	if (nsops < 1 || nsops > seminfo.semopm || nsops > MAX_SOPS)
+		return E2BIG;
+
+	if (!sops)
+		return EFAULT;
+
+	/* the caller may change them while we sleep */
+	memcpy (kops, sops, nsops * sizeof (*kops));
+
+	for (i = 0; i < nsops; i++)
+	{
+		if (kops[i].sem_num >= set->ds.sem_nsems)
+			return EFBIG;
+
+		if (kops[i].sem_op != 0)
+			alter = 1;
+	}
+
+	r = ipcperm (p->p_cred->ucr, &set->ds.sem_perm, alter ? IPC_W : IPC_R);
+	if (r)
+		return r;
+
+	for (;;)
+	{
+		struct sembuf *sopptr = NULL;
+		struct __sem *semptr = NULL;
+		struct sem_sleeper sl;
+		int sig;
+
+		/* try all operations */
+		for (i = 0; i < nsops; i++)
+		{
+			sopptr = &kops[i];
+			semptr = &set->ds.sem_base[sopptr->sem_num];
+
+			if (sopptr->sem_op < 0)
+			{
+				if ((long) semptr->semval + sopptr->sem_op < 0)
+					break;
+			}
+			else if (sopptr->sem_op == 0)
+			{
+				if (semptr->semval != 0)
+					break;
+			}
+			else if ((long) semptr->semval + sopptr->sem_op > seminfo.semvmx)
+			{
+				r = ERANGE;
+				break;
+			}
+
+			semptr->semval += sopptr->sem_op;
+		}
+
+		if (i == nsops)
+			break;
+
+		/* roll back what we did so far */
+		for (j = i - 1; j >= 0; j--)
+			set->ds.sem_base[kops[j].sem_num].semval -= kops[j].sem_op;
+
+		if (r)
+			return r;
+
+		if (sopptr->sem_flg & IPC_NOWAIT)
+			return EAGAIN;
+
+		sl.p = p;
+		sl.semid = semid;
+		sl.semptr = semptr;
+		sl.zero = (sopptr->sem_op == 0);
+		sl.next = sem_sleepers;
+		sem_sleepers = &sl;
+
+		if (sl.zero)
+			semptr->semzcnt++;
+		else
+			semptr->semncnt++;
+
+		set->waiters++;
+		sig = sleep (IO_Q, (long) set);
+		sem_unsleep (&sl);
+
+		if (sem_lookup (semid) != set)
+			return EIDRM;
+
+		if (sig)
+			return EINTR;
+	}
+
+	/* all done, remember the undo adjustments */
+	for (i = 0; i < nsops; i++)
+	{
+		if (!(kops[i].sem_flg & SEM_UNDO) || kops[i].sem_op == 0)
+			continue;
+
+		r = semundo_adjust (p, semid, kops[i].sem_num, -kops[i].sem_op);
+		if (r)
+		{
+			/* take everything back */
+			for (j = i - 1; j >= 0; j--)
+				if ((kops[j].sem_flg & SEM_UNDO) && kops[j].sem_op != 0)
+					semundo_adjust (p, semid, kops[j].sem_num, kops[j].sem_op);
+
+			for (j = nsops - 1; j >= 0; j--)
+				set->ds.sem_base[kops[j].sem_num].semval -= kops[j].sem_op;
+
+			return r;
+		}
+	}
+
+	for (i = 0; i < nsops; i++)
+		set->ds.sem_base[kops[i].sem_num].sempid = p->pid;
+
+	set->ds.sem_otime = xtime.tv_sec;
+
+	if (alter)
+		sem_wakeup (set);
+
+	return E_OK;
 }
 
+/*
+ * The kernel isn't preemptive, so there is no internal state that
+ * would need freezing; accept the requests for compatibility.
+ */
 long _cdecl
 sys_p_semconfig (long flag)
 {
-	return ENOSYS;
+	switch (flag)
+	{
+		case SEM_CONFIG_FREEZE:
+		case SEM_CONFIG_THAW:
+			return E_OK;
+	}
+
+	return EINVAL;
 }
@@ -39,7 +39,13 @@
 #define SEMVMX	32767		/* semaphore maximum value */
 #define SEMAEM	16384		/* adjust on exit max value */
 
-#define MAX_SOPS	5	/* maximum # of sembuf's per semop call */
+#define MAX_SOPS	32	/* maximum # of sembuf's per semop call */
+
+#define SEMMNI	32		/* # of semaphore identifiers */
+#define SEMMNS	256		/* # of semaphores in system */
+#define SEMMNU	32		/* # of undo structures in system */
+#define SEMMSL	64		/* max # of semaphores per id */
+#define SEMUME	16		/* max # of undo entries per process */
 
 /*
  * Permissions
@@ -62,6 +68,10 @@ struct sem_undo
 	} un_ent[1];			/* undo entries */
 };
 
+extern struct seminfo seminfo;
+
+void semexit (struct proc *p);
+
 long _cdecl sys_p_semctl (long semid, long semnum, long cmd, union __semun *arg);
 long _cdecl sys_p_semget (long key, long nsems, long semflg);
 long _cdecl sys_p_semop (long semid, struct sembuf *sops, long nsops);
@@ -29,29 +29,425 @@
  * 
  */
 
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - every segment is one shared MEMREGION (M_SHARED|M_SYSVSHM) that is
+ *   attached with attach_region; fork and exit keep track of it like
+ *   of every other shared region
+ *
+ * - the segment table holds one reference on the region; all other
+ *   links are attachments, so shm_nattch is simply links - 1
+ *
+ * - the region is private (PROT_P) in the global table, attaching
+ *   processes become owners; SHM_RDONLY downgrades the attaching
+ *   process to read-only access
+ *
+ * - IPC_RMID only hides the key; the segment and its memory go away
+ *   when the last attachment is gone (see shm_reap)
+ */
+
 # include "sysv_shm.h"
 
+# include "libkern/libkern.h"
+# include "mint/credentials.h"
+
+# include "arch/mprot.h"
+
+# include "memory.h"
+# include "proc.h"
+# include "sysv_ipc.h"
+# include "time.h"
+
+
+/* private mode bits in shm_perm.mode */
+# define SHMSEG_ALLOCATED	0x0800
+# define SHMSEG_REMOVED		0x0400
+
+struct shminfo shminfo =
+{
+	SHMMAX,
+	SHMMIN,
+	SHMMNI,
+	SHMSEG,
+	SHMALL
+};
+
+static struct shmid_ds shmsegs[SHMMNI];
+static long shm_total;		/* bytes in all segments */
+static long shm_nremoved;	/* removed segments still attached */
+
+# define SHMSEG_REG(seg)	((MEMREGION *) (seg)->_shm_internal)
+
+
+static struct shmid_ds *
+shm_find_segment_by_shmid (long shmid)
+{
+	struct shmid_ds *seg;
+	long ix = IPCID_TO_IX (shmid);
+
+	if (ix < 0 || ix >= shminfo.shmmni)
+		return NULL;
+
+	seg = &shmsegs[ix];
+	if ((seg->shm_perm.mode & (SHMSEG_ALLOCATED | SHMSEG_REMOVED)) != SHMSEG_ALLOCATED
+	    || seg->shm_perm._seq != IPCID_TO_SEQ (shmid))
+		return NULL;
+
+	return seg;
+}
+
+static struct shmid_ds *
+shm_find_segment_by_key (long key)
+{
+	long i;
+
+	for (i = 0; i < shminfo.shmmni; i++)
+	{
+		struct shmid_ds *seg = &shmsegs[i];
+
+		if ((seg->shm_perm.mode & (SHMSEG_ALLOCATED | SHMSEG_REMOVED)) == SHMSEG_ALLOCATED
+		    && seg->shm_perm._key == key)
+			return seg;
+	}
+
+	return NULL;
+}
+
+static struct shmid_ds *
+shm_find_segment_by_region (MEMREGION *m)
+{
+	long i;
+
+	for (i = 0; i < shminfo.shmmni; i++)
+	{
+		struct shmid_ds *seg = &shmsegs[i];
+
+		if ((seg->shm_perm.mode & SHMSEG_ALLOCATED) && SHMSEG_REG (seg) == m)
+			return seg;
+	}
+
+	return NULL;
+}
+
+INLINE long
+shm_id (struct shmid_ds *seg)
+{
+	return (seg - shmsegs) | (seg->shm_perm._seq << 16);
+}
+
+static void
+shm_deallocate_segment (struct shmid_ds *seg)
+{
+	MEMREGION *m = SHMSEG_REG (seg);
+
+	TRACE (("shm_deallocate_segment: id %lx, %ld bytes", shm_id (seg), seg->shm_segsz));
+
+	shm_total -= m->len;
+
+	/* drop the reference of the segment table */
+	m->mflags &= ~M_SYSVSHM;
+	m->links--;
+	if (m->links == 0)
+		free_region (m);
+
+	seg->_shm_internal = NULL;
+	seg->shm_perm.mode = 0;
+}
+
+/*
+ * release removed segments that aren't attached anymore;
+ * called after a process gave up its memory
+ */
+void
+shm_reap (void)
+{
+	long i;
+
+	if (!shm_nremoved)
+		return;
+
+	for (i = 0; i < shminfo.shmmni; i++)
+	{
+		struct shmid_ds *seg = &shmsegs[i];
+
+		if ((seg->shm_perm.mode & SHMSEG_REMOVED)
+		    && SHMSEG_REG (seg)->links == 1)
+		{
+			shm_deallocate_segment (seg);
+			shm_nremoved--;
+		}
+	}
+}
+
+/* number of SysV segments attached to a process */
+static long
+shm_nattached (struct proc *p)
+{
+	struct memspace *mem = p->p_mem;
+	long n = 0;
+	int i;
+
+	for (i = 0; i < mem->num_reg; i++)
+	{
+		MEMREGION *m = mem->mem[i];
+
+		if (m && (m->mflags & M_SYSVSHM))
+			n++;
+	}
+
+	return n;
+}
+
 
 long _cdecl
 sys_p_shmdt (const void *shmaddr)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct shmid_ds *seg;
+	MEMREGION *m;
+
+	TRACE (("Pshmdt(%p)", shmaddr));
+
+	m = addr2mem (p, (long) shmaddr);
+	if (!m || !(m->mflags & M_SYSVSHM))
+		return EINVAL;
+
+	seg = shm_find_segment_by_region (m);
+	if (!seg)
+	{
+		ALERT ("Pshmdt: segment for region %lx not found", m->loc);
+		return EINVAL;
+	}
+
+	/* the segment table keeps its own reference,
+	 * so this never frees the memory
+	 */
+	detach_region (p, m);
+
+	seg->shm_lpid = p->pid;
+	seg->shm_dtime = xtime.tv_sec;
+
+	shm_reap ();
+	return E_OK;
 }
 
 long _cdecl
 sys_p_shmat (long shmid, const void *shmaddr, long shmflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+	struct shmid_ds *seg;
+	MEMREGION *m;
+	long addr;
+	long r;
+
+	TRACE (("Pshmat(%lx, %p, %lx)", shmid, shmaddr, shmflg));
+
+	seg = shm_find_segment_by_shmid (shmid);
+	if (!seg)
+		return EINVAL;
+
+	r = ipcperm (p->p_cred->ucr, &seg->shm_perm,
+		     (shmflg & SHM_RDONLY) ? IPC_R : (IPC_R | IPC_W));
+	if (r)
+		return r;
+
+	m = SHMSEG_REG (seg);
+
+	/* there is no address translation, a segment lives at
+	 * one address for everybody
+	 */
+	if (shmaddr)
+	{
+		long want = (long) shmaddr;
+
+		if (shmflg & SHM_RND)
+			want &= ~(SHMLBA - 1);
+
+		if (want != m->loc)
+			return EINVAL;
+	}
+
+	if (shm_nattached (p) >= shminfo.shmseg)
+		return EMFILE;
+
+	/* check for memory limits */
+	if (p->maxmem && m->len > p->maxmem - memused (p))
+		return ENOMEM;
+
+	addr = attach_region (p, m);
+	if (!addr)
+		return ENOMEM;
+
+	if (shmflg & SHM_RDONLY)
+		mark_proc_region (p->p_mem, m, PROT_PR, p->pid);
+
+	seg->shm_lpid = p->pid;
+	seg->shm_atime = xtime.tv_sec;
+
+	return addr;
 }
 
 long _cdecl
 sys_p_shmctl (long shmid, long cmd, struct shmid_ds *buf)
 {
-	return ENOSYS;
+	struct ucred *cred = get_curproc()->p_cred->ucr;
+	struct shmid_ds *seg;
+	long r;
+
+	TRACE (("Pshmctl(%lx, %ld, %p)", shmid, cmd, buf));
+
+	seg = shm_find_segment_by_shmid (shmid);
+	if (!seg)
+		return EINVAL;
+
+	switch (cmd)
+	{
+		case IPC_STAT:
+		{
+			r = ipcperm (cred, &seg->shm_perm, IPC_R);
+			if (r)
+				return r;
+
+			if (!buf)
+				return EFAULT;
+
+			*buf = *seg;
+			buf->shm_perm.mode &= 0777;
+			buf->shm_nattch = SHMSEG_REG (seg)->links - 1;
+			buf->_shm_internal = NULL;
+			break;
+		}
+		case IPC_SET:
+		{
+			r = ipcperm (cred, &seg->shm_perm, IPC_M);
+			if (r)
+				return r;
+
+			if (!buf)
+				return EFAULT;
+
+			seg->shm_perm.uid = buf->shm_perm.uid;
+			seg->shm_perm.gid = buf->shm_perm.gid;
+			seg->shm_perm.mode = (seg->shm_perm.mode & ~0777)
+					   | (buf->shm_perm.mode & 0777);
+			seg->shm_ctime = xtime.tv_sec;
+			break;
+		}
+		case IPC_RMID:
+		{
+			r = ipcperm (cred, &seg->shm_perm, IPC_M);
+			if (r)
+				return r;
+
+			/* hide the key, the memory stays until
+			 * the last process detached it
+			 */
+			seg->shm_perm._key = IPC_PRIVATE;
+			seg->shm_perm.mode |= SHMSEG_REMOVED;
+			seg->shm_ctime = xtime.tv_sec;
+
+			shm_nremoved++;
+			shm_reap ();
+			break;
+		}
+		default:
+			return EINVAL;
+	}
+
+	return E_OK;
+}
+
+static long
+shm_create (struct proc *p, long key, long size, long shmflg)
+{
+	struct ucred *cred = p->p_cred->ucr;
+	struct shmid_ds *seg = NULL;
+	MEMREGION *m;
+	long i;
+
+	if (size < shminfo.shmmin || size > shminfo.shmmax)
+		return EINVAL;
+
+	if (shm_total + size > shminfo.shmall)
+		return ENOSPC;
+
+	for (i = 0; i < shminfo.shmmni; i++)
+	{
+		if (!(shmsegs[i].shm_perm.mode & SHMSEG_ALLOCATED))
+		{
+			seg = &shmsegs[i];
+			break;
+		}
+	}
+
+	if (!seg)
+		return ENOSPC;
+
+	/* prefer alternate RAM like Mxalloc(3) */
+	m = get_region (alt, size, PROT_P);
+	if (!m)
+		m = get_region (core, size, PROT_P);
+	if (!m)
+		return ENOMEM;
+
+	/* a new segment is always zero filled */
+	mint_bzero ((void *) m->loc, m->len);
+
+	m->mflags |= M_SHARED | M_SYSVSHM;
+
+	seg->shm_perm.uid = seg->shm_perm.cuid = cred->euid;
+	seg->shm_perm.gid = seg->shm_perm.cgid = cred->egid;
+	seg->shm_perm.mode = (shmflg & 0777) | SHMSEG_ALLOCATED;
+	seg->shm_perm._seq = (seg->shm_perm._seq + 1) & 0x7fff;
+	seg->shm_perm._key = key;
+	seg->shm_segsz = size;
+	seg->shm_cpid = p->pid;
+	seg->shm_lpid = 0;
+	seg->shm_nattch = 0;
+	seg->shm_atime = seg->shm_dtime = 0;
+	seg->shm_ctime = xtime.tv_sec;
+	seg->_shm_internal = m;
+
+	shm_total += m->len;
+
+	TRACE (("shm_create: id %lx, %ld bytes at %lx", shm_id (seg), size, m->loc));
+	return shm_id (seg);
 }
 
 long _cdecl
 sys_p_shmget (long key, long size, long shmflg)
 {
-	return ENOSYS;
+	struct proc *p = get_curproc();
+
+	TRACE (("Pshmget(%lx, %ld, %lx)", key, size, shmflg));
+
+	if (key != IPC_PRIVATE)
+	{
+		struct shmid_ds *seg;
+
+		seg = shm_find_segment_by_key (key);
+		if (seg)
+		{
+			long r;
+
+			if ((shmflg & (IPC_CREAT | IPC_EXCL)) == (IPC_CREAT | IPC_EXCL))
+				return EEXIST;
+
+			r = ipcperm (p->p_cred->ucr, &seg->shm_perm, shmflg & 0777);
+			if (r)
+				return r;
+
+			if (size && size > seg->shm_segsz)
+				return EINVAL;
+
+			return shm_id (seg);
+		}
+
+		if (!(shmflg & IPC_CREAT))
+			return ENOENT;
+	}
+
+	return shm_create (p, key, size, shmflg);
 }
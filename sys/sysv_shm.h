@@ -36,6 +36,26 @@
 # include "mint/shm.h"
 
 
+/* default limits */
+# define SHMMAX		(16L * 1024 * 1024)	/* max bytes per segment */
+# define SHMMIN		1			/* min bytes per segment */
+# define SHMMNI		64			/* max number of segments */
+# define SHMSEG		32			/* max segments per process */
+# define SHMALL		(32L * 1024 * 1024)	/* max bytes in all segments */
+
+struct shminfo
+{
+	long	shmmax;
+	long	shmmin;
+	long	shmmni;
+	long	shmseg;
+	long	shmall;
+};
+
+extern struct shminfo shminfo;
+
+void	shm_reap (void);
+
 long	_cdecl sys_p_shmat  (long shmid, const void *shmaddr, long shmflg);
 long	_cdecl sys_p_shmctl (long shmid, long cmd, struct shmid_ds *buf);
 long	_cdecl sys_p_shmdt  (const void *shmaddr);
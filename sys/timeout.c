@@ -15,7 +15,7 @@
 # include "mint/asm.h"
 
 # include "dosdir.h"
-# include "kmemory.h"
+# include "kmem_cache.h"
 # include "proc.h"
 # include "time.h"
 
@@ -28,6 +28,7 @@
  * set up correctly.
  */
 static TIMEOUT timeouts [TIMEOUTS];
+static KMEM_CACHE (timeout_cache, "TIMEOUT", sizeof (TIMEOUT), NULL);
 TIMEOUT *tlist = NULL;
 TIMEOUT *expire_list = NULL;
 
@@ -43,7 +44,7 @@ newtimeout (short fromlist)
 	{
 		register TIMEOUT *t;
 		
-		t = kmalloc (sizeof (*t));
+		t = kmem_cache_alloc (&timeout_cache);
 		if (t)
 		{
 			t->flags = 0;
@@ -77,7 +78,7 @@ static void
 disposetimeout (TIMEOUT *t)
 {
 	if (t->flags & TIMEOUT_STATIC) t->flags &= ~TIMEOUT_USED;
-	else kfree (t);
+	else kmem_cache_free (&timeout_cache, t);
 }
 
 static void
@@ -3,92 +3,37 @@
  * distribution.  See the file Changes.MH for a detailed log of changes.
  *
  *
- * this is the system update daemon, its only purpose is to call
- * Sync() in regular intervals, so file systems get their sync()
- * function called.
+ * this is the system update, its only purpose is to call Sync()
+ * in regular intervals, so file systems get their sync() function
+ * called. It runs as work on system_wq (see workqueue.c).
  *
  */
 
 # include "update.h"
 
-long sync_time = 5;
-
-# ifdef SYSUPDATE_DAEMON
-
-# include "mint/proc.h"
-
-# include "dosfile.h"
-# include "dossig.h"
 # include "filesys.h"
-# include "k_kthread.h"
-
-static void
-do_sync (long sig)
-{
-	sys_s_ync ();
-}
-
-static void
-update (void *arg)
-{
-	sys_p_signal (SIGALRM, (long) do_sync);
-	sys_p_signal (SIGTERM, (long) do_sync);
-	sys_p_signal (SIGQUIT, (long) do_sync);
-	sys_p_signal (SIGHUP,  (long) do_sync);
-	sys_p_signal (SIGTSTP, (long) do_sync);
-	sys_p_signal (SIGINT,  (long) do_sync);
-	sys_p_signal (SIGABRT, (long) do_sync);
-	sys_p_signal (SIGUSR1, (long) do_sync);
-	sys_p_signal (SIGUSR2, (long) do_sync);
+# include "workqueue.h"
 
-	for (;;)
-	{
-		long tsync = sync_time;
-
-		while (tsync > 32)
-		{
-			sys_f_select (32000, 0L, 0L, 0L);
-			tsync -= 32;
-		}
-
-		if (tsync > 0)
-			sys_f_select (tsync * 1000, 0L, 0L, 0L);
-
-		do_sync (0);
-	}
-
-	kthread_exit (0);
-	/* not reached */
-}
-
-# else
+long sync_time = 5;
 
-# include "timeout.h"
+static struct work sync_work;
 
-/* do_sync: sync all filesystems at regular intervals
+/* do_sync: sync all filesystems at regular intervals, on system_wq
+ * so the sync may sleep without holding up the timeouts
  */
-static void
-do_sync (struct proc *p)
+static void _cdecl
+do_sync (struct work *w)
 {
 	sys_s_ync ();
 
-	addroottimeout (1000L * sync_time, do_sync, 0);
+	queue_delayed_work (system_wq, w, 1000L * (sync_time > 0 ? sync_time : 1));
 }
 
-# endif
-
 void
 start_sysupdate (void)
 {
-# ifndef SYSUPDATE_DAEMON
-
-	addroottimeout (1000L * sync_time, do_sync, 0);
-
-# else
-	long r;
+	INIT_WORK (&sync_work, do_sync);
 
-	r = kthread_create (NULL, update, NULL, NULL, "update");
-	if (r != 0)
-		FATAL ("can't create \"update\" kernel thread");
-# endif
+	if (queue_delayed_work (system_wq, &sync_work, 1000L * (sync_time > 0 ? sync_time : 1)) < 0)
+		FATAL ("can't start the system update");
 }
@@ -0,0 +1,394 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+/*
+ * implementation aspects:
+ * =======================
+ *
+ * - every queue has up to WQ_MAXTHREADS kernel threads; an idle thread
+ *   sleeps on WAIT_Q with the queue as condition, queue_work takes the
+ *   first idle one off WAIT_Q at spl7 like wakeselect() does, so it may
+ *   be called from interrupts
+ *
+ * - the threads set wait_cond before the queue check and sleep with
+ *   the 0x100 bit, so a wakeup between the check and the sleep isn't
+ *   lost
+ *
+ * - kernel threads aren't preempted, the workers give up the CPU
+ *   between work items once their time slice is used up
+ *
+ * - queue_delayed_work uses a root timeout that only queues the work,
+ *   the work function itself never runs from checkalarms()
+ *
+ * - times are measured with ktrace_clock (MFP timer C steps) and kept
+ *   in milliseconds
+ */
+
+# include "workqueue.h"
+
+# include "libkern/libkern.h"
+# include "mint/asm.h"
+
+# include "k_kthread.h"
+# include "kmemory.h"
+# include "ktrace.h"
+# include "proc.h"
+# include "timeout.h"
+
+
+struct workqueue *system_wq = NULL;
+struct workqueue *workqueues = NULL;
+
+struct workqueue_ops workqueue_ops =
+{
+	workqueue_create,
+	queue_work,
+	queue_delayed_work,
+	cancel_work,
+	&system_wq
+};
+
+
+/* ktrace_clock steps (192 per 5 ms tick) to milliseconds */
+INLINE ulong
+steps_to_ms (ulong steps)
+{
+	return (steps / 192) * 5 + ((steps % 192) * 5) / 192;
+}
+
+/* called at spl7 */
+static void
+wq_wakeup (struct workqueue *wq)
+{
+	int i;
+
+	for (i = 0; i < wq->nthreads; i++)
+	{
+		struct proc *p = wq->thread[i];
+
+		if (p->wait_cond == (long) wq)
+		{
+			/* if it isn't on WAIT_Q yet, sleep() returns at once */
+			p->wait_cond = 0;
+
+			if (p->wait_q == WAIT_Q)
+			{
+				rm_q (WAIT_Q, p);
+				add_q (READY_Q, p);
+			}
+
+			break;
+		}
+	}
+}
+
+static void _cdecl
+worker (void *arg)
+{
+	struct workqueue *wq = arg;
+	struct proc *p = get_curproc ();
+
+	for (;;)
+	{
+		struct work *w;
+		ulong start, t;
+		ushort sr;
+
+		sr = spl7 ();
+
+		w = wq->head;
+		if (!w)
+		{
+			p->wait_cond = (long) wq;
+			spl (sr);
+
+			sleep (WAIT_Q | 0x100, (long) wq);
+			continue;
+		}
+
+		wq->head = w->next;
+		if (!wq->head)
+			wq->tail = NULL;
+
+		w->next = NULL;
+		w->flags &= ~WORK_PENDING;
+		wq->pending--;
+
+		spl (sr);
+
+		start = ktrace_clock ();
+
+		t = steps_to_ms (start - w->stamp);
+		if (t > wq->maxlat)
+			wq->maxlat = t;
+
+		/* w may be requeued or freed from here on */
+		(*w->func)(w);
+
+		t = steps_to_ms (ktrace_clock () - start);
+		if (t > wq->maxrun)
+			wq->maxrun = t;
+
+		wq->runtime += t;
+		wq->run++;
+
+		if (!proc_clock)
+			sleep (READY_Q, 0);
+	}
+}
+
+struct workqueue * _cdecl
+workqueue_create (const char *name, short pri, short nthreads)
+{
+	struct workqueue *wq;
+	int i;
+
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > WQ_MAXTHREADS)
+		nthreads = WQ_MAXTHREADS;
+
+	if (pri < MIN_NICE)
+		pri = MIN_NICE;
+	if (pri > MAX_NICE)
+		pri = MAX_NICE;
+
+	wq = kmalloc (sizeof (*wq));
+	if (!wq)
+		return NULL;
+
+	bzero (wq, sizeof (*wq));
+	strncpy_f (wq->name, name, sizeof (wq->name));
+	wq->pri = pri;
+
+	for (i = 0; i < nthreads; i++)
+	{
+		struct proc *p;
+		long r;
+
+		if (nthreads == 1)
+			r = kthread_create (NULL, worker, wq, &p, "%s", wq->name);
+		else
+			r = kthread_create (NULL, worker, wq, &p, "%s/%d", wq->name, i);
+
+		if (r)
+		{
+			ALERT ("workqueue_create: can't create thread for \"%s\" (%li)", wq->name, r);
+			break;
+		}
+
+		p->pri = p->curpri = pri;
+		wq->thread[i] = p;
+
+		/* the thread isn't running yet, publish it when it may be woken */
+		wq->nthreads = i + 1;
+	}
+
+	if (!wq->nthreads)
+	{
+		kfree (wq);
+		return NULL;
+	}
+
+	wq->next = workqueues;
+	workqueues = wq;
+
+	TRACE (("workqueue_create: \"%s\", pri %i, %i threads", wq->name, pri, wq->nthreads));
+	return wq;
+}
+
+/*
+ * queue_work: run w->func on one of the queue's threads;
+ * returns 1 if queued, 0 if it was pending already
+ */
+long _cdecl
+queue_work (struct workqueue *wq, struct work *w)
+{
+	ushort sr;
+
+	sr = spl7 ();
+
+	if (w->flags & WORK_PENDING)
+	{
+		spl (sr);
+		return 0;
+	}
+
+	w->flags |= WORK_PENDING;
+	w->wq = wq;
+	w->next = NULL;
+	w->stamp = ktrace_clock ();
+
+	if (wq->tail)
+		wq->tail->next = w;
+	else
+		wq->head = w;
+	wq->tail = w;
+
+	wq->queued++;
+	if (++wq->pending > wq->maxpending)
+		wq->maxpending = wq->pending;
+
+	wq_wakeup (wq);
+
+	spl (sr);
+	return 1;
+}
+
+static void _cdecl
+wq_timeout (struct proc *p, long arg)
+{
+	struct work *w = (struct work *) arg;
+
+	w->timer = NULL;
+	w->flags &= ~WORK_DELAYED;
+
+	queue_work (w->wq, w);
+}
+
+/*
+ * queue_delayed_work: queue w after ms milliseconds, process context only;
+ * returns 1 if the timer was started, 0 if w was pending already
+ */
+long _cdecl
+queue_delayed_work (struct workqueue *wq, struct work *w, long ms)
+{
+	TIMEOUT *t;
+
+	if (w->flags & (WORK_PENDING | WORK_DELAYED))
+		return 0;
+
+	if (ms <= 0)
+		return queue_work (wq, w);
+
+	t = addroottimeout (ms, wq_timeout, 0);
+	if (!t)
+		return ENOMEM;
+
+	t->arg = (long) w;
+
+	w->wq = wq;
+	w->timer = t;
+	w->flags |= WORK_DELAYED;
+
+	wq->delayed++;
+	return 1;
+}
+
+/*
+ * cancel_work: stop the timer and take w off its queue, process context
+ * only; doesn't wait for a running work function. Returns 1 if w was
+ * pending.
+ */
+long _cdecl
+cancel_work (struct work *w)
+{
+	struct workqueue *wq = w->wq;
+	long ret = 0;
+	ushort sr;
+
+	if (w->flags & WORK_DELAYED)
+	{
+		cancelroottimeout (w->timer);
+		w->timer = NULL;
+		w->flags &= ~WORK_DELAYED;
+		ret = 1;
+	}
+
+	sr = spl7 ();
+
+	if (w->flags & WORK_PENDING)
+	{
+		struct work **wp, *prev = NULL;
+
+		for (wp = &wq->head; *wp; prev = *wp, wp = &(*wp)->next)
+		{
+			if (*wp == w)
+			{
+				*wp = w->next;
+				if (wq->tail == w)
+					wq->tail = prev;
+				break;
+			}
+		}
+
+		w->next = NULL;
+		w->flags &= ~WORK_PENDING;
+		wq->pending--;
+		ret = 1;
+	}
+
+	spl (sr);
+
+	if (ret && wq)
+		wq->cancelled++;
+
+	return ret;
+}
+
+long
+workqueue_read (SIZEBUF **buffer)
+{
+	struct workqueue *wq;
+	SIZEBUF *info;
+	ulong len, n;
+	char *crs;
+
+	n = 0;
+	for (wq = workqueues; wq; wq = wq->next)
+		n++;
+
+	len = 128 + n * 160;
+
+	info = kmalloc (sizeof (*info) + len);
+	if (!info)
+		return ENOMEM;
+
+	crs = info->buf;
+
+	n = ksprintf (crs, len, "# name threads pri queued delayed cancelled run"
+		      " pending maxpending maxlat_ms runtime_ms maxrun_ms\n");
+	crs += n; len -= n;
+
+	for (wq = workqueues; wq; wq = wq->next)
+	{
+		n = ksprintf (crs, len, "%-15s %d %d %lu %lu %lu %lu %lu %lu %lu %lu %lu\n",
+			      wq->name, wq->nthreads, wq->pri,
+			      wq->queued, wq->delayed, wq->cancelled, wq->run,
+			      wq->pending, wq->maxpending,
+			      wq->maxlat, wq->runtime, wq->maxrun);
+		crs += n; len -= n;
+	}
+
+	info->len = crs - info->buf;
+
+	*buffer = info;
+	return 0;
+}
+
+void
+init_workqueues (void)
+{
+	system_wq = workqueue_create ("kworker", 0, 1);
+	if (!system_wq)
+		FATAL ("can't create the system work queue");
+}
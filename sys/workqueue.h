@@ -0,0 +1,72 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *
+ * Work queues: deferred work run by a pool of kernel threads instead
+ * of a root timeout, so it may sleep and doesn't hold up the context
+ * switch. queue_work may be called from interrupts, the rest only
+ * from process context.
+ */
+
+# ifndef _workqueue_h
+# define _workqueue_h
+
+# include "mint/mint.h"
+# include "mint/workqueue.h"
+
+
+# define WQ_MAXTHREADS	4
+
+struct workqueue
+{
+	struct workqueue *next;		/* list of all queues */
+	char	name[16];
+	short	pri;			/* p->pri of the threads (-nice) */
+	short	nthreads;
+	struct proc *thread[WQ_MAXTHREADS];
+
+	struct work *head;		/* pending work, FIFO */
+	struct work *tail;
+
+	/* statistics, see /kern/workqueues */
+	ulong	queued;			/* queue_work calls that queued */
+	ulong	delayed;		/* queue_delayed_work calls */
+	ulong	cancelled;
+	ulong	run;			/* work functions run */
+	ulong	pending;		/* currently queued */
+	ulong	maxpending;
+	ulong	maxlat;			/* longest wait on the queue, ms */
+	ulong	runtime;		/* total time in work functions, ms */
+	ulong	maxrun;			/* longest work function, ms */
+};
+
+extern struct workqueue *system_wq;
+extern struct workqueue *workqueues;
+extern struct workqueue_ops workqueue_ops;
+
+void init_workqueues (void);
+long workqueue_read (SIZEBUF **buffer);
+
+struct workqueue * _cdecl workqueue_create (const char *name, short pri, short nthreads);
+long _cdecl queue_work (struct workqueue *wq, struct work *w);
+long _cdecl queue_delayed_work (struct workqueue *wq, struct work *w, long ms);
+long _cdecl cancel_work (struct work *w);
+
+
+# endif /* _workqueue_h */
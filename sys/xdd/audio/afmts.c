@@ -4,164 +4,230 @@
  * 11/03/95, Kay Roemer.
  *
  * 9705, John Blakeley - added u16copy
+ *
+ * The converters work on blocks and are unrolled by 8 (mixing by 4),
+ * the per sample loop overhead is the bulk of the cost on a 68000.
+ * Everything goes to signed 16 bit, the mixer's format.
  */
 
-# include "global.h"
-
 # include "afmts.h"
 
 
-static const char ulaw_s8[] = {
-	-128, -128, -128, -128, -128, -128, -128, -128, 
-	-128, -128, -128, -128, -128, -128, -128, -128, 
-	-128, -128, -128, -128, -128, -128, -128, -128, 
-	-128, -128, -128, -128, -128, -128, -128, -126, 
-	-123, -119, -115, -111, -107, -103,  -99,  -95, 
-	 -91,  -87,  -83,  -79,  -75,  -71,  -67,  -63, 
-	 -60,  -58,  -56,  -54,  -52,  -50,  -48,  -46, 
-	 -44,  -42,  -40,  -38,  -36,  -34,  -32,  -30, 
-	 -28,  -27,  -26,  -25,  -24,  -23,  -22,  -21, 
-	 -20,  -19,  -18,  -17,  -16,  -15,  -14,  -13, 
-	 -13,  -12,  -12,  -11,  -11,  -10,  -10,   -9, 
-	  -9,   -8,   -8,   -7,   -7,   -6,   -6,   -5, 
-	  -5,   -5,   -4,   -4,   -4,   -4,   -3,   -3, 
-	  -3,   -3,   -2,   -2,   -2,   -2,   -1,   -1, 
-	  -1,   -1,   -1,   -1,    0,    0,    0,    0, 
-	   0,    0,    0,    0,    0,    0,    0,    0, 
-	 127,  127,  127,  127,  127,  127,  127,  127, 
-	 127,  127,  127,  127,  127,  127,  127,  127, 
-	 127,  127,  127,  127,  127,  127,  127,  127, 
-	 127,  127,  127,  127,  127,  127,  127,  127, 
-	 124,  120,  116,  112,  108,  104,  100,   96, 
-	  92,   88,   84,   80,   76,   72,   68,   64, 
-	  61,   59,   57,   55,   53,   51,   49,   47, 
-	  45,   43,   41,   39,   37,   35,   33,   31, 
-	  29,   28,   27,   26,   25,   24,   23,   22, 
-	  21,   20,   19,   18,   17,   16,   15,   14, 
-	  14,   13,   13,   12,   12,   11,   11,   10, 
-	  10,    9,    9,    8,    8,    7,    7,    6, 
-	   6,    6,    5,    5,    5,    5,    4,    4, 
-	   4,    4,    3,    3,    3,    3,    2,    2, 
-	   2,    2,    2,    2,    1,    1,    1,    1, 
-	   1,    1,    1,    1,    0,    0,    0,    0, 
+/* G.711 u-law */
+static const short ulaw_s16tab[256] = {
+	-32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+	-23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+	-15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+	-11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+	 -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+	 -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+	 -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+	 -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+	 -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+	 -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+	  -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+	  -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+	  -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+	  -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+	  -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+	   -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+	 32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+	 23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+	 15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+	 11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+	  7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+	  5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+	  3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+	  2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+	  1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+	  1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+	   876,    844,    812,    780,    748,    716,    684,    652,
+	   620,    588,    556,    524,    492,    460,    428,    396,
+	   372,    356,    340,    324,    308,    292,    276,    260,
+	   244,    228,    212,    196,    180,    164,    148,    132,
+	   120,    112,    104,     96,     88,     80,     72,     64,
+	    56,     48,     40,     32,     24,     16,      8,      0,
 };
 
-void *
-u8copy (void *dst, const void *src, long len)
+void
+u8_s16 (short *dst, const void *src, long n)
 {
-	uchar *_dst = dst;
-	const uchar *_src = src;
-
-	if ((((long)dst ^ (long)src) & 1) == 0) {
-		ulong *d; const ulong *s;
-		/*
-		 * both pointers are either aligned or unaligned,
-		 * so we can use long copy's
-		 */
-		if ((long)dst & 1) {
-			*_dst++ = *_src++ ^ 0x80;
-			--len;
-		}
-		for (d = (ulong *)_dst, s = (const ulong *)_src; len >= 4; len -= 4) {
-			*d++ = *s++ ^ 0x80808080L;
-		}
+	const unsigned char *s = src;
+
+	for ( ; n & 7; --n)
+		*dst++ = (short) ((*s++ ^ 0x80) << 8);
+	while ((n -= 8) >= 0) {
+		dst[0] = (short) ((s[0] ^ 0x80) << 8);
+		dst[1] = (short) ((s[1] ^ 0x80) << 8);
+		dst[2] = (short) ((s[2] ^ 0x80) << 8);
+		dst[3] = (short) ((s[3] ^ 0x80) << 8);
+		dst[4] = (short) ((s[4] ^ 0x80) << 8);
+		dst[5] = (short) ((s[5] ^ 0x80) << 8);
+		dst[6] = (short) ((s[6] ^ 0x80) << 8);
+		dst[7] = (short) ((s[7] ^ 0x80) << 8);
+		dst += 8; s += 8;
+	}
+}
+
+void
+s8_s16 (short *dst, const void *src, long n)
+{
+	const signed char *s = src;
+
+	for ( ; n & 7; --n)
+		*dst++ = (short) (*s++ << 8);
+	while ((n -= 8) >= 0) {
+		dst[0] = (short) (s[0] << 8);
+		dst[1] = (short) (s[1] << 8);
+		dst[2] = (short) (s[2] << 8);
+		dst[3] = (short) (s[3] << 8);
+		dst[4] = (short) (s[4] << 8);
+		dst[5] = (short) (s[5] << 8);
+		dst[6] = (short) (s[6] << 8);
+		dst[7] = (short) (s[7] << 8);
+		dst += 8; s += 8;
 	}
-	while (--len >= 0)
-		*_dst++ = *_src++ ^ 0x80;
-	return dst;
 }
 
-void *
-ulawcopy (void *dst, const void *src, long len)
+void
+ulaw_s16 (short *dst, const void *src, long n)
 {
-	char *_dst = dst;
-	const uchar *_src = src;
-
-	for ( ; len & 7; --len)
-		*_dst++ = ulaw_s8[*_src++];
-	while ((len -= 8) >= 0) {
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
-		*_dst++ = ulaw_s8[*_src++];
+	const unsigned char *s = src;
+
+	for ( ; n & 7; --n)
+		*dst++ = ulaw_s16tab[*s++];
+	while ((n -= 8) >= 0) {
+		dst[0] = ulaw_s16tab[s[0]];
+		dst[1] = ulaw_s16tab[s[1]];
+		dst[2] = ulaw_s16tab[s[2]];
+		dst[3] = ulaw_s16tab[s[3]];
+		dst[4] = ulaw_s16tab[s[4]];
+		dst[5] = ulaw_s16tab[s[5]];
+		dst[6] = ulaw_s16tab[s[6]];
+		dst[7] = ulaw_s16tab[s[7]];
+		dst += 8; s += 8;
 	}
-	return dst;
 }
 
-void *
-u16copy (void *dst, const void *src, long len)
+/*
+ * 16 bit samples are in the CPU's byte order; write() buffers
+ * may be odd aligned, so they are read bytewise then
+ */
+void
+u16_s16 (short *dst, const void *src, long n)
 {
-	ushort *_dst = dst;
-	const ushort *_src = src;
-
-	if ((((long)dst ^ (long)src) & 1) == 0) {
-		ulong *d; const ulong *s;
-		/*
-		 * both pointers are either aligned or unaligned,
-		 * so we can use long copy's
-		 */
-		if ((long)dst & 1) {
-			*_dst++ = *_src++ ^ 0x8000;
-			len -= 2;
+	if ((long) src & 1) {
+		const unsigned char *s = src;
+		short v;
+
+		for ( ; n > 0; --n, s += 2) {
+			*((unsigned char *) &v) = s[0];
+			*((unsigned char *) &v + 1) = s[1];
+			*dst++ = v ^ (short) 0x8000;
 		}
-		for (d = (ulong *)_dst, s = (const ulong *)_src; len >= 4; len -= 4) {
-			*d++ = *s++ ^ 0x80008000L;
+	} else {
+		const short *s = src;
+
+		for ( ; n & 7; --n)
+			*dst++ = *s++ ^ (short) 0x8000;
+		while ((n -= 8) >= 0) {
+			dst[0] = s[0] ^ (short) 0x8000;
+			dst[1] = s[1] ^ (short) 0x8000;
+			dst[2] = s[2] ^ (short) 0x8000;
+			dst[3] = s[3] ^ (short) 0x8000;
+			dst[4] = s[4] ^ (short) 0x8000;
+			dst[5] = s[5] ^ (short) 0x8000;
+			dst[6] = s[6] ^ (short) 0x8000;
+			dst[7] = s[7] ^ (short) 0x8000;
+			dst += 8; s += 8;
 		}
 	}
-	while ((len -= 2) >= 0)
-		*_dst++ = *_src++ ^ 0x8000;
-	return dst;
 }
 
-void *
-mu16copy (void *dst, const void *src, long len)
+void
+s16_s16 (short *dst, const void *src, long n)
 {
-	ushort *_dst = dst;
-	const ushort *_src = src;
-
-	if ((((long)dst ^ (long)src) & 1) == 0) {
-		if ((long)dst & 1) {
-			*_dst++ = *_src ^ 0x8000;
-			*_dst++ = *_src++ ^ 0x8000;
-			len -= 4;
-		}
-		for ( ; len >= 4; len -= 4) {
-			*_dst++ = *_src ^ 0x8000;
-			*_dst++ = *_src++ ^ 0x8000;
+	if ((long) src & 1) {
+		const unsigned char *s = src;
+		unsigned char *d = (unsigned char *) dst;
+
+		for (n *= 2; n > 0; --n)
+			*d++ = *s++;
+	} else {
+		const short *s = src;
+
+		for ( ; n & 7; --n)
+			*dst++ = *s++;
+		while ((n -= 8) >= 0) {
+			dst[0] = s[0]; dst[1] = s[1]; dst[2] = s[2]; dst[3] = s[3];
+			dst[4] = s[4]; dst[5] = s[5]; dst[6] = s[6]; dst[7] = s[7];
+			dst += 8; s += 8;
 		}
 	}
-	while ((len -= 4) >= 0) {
-		*_dst++ = *_src ^ 0x8000;
-		*_dst++ = *_src++ ^ 0x8000;
+}
+
+
+void
+mix_clear (long *acc, long n)
+{
+	for ( ; n & 3; --n)
+		*acc++ = 0;
+	while ((n -= 4) >= 0) {
+		acc[0] = 0; acc[1] = 0; acc[2] = 0; acc[3] = 0;
+		acc += 4;
 	}
-	return dst;
 }
 
-void *
-m16copy (void *dst, const void *src, long len)
+void
+mix_add (long *acc, const short *src, long n)
 {
-	int *_dst = dst;
-	const short *_src = src;
-
-	if ((((long)dst ^ (long)src) & 1) == 0) {
-		if ((long)dst & 1) {
-			*_dst++ = *_src;
-			*_dst++ = *_src++;
-			len -= 4;
-		}
-		for ( ; len >= 4; len -= 4) {
-			*_dst++ = *_src;
-			*_dst++ = *_src++;
-		}
+	for ( ; n & 3; --n)
+		*acc++ += *src++;
+	while ((n -= 4) >= 0) {
+		acc[0] += src[0];
+		acc[1] += src[1];
+		acc[2] += src[2];
+		acc[3] += src[3];
+		acc += 4; src += 4;
 	}
-	while ((len -= 4) >= 0) {
-		*_dst++ = *_src;
-		*_dst++ = *_src++;
+}
+
+# define CLIP16(v)	((v) > 32767 ? 32767 : ((v) < -32768 ? -32768 : (v)))
+
+void
+mix_s16 (short *dst, const long *acc, long n)
+{
+	long v0, v1, v2, v3;
+
+	for ( ; n & 3; --n) {
+		v0 = *acc++;
+		*dst++ = CLIP16 (v0);
+	}
+	while ((n -= 4) >= 0) {
+		v0 = acc[0]; v1 = acc[1]; v2 = acc[2]; v3 = acc[3];
+		dst[0] = CLIP16 (v0);
+		dst[1] = CLIP16 (v1);
+		dst[2] = CLIP16 (v2);
+		dst[3] = CLIP16 (v3);
+		dst += 4; acc += 4;
 	}
-	return dst;
 }
 
+void
+mix_s8 (char *dst, const long *acc, long n)
+{
+	long v0, v1, v2, v3;
+
+	for ( ; n & 3; --n) {
+		v0 = *acc++;
+		*dst++ = CLIP16 (v0) >> 8;
+	}
+	while ((n -= 4) >= 0) {
+		v0 = acc[0]; v1 = acc[1]; v2 = acc[2]; v3 = acc[3];
+		dst[0] = CLIP16 (v0) >> 8;
+		dst[1] = CLIP16 (v1) >> 8;
+		dst[2] = CLIP16 (v2) >> 8;
+		dst[3] = CLIP16 (v3) >> 8;
+		dst += 4; acc += 4;
+	}
+}
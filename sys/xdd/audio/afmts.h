@@ -1,11 +1,32 @@
+/*
+ * sample format conversion and mixing kernels for /dev/audio
+ *
+ * These use no kernel services, tools/audiomix builds them on the
+ * host (and for the Atari) to check the output and the cost.
+ */
 
 # ifndef _afmts_h
 # define _afmts_h
 
-void *u8copy   (void *, const void *, long);
-void *ulawcopy (void *, const void *, long);
-void *u16copy  (void *, const void *, long);
-void *m16copy  (void *, const void *, long);
-void *mu16copy (void *, const void *, long);
+/*
+ * stream formats to signed 16 bit, n is the number of samples
+ * (frames times channels)
+ */
+typedef void (*afmt_cvt) (short *dst, const void *src, long n);
+
+void u8_s16   (short *, const void *, long);
+void s8_s16   (short *, const void *, long);
+void ulaw_s16 (short *, const void *, long);
+void u16_s16  (short *, const void *, long);
+void s16_s16  (short *, const void *, long);
+
+/*
+ * mixing: streams are summed into a long accumulator,
+ * which is clipped to the device format at the end
+ */
+void mix_clear (long *acc, long n);
+void mix_add   (long *acc, const short *src, long n);
+void mix_s16   (short *dst, const long *acc, long n);
+void mix_s8    (char *dst, const long *acc, long n);
 
 # endif /* _afmts_h */
@@ -8,6 +8,9 @@
  *
  *	9705, John Blakeley - version 0.8 - now works on the Falcon, properly.
  *	9802, John Blakeley - version 0.9 - added support for 16bit F030 support.
+ *
+ *	version 1.0 - software mixer: any number of openers (up to
+ *	MIX_MAXSTREAMS), each with its own format, channels and rate.
  */
 
 # include "global.h"
@@ -17,13 +20,12 @@
 # include "mint/ssystem.h"
 # include "cookie.h"
 
-# include "afmts.h"
-
 #include "device.h"
 #include "mfp.h"
+#include "mixer.h"
 
 
-#define AUDIO_VERSION	"0.9"
+#define AUDIO_VERSION	"1.0"
 
 static long	audio_open	(FILEPTR *f);
 static long	audio_write	(FILEPTR *f, const char *buf, long bytes);
@@ -178,7 +180,10 @@ audio_install (void)
 		return 1;
 	}
 
-	thedev.copyfn = (void *)memcpy;
+	if (mix_init ()) {
+		c_conws ("Cannot set up the mixer\r\n");
+		return 1;
+	}
 
 	ksprintf (msg, "hardware: %s, %s\r\n",
 		players[i].name, mixers[i].name);
@@ -193,34 +198,23 @@ audio_install (void)
 static long
 audio_open (FILEPTR *fp)
 {
-	/* Nothing to do */
+	struct stream *s;
+	long r;
+
+	r = mix_open (&s);
+	if (r)
+		return r;
+
+	fp->devinfo = (long) s;
 	return 0;
 }
 
 static long
 audio_write (FILEPTR *fp, const char *buf, long nbytes)
 {
-	long r, bufsize;
+	struct stream *s = (struct stream *) fp->devinfo;
 
-	bufsize = nbytes;
-	while (nbytes > 0) {
-		while ((*thedev.wspace) () == 0) {
-			if (fp->flags & O_NDELAY) {
-				return bufsize - nbytes;
-			}
-			nap (100);
-		}
-		r = (*thedev.copyin) (buf, nbytes);
-		if (r < 0) {
-			if (nbytes == bufsize) {
-				return r;
-			}
-			break;
-		}
-		nbytes -= r;
-		buf += r;
-	}
-	return bufsize - nbytes;
+	return mix_write (s, buf, nbytes, fp->flags & O_NDELAY);
 }
 
 static long
@@ -238,6 +232,7 @@ audio_lseek (FILEPTR *fp, long where, int whence)
 static long
 audio_ioctl (FILEPTR *fp, int mode, void *buf)
 {
+	struct stream *s = (struct stream *) fp->devinfo;
 	struct flock *g;
 	long arg = (long)buf;
 
@@ -250,12 +245,11 @@ audio_ioctl (FILEPTR *fp, int mode, void *buf)
 		return (*thedev.mix_ioctl) (mode, buf);
 
 	case AIOCRESET:
-		(*thedev.reset) ();
+		mix_flush (s);
 		return 0;
 
 	case AIOCSYNC:
-		while (thedev.status)
-			nap (50);
+		mix_sync (s);
 		return 0;
 
 	case AIOCGBLKSIZE:
@@ -263,60 +257,33 @@ audio_ioctl (FILEPTR *fp, int mode, void *buf)
 		break;
 
 	case AIOCGFMTS:
-		*(long *)arg = (long) thedev.format_map;
+		/* the mixer converts all of them */
+		*(long *)arg = AFMT_U8|AFMT_S8|AFMT_ULAW|AFMT_U16|AFMT_S16;
 		break;
 
 	case AIOCSFMT:
-		thedev.curformat = arg;
-		switch (arg) {
-		case AFMT_U8:
-			thedev.copyfn = u8copy;
-			thedev.ssize = 8;
-			break;
-
-		case AFMT_S8:
-			thedev.copyfn = (void *)memcpy;
-			thedev.ssize = 8;
-			break;
-
-		case AFMT_ULAW:
-			thedev.copyfn = ulawcopy;
-			thedev.ssize = 8;
-			break;
-
-		case AFMT_U16:
-			if (thedev.curchans == 1)
-				thedev.copyfn = mu16copy;
-			else
-				thedev.copyfn = u16copy;
-			thedev.ssize = 16;
-			break;
-
-		case AFMT_S16:
-			if (thedev.curchans == 1)
-				thedev.copyfn = m16copy;
-			else
-				thedev.copyfn = (void *)memcpy;
-			thedev.ssize = 16;
-			break;
+		return mix_setformat (s, arg);
 
-		default:
-			return EINVAL;
-		}
+	case AIOCGSPEED:
+		*(long *)arg = s->rate;
 		break;
 
-	case AIOCGSPEED:
 	case AIOCSSPEED:
+		return mix_setrate (s, arg);
+
 	case AIOCGCHAN:
+		*(long *)arg = s->chans;
+		break;
+
 	case AIOCSCHAN:
-		return (*thedev.ioctl) (mode, buf);
+		return mix_setchans (s, arg);
 
 	case FIONREAD:
 		*(long *)buf = (*thedev.rspace) ();
 		break;
 
 	case FIONWRITE:
-		*(long *)buf = (*thedev.wspace) ();
+		*(long *)buf = mix_wspace (s);
 		break;
 
 	case F_GETLK:
@@ -390,6 +357,8 @@ audio_close (FILEPTR *fp, int pid)
 		audio_lock.l_pid = -1;
 		wake (IO_Q, (long)&audio_lock);
 	}
+	if (fp->links <= 0)
+		mix_close ((struct stream *) fp->devinfo);
 	return 0;
 }
 
@@ -401,7 +370,7 @@ audio_select (FILEPTR *fp, long proc, int mode)
 		return 1;
 
 	case O_WRONLY:
-		if ((*thedev.wspace) () > 0) {
+		if (mix_wspace ((struct stream *) fp->devinfo) > 0) {
 			return 1;
 		}
 		if (audio_rsel == 0) {
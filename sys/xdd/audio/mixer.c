@@ -0,0 +1,435 @@
+/*
+ *	/dev/audio for Atari Ste, MegaSte, TT, Falcon running Mint.
+ *	(software mixer).
+ *
+ * Every open file is a stream with its own sample format, number of
+ * channels and rate. write() converts the samples to signed 16 bit at
+ * the hardware rate and channels (afmts.c, resample.c) into the
+ * stream's fifo; mix_run() sums the fifos into the DMA buffers through
+ * the hardware's copyin(). It runs after every write and from a
+ * timeout as long as samples are left.
+ *
+ * While several streams have samples, only as many frames are mixed as
+ * the emptiest of them has, so streams that are written in parallel
+ * stay in step; a stream that runs dry simply drops out.
+ *
+ * All of this runs in process context (write, ioctl, the timeout),
+ * never from the sound interrupts, so the fifos need no locking.
+ */
+
+# include "global.h"
+# include "mint/ioctl.h"
+
+# include "device.h"
+# include "mixer.h"
+
+
+# define MIX_FRAMES	512		/* mixed per round */
+# define MIX_TIMEOUT	20		/* ms, while samples are left */
+
+static struct stream *streams = NULL;
+static short nstreams = 0;
+
+static short dev_chans;			/* hardware setup, see mix_init */
+static short dev_bits;
+static short dev_fbytes;
+
+/*
+ * new streams start with the settings made last,
+ * so "actrl format ulaw; cat file >/dev/audio" still works
+ */
+static long def_format = AFMT_S8;
+static short def_chans = 1;
+static long def_rate;
+
+static TIMEOUT *mix_tmout = NULL;
+
+static long mixacc[MIX_FRAMES * 2];
+static short mixbuf[MIX_FRAMES * 2];
+
+
+static long
+fmt_lookup (long format, afmt_cvt *cvt, short *ssize)
+{
+	switch (format) {
+	case AFMT_U8:	*cvt = u8_s16;   *ssize = 1; break;
+	case AFMT_S8:	*cvt = s8_s16;   *ssize = 1; break;
+	case AFMT_ULAW:	*cvt = ulaw_s16; *ssize = 1; break;
+	case AFMT_U16:	*cvt = u16_s16;  *ssize = 2; break;
+	case AFMT_S16:	*cvt = s16_s16;  *ssize = 2; break;
+	default:
+		return EINVAL;
+	}
+	return 0;
+}
+
+/*
+ * the hardware takes the nearest rate it has, the
+ * streams are resampled to that
+ */
+static void
+hw_setrate (long rate)
+{
+	struct stream *s;
+
+	(*thedev.ioctl) (AIOCSSPEED, (void *) rate);
+
+	/* the F030's slowest setting mutes it */
+	if (thedev.srate <= 0)
+		(*thedev.ioctl) (AIOCSSPEED, (void *) 8195L);
+
+	for (s = streams; s; s = s->next)
+		rs_init (&s->rs, s->rate, thedev.srate, s->chans);
+}
+
+/* no samples anywhere but (maybe) in s */
+static short
+mix_idle (struct stream *s)
+{
+	struct stream *t;
+
+	for (t = streams; t; t = t->next)
+		if (t != s && t->fill)
+			return 0;
+
+	return 1;
+}
+
+long
+mix_init (void)
+{
+	dev_chans = (thedev.maxchans >= 2) ? 2 : 1;
+	dev_bits = (thedev.format_map & AFMT_S16) ? 16 : 8;
+	dev_fbytes = dev_chans * dev_bits / 8;
+
+	/* mix_run hands over samples in the hardware's format */
+	thedev.copyfn = (void *) memcpy;
+	thedev.ssize = dev_bits;
+	thedev.curformat = (dev_bits == 16) ? AFMT_S16 : AFMT_S8;
+
+	(*thedev.ioctl) (AIOCSCHAN, (void *) (long) dev_chans);
+	hw_setrate (12517L);
+
+	def_rate = thedev.srate;
+	return 0;
+}
+
+long
+mix_open (struct stream **sp)
+{
+	struct stream *s;
+
+	if (nstreams >= MIX_MAXSTREAMS)
+		return EBUSY;
+
+	s = kmalloc (sizeof (*s));
+	if (!s)
+		return ENOMEM;
+
+	s->fifo = kmalloc (MIX_FIFOFRAMES * dev_chans * sizeof (short));
+	if (!s->fifo) {
+		kfree (s);
+		return ENOMEM;
+	}
+
+	s->flags = 0;
+	s->format = def_format;
+	s->chans = def_chans;
+	s->rate = def_rate;
+	s->npart = 0;
+	s->head = s->tail = s->fill = 0;
+	fmt_lookup (s->format, &s->cvt, &s->ssize);
+	rs_init (&s->rs, s->rate, thedev.srate, s->chans);
+
+	s->next = streams;
+	streams = s;
+	nstreams++;
+
+	*sp = s;
+	return 0;
+}
+
+/*
+ * the stream goes away when its samples have been played
+ */
+void
+mix_close (struct stream *s)
+{
+	s->flags |= ST_CLOSED;
+	mix_run ();
+}
+
+long
+mix_setformat (struct stream *s, long format)
+{
+	long r;
+
+	r = fmt_lookup (format, &s->cvt, &s->ssize);
+	if (r)
+		return r;
+
+	s->format = def_format = format;
+	s->npart = 0;
+	return 0;
+}
+
+long
+mix_setchans (struct stream *s, long chans)
+{
+	if (chans != 1 && chans != 2)
+		return EINVAL;
+
+	s->chans = def_chans = chans;
+	s->npart = 0;
+	rs_init (&s->rs, s->rate, thedev.srate, s->chans);
+	return 0;
+}
+
+long
+mix_setrate (struct stream *s, long rate)
+{
+	if (rate < 1000 || rate > 100000L)
+		return EINVAL;
+
+	s->rate = def_rate = rate;
+
+	/* follow the only stream with the hardware, if it isn't playing */
+	if (rate != thedev.srate && !s->fill && mix_idle (s) && !thedev.status)
+		hw_setrate (rate);
+	else
+		rs_init (&s->rs, s->rate, thedev.srate, s->chans);
+
+	return 0;
+}
+
+/*
+ * convert and resample up to frames frames into the fifo,
+ * returns the number of frames taken
+ */
+static long
+mix_push (struct stream *s, const char *src, long frames)
+{
+	long done = 0;
+
+	while (done < frames) {
+		long space, n, in, out;
+
+		space = MIX_FIFOFRAMES - s->fill;
+		if (space > MIX_FIFOFRAMES - s->tail)
+			space = MIX_FIFOFRAMES - s->tail;
+		if (space <= 0)
+			break;
+
+		/* about the input that fills the space */
+		n = ((space * (long) (s->rs.step >> 8)) >> 8) + RS_TAPS;
+		if (n > frames - done)
+			n = frames - done;
+		if (n > MIX_CVTFRAMES)
+			n = MIX_CVTFRAMES;
+
+		(*s->cvt) (s->cbuf, src, n * s->chans);
+
+		in = n;
+		out = rs_run (&s->rs, s->fifo + s->tail * dev_chans, space,
+			      dev_chans, s->cbuf, &in);
+
+		s->tail = (s->tail + out) & (MIX_FIFOFRAMES - 1);
+		s->fill += out;
+
+		src += in * s->chans * s->ssize;
+		done += in;
+
+		if (!in && !out)
+			break;
+	}
+
+	return done;
+}
+
+long
+mix_write (struct stream *s, const char *buf, long nbytes, short ndelay)
+{
+	const long fbytes = s->chans * s->ssize;
+	long done = 0;
+
+	while (nbytes > 0) {
+		const char *src;
+		long frames, r;
+
+		if (s->npart || nbytes < fbytes) {
+			/*
+			 * complete the frame left over from the last write
+			 */
+			long k = fbytes - s->npart;
+
+			if (k > nbytes)
+				k = nbytes;
+			memcpy (s->part + s->npart, buf, k);
+			s->npart += k;
+			buf += k;
+			nbytes -= k;
+			done += k;
+
+			if (s->npart < fbytes)
+				break;
+
+			src = s->part;
+			frames = 1;
+		} else {
+			src = buf;
+			frames = nbytes / fbytes;
+		}
+
+		r = mix_push (s, src, frames);
+		if (src == s->part) {
+			if (r)
+				s->npart = 0;
+		} else {
+			buf += r * fbytes;
+			nbytes -= r * fbytes;
+			done += r * fbytes;
+		}
+
+		mix_run ();
+
+		if (!r) {
+			if (ndelay)
+				break;
+			nap (20);
+		}
+	}
+
+	return done;
+}
+
+/*
+ * AIOCRESET: drop what the stream has queued, and what the
+ * hardware has if nobody else is playing
+ */
+void
+mix_flush (struct stream *s)
+{
+	s->head = s->tail = s->fill = 0;
+	s->npart = 0;
+	rs_init (&s->rs, s->rate, thedev.srate, s->chans);
+
+	if (mix_idle (s))
+		(*thedev.reset) ();
+}
+
+/*
+ * AIOCSYNC: wait until the stream's samples are in the DMA buffers,
+ * and until they have been played if nobody else is playing
+ */
+void
+mix_sync (struct stream *s)
+{
+	while (s->fill) {
+		mix_run ();
+		if (s->fill)
+			nap (50);
+	}
+
+	while (thedev.status && mix_idle (s))
+		nap (50);
+}
+
+/* bytes a write can take without blocking */
+long
+mix_wspace (struct stream *s)
+{
+	long frames;
+
+	frames = MIX_FIFOFRAMES - s->fill;
+	frames = (frames * (long) (s->rs.step >> 8)) >> 8;
+
+	return frames * s->chans * s->ssize;
+}
+
+static void
+mix_timeout (PROC *p, long arg)
+{
+	mix_tmout = NULL;
+	mix_run ();
+}
+
+void
+mix_run (void)
+{
+	struct stream *s, **sp;
+	short left = 0;
+
+	for (;;) {
+		long n, len, r;
+		short active = 0;
+		char *p;
+
+		n = (*thedev.wspace) () / dev_fbytes;
+		if (n > MIX_FRAMES)
+			n = MIX_FRAMES;
+
+		for (s = streams; s; s = s->next) {
+			if (s->fill) {
+				if (s->fill < n)
+					n = s->fill;
+				active = 1;
+			}
+		}
+		if (!active || n <= 0)
+			break;
+
+		mix_clear (mixacc, n * dev_chans);
+
+		for (s = streams; s; s = s->next) {
+			long k, c;
+
+			if (!s->fill)
+				continue;
+
+			/* the fifo may wrap */
+			for (k = 0; k < n; k += c) {
+				c = MIX_FIFOFRAMES - s->head;
+				if (c > n - k)
+					c = n - k;
+				mix_add (mixacc + k * dev_chans,
+					 s->fifo + s->head * dev_chans, c * dev_chans);
+				s->head = (s->head + c) & (MIX_FIFOFRAMES - 1);
+			}
+			s->fill -= n;
+		}
+
+		if (dev_bits == 16)
+			mix_s16 (mixbuf, mixacc, n * dev_chans);
+		else
+			mix_s8 ((char *) mixbuf, mixacc, n * dev_chans);
+
+		/* copyin fills one DMA buffer at a time */
+		p = (char *) mixbuf;
+		for (len = n * dev_fbytes; len > 0; len -= r, p += r) {
+			r = (*thedev.copyin) (p, len);
+			if (r <= 0)
+				break;
+		}
+	}
+
+	/* free the closed streams that have been played */
+	sp = &streams;
+	while ((s = *sp) != NULL) {
+		if ((s->flags & ST_CLOSED) && !s->fill) {
+			*sp = s->next;
+			kfree (s->fifo);
+			kfree (s);
+			nstreams--;
+		} else {
+			if (s->fill)
+				left = 1;
+			sp = &s->next;
+		}
+	}
+
+	if (left && !mix_tmout)
+		mix_tmout = addroottimeout (MIX_TIMEOUT, mix_timeout, 0);
+
+	if (audio_rsel)
+		wakeselect (audio_rsel);
+}
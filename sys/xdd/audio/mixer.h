@@ -0,0 +1,50 @@
+/*
+ * software mixer for /dev/audio: every open file is a stream with
+ * its own format, channels and rate; the streams are converted to the
+ * hardware rate and summed.
+ */
+
+# ifndef _mixer_h
+# define _mixer_h
+
+# include "afmts.h"
+# include "resample.h"
+
+# define MIX_MAXSTREAMS	8
+# define MIX_FIFOFRAMES	8192		/* per stream, at the hardware rate */
+# define MIX_CVTFRAMES	256		/* converted per round */
+
+struct stream
+{
+	struct stream *next;
+	short	flags;
+# define ST_CLOSED	0x0001		/* free when drained */
+	short	chans;			/* 1 or 2 */
+	long	format;			/* AFMT_* */
+	long	rate;
+	afmt_cvt cvt;
+	short	ssize;			/* bytes per sample */
+	short	npart;			/* bytes in part */
+	char	part[4];		/* frame left over from the last write */
+
+	/* converted samples waiting for the mixer: hardware rate and channels */
+	short	*fifo;
+	long	head, tail, fill;	/* frames */
+
+	struct resampler rs;
+	short	cbuf[MIX_CVTFRAMES * 2];
+};
+
+long	mix_init	(void);
+long	mix_open	(struct stream **sp);
+void	mix_close	(struct stream *s);
+long	mix_write	(struct stream *s, const char *buf, long nbytes, short ndelay);
+long	mix_setformat	(struct stream *s, long format);
+long	mix_setchans	(struct stream *s, long chans);
+long	mix_setrate	(struct stream *s, long rate);
+void	mix_flush	(struct stream *s);
+void	mix_sync	(struct stream *s);
+long	mix_wspace	(struct stream *s);
+void	mix_run		(void);
+
+# endif /* _mixer_h */
@@ -0,0 +1,233 @@
+/*
+ * fixed point polyphase resampler for /dev/audio
+ *
+ * Converts a stream's sample rate to the hardware rate. The filter is
+ * a 4 tap Lanczos (a = 2) kernel sampled at 64 phases, coefficients
+ * in 1.14 fixed point. It is meant for the cheap case of going up
+ * to the hardware rate; going down it doesn't narrow its passband,
+ * so content above the new Nyquist frequency aliases.
+ *
+ * Equal rates only convert the channels.
+ */
+
+# include "resample.h"
+
+
+# define RS_PHASES	(1 << RS_PHASEBITS)
+
+static const short rs_coef[RS_PHASES][RS_TAPS] =
+{
+	{      0,  16384,      0,      0 },	/*  0/64 */
+	{   -158,  16375,    168,     -1 },	/*  1/64 */
+	{   -306,  16348,    346,     -4 },	/*  2/64 */
+	{   -443,  16301,    535,     -9 },	/*  3/64 */
+	{   -570,  16238,    733,    -17 },	/*  4/64 */
+	{   -688,  16158,    941,    -27 },	/*  5/64 */
+	{   -795,  16059,   1159,    -39 },	/*  6/64 */
+	{   -893,  15944,   1386,    -53 },	/*  7/64 */
+	{   -981,  15813,   1622,    -70 },	/*  8/64 */
+	{  -1060,  15666,   1868,    -90 },	/*  9/64 */
+	{  -1130,  15503,   2122,   -111 },	/* 10/64 */
+	{  -1191,  15325,   2385,   -135 },	/* 11/64 */
+	{  -1244,  15133,   2657,   -162 },	/* 12/64 */
+	{  -1288,  14927,   2936,   -191 },	/* 13/64 */
+	{  -1324,  14707,   3223,   -222 },	/* 14/64 */
+	{  -1353,  14475,   3517,   -255 },	/* 15/64 */
+	{  -1374,  14231,   3817,   -290 },	/* 16/64 */
+	{  -1389,  13976,   4125,   -328 },	/* 17/64 */
+	{  -1397,  13710,   4438,   -367 },	/* 18/64 */
+	{  -1398,  13432,   4758,   -408 },	/* 19/64 */
+	{  -1394,  13147,   5082,   -451 },	/* 20/64 */
+	{  -1385,  12853,   5411,   -495 },	/* 21/64 */
+	{  -1370,  12550,   5745,   -541 },	/* 22/64 */
+	{  -1351,  12239,   6083,   -587 },	/* 23/64 */
+	{  -1327,  11922,   6424,   -635 },	/* 24/64 */
+	{  -1300,  11599,   6768,   -683 },	/* 25/64 */
+	{  -1268,  11270,   7114,   -732 },	/* 26/64 */
+	{  -1234,  10937,   7463,   -782 },	/* 27/64 */
+	{  -1196,  10599,   7812,   -831 },	/* 28/64 */
+	{  -1156,  10257,   8163,   -880 },	/* 29/64 */
+	{  -1114,   9912,   8515,   -929 },	/* 30/64 */
+	{  -1070,   9565,   8866,   -977 },	/* 31/64 */
+	{  -1024,   9216,   9216,  -1024 },	/* 32/64 */
+	{   -977,   8866,   9565,  -1070 },	/* 33/64 */
+	{   -929,   8515,   9912,  -1114 },	/* 34/64 */
+	{   -880,   8163,  10257,  -1156 },	/* 35/64 */
+	{   -831,   7812,  10599,  -1196 },	/* 36/64 */
+	{   -782,   7463,  10937,  -1234 },	/* 37/64 */
+	{   -732,   7114,  11270,  -1268 },	/* 38/64 */
+	{   -683,   6768,  11599,  -1300 },	/* 39/64 */
+	{   -635,   6423,  11923,  -1327 },	/* 40/64 */
+	{   -587,   6082,  12240,  -1351 },	/* 41/64 */
+	{   -541,   5745,  12550,  -1370 },	/* 42/64 */
+	{   -495,   5411,  12853,  -1385 },	/* 43/64 */
+	{   -451,   5082,  13147,  -1394 },	/* 44/64 */
+	{   -408,   4757,  13433,  -1398 },	/* 45/64 */
+	{   -367,   4439,  13709,  -1397 },	/* 46/64 */
+	{   -328,   4125,  13976,  -1389 },	/* 47/64 */
+	{   -290,   3817,  14231,  -1374 },	/* 48/64 */
+	{   -255,   3517,  14475,  -1353 },	/* 49/64 */
+	{   -222,   3223,  14707,  -1324 },	/* 50/64 */
+	{   -191,   2936,  14927,  -1288 },	/* 51/64 */
+	{   -162,   2657,  15133,  -1244 },	/* 52/64 */
+	{   -135,   2385,  15325,  -1191 },	/* 53/64 */
+	{   -111,   2122,  15503,  -1130 },	/* 54/64 */
+	{    -90,   1868,  15666,  -1060 },	/* 55/64 */
+	{    -70,   1622,  15813,   -981 },	/* 56/64 */
+	{    -53,   1385,  15945,   -893 },	/* 57/64 */
+	{    -39,   1158,  16060,   -795 },	/* 58/64 */
+	{    -27,    941,  16158,   -688 },	/* 59/64 */
+	{    -17,    732,  16239,   -570 },	/* 60/64 */
+	{     -9,    534,  16302,   -443 },	/* 61/64 */
+	{     -4,    347,  16347,   -306 },	/* 62/64 */
+	{     -1,    168,  16375,   -158 },	/* 63/64 */
+};
+
+# define CLIP16(v)	((v) > 32767 ? 32767 : ((v) < -32768 ? -32768 : (v)))
+
+/* one output sample from 4 input frames of ch channels */
+# define FIR(x, c, ch)	((((long) (c)[0] * (x)[0] + (long) (c)[1] * (x)[ch] \
+			 + (long) (c)[2] * (x)[2 * (ch)] + (long) (c)[3] * (x)[3 * (ch)]) \
+			 + 8192) >> 14)
+
+
+void
+rs_init (struct resampler *rs, long inrate, long outrate, short chans)
+{
+	short i;
+
+	rs->step = ((unsigned long) (inrate / outrate) << 16)
+		+ ((unsigned long) (inrate % outrate) << 16) / outrate;
+	rs->chans = chans;
+
+	/*
+	 * one frame of silence in front, so that the first output
+	 * sample is the first input sample
+	 */
+	rs->pos = 0;
+	rs->nbuf = 1;
+	for (i = 0; i < RS_TAPS * 2; i++)
+		rs->buf[i] = 0;
+}
+
+/* copy frames, converting the number of channels */
+static void
+rs_map (short *dst, const short *src, long n, short inchans, short outchans)
+{
+	if (inchans == outchans) {
+		n *= inchans;
+		for ( ; n & 3; --n)
+			*dst++ = *src++;
+		while ((n -= 4) >= 0) {
+			dst[0] = src[0]; dst[1] = src[1];
+			dst[2] = src[2]; dst[3] = src[3];
+			dst += 4; src += 4;
+		}
+	} else if (inchans == 1) {
+		for ( ; n & 3; --n, ++src) {
+			*dst++ = *src;
+			*dst++ = *src;
+		}
+		while ((n -= 4) >= 0) {
+			dst[0] = dst[1] = src[0];
+			dst[2] = dst[3] = src[1];
+			dst[4] = dst[5] = src[2];
+			dst[6] = dst[7] = src[3];
+			dst += 8; src += 4;
+		}
+	} else {
+		for ( ; n & 3; --n, src += 2)
+			*dst++ = ((long) src[0] + src[1]) >> 1;
+		while ((n -= 4) >= 0) {
+			dst[0] = ((long) src[0] + src[1]) >> 1;
+			dst[1] = ((long) src[2] + src[3]) >> 1;
+			dst[2] = ((long) src[4] + src[5]) >> 1;
+			dst[3] = ((long) src[6] + src[7]) >> 1;
+			dst += 4; src += 8;
+		}
+	}
+}
+
+/*
+ * rs_run: make up to nout frames of outchans channels at dst from the
+ * *nin frames at src; returns the frames made, *nin is set to the
+ * input frames used. Input is only taken as far as it is needed.
+ */
+long
+rs_run (struct resampler *rs, short *dst, long nout, short outchans,
+	const short *src, long *nin)
+{
+	const short ch = rs->chans;
+	long avail = *nin, used = 0, done = 0;
+
+	if (rs->step == 0x10000L) {
+		done = (nout < avail) ? nout : avail;
+		rs_map (dst, src, done, ch, outchans);
+		*nin = done;
+		return done;
+	}
+
+	while (done < nout) {
+		long i = rs->pos >> 16;
+		const short *c, *x;
+		long l, r;
+
+		if (i + RS_TAPS > rs->nbuf) {
+			long drop, n, k;
+
+			if (used == avail)
+				break;
+
+			/* drop the frames behind us */
+			drop = (i < rs->nbuf) ? i : rs->nbuf;
+			for (k = 0; k < (rs->nbuf - drop) * ch; k++)
+				rs->buf[k] = rs->buf[k + drop * ch];
+			rs->nbuf -= drop;
+			rs->pos -= (unsigned long) drop << 16;
+
+			/* going down we may skip input altogether */
+			n = rs->pos >> 16;
+			if (n > avail - used)
+				n = avail - used;
+			used += n;
+			rs->pos -= (unsigned long) n << 16;
+			src += n * ch;
+
+			n = RS_BLOCK + RS_TAPS - rs->nbuf;
+			if (n > avail - used)
+				n = avail - used;
+			for (k = 0; k < n * ch; k++)
+				rs->buf[rs->nbuf * ch + k] = src[k];
+			rs->nbuf += n;
+			used += n;
+			src += n * ch;
+			continue;
+		}
+
+		c = rs_coef[(rs->pos >> (16 - RS_PHASEBITS)) & (RS_PHASES - 1)];
+		x = rs->buf + i * ch;
+
+		l = FIR (x, c, ch);
+		l = CLIP16 (l);
+		if (ch == 1) {
+			*dst++ = l;
+			if (outchans == 2)
+				*dst++ = l;
+		} else {
+			r = FIR (x + 1, c, ch);
+			r = CLIP16 (r);
+			if (outchans == 1)
+				*dst++ = (l + r) >> 1;
+			else {
+				*dst++ = l;
+				*dst++ = r;
+			}
+		}
+
+		rs->pos += rs->step;
+		done++;
+	}
+
+	*nin = used;
+	return done;
+}
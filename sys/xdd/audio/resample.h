@@ -0,0 +1,27 @@
+/*
+ * fixed point polyphase resampler for /dev/audio
+ *
+ * Like afmts.c this uses no kernel services.
+ */
+
+# ifndef _resample_h
+# define _resample_h
+
+# define RS_TAPS	4		/* filter length */
+# define RS_PHASEBITS	6		/* 64 filter phases */
+# define RS_BLOCK	256		/* input frames buffered at a time */
+
+struct resampler
+{
+	unsigned long step;		/* input frames per output frame, 16.16 */
+	unsigned long pos;		/* position in buf, 16.16 */
+	short	chans;			/* input channels, 1 or 2 */
+	short	nbuf;			/* frames in buf */
+	short	buf[(RS_BLOCK + RS_TAPS) * 2];
+};
+
+void rs_init (struct resampler *rs, long inrate, long outrate, short chans);
+long rs_run  (struct resampler *rs, short *dst, long nout, short outchans,
+	      const short *src, long *nin);
+
+# endif /* _resample_h */
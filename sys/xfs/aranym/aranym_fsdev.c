@@ -170,6 +170,7 @@ FILESYS arafs_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_LONGPATH		|
@@ -219,7 +220,9 @@ FILESYS arafs_filesys =
 
 	/* FS_EXT_3 */
 	stat64:			ara_stat64,
-	res1:			0,
+
+	/* FS_EXT_4 */
+	readdirplus:		NULL,
 	res2:			0,
 	res3:			0,
 
@@ -81,6 +81,42 @@ load_block_bitmap (SI *s, ulong block_group)
 	return u;
 }
 
+/*
+ * Free space summary
+ * 
+ * For every block group we keep an upper bound of the longest free
+ * run in its block bitmap and the lowest bit that may be free. Both
+ * live in memory only and start out as "anything is possible". A
+ * full scan of a group makes the bound exact, allocations keep it
+ * valid and freeing a run of n blocks can at most join it with its
+ * two neighbours. This lets ext2_new_blocks() skip groups that can't
+ * satisfy a request without reading their bitmap.
+ */
+
+static void
+group_run_freed (SI *s, ulong group, ulong bit, ulong count)
+{
+	struct ext2_group_run *gr = &(s->sbi.s_group_run [group]);
+	ulong max_run = (gr->max_run << 1) + count;
+	
+	if (max_run > EXT2_BLOCKS_PER_GROUP (s))
+		max_run = EXT2_BLOCKS_PER_GROUP (s);
+	
+	gr->max_run = max_run;
+	
+	if (bit < gr->first_free)
+		gr->first_free = bit;
+}
+
+/* true if the caller may use the reserved blocks
+ */
+INLINE long
+may_use_reserved (SI *s)
+{
+	return ((s->sbi.s_resuid == p_geteuid ())
+		|| (s->sbi.s_resgid != 0 && s->sbi.s_resgid == p_getegid ()));
+}
+
 
 void
 ext2_free_blocks (COOKIE *inode, ulong block, ulong count)
@@ -161,6 +197,8 @@ do_more:
 		}
 	}
 	
+	group_run_freed (s, block_group, bit, count);
+	
 	bio_MARK_MODIFIED (&bio, u);
 	bio_MARK_MODIFIED (&bio, u2);
 	bio_MARK_MODIFIED (&bio, s->sbi.s_sb_unit);
@@ -469,6 +507,294 @@ io_error:
 	
 }
 
+/*
+ * Look for a run of at least "want" free bits in a block bitmap,
+ * starting at bit "start". Returns the start of the first run that
+ * is long enough, or of the longest run seen if there is none, and
+ * its length in *len. If the scan covered the whole group the
+ * summary of the group is updated.
+ */
+static ulong
+find_free_run (SI *s, ulong group, const void *map, ulong start, ulong want, ulong *len)
+{
+	struct ext2_group_run *gr = &(s->sbi.s_group_run [group]);
+	ulong size = EXT2_BLOCKS_PER_GROUP (s);
+	ulong from = start;
+	ulong best = size;
+	
+	*len = 0;
+	
+	if (from <= gr->first_free)
+		from = gr->first_free;
+	
+	while (from < size)
+	{
+		ulong first, end;
+		
+		first = ext2_find_next_zero_bit (map, size, from);
+		if (first >= size)
+			break;
+		
+		if (start <= gr->first_free && from == gr->first_free)
+			gr->first_free = first;
+		
+		end = ext2_find_next_set_bit (map, size, first);
+		if (end - first > *len)
+		{
+			best = first;
+			*len = end - first;
+			
+			if (*len >= want)
+				return best;
+		}
+		
+		from = end;
+	}
+	
+	/* complete scan, the bound is exact now */
+	if (start <= gr->first_free)
+	{
+		gr->max_run = *len;
+		if (!*len)
+			gr->first_free = size;
+	}
+	
+	return best;
+}
+
+/*
+ * Mark the bits [bit, bit + count) of a group as used and account
+ * for them; the run is shortened if it hits a used bit.
+ */
+static long
+alloc_run (SI *s, ulong group, UNIT *u, ulong bit, ulong *count, long *err)
+{
+	struct ext2_group_run *gr = &(s->sbi.s_group_run [group]);
+	ext2_gd *gdp;
+	UNIT *u2;
+	ulong block;
+	ulong i;
+	
+	gdp = ext2_get_group_desc (s, group, &u2);
+	if (!gdp)
+	{
+		*err = EREAD;
+		return 0;
+	}
+	
+	block = bit + group * EXT2_BLOCKS_PER_GROUP (s) + s->sbi.s_first_data_block;
+	
+	if (block + *count > s->sbi.s_blocks_count)
+	{
+		ALERT (("Ext2-FS: ext2_new_blocks [%c]: block >= blocks count - "
+			"block_group = %ld, block = %ld", DriveToLetter(s->dev), group, block + *count));
+		
+		*err = EIO;
+		return 0;
+	}
+	
+	if (test_opt (s, CHECK_STRICT)
+		&& (in_range (le2cpu32 (gdp->bg_block_bitmap), block, *count)
+			|| in_range (le2cpu32 (gdp->bg_inode_bitmap), block, *count)
+			|| in_range (block, le2cpu32 (gdp->bg_inode_table), s->sbi.s_itb_per_group)
+			|| in_range (block + *count - 1, le2cpu32 (gdp->bg_inode_table), s->sbi.s_itb_per_group)))
+	{
+		FATAL ("ext2_new_blocks: "
+			"Allocating blocks in system zone - "
+			"block = %lu, count = %lu", block, *count);
+	}
+	
+	for (i = 0; i < *count; i++)
+	{
+		if (ext2_set_bit (bit + i, u->data))
+		{
+			ALERT (("Ext2-FS: ext2_new_blocks [%c]: bit already set for block %ld",
+				DriveToLetter(s->dev), block + i));
+			break;
+		}
+	}
+	
+	*count = i;
+	if (!i)
+	{
+		*err = EIO;
+		return 0;
+	}
+	
+	if (bit == gr->first_free)
+		gr->first_free += i;
+	
+	bio_MARK_MODIFIED (&bio, u);
+	
+	gdp->bg_free_blocks_count = cpu2le16 (le2cpu16 (gdp->bg_free_blocks_count) - i);
+	bio_MARK_MODIFIED (&bio, u2);
+	
+	s->sbi.s_sb->s_free_blocks_count = cpu2le32 (le2cpu32 (s->sbi.s_sb->s_free_blocks_count) - i);
+	bio_MARK_MODIFIED (&bio, s->sbi.s_sb_unit);
+	
+	s->sbi.s_dirty = 1;
+	*err = E_OK;
+	
+	return block;
+}
+
+/*
+ * ext2_new_blocks allocates a run of up to *count contiguous blocks
+ * and returns the first one; *count is set to the length of the run.
+ * 
+ * If the goal block is free the run starts there and extends as far
+ * as the bitmap allows. Otherwise the groups are searched, starting
+ * with the goal group, for the first run that is long enough; groups
+ * whose summary says they can't have one are skipped unread. If no
+ * group has such a run the request is reduced to the longest run we
+ * know of and the search is repeated.
+ * 
+ * With "exact" set only the goal is tried; this is used to extend an
+ * existing reservation.
+ * 
+ * Bitmap, group descriptor and super block are updated once per run.
+ */
+long
+ext2_new_blocks (COOKIE *inode, ulong goal, ulong *count, long exact, long *err)
+{
+	SI *s = inode->s;
+	ulong bpg = EXT2_BLOCKS_PER_GROUP (s);
+	ulong want = *count;
+	ulong avail;
+	ulong group, bit;
+	ulong len;
+	UNIT *u;
+	
+	
+	*count = 0;
+	*err = ENOSPC;
+	
+	/* lock_super (s); */
+	
+	avail = le2cpu32 (s->sbi.s_sb->s_free_blocks_count);
+	if (!may_use_reserved (s))
+	{
+		ulong reserved = le2cpu32 (s->sbi.s_sb->s_r_blocks_count);
+		
+		if (avail <= reserved)
+		{
+			DEBUG (("ext2_new_blocks: no free user blocks!"));
+			return 0;
+		}
+		
+		avail -= reserved;
+	}
+	
+	if (want > avail)
+		want = avail;
+	
+	if (want > bpg)
+		want = bpg;
+	
+	if (!want)
+		return 0;
+	
+	DEBUG (("ext2_new_blocks: goal = %lu, want = %lu", goal, want));
+	
+	if (goal < s->sbi.s_first_data_block || goal >= s->sbi.s_blocks_count)
+	{
+		if (exact)
+			return 0;
+		
+		goal = s->sbi.s_first_data_block;
+	}
+	
+	group = (goal - s->sbi.s_first_data_block) / bpg;
+	bit = (goal - s->sbi.s_first_data_block) % bpg;
+	
+	/* First, test whether the goal block is free.
+	 */
+	u = load_block_bitmap (s, group);
+	if (!u)
+	{
+		*err = EREAD;
+		return 0;
+	}
+	
+	if (!ext2_test_bit (bit, u->data))
+	{
+		len = ext2_find_next_set_bit (u->data, bit + want < bpg ? bit + want : bpg, bit) - bit;
+		
+		DEBUG (("ext2_new_blocks: goal hit (%lu blocks)", len));
+		
+		*count = len;
+		return alloc_run (s, group, u, bit, count, err);
+	}
+	
+	if (exact)
+		return 0;
+	
+	while (want)
+	{
+		ulong best = 0;
+		ulong i;
+		
+		/* remainder of the goal group first, then all groups
+		 * cyclicly; the goal group is visited again from its
+		 * start at the end
+		 */
+		for (i = 0; i <= s->sbi.s_groups_count; i++)
+		{
+			ulong g = (group + i) % s->sbi.s_groups_count;
+			struct ext2_group_run *gr = &(s->sbi.s_group_run [g]);
+			ext2_gd *gdp;
+			ulong start;
+			
+			gdp = ext2_get_group_desc (s, g, NULL);
+			if (!gdp)
+			{
+				*err = EREAD;
+				return 0;
+			}
+			
+			if (!le2cpu16 (gdp->bg_free_blocks_count))
+				continue;
+			
+			if (gr->max_run < want)
+			{
+				if (gr->max_run > best)
+					best = gr->max_run;
+				
+				continue;
+			}
+			
+			u = load_block_bitmap (s, g);
+			if (!u)
+			{
+				*err = EREAD;
+				return 0;
+			}
+			
+			start = (i == 0) ? bit : 0;
+			start = find_free_run (s, g, u->data, start, want, &len);
+			if (len >= want)
+			{
+				DEBUG (("ext2_new_blocks: run %lu:%lu (%lu blocks)", g, start, want));
+				
+				*count = want;
+				return alloc_run (s, g, u, start, count, err);
+			}
+			
+			if (len > best)
+				best = len;
+		}
+		
+		/* best < want here */
+		want = best;
+	}
+	
+	ALERT (("Ext2-FS: ext2_new_blocks [%c]: "
+		"Free blocks count corrupted, no free run found", DriveToLetter(s->dev)));
+	
+	/* unlock_super (s); */
+	return 0;
+}
+
 
 INLINE long
 block_in_use (ulong block, SI *s, uchar *map)
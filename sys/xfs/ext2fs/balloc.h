@@ -30,6 +30,7 @@
 
 void	ext2_free_blocks		(COOKIE *inode, ulong block, ulong count);
 long	ext2_new_block			(COOKIE *inode, ulong goal, ulong *prealloc_count, ulong *prealloc_block, long *err);
+long	ext2_new_blocks			(COOKIE *inode, ulong goal, ulong *count, long exact, long *err);
 long	ext2_group_sparse		(long group);
 void	ext2_check_blocks_bitmap	(SI * s);
 
@@ -31,19 +31,16 @@
 ulong
 ext2_count_free (char *map, ulong numchars)
 {
-	static long nibblemap [] = { 4, 3, 3, 2, 3, 2, 2, 1, 3, 2, 2, 1, 2, 1, 1, 0 };
-	
-	register ulong i;
-	register ulong sum = 0;
+	ulong used;
+	ulong i;
 	
 	if (!map) 
 		return 0;
 	
-	for (i = 0; i < numchars; i++)
-	{
-		sum += nibblemap[(map [i]     ) & 0xf];
-		sum += nibblemap[(map [i] >> 4) & 0xf];
-	}
+	/* bit order doesn't matter for counting */
+	used = bitmap_weight ((const __u32 *) map, numchars >> 2);
+	for (i = numchars & ~3UL; i < numchars; i++)
+		used += bitmap_weight32 ((uchar) map [i]);
 	
-	return sum;
+	return (numchars << 3) - used;
 }
@@ -30,6 +30,9 @@
 
 # include "global.h"
 
+# include <mint/bitmap.h>
+# include <mint/endian.h>
+
 
 ulong	ext2_count_free	(char *map, ulong numchars);
 
@@ -130,55 +133,68 @@ ext2_test_bit (long nr, const void *addr)
 
 # endif
 
+/* Bit n of an ext2 bitmap is bit (n & 7) of byte (n >> 3); read as
+ * little endian 32 bit words the bits are in order, so the scans
+ * below can skip full (or empty) words at once.
+ */
+
 INLINE long
-ext2_find_first_zero_bit (const void *vaddr, ulong size)
+ext2_find_next_zero_bit (const void *vaddr, ulong size, ulong offset)
 {
-	const unsigned long *p = vaddr, *addr = vaddr;
+	const __u32 *map = vaddr;
+	long k = offset >> 5;
+	long end = (size + 31UL) >> 5;
 	long res;
-	ulong tmp;
+	__u32 w;
 	
-	if (!size)
-		return 0;
-	tmp = size >> 5;
-
-	if ((size & 31UL))
-		tmp += 1;
-
-	while (*p++ == -1UL) {
-		if (--tmp == 0)
-			return (p - addr) << 5;
-	}
-	--p;
-	for (res = 0; res < 32L; res++)	{
-		if (!ext2_test_bit(res, p))
-			break;
+	if (offset >= size)
+		return size;
+	
+	/* ignore the bits below offset in the first word */
+	w = le2cpu32 (map [k]) | ((1UL << (offset & 31UL)) - 1);
+	while (w == 0xffffffffUL)
+	{
+		k = bitmap_skip (map, k + 1, end, 0xffffffffUL);
+		if (k >= end)
+			return size;
+		
+		w = le2cpu32 (map [k]);
 	}
-	return (p - addr) * 32L + res;
+	
+	res = (k << 5) + bitmap_ffz32 (w);
+	return ((ulong) res < size) ? res : (long) size;
 }
 
 INLINE long
-ext2_find_next_zero_bit (const void *vaddr, ulong size, ulong offset)
+ext2_find_first_zero_bit (const void *vaddr, ulong size)
+{
+	return ext2_find_next_zero_bit (vaddr, size, 0);
+}
+
+INLINE long
+ext2_find_next_set_bit (const void *vaddr, ulong size, ulong offset)
 {
-	const unsigned long *addr = vaddr;
-	const unsigned long *p = addr + (offset >> 5);
-	long bit = offset & 31L, res;
+	const __u32 *map = vaddr;
+	long k = offset >> 5;
+	long end = (size + 31UL) >> 5;
+	long res;
+	__u32 w;
 	
 	if (offset >= size)
 		return size;
 	
-	if (bit)
+	w = le2cpu32 (map [k]) & ~((1UL << (offset & 31UL)) - 1);
+	while (!w)
 	{
-		/* Look for zero in first longword */
-		for (res = bit; res < 32L; res++)
-			if (!ext2_test_bit (res, p))
-				return (p - addr) * 32L + res;
-		p++;
+		k = bitmap_skip (map, k + 1, end, 0);
+		if (k >= end)
+			return size;
+		
+		w = le2cpu32 (map [k]);
 	}
 	
-	/* No zero yet, search remaining full bytes for a zero */
-	res = ext2_find_first_zero_bit (p, size - 32UL * (p - addr));
-	
-	return (p - addr) * 32L + res;
+	res = (k << 5) + bitmap_ffs32 (w);
+	return ((ulong) res < size) ? res : (long) size;
 }
 
 # endif /* _bitmap_h */
@@ -40,6 +40,11 @@
 # define EXT2_PREALLOCATE
 # define EXT2_DEFAULT_PREALLOC_BLOCKS	8
 
+/*
+ * Upper limit for the runs ext2_reserve_blocks() asks for
+ */
+# define EXT2_MAX_RESERVE_BLOCKS	1024
+
 /*
  * The second extended file system version
  */
@@ -389,9 +394,36 @@ struct ext2_super_block
 	__u8	s_prealloc_blocks;	/* Nr of blocks to try to preallocate*/
 	__u8	s_prealloc_dir_blocks;	/* Nr to preallocate for dirs */
 	__u16	s_padding1;
-	__u32	s_reserved[204];	/* Padding to the end of the block */
+	/*
+	 * Journaling support valid if EXT3_FEATURE_COMPAT_HAS_JOURNAL set.
+	 */
+	__u8	s_journal_uuid[16];	/* uuid of journal superblock */
+	__u32	s_journal_inum;		/* inode number of journal file */
+	__u32	s_journal_dev;		/* device number of journal file */
+	__u32	s_last_orphan;		/* start of list of inodes to delete */
+	__u32	s_hash_seed[4];		/* HTREE hash seed */
+	__u8	s_def_hash_version;	/* Default hash version to use */
+	__u8	s_reserved_char_pad;
+	__u16	s_desc_size;		/* size of group descriptor */
+	__u32	s_default_mount_opts;
+	__u32	s_first_meta_bg; 	/* First metablock block group */
+	__u32	s_mkfs_time;		/* When the filesystem was created */
+	__u32	s_jnl_blocks[17]; 	/* Backup of the journal inode */
+	__u32	s_blocks_count_hi;	/* Blocks count */
+	__u32	s_r_blocks_count_hi;	/* Reserved blocks count */
+	__u32	s_free_blocks_hi; 	/* Free blocks count */
+	__u16	s_min_extra_isize;	/* All inodes have at least # bytes */
+	__u16	s_want_extra_isize; 	/* New inodes should reserve # bytes */
+	__u32	s_flags;		/* Miscellaneous flags */
+	__u32	s_reserved[167];	/* Padding to the end of the block */
 };
 
+/*
+ * Superblock s_flags
+ */
+# define EXT2_FLAGS_SIGNED_HASH		0x0001	/* Signed dirhash in use */
+# define EXT2_FLAGS_UNSIGNED_HASH	0x0002	/* Unsigned dirhash in use */
+
 /*
  * Codes for operating systems
  */
@@ -422,6 +454,7 @@ struct ext2_super_block
 # define EXT2_HAS_INCOMPAT_FEATURE(sb, mask)	(EXT2_SB(sb)->s_feature_incompat & (mask))
 
 # define EXT2_FEATURE_COMPAT_DIR_PREALLOC	0x0001
+# define EXT2_FEATURE_COMPAT_DIR_INDEX		0x0020
 
 # define EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER	0x0001
 # define EXT2_FEATURE_RO_COMPAT_LARGE_FILE	0x0002
@@ -429,9 +462,15 @@ struct ext2_super_block
 
 # define EXT2_FEATURE_INCOMPAT_COMPRESSION	0x0001
 # define EXT2_FEATURE_INCOMPAT_FILETYPE		0x0002
+# define EXT4_FEATURE_INCOMPAT_EXTENTS		0x0040
+# define EXT4_FEATURE_INCOMPAT_FLEX_BG		0x0200
 
 # define EXT2_FEATURE_COMPAT_SUPP	0
-# define EXT2_FEATURE_INCOMPAT_SUPP	EXT2_FEATURE_INCOMPAT_FILETYPE
+# define EXT2_FEATURE_INCOMPAT_SUPP	( EXT2_FEATURE_INCOMPAT_FILETYPE	\
+					| EXT2_FEATURE_INCOMPAT_RDONLY		)
+/* incompatible features we can read but not write */
+# define EXT2_FEATURE_INCOMPAT_RDONLY	( EXT4_FEATURE_INCOMPAT_EXTENTS		\
+					| EXT4_FEATURE_INCOMPAT_FLEX_BG		)
 # define EXT2_FEATURE_RO_COMPAT_SUPP	( EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER	\
 					| EXT2_FEATURE_RO_COMPAT_LARGE_FILE	\
 					| EXT2_FEATURE_RO_COMPAT_BTREE_DIR	)
@@ -494,6 +533,43 @@ struct ext2_dir_entry_2
 # define EXT2_DIR_ROUND 	(EXT2_DIR_PAD - 1)
 # define EXT2_DIR_REC_LEN(len)	(((len) + 8 + EXT2_DIR_ROUND) & ~EXT2_DIR_ROUND)
 
+/*
+ * ext4 extent tree; for inodes with EXT4_EXTENTS_FL i_block holds the
+ * header followed by up to 4 extents or index entries
+ */
+# define EXT4_EXT_MAGIC		0xf30a
+
+struct ext4_extent_header
+{
+	__u16	eh_magic;		/* EXT4_EXT_MAGIC */
+	__u16	eh_entries;		/* number of valid entries */
+	__u16	eh_max;			/* capacity of store in entries */
+	__u16	eh_depth;		/* has tree real underlying blocks? */
+	__u32	eh_generation;		/* generation of the tree */
+};
+
+/* leaf entry */
+struct ext4_extent
+{
+	__u32	ee_block;		/* first logical block extent covers */
+	__u16	ee_len;			/* number of blocks covered by extent */
+	__u16	ee_start_hi;		/* high 16 bits of physical block */
+	__u32	ee_start_lo;		/* low 32 bits of physical block */
+};
+
+/* index entry */
+struct ext4_extent_idx
+{
+	__u32	ei_block;		/* index covers logical blocks from 'block' */
+	__u32	ei_leaf_lo;		/* pointer to the physical block of the next level */
+	__u16	ei_leaf_hi;		/* high 16 bits of physical block */
+	__u16	ei_unused;
+};
+
+/* ee_len above this marks an uninitialized (preallocated) extent */
+# define EXT4_EXT_INIT_MAX_LEN	(1UL << 15)
+# define EXT4_EXT_MAX_DEPTH	5
+
 
 
 
@@ -509,6 +585,15 @@ typedef struct ext2_sb_info	ext2_si;
 # define EXT2_SB(s)		(&(s->sbi))
 
 
+/* in-memory free space summary of a block group, see balloc.c
+ */
+struct ext2_group_run
+{
+	__u32	max_run;		/* upper bound of the longest free run */
+	__u32	first_free;		/* no free block below this bit */
+};
+
+
 struct ext2_sb_info
 {
 	__u32	s_blocksize;		/* Size of a block in bytes */
@@ -535,6 +620,7 @@ struct ext2_sb_info
 	ext2_sb	*s_sb;			/* ptr to our superblock (resident) */
 
 	UNIT	**s_group_desc_units;	/* the units for the group descriptors blocks */
+	struct ext2_group_run *s_group_run; /* free space summary per group */
 	UNIT	*s_sb_unit;		/* the unit for the superblock */
 
 	__u32	s_dirty;		/* dirty flag for super block */
@@ -586,6 +672,9 @@ struct ext2_sb_info
 /* nn	__u32	s_algorithm_use_bitmap;	 * For compression */
 	__u8	s_prealloc_blocks;	/* Nr of blocks to try to preallocate*/
 	__u8	s_prealloc_dir_blocks;	/* Nr to preallocate for dirs */
+	__u32	s_hash_seed[4];		/* HTREE hash seed */
+	__u8	s_def_hash_version;	/* Default hash version to use */
+	__u8	s_hash_unsigned;	/* 3 if hash should be unsigned, 0 if not */
 };
 
 
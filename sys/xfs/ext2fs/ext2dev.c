@@ -283,6 +283,11 @@ e_write (FILEPTR *f, const char *buf, long bytes)
 		pos += data;
 	}
 	
+	/* reserve the blocks for the rest of the write as one run
+	 */
+	if (todo)
+		ext2_reserve_blocks (c, block, (todo + EXT2_BLOCK_SIZE_MASK (s)) >> EXT2_BLOCK_SIZE_BITS (s));
+	
 	/* full blocks
 	 */
 	while (todo >> EXT2_BLOCK_SIZE_BITS (s))
@@ -440,42 +445,21 @@ e_read (FILEPTR *f, char *buf, long bytes)
 		f->pos += data;
 	}
 	
-	/* full blocks
+	/* full blocks; one bio.l_read per contiguous run
 	 */
 	while (todo >> EXT2_BLOCK_SIZE_BITS (s))
 	{
-		long blocks = 1;
-		long data = EXT2_BLOCK_SIZE (s);
+		long blocks;
+		long data;
 		ulong tmp;
 		
-		tmp = ext2_bmap (c, block++);
+		tmp = ext2_bmap_extent (c, block, todo >> EXT2_BLOCK_SIZE_BITS (s), &blocks);
+		data = blocks << EXT2_BLOCK_SIZE_BITS (s);
+		
 		if (tmp)
 		{
 			long r;
 			
-			if ((todo - data) >= EXT2_BLOCK_SIZE (s))
-			{
-				register ulong tmp_new = ext2_bmap (c, block);
-				register long tmp_old = tmp;
-				
-				/* linear read optimization
-				 */
-				while (tmp_new && ((tmp_new - tmp_old) == 1))
-				{
-					data += EXT2_BLOCK_SIZE (s);
-					block++;
-					blocks++;
-					
-					if ((todo - data) >= EXT2_BLOCK_SIZE (s))
-					{
-						tmp_old = tmp_new;
-						tmp_new = ext2_bmap (c, block);
-					}
-					else
-						break;
-				}
-			}
-			
 			r = bio.l_read (s->di, tmp, blocks, EXT2_BLOCK_SIZE (s), buf);
 			if (r)
 			{
@@ -486,6 +470,7 @@ e_read (FILEPTR *f, char *buf, long bytes)
 		else
 			bzero (buf, data);
 		
+		block += blocks;
 		buf += data;
 		todo -= data;
 		done += data;
@@ -65,6 +65,7 @@ static long	_cdecl e_rename		(fcookie *olddir, char *oldname, fcookie *newdir, c
 
 static long	_cdecl e_opendir	(DIR *dirh, int flag);
 static long	_cdecl e_readdir	(DIR *dirh, char *name, int namelen, fcookie *fc);
+static long	_cdecl e_readdirplus	(DIR *dirh, char *buf, long len);
 static long	_cdecl e_rewinddir	(DIR *dirh);
 static long	_cdecl e_closedir	(DIR *dirh);
 
@@ -105,6 +106,7 @@ FILESYS ext2_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_LONGPATH		|
@@ -112,7 +114,8 @@ FILESYS ext2_filesys =
 	FS_OWN_MEDIACHANGE	|
 	FS_EXT_1		|
 	FS_EXT_2		|
-	FS_EXT_3		,
+	FS_EXT_3		|
+	FS_EXT_4		,
 
 	root:			e_root,
 	lookup:			e_lookup,
@@ -153,7 +156,9 @@ FILESYS ext2_filesys =
 
 	/* FS_EXT_3 */
 	stat64:			e_stat64,
-	res1:			0,
+
+	/* FS_EXT_4 */
+	readdirplus:		e_readdirplus,
 	res2:			0,
 	res3:			0,
 
@@ -1500,6 +1505,29 @@ found:
 	}
 }
 
+/* the inode is in the cookie cache after e_readdir, so the stat
+ * of each entry is a plain copy
+ */
+static long _cdecl
+e_dirplus_stat (fcookie *fc, STAT *st)
+{
+	long r = e_stat64 (fc, st);
+
+	rel_cookie ((COOKIE *) fc->index);
+	return r;
+}
+
+static long _cdecl
+e_readdirplus (DIR *dirh, char *buf, long len)
+{
+	long count;
+
+	count = dirplus_read (dirh, buf, len, e_readdir, e_dirplus_stat);
+
+	DEBUG (("Ext2-FS [%c]: e_readdirplus: %li entries", DriveToLetter(dirh->fc.dev), count));
+	return count;
+}
+
 static long _cdecl
 e_rewinddir (DIR *dirh)
 {
@@ -1986,6 +2014,12 @@ e_fscntl (fcookie *dir, const char *name, int cmd, long arg)
 
 				r = E_OK;
 			}
+			else if (s->s_flags & S_RDONLY_FEATURES)
+			{
+				ALERT (("Ext2-FS [%c]: can't remount read/write, unsupported optional features!", DriveToLetter(dir->dev)));
+				
+				r = EROFS;
+			}
 			else if (s->s_flags & MS_RDONLY)
 			{
 				s->sbi.s_sb->s_state = cpu2le16 (le2cpu16 (s->sbi.s_sb->s_state) & ~EXT2_VALID_FS);
@@ -118,6 +118,9 @@ current_time (void)
 typedef struct cookie	COOKIE;	/* */
 typedef struct si	SI;	/* */
 
+/* number of block runs cached per inode */
+# define EXT2_EXTENT_CACHE	4
+
 struct cookie
 {
 	COOKIE	*next;		/* internal usage */
@@ -146,6 +149,15 @@ struct cookie
 	ulong	i_next_alloc_goal;
 	ulong	i_prealloc_block;
 	ulong	i_prealloc_count;
+	
+	/* cached logical -> physical block runs, see ext2_bmap_extent() */
+	struct
+	{
+		ulong	lblock;		/* first logical block */
+		ulong	pblock;		/* first physical block */
+		ulong	len;		/* number of blocks, 0 if unused */
+	} i_extent [EXT2_EXTENT_CACHE];
+	ushort	i_extent_next;		/* next slot to replace */
 };
 
 INLINE void
@@ -223,6 +235,7 @@ extern SI *super [NUM_DRIVES];
 # define MS_NOATIME		1024	/* Do not update access times. */
 # define MS_NODIRATIME		2048    /* Do not update directory access times */
 # define S_NOT_CLEAN_MOUNTED	4096	/* not cleanly mounted */
+# define S_RDONLY_FEATURES	8192	/* uses features we can't write */
 
 # define IS_APPEND(inode)	(inode->i_flags & S_APPEND)
 # define IS_IMMUTABLE(inode)	(inode->i_flags & S_IMMUTABLE)
@@ -0,0 +1,595 @@
+/*
+ * Filename:     htree.c
+ * Project:      ext2 file system driver for MiNT
+ *
+ * Note:         Please send suggestions, patches or bug reports to
+ *               the MiNT mailing list <freemint-discuss@lists.sourceforge.net>
+ *
+ * Copying:      Copyright 1999 Frank Naumann (fnaumann@freemint.de)
+ *
+ * Portions copyright 2002 by Theodore Ts'o and
+ * 2002 Daniel Phillips (hash functions and index layout)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * Read only support for hashed (htree, dir_index) directories.
+ *
+ * The first block of an indexed directory holds the "." and ".."
+ * entries; the rest of the ".." record contains the dx_root header
+ * followed by a sorted table of (hash, block) pairs. With one level of
+ * indirection the table points to dx_node blocks which in turn hold
+ * (hash, block) pairs pointing to the leaf blocks. For ordinary
+ * directory scans all index blocks look like a block with one unused
+ * entry, so readdir and the linear lookup don't need to know about it.
+ *
+ * A lookup hashes the name, does a binary search in the root (and
+ * node) and only scans the leaf block the name must be in. The low
+ * bit of a table hash marks a leaf whose first name has the same hash
+ * as the last name of the previous leaf; then the following leaves
+ * are scanned too.
+ *
+ * We never update the index. ext2_add_entry() clears EXT2_INDEX_FL on
+ * any modification that may place a name in the wrong leaf, which
+ * turns the directory back into a plain linear one (e2fsck -D can
+ * rebuild the index). Deleting entries keeps the index valid.
+ */
+
+# include "htree.h"
+
+# include <mint/endian.h>
+
+# include "inode.h"
+# include "namei.h"
+
+
+struct dx_root_info
+{
+	__u32	reserved_zero;
+	__u8	hash_version;
+	__u8	info_length;		/* 8 */
+	__u8	indirect_levels;
+	__u8	unused_flags;
+};
+
+struct dx_entry
+{
+	__u32	hash;
+	__u32	block;
+};
+
+/* overlays the hash field of the first dx_entry */
+struct dx_countlimit
+{
+	__u16	limit;
+	__u16	count;
+};
+
+/* offset of dx_root_info in the root block: "." and ".." entries */
+# define DX_ROOT_INFO_OFFSET	(EXT2_DIR_REC_LEN (1) + 8 + 4)
+
+/* offset of the entries in a dx_node block: one empty ext2_d2 */
+# define DX_NODE_OFFSET		8
+
+# define DX_MAX_LEVELS		2
+
+# define DX_BLOCK(e)		(le2cpu32 ((e)->block) & 0x00ffffffUL)
+# define DX_HASH(e)		(le2cpu32 ((e)->hash))
+# define DX_COUNT(e)		(le2cpu16 (((struct dx_countlimit *)(e))->count))
+# define DX_LIMIT(e)		(le2cpu16 (((struct dx_countlimit *)(e))->limit))
+
+struct dx_frame
+{
+	long	block;		/* directory block of this index block */
+	ushort	at;		/* entry we followed */
+	ushort	count;		/* entries in this index block */
+	long	next;		/* block the entry points to */
+};
+
+
+/*
+ * hash functions
+ */
+
+# define ROL32(x, s)	(((x) << (s)) | ((x) >> (32 - (s))))
+
+# define TEA_DELTA	0x9E3779B9UL
+
+static void
+tea_transform (__u32 buf[4], const __u32 *in)
+{
+	register __u32 sum = 0;
+	register __u32 b0 = buf[0], b1 = buf[1];
+	register __u32 a = in[0], b = in[1], c = in[2], d = in[3];
+	register int n = 16;
+
+	do {
+		sum += TEA_DELTA;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	}
+	while (--n);
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+# define MD4_F(x, y, z)	((z) ^ ((x) & ((y) ^ (z))))
+# define MD4_G(x, y, z)	(((x) & (y)) + (((x) ^ (y)) & (z)))
+# define MD4_H(x, y, z)	((x) ^ (y) ^ (z))
+
+# define MD4_ROUND(f, a, b, c, d, x, s)	\
+	(a += f (b, c, d) + (x), a = ROL32 (a, s))
+
+# define K1	0UL
+# define K2	013240474631UL
+# define K3	015666365641UL
+
+static void
+half_md4_transform (__u32 buf[4], const __u32 *in)
+{
+	register __u32 a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	/* round 1 */
+	MD4_ROUND (MD4_F, a, b, c, d, in[0] + K1,  3);
+	MD4_ROUND (MD4_F, d, a, b, c, in[1] + K1,  7);
+	MD4_ROUND (MD4_F, c, d, a, b, in[2] + K1, 11);
+	MD4_ROUND (MD4_F, b, c, d, a, in[3] + K1, 19);
+	MD4_ROUND (MD4_F, a, b, c, d, in[4] + K1,  3);
+	MD4_ROUND (MD4_F, d, a, b, c, in[5] + K1,  7);
+	MD4_ROUND (MD4_F, c, d, a, b, in[6] + K1, 11);
+	MD4_ROUND (MD4_F, b, c, d, a, in[7] + K1, 19);
+
+	/* round 2 */
+	MD4_ROUND (MD4_G, a, b, c, d, in[1] + K2,  3);
+	MD4_ROUND (MD4_G, d, a, b, c, in[3] + K2,  5);
+	MD4_ROUND (MD4_G, c, d, a, b, in[5] + K2,  9);
+	MD4_ROUND (MD4_G, b, c, d, a, in[7] + K2, 13);
+	MD4_ROUND (MD4_G, a, b, c, d, in[0] + K2,  3);
+	MD4_ROUND (MD4_G, d, a, b, c, in[2] + K2,  5);
+	MD4_ROUND (MD4_G, c, d, a, b, in[4] + K2,  9);
+	MD4_ROUND (MD4_G, b, c, d, a, in[6] + K2, 13);
+
+	/* round 3 */
+	MD4_ROUND (MD4_H, a, b, c, d, in[3] + K3,  3);
+	MD4_ROUND (MD4_H, d, a, b, c, in[7] + K3,  9);
+	MD4_ROUND (MD4_H, c, d, a, b, in[2] + K3, 11);
+	MD4_ROUND (MD4_H, b, c, d, a, in[6] + K3, 15);
+	MD4_ROUND (MD4_H, a, b, c, d, in[1] + K3,  3);
+	MD4_ROUND (MD4_H, d, a, b, c, in[5] + K3,  9);
+	MD4_ROUND (MD4_H, c, d, a, b, in[0] + K3, 11);
+	MD4_ROUND (MD4_H, b, c, d, a, in[4] + K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+# undef MD4_ROUND
+# undef MD4_F
+# undef MD4_G
+# undef MD4_H
+
+/* the original Linux hash; "uns" selects how chars >= 0x80 are taken */
+static __u32
+dx_hack_hash (const char *name, long len, int uns)
+{
+	__u32 hash, hash0 = 0x12a3fe2dUL, hash1 = 0x37abe8f9UL;
+
+	while (len--)
+	{
+		long c = uns ? (long)(unsigned char) *name : (long)(signed char) *name;
+
+		name++;
+
+		hash = hash1 + (hash0 ^ (__u32)(c * 7152373L));
+		if (hash & 0x80000000UL)
+			hash -= 0x7fffffffUL;
+
+		hash1 = hash0;
+		hash0 = hash;
+	}
+
+	return hash0 << 1;
+}
+
+static void
+str2hashbuf (const char *msg, long len, __u32 *buf, long num, int uns)
+{
+	__u32 pad, val;
+	long i;
+
+	pad = (__u32) len | ((__u32) len << 8);
+	pad |= pad << 16;
+
+	val = pad;
+	if (len > num * 4)
+		len = num * 4;
+
+	for (i = 0; i < len; i++)
+	{
+		long c = uns ? (long)(unsigned char) msg[i] : (long)(signed char) msg[i];
+
+		val = (__u32) c + (val << 8);
+		if ((i % 4) == 3)
+		{
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+
+	if (--num >= 0)
+		*buf++ = val;
+
+	while (--num >= 0)
+		*buf++ = pad;
+}
+
+/*
+ * Returns the major hash of name; the low bit is always clear.
+ * The minor hash is only needed by readdir cookies, we don't use it
+ * for lookups.
+ */
+ulong
+ext2_dx_hash (const char *name, long len, long version, const __u32 *seed, ulong *minor)
+{
+	__u32 buf[4];
+	__u32 in[8];
+	__u32 hash = 0;
+	__u32 minor_hash = 0;
+	int uns = 0;
+
+	buf[0] = 0x67452301UL;
+	buf[1] = 0xefcdab89UL;
+	buf[2] = 0x98badcfeUL;
+	buf[3] = 0x10325476UL;
+
+	/* an all zero seed means the default one */
+	if (seed && (seed[0] | seed[1] | seed[2] | seed[3]))
+	{
+		buf[0] = seed[0];
+		buf[1] = seed[1];
+		buf[2] = seed[2];
+		buf[3] = seed[3];
+	}
+
+	switch (version)
+	{
+		case DX_HASH_LEGACY_UNSIGNED:
+			uns = 1;
+		case DX_HASH_LEGACY:
+		{
+			hash = dx_hack_hash (name, len, uns);
+			break;
+		}
+		case DX_HASH_HALF_MD4_UNSIGNED:
+			uns = 1;
+		case DX_HASH_HALF_MD4:
+		{
+			while (len > 0)
+			{
+				str2hashbuf (name, len, in, 8, uns);
+				half_md4_transform (buf, in);
+				len -= 32;
+				name += 32;
+			}
+			minor_hash = buf[2];
+			hash = buf[1];
+			break;
+		}
+		case DX_HASH_TEA_UNSIGNED:
+			uns = 1;
+		case DX_HASH_TEA:
+		{
+			while (len > 0)
+			{
+				str2hashbuf (name, len, in, 4, uns);
+				tea_transform (buf, in);
+				len -= 16;
+				name += 16;
+			}
+			hash = buf[0];
+			minor_hash = buf[1];
+			break;
+		}
+	}
+
+	hash &= ~1UL;
+
+	/* 0xfffffffe is reserved as end of directory marker */
+	if (hash == 0xfffffffeUL)
+		hash = 0xfffffffcUL;
+
+	if (minor)
+		*minor = minor_hash;
+
+	return hash;
+}
+
+
+/*
+ * index traversal
+ */
+
+/* read index block and return its entry table or NULL if it's bad */
+static struct dx_entry *
+dx_get_entries (COOKIE *dir, long block)
+{
+	SI *s = dir->s;
+	struct dx_entry *entries;
+	ulong offset = DX_NODE_OFFSET;
+	ulong limit;
+	UNIT *u;
+
+	u = ext2_read (dir, block, NULL);
+	if (!u)
+		return NULL;
+
+	if (block == 0)
+	{
+		struct dx_root_info *info = (struct dx_root_info *)(u->data + DX_ROOT_INFO_OFFSET);
+
+		offset = DX_ROOT_INFO_OFFSET + info->info_length;
+	}
+
+	entries = (struct dx_entry *)(u->data + offset);
+	limit = (EXT2_BLOCK_SIZE (s) - offset) / sizeof (struct dx_entry);
+
+	if (DX_LIMIT (entries) > limit || DX_COUNT (entries) > DX_LIMIT (entries)
+		|| DX_COUNT (entries) == 0)
+	{
+		ALERT (("Ext2-FS: dx_get_entries: bad index block %li in directory #%lu (count %u, limit %u)",
+			block, dir->inode, DX_COUNT (entries), DX_LIMIT (entries)));
+
+		return NULL;
+	}
+
+	return entries;
+}
+
+/* find the last entry with a hash <= hash; entries[0] covers everything
+ * below entries[1]
+ */
+static ushort
+dx_search (struct dx_entry *entries, ulong hash)
+{
+	struct dx_entry *p = entries + 1;
+	struct dx_entry *q = entries + DX_COUNT (entries) - 1;
+
+	while (p <= q)
+	{
+		struct dx_entry *m = p + (q - p) / 2;
+
+		if (DX_HASH (m) > hash)
+			q = m - 1;
+		else
+			p = m + 1;
+	}
+
+	return (p - 1) - entries;
+}
+
+/*
+ * Walk from the root down to the leaf hash belongs to. Returns the
+ * number of frames used or 0 if the index can't be used.
+ */
+static long
+dx_probe (COOKIE *dir, const char *name, long namelen, ulong *hash, struct dx_frame *frames)
+{
+	SI *s = dir->s;
+	struct dx_root_info *info;
+	struct dx_entry *entries = NULL;
+	long nblocks;
+	long levels;
+	long version;
+	long i;
+	UNIT *u;
+
+	nblocks = le2cpu32 (dir->in.i_size) >> EXT2_BLOCK_SIZE_BITS (s);
+
+	u = ext2_read (dir, 0, NULL);
+	if (!u)
+		return 0;
+
+	info = (struct dx_root_info *)(u->data + DX_ROOT_INFO_OFFSET);
+
+	version = info->hash_version;
+	if (info->reserved_zero
+		|| (version != DX_HASH_LEGACY && version != DX_HASH_HALF_MD4 && version != DX_HASH_TEA)
+		|| info->info_length < sizeof (*info)
+		|| info->indirect_levels >= DX_MAX_LEVELS)
+	{
+		ALERT (("Ext2-FS: dx_probe: unsupported index in directory #%lu (version %li, levels %i)",
+			dir->inode, version, info->indirect_levels));
+
+		return 0;
+	}
+
+	version += s->sbi.s_hash_unsigned;
+	levels = info->indirect_levels;
+
+	*hash = ext2_dx_hash (name, namelen, version, s->sbi.s_hash_seed, NULL);
+
+	for (i = 0; i <= levels; i++)
+	{
+		long block = i ? frames[i - 1].next : 0;
+
+		if (block >= nblocks || (i && block == 0))
+			return 0;
+
+		entries = dx_get_entries (dir, block);
+		if (!entries)
+			return 0;
+
+		frames[i].block = block;
+		frames[i].count = DX_COUNT (entries);
+		frames[i].at = dx_search (entries, *hash);
+		frames[i].next = DX_BLOCK (&entries[frames[i].at]);
+	}
+
+	return levels + 1;
+}
+
+/*
+ * Step to the next leaf if it may contain names with the same hash.
+ * Returns 1 if frames now point to it, 0 otherwise.
+ */
+static long
+dx_next_leaf (COOKIE *dir, ulong hash, struct dx_frame *frames, long nframes)
+{
+	struct dx_entry *entries;
+	long i = nframes - 1;
+
+	while (frames[i].at + 1 >= frames[i].count)
+	{
+		if (i == 0)
+			return 0;
+		i--;
+	}
+
+	entries = dx_get_entries (dir, frames[i].block);
+	if (!entries)
+		return 0;
+
+	frames[i].at++;
+	frames[i].next = DX_BLOCK (&entries[frames[i].at]);
+
+	/* collision bit is set if the hash continues in this leaf */
+	if ((DX_HASH (&entries[frames[i].at]) & ~1UL) != hash)
+		return 0;
+
+	for (; i < nframes - 1; i++)
+	{
+		long block = frames[i].next;
+
+		entries = dx_get_entries (dir, block);
+		if (!entries)
+			return 0;
+
+		frames[i + 1].block = block;
+		frames[i + 1].count = DX_COUNT (entries);
+		frames[i + 1].at = 0;
+		frames[i + 1].next = DX_BLOCK (&entries[0]);
+	}
+
+	return 1;
+}
+
+static UNIT *
+dx_search_leaf (COOKIE *dir, long block, const char *name, long namelen, ext2_d2 **res_dir)
+{
+	SI *s = dir->s;
+	UNIT *u;
+	ext2_d2 *de;
+	char *upper;
+	ulong offset;
+
+	u = ext2_read (dir, block, NULL);
+	if (!u)
+		return NULL;
+
+	de = (ext2_d2 *) u->data;
+	upper = (char *) de + EXT2_BLOCK_SIZE (s);
+	offset = block << EXT2_BLOCK_SIZE_BITS (s);
+
+	while ((char *) de < upper)
+	{
+		long de_len;
+
+		if ((char *) de + namelen <= upper
+			&& de->inode && de->name_len == namelen
+			&& !memcmp (name, de->name, namelen))
+		{
+			if (!ext2_check_dir_entry ("dx_search_leaf", dir, de, u, offset))
+				return NULL;
+
+			*res_dir = de;
+			return u;
+		}
+
+		de_len = le2cpu16 (de->rec_len);
+		if (de_len <= 0)
+			return NULL;
+
+		offset += de_len;
+		de = (ext2_d2 *) ((char *) de + de_len);
+	}
+
+	return NULL;
+}
+
+/*
+ * Like ext2_find_entry() but only scans the leaf block(s) the hash
+ * index points to. On success the unit is returned and *res_dir set.
+ * Otherwise NULL is returned and *err is ENOENT if the name doesn't
+ * exist or EINVAL if the index is unusable; the caller should then
+ * fall back to a linear search.
+ *
+ * "." and ".." aren't hashed, they live in the head of block 0 in
+ * front of the dx_root; they are looked up there directly and never
+ * reported as ENOENT.
+ */
+UNIT *
+ext2_dx_find (COOKIE *dir, const char *name, long namelen, ext2_d2 **res_dir, long *err)
+{
+	struct dx_frame frames[DX_MAX_LEVELS];
+	long nblocks;
+	long nframes;
+	ulong hash;
+
+	*res_dir = NULL;
+	*err = EINVAL;
+
+	if (name[0] == '.' && (namelen == 1 || (namelen == 2 && name[1] == '.')))
+	{
+		UNIT *u;
+
+		u = dx_search_leaf (dir, 0, name, namelen, res_dir);
+		if (u)
+			*err = E_OK;
+
+		return u;
+	}
+
+	nframes = dx_probe (dir, name, namelen, &hash, frames);
+	if (!nframes)
+		return NULL;
+
+	nblocks = le2cpu32 (dir->in.i_size) >> EXT2_BLOCK_SIZE_BITS (dir->s);
+
+	do {
+		long block = frames[nframes - 1].next;
+		UNIT *u;
+
+		if (block == 0 || block >= nblocks)
+			return NULL;
+
+		TRACE (("Ext2-FS: ext2_dx_find: %s (%lx) -> leaf %li", name, hash, block));
+
+		u = dx_search_leaf (dir, block, name, namelen, res_dir);
+		if (u)
+		{
+			*err = E_OK;
+			return u;
+		}
+	}
+	while (dx_next_leaf (dir, hash, frames, nframes));
+
+	*err = ENOENT;
+	return NULL;
+}
@@ -0,0 +1,51 @@
+/*
+ * Filename:     htree.h
+ * Project:      ext2 file system driver for MiNT
+ *
+ * Note:         Please send suggestions, patches or bug reports to
+ *               the MiNT mailing list <freemint-discuss@lists.sourceforge.net>
+ *
+ * Copying:      Copyright 1999 Frank Naumann (fnaumann@freemint.de)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+# ifndef _htree_h
+# define _htree_h
+
+# include "global.h"
+
+
+/* hash versions as found in the dx_root block
+ * and in s_def_hash_version
+ */
+# define DX_HASH_LEGACY			0
+# define DX_HASH_HALF_MD4		1
+# define DX_HASH_TEA			2
+# define DX_HASH_LEGACY_UNSIGNED	3
+# define DX_HASH_HALF_MD4_UNSIGNED	4
+# define DX_HASH_TEA_UNSIGNED		5
+
+/* true if the directory carries a hash index we can use */
+# define EXT2_DX_DIR(dir)	\
+	(EXT2_HAS_COMPAT_FEATURE ((dir)->s, EXT2_FEATURE_COMPAT_DIR_INDEX) \
+	 && (le2cpu32 ((dir)->in.i_flags) & EXT2_INDEX_FL))
+
+
+ulong	ext2_dx_hash	(const char *name, long len, long version, const __u32 *seed, ulong *minor);
+UNIT *	ext2_dx_find	(COOKIE *dir, const char *name, long namelen, ext2_d2 **res_dir, long *err);
+
+
+# endif /* _htree_h */
@@ -629,39 +629,30 @@ block_bmap (COOKIE *inode, long block, long nr)
 	return tmp;
 }
 
-long
-ext2_bmap (COOKIE *inode, long block)
+/* return a pointer to the block pointer for logical block "block" and
+ * the number of pointers that follow it in the same (indirect) block
+ */
+static __u32 *
+bmap_slot (COOKIE *inode, long block, long *left)
 {
 	long addr_per_block = EXT2_ADDR_PER_BLOCK (inode->s);
 	long addr_per_block_bits = EXT2_ADDR_PER_BLOCK_BITS (inode->s);
-	long i;
-	
-	DEBUG (("Ext2-FS: ext2_bmap enter (%li)", block));
+	long i, nr;
+	UNIT *u;
 	
 	if (block < 0)
 	{
 		ALERT (("Ext2-FS: ext2_bmap: block < 0"));
-		return 0;
-	}
-	
-	if (block >= EXT2_NDIR_BLOCKS + addr_per_block +
-		(1UL << (addr_per_block_bits << 1)) +
-		((1UL << (addr_per_block_bits << 1)) << addr_per_block_bits))
-	{
-		ALERT (("Ext2-FS: ext2_bmap: block (%li) > big (%li)",
-			block,
-			EXT2_NDIR_BLOCKS + addr_per_block +
-			(1UL << (addr_per_block_bits << 1)) +
-			((1UL << (addr_per_block_bits << 1)) << addr_per_block_bits)
-		));
-		
-		return 0;
+		return NULL;
 	}
 	
 	/* direct blocks */
 	
 	if (block < EXT2_NDIR_BLOCKS)
-		return inode_bmap (inode, block);
+	{
+		*left = EXT2_NDIR_BLOCKS - block;
+		return &(inode->in.i_block[block]);
+	}
 	
 	/* indirect blocks */
 	
@@ -669,26 +660,334 @@ ext2_bmap (COOKIE *inode, long block)
 	if (block < addr_per_block)
 	{
 		i = inode_bmap (inode, EXT2_IND_BLOCK);
-		return block_bmap (inode, i, block);
+		nr = block;
+	}
+	else
+	{
+		/* double indirect blocks */
+		
+		block -= addr_per_block;
+		if (block < (1UL << (addr_per_block_bits << 1)))
+		{
+			i = inode_bmap (inode, EXT2_DIND_BLOCK);
+			i = block_bmap (inode, i, block >> addr_per_block_bits);
+			nr = block & (addr_per_block - 1);
+		}
+		else
+		{
+			/* triple indirect blocks */
+			
+			block -= (1UL << (addr_per_block_bits << 1));
+			if (block >= ((1UL << (addr_per_block_bits << 1)) << addr_per_block_bits))
+			{
+				ALERT (("Ext2-FS: ext2_bmap: block (%li) > big", block));
+				return NULL;
+			}
+			
+			i = inode_bmap (inode, EXT2_TIND_BLOCK);
+			i = block_bmap (inode, i, block >> (addr_per_block_bits << 1));
+			i = block_bmap (inode, i, (block >> addr_per_block_bits) & (addr_per_block - 1));
+			nr = block & (addr_per_block - 1);
+		}
 	}
 	
-	/* double indirect blocks */
+	/* same checks as block_bmap */
+	if (i == 0)
+		return NULL;
 	
-	block -= addr_per_block;
-	if (block < (1UL << (addr_per_block_bits << 1)))
+	if ((i < inode->s->sbi.s_first_data_block) || (i >= inode->s->sbi.s_blocks_count))
 	{
-		i = inode_bmap (inode, EXT2_DIND_BLOCK);
-		i = block_bmap (inode, i, block >> addr_per_block_bits);
-		return block_bmap (inode, i, block & (addr_per_block - 1));
+		ALERT (("Ext2-FS: ext2_bmap: block (%li) outside range!", i));
+		return NULL;
 	}
 	
-	/* triple indirect blocks */
+	u = bio.read (inode->s->di, i, EXT2_BLOCK_SIZE (inode->s));
+	if (!u)
+		return NULL;
 	
-	block -= (1UL << (addr_per_block_bits << 1));
-	i = inode_bmap (inode, EXT2_TIND_BLOCK);
-	i = block_bmap (inode, i, block >> (addr_per_block_bits << 1));
-	i = block_bmap (inode, i, (block >> addr_per_block_bits) & (addr_per_block - 1));
-	return block_bmap (inode, i, block & (addr_per_block - 1));
+	*left = addr_per_block - nr;
+	return ((__u32 *) u->data) + nr;
+}
+
+/* map a run of blocks (or a hole) through the (in)direct block
+ * pointers; the pointer blocks are walked only once per indirect block
+ */
+static long
+indirect_bmap (COOKIE *inode, long block, long max, long *len)
+{
+	ulong blocks_count = inode->s->sbi.s_blocks_count;
+	ulong start;
+	__u32 *p;
+	long left;
+	long n;
+	
+	*len = 1;
+	
+	p = bmap_slot (inode, block, &left);
+	if (!p)
+		return 0;
+	
+	start = le2cpu32 (*p);
+	if (start && ((start < inode->s->sbi.s_first_data_block) || (start >= blocks_count)))
+	{
+		ALERT (("Ext2-FS: ext2_bmap: tmp (%li), illegal value", start));
+		return 0;
+	}
+	
+	for (n = 1, p++, left--; n < max; n++, p++, left--)
+	{
+		ulong next;
+		
+		if (!left)
+		{
+			p = bmap_slot (inode, block + n, &left);
+			if (!p)
+				break;
+		}
+		
+		next = le2cpu32 (*p);
+		if (start ? (next != start + n || next >= blocks_count) : (next != 0))
+			break;
+	}
+	
+	*len = n;
+	return start;
+}
+
+/* binary search for the last entry in an extent node starting at or
+ * below block; entries are 12 bytes for leaves and index nodes alike
+ */
+static void *
+extent_search (struct ext4_extent_header *eh, ulong block)
+{
+	struct ext4_extent *first = (struct ext4_extent *)(eh + 1);
+	struct ext4_extent *l = first + 1;
+	struct ext4_extent *r = first + le2cpu16 (eh->eh_entries) - 1;
+	
+	if (!eh->eh_entries || block < le2cpu32 (first->ee_block))
+		return NULL;
+	
+	while (l <= r)
+	{
+		struct ext4_extent *m = l + (r - l) / 2;
+		
+		if (block < le2cpu32 (m->ee_block))
+			r = m - 1;
+		else
+			l = m + 1;
+	}
+	
+	return l - 1;
+}
+
+static long
+extent_check (COOKIE *inode, struct ext4_extent_header *eh, long size, long depth)
+{
+	if (le2cpu16 (eh->eh_magic) != EXT4_EXT_MAGIC
+		|| le2cpu16 (eh->eh_entries) > le2cpu16 (eh->eh_max)
+		|| le2cpu16 (eh->eh_max) > (size - sizeof (*eh)) / sizeof (struct ext4_extent)
+		|| (depth >= 0 && le2cpu16 (eh->eh_depth) != depth)
+		|| le2cpu16 (eh->eh_depth) > EXT4_EXT_MAX_DEPTH)
+	{
+		ALERT (("Ext2-FS: bad extent header in inode #%li (magic %x, entries %i, depth %i)",
+			inode->inode, le2cpu16 (eh->eh_magic), le2cpu16 (eh->eh_entries), le2cpu16 (eh->eh_depth)));
+		
+		return 0;
+	}
+	
+	return 1;
+}
+
+/* map a run of blocks through an ext4 extent tree
+ */
+static long
+extent_bmap (COOKIE *inode, long block, long max, long *len)
+{
+	SI *s = inode->s;
+	struct ext4_extent_header *eh;
+	struct ext4_extent *ex, *last;
+	ulong start, elen, pblock;
+	long depth;
+	
+	*len = 1;
+	
+	eh = (struct ext4_extent_header *) inode->in.i_block;
+	if (!extent_check (inode, eh, sizeof (inode->in.i_block), -1))
+		return 0;
+	
+	depth = le2cpu16 (eh->eh_depth);
+	while (depth--)
+	{
+		struct ext4_extent_idx *ix;
+		ulong leaf;
+		UNIT *u;
+		
+		ix = extent_search (eh, block);
+		if (!ix)
+			return 0;
+		
+		leaf = le2cpu32 (ix->ei_leaf_lo);
+		if (ix->ei_leaf_hi || leaf < s->sbi.s_first_data_block || leaf >= s->sbi.s_blocks_count)
+		{
+			ALERT (("Ext2-FS: extent_bmap: bad index block %lu in inode #%li", leaf, inode->inode));
+			return 0;
+		}
+		
+		u = bio.read (s->di, leaf, EXT2_BLOCK_SIZE (s));
+		if (!u)
+			return 0;
+		
+		eh = (struct ext4_extent_header *) u->data;
+		if (!extent_check (inode, eh, EXT2_BLOCK_SIZE (s), depth))
+			return 0;
+	}
+	
+	last = (struct ext4_extent *)(eh + 1) + le2cpu16 (eh->eh_entries) - 1;
+	
+	ex = extent_search (eh, block);
+	if (!ex)
+	{
+		/* hole up to the first extent */
+		if (eh->eh_entries)
+			*len = MIN (max, (long)(le2cpu32 (((struct ext4_extent *)(eh + 1))->ee_block) - block));
+		
+		return 0;
+	}
+	
+	start = le2cpu32 (ex->ee_block);
+	elen = le2cpu16 (ex->ee_len);
+	
+	if (elen > EXT4_EXT_INIT_MAX_LEN)
+	{
+		/* uninitialized extents read as zeros */
+		elen -= EXT4_EXT_INIT_MAX_LEN;
+		if (block < start + elen)
+			*len = MIN (max, (long)(start + elen - block));
+		
+		return 0;
+	}
+	
+	if (block >= start + elen)
+	{
+		/* hole up to the next extent */
+		if (ex < last)
+			*len = MIN (max, (long)(le2cpu32 (ex[1].ee_block) - block));
+		
+		return 0;
+	}
+	
+	pblock = le2cpu32 (ex->ee_start_lo) + (block - start);
+	if (ex->ee_start_hi || pblock + (start + elen - block) > s->sbi.s_blocks_count)
+	{
+		ALERT (("Ext2-FS: extent_bmap: bad extent in inode #%li", inode->inode));
+		return 0;
+	}
+	
+	*len = start + elen - block;
+	
+	/* extents are limited to 32768 blocks; merge physically
+	 * contiguous neighbours in the same leaf
+	 */
+	while (*len < max && ex < last)
+	{
+		ex++;
+		
+		elen = le2cpu16 (ex->ee_len);
+		if (elen > EXT4_EXT_INIT_MAX_LEN
+			|| le2cpu32 (ex->ee_block) != block + *len
+			|| ex->ee_start_hi
+			|| le2cpu32 (ex->ee_start_lo) != pblock + *len
+			|| pblock + *len + elen > s->sbi.s_blocks_count)
+		{
+			break;
+		}
+		
+		*len += elen;
+	}
+	
+	*len = MIN (max, *len);
+	return pblock;
+}
+
+/* throw away the cached block runs; must be called whenever blocks
+ * are removed from the inode
+ */
+void
+ext2_bmap_inval (COOKIE *inode)
+{
+	long i;
+	
+	for (i = 0; i < EXT2_EXTENT_CACHE; i++)
+		inode->i_extent[i].len = 0;
+}
+
+/*
+ * Map logical block "block" of the inode. Returns the physical block
+ * (0 for holes) and in *len the number of following blocks (at most
+ * max, at least 1) that are mapped contiguously or are part of the
+ * same hole. Mapped runs are cached in the cookie so sequential and
+ * repeated access don't walk the indirect blocks or the extent tree
+ * for every block.
+ *
+ * Only the removal of blocks invalidates cached runs; filling a hole
+ * or appending can't change a mapped run.
+ */
+long
+ext2_bmap_extent (COOKIE *inode, long block, long max, long *len)
+{
+	long pblock;
+	long ahead;
+	long i;
+	
+	DEBUG (("Ext2-FS: ext2_bmap_extent enter (%li, %li)", block, max));
+	
+	if (max < 1)
+		max = 1;
+	
+	for (i = 0; i < EXT2_EXTENT_CACHE; i++)
+	{
+		ulong off = block - inode->i_extent[i].lblock;
+		
+		if (off < inode->i_extent[i].len)
+		{
+			*len = MIN (max, (long)(inode->i_extent[i].len - off));
+			return inode->i_extent[i].pblock + off;
+		}
+	}
+	
+	/* look ahead at least one pointer block; the following
+	 * blocks are very likely requested next
+	 */
+	ahead = MAX (max, EXT2_ADDR_PER_BLOCK (inode->s));
+	
+	if (le2cpu32 (inode->in.i_flags) & EXT4_EXTENTS_FL)
+		pblock = extent_bmap (inode, block, ahead, len);
+	else
+		pblock = indirect_bmap (inode, block, ahead, len);
+	
+	if (pblock && *len > 1)
+	{
+		i = inode->i_extent_next++;
+		if (inode->i_extent_next == EXT2_EXTENT_CACHE)
+			inode->i_extent_next = 0;
+		
+		inode->i_extent[i].lblock = block;
+		inode->i_extent[i].pblock = pblock;
+		inode->i_extent[i].len = *len;
+	}
+	
+	*len = MIN (max, *len);
+	return pblock;
+}
+
+long
+ext2_bmap (COOKIE *inode, long block)
+{
+	long len;
+	
+	DEBUG (("Ext2-FS: ext2_bmap enter (%li)", block));
+	
+	return ext2_bmap_extent (inode, block, 1, &len);
 }
 
 UNIT *
@@ -723,7 +1022,7 @@ void
 ext2_discard_prealloc (COOKIE *inode)
 {
 # ifdef EXT2_PREALLOCATE
-	register ushort total;
+	register ulong total;
 	
 	DEBUG (("ext2_discard_prealloc: enter (#%li)", inode->inode));
 	
@@ -788,6 +1087,92 @@ ext2_alloc_block (COOKIE *inode, ulong goal, long *err)
 	return result;
 }
 
+/* Called before "count" blocks starting at logical block "block" of
+ * a regular file are written. If they aren't allocated yet the
+ * preallocation window is set up (or extended) to one contiguous run
+ * behind the previous block of the file, large enough for the data
+ * and the indirect blocks on the way. ext2_getblk() then takes them
+ * from the window one by one and the write goes out in as few runs
+ * as possible. Unused blocks are given back on close or truncate.
+ */
+void
+ext2_reserve_blocks (COOKIE *inode, long block, long count)
+{
+# ifdef EXT2_PREALLOCATE
+	SI *s = inode->s;
+	ulong goal = 0;
+	ulong want, have;
+	long len, err;
+	
+	if (!EXT2_ISREG (le2cpu16 (inode->in.i_mode))
+		|| (le2cpu32 (inode->in.i_flags) & EXT4_EXTENTS_FL))
+		return;
+	
+	/* overwrite of allocated blocks */
+	if (ext2_bmap_extent (inode, block, 1, &len))
+		return;
+	
+	want = count + count / EXT2_ADDR_PER_BLOCK (s) + 2;
+	if (want > EXT2_MAX_RESERVE_BLOCKS)
+		want = EXT2_MAX_RESERVE_BLOCKS;
+	
+	if (block > 0)
+	{
+		if (block == inode->i_next_alloc_block + 1)
+			goal = inode->i_next_alloc_goal + 1;
+		else
+		{
+			goal = ext2_bmap (inode, block - 1);
+			if (goal)
+				goal++;
+		}
+	}
+	
+	if (!goal)
+		goal = (inode->i_block_group * EXT2_BLOCKS_PER_GROUP (s)) +
+			s->sbi.s_first_data_block;
+	
+	have = 0;
+	if (inode->i_prealloc_count)
+	{
+		if (inode->i_prealloc_block == goal)
+			have = inode->i_prealloc_count;
+		else
+			ext2_discard_prealloc (inode);
+	}
+	
+	if (have < want)
+	{
+		ulong n = want - have;
+		
+		if (have)
+		{
+			/* grow the window in place */
+			if (ext2_new_blocks (inode, goal + have, &n, 1, &err))
+				inode->i_prealloc_count += n;
+		}
+		else
+		{
+			long start;
+			
+			start = ext2_new_blocks (inode, goal, &n, 0, &err);
+			if (!start)
+				return;
+			
+			inode->i_prealloc_block = start;
+			inode->i_prealloc_count = n;
+		}
+		
+		DEBUG (("ext2_reserve_blocks: #%li: %lu blocks at %lu (goal %lu)",
+			inode->inode, inode->i_prealloc_count, inode->i_prealloc_block, goal));
+	}
+	
+	/* let the next ext2_getblk() continue at the window */
+	inode->i_next_alloc_block = block - 1;
+	inode->i_next_alloc_goal = inode->i_prealloc_block - 1;
+# endif
+}
+
 static long
 inode_getblk (COOKIE *inode, long nr, long new_block, long *err, ushort clear_flag)
 {
@@ -1017,6 +1402,13 @@ ext2_getblk (COOKIE *inode, long block, long *err, ushort clear_flag)
 	
 	DEBUG (("ext2_getblk: enter (#%li, block = %li)", inode->inode, block));
 	
+	if (le2cpu32 (inode->in.i_flags) & EXT4_EXTENTS_FL)
+	{
+		ALERT (("Ext2-FS: ext2_getblk: extent mapped inode #%li is read-only", inode->inode));
+		*err = EROFS;
+		return 0;
+	}
+	
 	if (block < 0)
 	{
 		ALERT (("Ext2-FS: ext2_getblk: block < 0"));
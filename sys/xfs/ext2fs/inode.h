@@ -73,10 +73,13 @@ void	dump_inode_cache	(char *buf, long bufsize);
 
 void	ext2_delete_inode	(COOKIE *inode);
 
+long	ext2_bmap_extent	(COOKIE *inode, long block, long max, long *len);
+void	ext2_bmap_inval		(COOKIE *inode);
 long	ext2_bmap		(COOKIE *inode, long block);
 UNIT *	ext2_read		(COOKIE *inode, long block, long *err);
 
 void	ext2_discard_prealloc	(COOKIE *inode);
+void	ext2_reserve_blocks	(COOKIE *inode, long block, long count);
 long	ext2_getblk		(COOKIE *inode, long block, long *err, ushort clear_flag);
 UNIT *	ext2_bread		(COOKIE *inode, long block, long *err);
 
@@ -30,6 +30,7 @@
 
 # include <mint/endian.h>
 
+# include "htree.h"
 # include "inode.h"
 # include "super.h"
 
@@ -387,7 +388,23 @@ ext2_search_entry (COOKIE *dir, const char *name, long namelen)
 		}
 	}
 
-	/* 3. search on disk
+	/* 3. search hash index
+	 */
+	if (EXT2_DX_DIR (dir))
+	{
+		ext2_d2 *de;
+		long err;
+
+		if (ext2_dx_find (dir, name, namelen, &de, &err))
+			return d_get_dir (dir, le2cpu32 (de->inode), de->name, de->name_len);
+
+		if (err == ENOENT)
+			goto failure;
+
+		/* unusable index, fall back to linear search */
+	}
+
+	/* 4. search on disk
 	 */
 	for (block = 0, offset = 0; offset < size; block++)
 	{
@@ -443,7 +460,7 @@ ext2_search_entry (COOKIE *dir, const char *name, long namelen)
 	}
 
 failure:
-	/* 4. update lookup fail cache
+	/* 5. update lookup fail cache
 	 */
 	update_lastlookup (dir, name, namelen);
 
@@ -544,6 +561,16 @@ ext2_find_entry (COOKIE *dir, const char *name, long namelen, ext2_d2 **res_dir)
 	s = super [dir->dev];
 	size = le2cpu32 (dir->in.i_size);
 
+	if (EXT2_DX_DIR (dir))
+	{
+		UNIT *u;
+		long err;
+
+		u = ext2_dx_find (dir, name, namelen, res_dir, &err);
+		if (u || err == ENOENT)
+			return u;
+	}
+
 	for (block = 0, offset = 0; offset < size; block++)
 	{
 		UNIT *u;
@@ -680,7 +707,7 @@ ext2_add_entry (COOKIE *dir, const char *name, long namelen, ext2_d2 **res_dir,
 				de->inode = 0;
 				de->rec_len = cpu2le16 (EXT2_BLOCK_SIZE (s));
 				dir->in.i_size = cpu2le32 (offset + EXT2_BLOCK_SIZE (s));
-				dir->in.i_flags = cpu2le32 (le2cpu32 (dir->in.i_flags) & ~EXT2_BTREE_FL);
+				dir->in.i_flags = cpu2le32 (le2cpu32 (dir->in.i_flags) & ~EXT2_INDEX_FL);
 				mark_inode_dirty (dir);
 			}
 			else
@@ -721,7 +748,10 @@ ext2_add_entry (COOKIE *dir, const char *name, long namelen, ext2_d2 **res_dir,
 			memcpy (de->name, name, namelen);
 
 			dir->in.i_mtime = dir->in.i_ctime = cpu2le32 (CURRENT_TIME);
-			dir->in.i_flags = cpu2le32 (le2cpu32 (dir->in.i_flags) & ~EXT2_BTREE_FL);
+			/* we don't maintain the hash index; the name is
+			 * most likely in the wrong leaf, drop the index
+			 */
+			dir->in.i_flags = cpu2le32 (le2cpu32 (dir->in.i_flags) & ~EXT2_INDEX_FL);
 			dir->in.i_version = cpu2le32 (++event);
 			mark_inode_dirty (dir);
 
@@ -131,21 +131,35 @@ ext2_check_descriptors (SI *s)
 	ulong block = s->sbi.s_first_data_block;
 	ext2_gd *gdp = NULL;
 	long desc_block = 0;
+	long flex_bg;
 	long i;
 	
 	DEBUG (("Ext2-FS [%c]: Checking group descriptors", DriveToLetter(s->dev)));
 	
+	/* with flex_bg the bitmaps and inode tables of several groups
+	 * are packed together; they only need to be on the device
+	 */
+	flex_bg = EXT2_HAS_INCOMPAT_FEATURE (s, EXT4_FEATURE_INCOMPAT_FLEX_BG);
+	
 	for (i = 0; i < s->sbi.s_groups_count; i++)
 	{
+		ulong first = block;
+		ulong last = block + EXT2_BLOCKS_PER_GROUP (s);
 		ulong tmp;
 		
+		if (flex_bg)
+		{
+			first = s->sbi.s_first_data_block;
+			last = s->sbi.s_blocks_count;
+		}
+		
 		if ((i % EXT2_DESC_PER_BLOCK (s)) == 0)
 		{
 			gdp = s->sbi.s_group_desc [desc_block++];
 		}
 		
 		tmp = le2cpu32 (gdp->bg_block_bitmap);
-		if (tmp < block || tmp >= block + EXT2_BLOCKS_PER_GROUP (s))
+		if (tmp < first || tmp >= last)
 		{
 			ALERT (("Ext2-FS: ext2_check_descriptors: Block bitmap for group %li"
 				" not in group (block %li)!", i, tmp));
@@ -154,7 +168,7 @@ ext2_check_descriptors (SI *s)
 		}
 		
 		tmp = le2cpu32 (gdp->bg_inode_bitmap);
-		if (tmp < block || tmp >= block + EXT2_BLOCKS_PER_GROUP (s))
+		if (tmp < first || tmp >= last)
 		{
 			ALERT (("Ext2-FS: ext2_check_descriptors: Inode bitmap for group %ld"
 				" not in group (block %lu)!", i, tmp));
@@ -163,7 +177,7 @@ ext2_check_descriptors (SI *s)
 		}
 		
 		tmp = le2cpu32 (gdp->bg_inode_table);
-		if (tmp < block || tmp + s->sbi.s_itb_per_group >= block + EXT2_BLOCKS_PER_GROUP (s))
+		if (tmp < first || tmp + s->sbi.s_itb_per_group > last)
 		{
 			ALERT (("Ext2-FS: ext2_check_descriptors: Inode table for group %ld"
 				" not in group (block %lu)!", i, tmp));
@@ -189,6 +203,7 @@ read_ext2_sb_info (ushort drv)
 	ulong blocksize;
 	ulong sb_block;
 	ulong sb_offset;
+	ushort rdonly = 0;
 	
 	
 	DEBUG (("Ext2-FS [%c]: read_ext2_sb_info enter", DriveToLetter(drv)));
@@ -260,13 +275,17 @@ read_ext2_sb_info (ushort drv)
 				goto leave;
 			}
 			
-			if (!BIO_WP_CHECK (di) &&
-				(le2cpu32 (sb->s_feature_ro_compat) & ~EXT2_FEATURE_RO_COMPAT_SUPP))
+			/* ext4 extents and read-only compatible features
+			 * we don't know: we can read but not write
+			 */
+			if ((le2cpu32 (sb->s_feature_incompat) & EXT2_FEATURE_INCOMPAT_RDONLY)
+				|| (le2cpu32 (sb->s_feature_ro_compat) & ~EXT2_FEATURE_RO_COMPAT_SUPP))
 			{
-				ALERT (("Ext2-FS [%c]: couldn't mount RDWR because of "
-					"unsupported optional features.", DriveToLetter(drv)));
+				if (!BIO_WP_CHECK (di))
+					ALERT (("Ext2-FS [%c]: mounting read-only because of "
+						"unsupported optional features.", DriveToLetter(drv)));
 				
-				goto leave;
+				rdonly = 1;
 			}
 			
 		}
@@ -429,6 +448,17 @@ read_ext2_sb_info (ushort drv)
 		s->sbi.s_prealloc_blocks	= sb->s_prealloc_blocks;
 		s->sbi.s_prealloc_dir_blocks	= sb->s_prealloc_dir_blocks;
 		
+		/* hashed directories
+		 */
+		for (i = 0; i < 4; i++)
+			s->sbi.s_hash_seed[i] = le2cpu32 (sb->s_hash_seed[i]);
+		
+		s->sbi.s_def_hash_version	= sb->s_def_hash_version;
+		s->sbi.s_hash_unsigned		= 0;
+		
+		if (le2cpu32 (sb->s_flags) & EXT2_FLAGS_UNSIGNED_HASH)
+			s->sbi.s_hash_unsigned	= 3;
+		
 		
 		/* setup calculated values
 		 */
@@ -533,7 +563,8 @@ read_ext2_sb_info (ushort drv)
 		/* load group descriptor blocks
 		 */
 		
-		s->sbi.s_group_desc_size = s->sbi.s_db_per_group * 2 * sizeof (void *);
+		s->sbi.s_group_desc_size = s->sbi.s_db_per_group * 2 * sizeof (void *)
+			+ s->sbi.s_groups_count * sizeof (struct ext2_group_run);
 		s->sbi.s_group_desc = kmalloc (s->sbi.s_group_desc_size);
 		if (!s->sbi.s_group_desc)
 		{
@@ -544,6 +575,14 @@ read_ext2_sb_info (ushort drv)
 		}
 		
 		s->sbi.s_group_desc_units = (UNIT **) (s->sbi.s_group_desc + s->sbi.s_db_per_group);
+		s->sbi.s_group_run = (struct ext2_group_run *) (s->sbi.s_group_desc_units + s->sbi.s_db_per_group);
+		
+		/* nothing known yet about the free space layout */
+		for (i = 0; i < s->sbi.s_groups_count; i++)
+		{
+			s->sbi.s_group_run [i].max_run = s->sbi.s_blocks_per_group;
+			s->sbi.s_group_run [i].first_free = 0;
+		}
 		
 		for (i = 0; i < s->sbi.s_db_per_group; i++)
 		{
@@ -573,6 +612,9 @@ read_ext2_sb_info (ushort drv)
 		if (BIO_WP_CHECK (di))
 			s->s_flags |= MS_RDONLY;
 		
+		if (rdonly)
+			s->s_flags |= MS_RDONLY | S_RDONLY_FEATURES;
+		
 		DEBUG (("Ext2-FS: s->sbi.s_inodes_count = %ld", s->sbi.s_inodes_count));
 		DEBUG (("Ext2-FS: s->sbi.s_blocks_count = %ld", s->sbi.s_blocks_count));
 		DEBUG (("Ext2-FS: s->sbi.s_r_blocks_count = %ld", s->sbi.s_r_blocks_count));
@@ -618,6 +660,8 @@ read_ext2_sb_info (ushort drv)
 		DEBUG (("Ext2-FS: s->sbi.s_feature_ro_compat = %lx", s->sbi.s_feature_ro_compat));
 		DEBUG (("Ext2-FS: s->sbi.s_prealloc_blocks = %d", s->sbi.s_prealloc_blocks));
 		DEBUG (("Ext2-FS: s->sbi.s_prealloc_dir_blocks = %d", s->sbi.s_prealloc_dir_blocks));
+		DEBUG (("Ext2-FS: s->sbi.s_def_hash_version = %d", s->sbi.s_def_hash_version));
+		DEBUG (("Ext2-FS: s->sbi.s_hash_unsigned = %d", s->sbi.s_hash_unsigned));
 		
 		s->di = di;
 		s->dev = drv;
@@ -386,10 +386,17 @@ ext2_truncate (COOKIE *inode, unsigned long newsize)
 	if (!(EXT2_ISREG (i_mode) || EXT2_ISDIR (i_mode) || EXT2_ISLNK (i_mode)))
 		return;
 	
+	if (le2cpu32 (inode->in.i_flags) & EXT4_EXTENTS_FL)
+	{
+		ALERT (("Ext2-FS: ext2_truncate: extent mapped inode #%li is read-only", inode->inode));
+		return;
+	}
+	
 	inode->in.i_size = cpu2le32 (newsize);
 	mark_inode_dirty (inode);
 	
 	ext2_discard_prealloc (inode);
+	ext2_bmap_inval (inode);
 	
 	/* do truncation
 	 */
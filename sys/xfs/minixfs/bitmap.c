@@ -11,64 +11,135 @@
 
 # include "bitmap.h"
 
+# include "mint/bitmap.h"
 
-static long	alloc_bit	(ushort *buf, long num, long last);
-static long	free_bit	(ushort *buf, long bitnum);
 
-INLINE long	bitcount	(register ushort wrd);
+/* The bitmaps are arrays of native 16 bit words, bit n is bit (n & 15)
+ * of word (n >> 4). For the word parallel scans two words are combined
+ * to a 32 bit word with the bits in order.
+ * 
+ * For every bitmap block we keep the number of free bits in it (isum,
+ * zsum); blocks without free bits are skipped unscanned.
+ */
 
+# define L_BPB		(L_BS + 3)		/* log 2 bits/block */
+# define BITS_PER_BLOCK	(1L << L_BPB)
 
-/* This routine is used for allocating both free inodes and free zones 
- * Search a bitmap for a zero , then return its bit number and change it
- * to a one ...... but without exceeding 'num' bits 
- */
+/* runs looked at by reserve_zones() before it settles */
+# define RESERVE_TRIES	16
 
+static long	alloc_bit	(ushort *buf, ushort *sum, long num, long last);
+static long	free_bit	(ushort *buf, ushort *sum, long bitnum);
+
+
+INLINE __u32
+map_word (const ushort *buf, long k)
+{
+	return buf[k << 1] | ((__u32) buf[(k << 1) + 1] << 16);
+}
+
+/* first zero bit in [from, to), 'to' if none */
 static long
-alloc_bit (ushort *buf, register long num, register long last)
+find_zero (const ushort *buf, long from, long to)
 {
-	register const long end = num >> 4;
-	register long i;
-	register long j;
-	register long k;
+	const __u32 *map = (const __u32 *) buf;
+	long end = (to + 31) >> 5;
+	long k = from >> 5;
+	long res;
+	__u32 w;
 	
-	k = 1;
-	for (i = last >> 4; (i <= end) && (buf[i] == 65535U); i++);
+	if (from >= to)
+		return to;
 	
-	if (i > end)
+	w = map_word (buf, k) | ((1UL << (from & 31)) - 1);
+	while (w == 0xffffffffUL)
 	{
-		return 0;
+		k = bitmap_skip (map, k + 1, end, 0xffffffffUL);
+		if (k >= end)
+			return to;
+		
+		w = map_word (buf, k);
 	}
-	else
+	
+	res = (k << 5) + bitmap_ffz32 (w);
+	return (res < to) ? res : to;
+}
+
+/* first set bit in [from, to), 'to' if none */
+static long
+find_set (const ushort *buf, long from, long to)
+{
+	const __u32 *map = (const __u32 *) buf;
+	long end = (to + 31) >> 5;
+	long k = from >> 5;
+	long res;
+	__u32 w;
+	
+	if (from >= to)
+		return to;
+	
+	w = map_word (buf, k) & ~((1UL << (from & 31)) - 1);
+	while (!w)
 	{
-		for (j = 0; j < 16; j++)
+		k = bitmap_skip (map, k + 1, end, 0);
+		if (k >= end)
+			return to;
+		
+		w = map_word (buf, k);
+	}
+	
+	res = (k << 5) + bitmap_ffs32 (w);
+	return (res < to) ? res : to;
+}
+
+/* first free bit in [from, to), skipping bitmap blocks with less
+ * than 'min' free bits
+ */
+static long
+next_free (const ushort *buf, const ushort *sum, long min, long from, long to)
+{
+	while (from < to)
+	{
+		long blk = from >> L_BPB;
+		long end = MIN (to, (blk + 1) << L_BPB);
+		
+		if (sum[blk] >= min)
 		{
-			if (!(buf[i] & k))
-			{
-				long free;
-				
-				free = i * 16 + j;
-				if (free >= num)
-				{
-					return 0;
-				}
-				
-				buf[i] |= k;
-				
-				return free;
-			}
-			
-			k <<= 1;
+			long bit = find_zero (buf, from, end);
+			if (bit < end)
+				return bit;
 		}
+		
+		from = end;
 	}
 	
-	ALERT (("Minix-FS: alloc_bit: This can't happen !"));
-	return 0;
+	return to;
+}
+
+/* This routine is used for allocating both free inodes and free zones 
+ * Search a bitmap for a zero , then return its bit number and change it
+ * to a one ...... but without exceeding 'num' bits 
+ */
+
+static long
+alloc_bit (ushort *buf, ushort *sum, long num, long last)
+{
+	long bit;
+	
+	bit = next_free (buf, sum, 1, last, num);
+	if (bit >= num)
+		return 0;
+	
+	buf[bit >> 4] |= 1 << (bit & 15);
+	sum[bit >> L_BPB]--;
+	
+	return bit;
 }
 
 /* zero a bit of a bitmap return 0 if already zero */
 
 static long
-free_bit (ushort *buf, register long bitnum)
+free_bit (ushort *buf, ushort *sum, long bitnum)
 {
 	register long index = bitnum >> 4;
 	register ushort bit = 1 << (bitnum & 15);
@@ -77,41 +148,45 @@ free_bit (ushort *buf, register long bitnum)
 	ret = buf[index] & bit;
 	buf[index] &= ~bit;
 	
+	if (ret)
+		sum[bitnum >> L_BPB]++;
+	
 	return ret;
 }
 
 
-INLINE long
-bitcount (register ushort wrd)
+long
+count_bits (ushort *buf, long num)
 {
-	register long count = 0;
-	register ushort i;
+	register const long end = num >> 5; /* num/32 */
+	register long count;
 	
-	for (i = 1; i != 0; i <<= 1)
-	{
-		if (wrd & i)
-		{
-			count++;
-		}
-	}
+	count = bitmap_weight ((const __u32 *) buf, end);
+	if (num & 31)
+		count += bitmap_weight32 (map_word (buf, end) & ((1UL << (num & 31)) - 1));
 	
 	return count;
 }
 
-long
-count_bits (ushort *buf, long num)
+static void
+sum_bitmap (const ushort *buf, ushort *sum, long blocks)
 {
-	register const long end = num >> 4; /* num/16 */
-	register long count = 0;
-	register long i;
+	long i;
 	
-	for (i = 0; i < end; i++)
+	for (i = 0; i < blocks; i++)
 	{
-		if (buf[i] == 65535U) count += 16;
-		else count += bitcount (buf[i]);
+		const __u32 *map = (const __u32 *) buf + i * (BLOCK_SIZE >> 2);
+		
+		sum[i] = BITS_PER_BLOCK - bitmap_weight (map, BLOCK_SIZE >> 2);
 	}
-	count += bitcount ((ushort)(buf[end] & ((1L << (num % 16)) - 1L)));
-	return count;
+}
+
+/* called after the bitmaps have been read */
+void
+init_bitmap_sums (SI *psblk)
+{
+	sum_bitmap (psblk->ibitmap, psblk->isum, psblk->sblk->s_imap_blks);
+	sum_bitmap (psblk->zbitmap, psblk->zsum, psblk->sblk->s_zmap_blks);
 }
 
 
@@ -121,7 +196,27 @@ alloc_zone (ushort drive)
 	SI *psblk = super_ptr[drive];
 	long save;
 	
-	save = alloc_bit (psblk->zbitmap, psblk->sblk->s_zones - psblk->sblk->s_firstdatazn + 1, psblk->zlast);
+	/* next zone of the reserved run, if nobody else took it */
+	if (psblk->zreslen)
+	{
+		save = psblk->zres;
+		
+		if (!(psblk->zbitmap[save >> 4] & (1 << (save & 15))))
+		{
+			psblk->zbitmap[save >> 4] |= 1 << (save & 15);
+			psblk->zsum[save >> L_BPB]--;
+			psblk->zdirty = 1;
+			
+			psblk->zres++;
+			psblk->zreslen--;
+			
+			return (save + psblk->sblk->s_firstdatazn - 1);
+		}
+		
+		psblk->zreslen = 0;
+	}
+	
+	save = alloc_bit (psblk->zbitmap, psblk->zsum, psblk->sblk->s_zones - psblk->sblk->s_firstdatazn + 1, psblk->zlast);
 	if (!save)
 	{
 		return 0;
@@ -136,6 +231,73 @@ alloc_zone (ushort drive)
 	return (save + psblk->sblk->s_firstdatazn - 1);
 }
 
+/* Look for a run of up to 'count' free zones, starting right behind
+ * zone 'goal' (the last zone of the file) if that one is free, and
+ * reserve it: alloc_zone() then hands out the zones of the run in
+ * order, so a file written in one go gets contiguous zones. The zones
+ * are marked in the bitmap only when they are handed out;
+ * release_zones() drops what is left.
+ */
+void
+reserve_zones (ushort drive, long goal, long count)
+{
+	SI *psblk = super_ptr[drive];
+	ushort *buf = psblk->zbitmap;
+	long num = psblk->sblk->s_zones - psblk->sblk->s_firstdatazn + 1;
+	long min = MIN (count, BITS_PER_BLOCK);
+	long best = 0, bestlen = 0;
+	long tries = RESERVE_TRIES;
+	long bit;
+	
+	psblk->zreslen = 0;
+	
+	if (count < 2)
+		return;
+	
+	/* behind the previous zone of the file; zone z is bit
+	 * z + 1 - s_firstdatazn, see alloc_zone()
+	 */
+	bit = goal ? goal + 2 - psblk->sblk->s_firstdatazn : 0;
+	if (bit > 0 && bit < num && find_zero (buf, bit, bit + 1) == bit)
+	{
+		best = bit;
+		bestlen = find_set (buf, bit, MIN (num, bit + count)) - bit;
+	}
+	
+	if (bestlen < count)
+	{
+		/* first fit among the bitmap blocks with enough free zones */
+		bit = next_free (buf, psblk->zsum, min, psblk->zlast, num);
+		while (bit < num && tries--)
+		{
+			long end = find_set (buf, bit, MIN (num, bit + count));
+			
+			if (end - bit > bestlen)
+			{
+				best = bit;
+				bestlen = end - bit;
+				
+				if (bestlen >= count)
+					break;
+			}
+			
+			bit = next_free (buf, psblk->zsum, min, end, num);
+		}
+	}
+	
+	if (bestlen > 1)
+	{
+		psblk->zres = best;
+		psblk->zreslen = bestlen;
+	}
+}
+
+void
+release_zones (ushort drive)
+{
+	super_ptr[drive]->zreslen = 0;
+}
+
 /* Release a zone */
 long
 free_zone (ushort drive, long zone)
@@ -145,7 +307,7 @@ free_zone (ushort drive, long zone)
 	long ret;
 	
 	save = zone + 1 - psblk->sblk->s_firstdatazn;
-	ret = free_bit (psblk->zbitmap, save);
+	ret = free_bit (psblk->zbitmap, psblk->zsum, save);
 	
 	/* Mark zone bitmap as dirty */
 	psblk->zdirty = 1;
@@ -169,7 +331,7 @@ alloc_inode (ushort drive)
 	SI *psblk = super_ptr[drive];
 	ushort save;	
 	
-	save = alloc_bit (psblk->ibitmap, psblk->sblk->s_ninodes + 1L, psblk->ilast);
+	save = alloc_bit (psblk->ibitmap, psblk->isum, psblk->sblk->s_ninodes + 1L, psblk->ilast);
 	if (!save)
 	{
 		return 0;
@@ -192,7 +354,7 @@ free_inode (ushort drive, ushort inum)
 	SI *psblk = super_ptr[drive];
 	long ret;
 	
-	ret = free_bit (psblk->ibitmap, inum);
+	ret = free_bit (psblk->ibitmap, psblk->isum, inum);
 	if (inum < psblk->ilast)
 	{
 		psblk->ilast = inum;
@@ -208,4 +370,3 @@ free_inode (ushort drive, ushort inum)
 	
 	return ret;
 }
-
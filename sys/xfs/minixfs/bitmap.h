@@ -16,8 +16,11 @@
 
 
 long	count_bits	(ushort *buf, long num);
+void	init_bitmap_sums(SI *psblk);
 
 long	alloc_zone	(ushort drive);
+void	reserve_zones	(ushort drive, long goal, long count);
+void	release_zones	(ushort drive);
 long	free_zone	(ushort drive, long zone);
 
 ushort	alloc_inode	(ushort drive);
@@ -19,6 +19,7 @@
 
 # define PRE_READ	8	/* Max Number of blocks to 'read-ahead' */
 # define MAX_RWS	1024	/* Maximum sectors to read/write atomically */
+# define MAX_RESERVE	1024	/* Max Number of zones reserved for a write */
 
 /* Default translation modes ... change if desired */
 # define TRANS_DEFAULT	(SRCH_TOS | DIR_TOS | DIR_MNT | LWR_TOS | AEXEC_TOS)
@@ -11,6 +11,7 @@
 
 # include "main.h"
 
+# include "bitmap.h"
 # include "minixsys.h"
 # include "inode.h"
 # include "zone.h"
@@ -220,8 +221,9 @@ minix_sanity (int drv)
 			
 			DEBUG (("Minix-FS (%c): maps = %li -> %li bytes", DriveToLetter(drv), maps, maps * BLOCK_SIZE));
 			
+			/* bitmaps followed by their summaries */
 			maps *= BLOCK_SIZE;
-			p = kmalloc (maps);
+			p = kmalloc (maps + (sblk->s_imap_blks + sblk->s_zmap_blks) * sizeof (ushort));
 			if (!p)
 			{
 				ALERT (("Minix-FS (%c): No memory for bitmaps!", DriveToLetter(drv)));
@@ -232,6 +234,8 @@ minix_sanity (int drv)
 			
 			psblk->ibitmap = (void *) p;
 			psblk->zbitmap = (void *) (p + BLOCK_SIZE * sblk->s_imap_blks);
+			psblk->isum = (void *) (p + maps);
+			psblk->zsum = psblk->isum + sblk->s_imap_blks;
 			
 			r = BIO_RWABS (di, 2, p, maps, 2);
 			if (r)
@@ -244,6 +248,9 @@ minix_sanity (int drv)
 			psblk->zdirty = 0;
 			psblk->zlast = 0;
 			psblk->ilast = 0;
+			psblk->zreslen = 0;
+			
+			init_bitmap_sums (psblk);
 			
 			/* Final step , read in the root directory zone 1 and
 			 * check the '.' and '..' spacing , The spacing
@@ -177,6 +177,12 @@ struct super_info
 	long	ilast;	/* search start for free inodes */
 	long	zlast;	/* search start for free zones */
 	
+	ushort	*isum;	/* free bits per ibitmap block */
+	ushort	*zsum;	/* free bits per zbitmap block */
+	
+	long	zres;	/* next zone of the reserved run */
+	long	zreslen;/* zones left in the reserved run */
+	
 	UNIT	*sunit;	/* actual super block */
 	
 	/* This lot is filled in as appropriate for each FS type */
@@ -377,6 +377,30 @@ __fio (FILEPTR *f, char *buf, long len, short mode)
 		f->pos += data;
 	}
 	
+	/* Writing beyond EOF ? Reserve a run of zones behind the last
+	 * zone of the file for the new blocks and their indirection zones
+	 */
+	if (mode == WRITE && todo > BLOCK_SIZE)
+	{
+		long first = (rip.i_size + BLOCK_SIZE - 1) >> L_BS;
+		long last = (f->pos + todo - 1) >> L_BS;
+		
+		if (first < chunk)
+			first = chunk;
+		
+		if (last > first)
+		{
+			long n = last - first + 1;
+			long goal = 0;
+			
+			if (first)
+				goal = find_zone (&rip, first - 1, f->fc.dev, 0);
+			
+			n += n / super_ptr[f->fc.dev]->zpind + 1;
+			reserve_zones (f->fc.dev, goal, MIN (n, MAX_RESERVE));
+		}
+	}
+	
 	/* Any full blocks to read ? */
 	while (todo >> L_BS)
 	{
@@ -473,6 +497,9 @@ cont:
 	}
 	
 out:
+	if (mode == WRITE)
+		release_zones (f->fc.dev);
+	
 	if (!(f->flags & O_NOATIME))
 		__update_rip (f->fc.index, &rip, f->fc.dev, f->pos, mode);
 	
@@ -51,6 +51,7 @@ static long	_cdecl m_rename		(fcookie *olddir, char *oldname, fcookie *newdir, c
 
 static long	_cdecl m_opendir	(DIR *dirh, int flag);
 static long	_cdecl m_readdir	(DIR *dirh, char *name, int namelen, fcookie *fc);
+static long	_cdecl m_readdirplus	(DIR *dirh, char *buf, long len);
 static long	_cdecl m_rewinddir	(DIR *dirh);
 static long	_cdecl m_closedir	(DIR *dirh);
 
@@ -90,6 +91,7 @@ FILESYS minix_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_LONGPATH		|
@@ -97,7 +99,8 @@ FILESYS minix_filesys =
 	FS_OWN_MEDIACHANGE	|
 	FS_EXT_1		|
 	FS_EXT_2		|
-	FS_EXT_3		,
+	FS_EXT_3		|
+	FS_EXT_4		,
 	
 	root:			m_root,
 	lookup:			m_lookup,
@@ -138,7 +141,9 @@ FILESYS minix_filesys =
 	
 	/* FS_EXT_3 */
 	stat64:			m_stat64,
-	res1:			0, 
+	
+	/* FS_EXT_4 */
+	readdirplus:		m_readdirplus,
 	res2:			0,
 	res3:			0,
 	
@@ -1051,6 +1056,20 @@ m_readdir (DIR *dirh, char *name, int namelen, fcookie *fc)
 	return ENMFILES;
 }
 
+/* minixfs cookies are plain inode numbers, there is nothing
+ * to release after the stat
+ */
+static long _cdecl
+m_readdirplus (DIR *dirh, char *buf, long len)
+{
+	long count;
+	
+	count = dirplus_read (dirh, buf, len, m_readdir, m_stat64);
+	
+	DEBUG (("Minix-FS (%c): m_readdirplus: %li entries", DriveToLetter(dirh->fc.dev), count));
+	return count;
+}
+
 static long _cdecl
 m_rewinddir (DIR *dirh)
 {
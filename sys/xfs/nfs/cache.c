@@ -16,7 +16,8 @@
 
 /*
  * File:  cache.c
- *        a small cache for lookup operations which occur very frequently
+ *        a small cache for lookup operations which occur very frequently,
+ *        and a cache for file data
  *
  */
 
@@ -26,25 +27,73 @@
 # include "nfsutil.h"
 
 
-typedef struct
+NFS_CACHE_STATS nfs_stats;
+
+
+/* The lookup cache keeps the indices of recently looked up names, and
+ * with them their attributes, for the lifetime of the attributes of
+ * the mount (actimeo). The entries are hashed by directory and name,
+ * the name case folded so that we find it from both domains.
+ */
+
+typedef struct nfs_lookup_cache NFS_LOOKUP_CACHE;
+struct nfs_lookup_cache
 {
+	NFS_LOOKUP_CACHE *next;	/* hash chain */
 	NFS_INDEX *dir;
 	char *name;
 	NFS_INDEX *index;
 	long expiration;
-} NFS_LOOKUP_CACHE;
+	long used;		/* last hit, for replacement */
+	long hash;		/* chain this is on */
+};
 
 
 static NFS_LOOKUP_CACHE nfs_cache[LOOKUP_CACHE_SIZE];
+static NFS_LOOKUP_CACHE *nfs_hash[LOOKUP_CACHE_HASH];
 
 
+static long
+nfs_cache_hash (NFS_INDEX *dir, const char *name)
+{
+	ulong hash = (ulong) dir;
+	
+	while (*name)
+	{
+		register char c = *name++;
+		
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		
+		hash = hash * 31 + (uchar) c;
+	}
+	
+	return (hash ^ (hash >> 16)) % LOOKUP_CACHE_HASH;
+}
 
 /* Delete the i-th entry in the lookup cache, so that it can be reused.
  */
 static void
 nfs_cache_del (int i)
 {
-	NFS_INDEX *ni = nfs_cache[i].index;
+	NFS_LOOKUP_CACHE *c = &nfs_cache[i];
+	NFS_INDEX *ni = c->index;
+	
+	if (c->dir)
+	{
+		NFS_LOOKUP_CACHE **p = &nfs_hash[c->hash];
+		
+		while (*p && *p != c)
+			p = &(*p)->next;
+		
+		if (*p)
+			*p = c->next;
+	}
+	
+	c->next = NULL;
+	c->dir = NULL;
+	c->name = NULL;
+	c->index = NULL;
 	
 	if (ni != NULL)
 	{
@@ -57,10 +106,6 @@ nfs_cache_del (int i)
 		if (0 == ni->link)
 			free_slot (ni);
 	}
-	
-	nfs_cache[i].dir = NULL;
-	nfs_cache[i].name = NULL;
-	nfs_cache[i].index = NULL;
 }
 
 
@@ -74,7 +119,7 @@ nfs_cache_expire (void)
 	long i;
 	
 	for (i = 0;  i < LOOKUP_CACHE_SIZE;  i++)
-		if (nfs_cache[i].expiration < stamp)
+		if (nfs_cache[i].dir && after (stamp, nfs_cache[i].expiration))
 			nfs_cache_del(i);
 }
 
@@ -86,69 +131,71 @@ nfs_cache_expire (void)
 NFS_INDEX *
 nfs_cache_lookup (NFS_INDEX *dir, const char *name, int dom)
 {
-	long i, eq;
+	NFS_LOOKUP_CACHE *c;
+	long now = get_timestamp ();
+	long eq;
 	
-	for (i = 0;  i < LOOKUP_CACHE_SIZE; i++)
+	for (c = nfs_hash[nfs_cache_hash (dir, name)]; c; c = c->next)
 	{
-		if (dir == nfs_cache[i].dir)
+		if (dir == c->dir)
 		{
 			if (0 == dom)
-				eq = stricmp (name, nfs_cache[i].name);
+				eq = stricmp (name, c->name);
 			else
-				eq = strcmp (name, nfs_cache[i].name);
+				eq = strcmp (name, c->name);
 			
 			if (!eq)
 			{
-				/* BUG: should we set a new expiration time?? */
-				return nfs_cache[i].index;
+				/* the entry lives as long as the attributes;
+				 * a hit doesn't extend that
+				 */
+				if (after (now, c->expiration))
+				{
+					nfs_cache_del (c - nfs_cache);
+					break;
+				}
+				
+				c->used = now;
+				nfs_stats.lookup_hits++;
+				return c->index;
 			}
 		}
 	}
 	
+	nfs_stats.lookup_misses++;
 	return NULL;
 }
 
 
 /* Add a given index to the lookup cache. The directory this file is in is
  * given in dir, so that we can search for it later.
- * Look through all the cache entries to find a free one; if there is no,
- * take the least recently used one.
+ * Look through all the cache entries to find a free or expired one; if
+ * there is no, take the least recently used one.
  */
 int
 nfs_cache_add(NFS_INDEX *dir, NFS_INDEX *index)
 {
+	NFS_LOOKUP_CACHE *c;
 	long i, least;
-	long least_ac, next_expire, now;
+	long now;
 	
 	least = 0;
 	now = get_timestamp ();
 	
-	next_expire = least_ac = now + NFS_CACHE_EXPIRE;
 	for (i = 0;  i < LOOKUP_CACHE_SIZE;  i++)
 	{
-		/* look for an unused entry
+		/* look for an unused entry, or one that has expired
 		 */
-		if (NULL == nfs_cache[i].dir)
+		if (NULL == nfs_cache[i].dir || after (now, nfs_cache[i].expiration))
 		{
 			least = i;
 			break;
 		}
 		
-		/* also look for the least recently added entry
+		/* also look for the least recently used entry
 		 */
-		if (nfs_cache[i].expiration < least_ac)
-		{
+		if (after (nfs_cache[least].used, nfs_cache[i].used))
 			least = i;
-			least_ac = nfs_cache[i].expiration;
-		}
-		
-		/* if the expiration time is over, free and reuse the entry
-		 */
-		if (nfs_cache[i].expiration < now)
-		{
-			nfs_cache_del (i);
-			least = i;
-		}
 	}
 	
 	/* free the entry if necessary
@@ -156,20 +203,22 @@ nfs_cache_add(NFS_INDEX *dir, NFS_INDEX *index)
 	if (nfs_cache[least].dir)
 		nfs_cache_del (least);
 	
-	/* BUG: if the cache entry was not in use, set a timeout for the expire
-	 *      function
-	 */
-	
 	/* this index is once more in use
 	 */
 	index->link++;
 	
 	/* set up cache entry
 	 */
-	nfs_cache[least].dir = dir;
-	nfs_cache[least].index = index;
-	nfs_cache[least].name = index->name;
-	nfs_cache[least].expiration = next_expire;
+	c = &nfs_cache[least];
+	c->dir = dir;
+	c->index = index;
+	c->name = index->name;
+	c->expiration = now + index->opt->actimeo;
+	c->used = now;
+	
+	c->hash = nfs_cache_hash (dir, c->name);
+	c->next = nfs_hash[c->hash];
+	nfs_hash[c->hash] = c;
 	
 	return 0;
 }
@@ -177,53 +226,229 @@ nfs_cache_add(NFS_INDEX *dir, NFS_INDEX *index)
 int
 nfs_cache_remove (NFS_INDEX *ni)
 {
-	long i, n;
+	long i;
 	
-	n = -1;
 	for (i = 0;  i < LOOKUP_CACHE_SIZE; i++)
 	{
 		if (ni == nfs_cache[i].index)
 		{
-			n = i;				
+			nfs_cache_del (i);
 			break;
 		}
 	}
 	
-	if (n != -1)
+	return 0;
+}
+
+int
+nfs_cache_removebyname (NFS_INDEX *parent, const char *name)
+{
+	NFS_LOOKUP_CACHE *c;
+	
+	for (c = nfs_hash[nfs_cache_hash (parent, name)]; c; c = c->next)
+	{
+		if (c->dir == parent && !strcmp (name, c->name))
+		{
+			nfs_cache_del (c - nfs_cache);
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+
+/* The data cache keeps a few blocks as they came from READ replies.
+ * A block is only used as long as size and modification time of the
+ * file are the same as when it was read, so it goes away as soon as
+ * new attributes show a change; how fresh the attributes are is the
+ * business of the attribute cache (actimeo, and nfs_open for
+ * close-to-open consistency). With noac nothing is cached.
+ */
+
+typedef struct nfs_data_cache NFS_DATA_CACHE;
+struct nfs_data_cache
+{
+	NFS_INDEX *ni;
+	long	offset;		/* file position of the block */
+	long	len;		/* number of bytes in the block */
+	short	eof;		/* the block ends at the end of the file */
+	ushort	mtime;		/* modification time and */
+	ushort	mdate;
+	long	size;		/* size of the file when the block was read */
+	long	used;		/* last use, for replacement */
+	long	bufsize;	/* size of data, more than MAXDATA for NFSv3 */
+	char	*data;
+};
+
+static NFS_DATA_CACHE nfs_data[DATA_CACHE_BLOCKS];
+
+
+/* is the block still valid for the file? */
+static int
+nfs_data_valid (NFS_DATA_CACHE *d)
+{
+	NFS_INDEX *ni = d->ni;
+	
+	if (ni->attr.size == d->size
+		&& ni->attr.mtime == d->mtime
+		&& ni->attr.mdate == d->mdate)
 	{
-		nfs_cache_del (n);
-# if 0
-		ni->link -= 1;
-		nfs_cache[i].dir = NULL;
-		nfs_cache[i].name = NULL;
-		nfs_cache[i].index = NULL;
-		
 		return 1;
-# endif
 	}
 	
+	nfs_stats.data_stale++;
+	d->ni = NULL;
+	
 	return 0;
 }
 
+/* the valid block of ni that holds pos, or that ends the file before pos */
+static NFS_DATA_CACHE *
+nfs_data_find (NFS_INDEX *ni, long pos)
+{
+	int i;
+	
+	for (i = 0; i < DATA_CACHE_BLOCKS; i++)
+	{
+		NFS_DATA_CACHE *d = &nfs_data[i];
+		
+		if (d->ni != ni || pos < d->offset)
+			continue;
+		
+		if (pos < d->offset + d->len || d->eof)
+		{
+			if (nfs_data_valid (d))
+				return d;
+		}
+	}
+	
+	return NULL;
+}
+
+/* Copy what is cached of the file at pos to buf; returns the number of
+ * bytes copied, 0 if nothing is cached there or -1 if pos is known to be
+ * at (or beyond) the end of the file.
+ */
+long
+nfs_data_read (NFS_INDEX *ni, long pos, char *buf, long bytes)
+{
+	NFS_DATA_CACHE *d;
+	long n;
+	
+	if (ni->opt->flags & OPT_NOAC)
+		return 0;
+	
+	d = nfs_data_find (ni, pos);
+	if (!d)
+	{
+		nfs_stats.data_misses++;
+		return 0;
+	}
+	
+	nfs_stats.data_hits++;
+	d->used = get_timestamp ();
+	
+	n = d->offset + d->len - pos;
+	if (n <= 0)
+		return -1;
+	
+	if (n > bytes)
+		n = bytes;
+	
+	memcpy (buf, d->data + (pos - d->offset), n);
+	return n;
+}
+
+/* is [pos, pos + len) cached? */
 int
-nfs_cache_removebyname (NFS_INDEX *parent, const char *name)
+nfs_data_cached (NFS_INDEX *ni, long pos, long len)
 {
-	long i, n;
+	NFS_DATA_CACHE *d;
 	
-	n = -1;
-	for (i = 0;  i < LOOKUP_CACHE_SIZE;  i++)
+	if (ni->opt->flags & OPT_NOAC)
+		return 0;
+	
+	d = nfs_data_find (ni, pos);
+	
+	return d && (d->eof || d->offset + d->len >= pos + len);
+}
+
+/* Remember len bytes at offset the server just gave us; count is the
+ * number of bytes that were asked for, less means end of file.
+ * The attributes of ni must be the ones of the reply.
+ */
+void
+nfs_data_fill (NFS_INDEX *ni, long offset, const char *data, long len, long count)
+{
+	NFS_DATA_CACHE *d = NULL;
+	long now;
+	int i;
+	
+	if ((ni->opt->flags & OPT_NOAC) || len < 0 || len > NFS3_MAXDATA)
+		return;
+	
+	now = get_timestamp ();
+	
+	for (i = 0; i < DATA_CACHE_BLOCKS; i++)
 	{
-		if (nfs_cache[i].dir == parent)
+		NFS_DATA_CACHE *tmp = &nfs_data[i];
+		
+		if (tmp->ni == ni && tmp->offset == offset)
 		{
-			if (!strcmp (name, nfs_cache[i].name))
-				n = i;
+			d = tmp;
+			break;
 		}
+		
+		if (!tmp->ni)
+		{
+			if (!d || d->ni)
+				d = tmp;
+		}
+		else if (!d || (d->ni && after (d->used, tmp->used)))
+			d = tmp;
 	}
 	
-	if (n != -1)
-		nfs_cache_del (n);
-	else
-		return 1;
+	if (d->data && d->bufsize < len)
+	{
+		kfree (d->data);
+		d->data = NULL;
+	}
 	
-	return 0;
+	if (!d->data)
+	{
+		d->bufsize = MAX (len, MAXDATA);
+		d->data = kmalloc (d->bufsize);
+		if (!d->data)
+		{
+			d->ni = NULL;
+			return;
+		}
+	}
+	
+	d->ni = ni;
+	d->offset = offset;
+	d->len = len;
+	d->eof = (len < count);
+	d->mtime = ni->attr.mtime;
+	d->mdate = ni->attr.mdate;
+	d->size = ni->attr.size;
+	d->used = now;
+	
+	memcpy (d->data, data, len);
+}
+
+/* forget the cached data of ni in [from, to) */
+void
+nfs_data_inval (NFS_INDEX *ni, long from, long to)
+{
+	int i;
+	
+	for (i = 0; i < DATA_CACHE_BLOCKS; i++)
+	{
+		NFS_DATA_CACHE *d = &nfs_data[i];
+		
+		if (d->ni == ni && d->offset < to && (d->offset + d->len > from || d->eof))
+			d->ni = NULL;
+	}
 }
@@ -26,5 +26,12 @@ int nfs_cache_add (NFS_INDEX *dir, NFS_INDEX *index);
 int nfs_cache_remove (NFS_INDEX *ni);
 int nfs_cache_removebyname (NFS_INDEX *parent, const char *name);
 
+long nfs_data_read (NFS_INDEX *ni, long pos, char *buf, long bytes);
+int nfs_data_cached (NFS_INDEX *ni, long pos, long len);
+void nfs_data_fill (NFS_INDEX *ni, long offset, const char *data, long len, long count);
+void nfs_data_inval (NFS_INDEX *ni, long from, long to);
+
+extern NFS_CACHE_STATS nfs_stats;
+
 
 # endif /* _cache_h */
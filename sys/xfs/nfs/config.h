@@ -60,12 +60,32 @@
 #define HARDLNBUFSIZE      128
 #define READBUFSIZE        128
 #define READDIRBUFSIZE     128
+#define NFS3BUFSIZE        256   /* NFSv3 requests, the handles are bigger */
 
-#define MAX_RPC_HDR_SIZE   4096  /* FIXME: this value is too small */
+#define RPC_HDRBUFSIZE      512  /* rpc header with auth_unix, larger ones are kmalloc()ed */
+
+/* size of the socket buffers, the most inet allows; the replies to
+ * the reads in flight have to fit into it
+ */
+#define NFS_SOCKBUF      65535
 
 /* maximum number of bytes in a reply for nfs_readdir */
 #define MAX_READDIR_LEN    4108	/* value has been increased because of Ubuntu NFS server problems */
 
+/* maximum number of bytes in a reply for READDIRPLUS (NFSv3) */
+#define MAX_READDIRPLUS_LEN  8192
+
+
+
+/* number of READ or WRITE calls a file keeps in flight for
+ * read ahead and write behind
+ */
+#define NFS_WINDOW         4
+
+/* number of unstable bytes written to an NFSv3 server before we
+ * ask it to COMMIT them; it is done on close in any case
+ */
+#define NFS_COMMIT_LIMIT   65536
 
 
 /* configuration values for the resend code */
@@ -75,8 +95,13 @@
 
 /* config values for the lookup cache */
 #define USE_CACHE         /* use the lookup cache */
-#define LOOKUP_CACHE_SIZE  64
-#define NFS_CACHE_EXPIRE  1000   /* 5 seconds */
+#define LOOKUP_CACHE_SIZE  256    /* entries expire after the actimeo of the mount */
+#define LOOKUP_CACHE_HASH   64
+
+/* number of READ replies kept by the data cache, MAXDATA bytes each
+ * and allocated when first used
+ */
+#define DATA_CACHE_BLOCKS   16
 
 /* when a process is running in TOS-Domain, convert filenames to
  * lower case before sending the request to the daemon, which might
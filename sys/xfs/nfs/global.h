@@ -29,6 +29,7 @@
 /* own default header */
 # include "config.h"
 # include "nfs_xdr.h"
+# include "nfs3_xdr.h"
 
 
 /* debug section
@@ -141,6 +142,7 @@ current_time (void)
 # define OPT_NOAC		0x0100
 # define OPT_NOCTO		0x0200
 # define OPT_POSIX		0x0400
+# define OPT_NFSV3		0x0800   /* talk version 3 of the protocol */
 
 # define OPT_USE_DEFAULTS	0x8000   /* use defaults for timeout, port etc */
 # define SERVER_OPTS		(OPT_SOFT | OPT_INTR)
@@ -151,7 +153,8 @@ typedef struct
 	struct sockaddr_in addr;    /* the address of the server */
 	int retrans;  /* number of request retries */
 	long timeo;   /* initial timeout in 1/200 sec */
-	long reserved[4];
+	long version; /* nfs protocol version, 0 is the default (2) */
+	long reserved[3];
 	char hostname[256];
 } SERVER_OPT;
 
@@ -181,10 +184,13 @@ struct nfs_index
 # define NO_HANDLE	0x4000	/* we have no handle (this is set by */
 				/* nfs_readdir, as the remote procedure */
 				/* does not provide a handle */
+# define JUST_CREATED	0x2000	/* nfs_creat made it, for the nfs_open */
+				/* that follows */
 	
 	NFS_MOUNT_OPT *opt;	/* options for this mount and subdirs */
 	INDEX_CLUSTER *cluster;	/* cluster this is in */
 	nfs_fh	handle;		/* file handle for this on the server */
+	nfs_fh3	fh3;		/* the same for version 3 mounts */
 	long	link;		/* no of times this cookie is in use */
 	XATTR	attr;
 	long	stamp;		/* time stamp when this xattr struct was filled */
@@ -206,12 +212,14 @@ extern NFS_INDEX *mounted;
 extern INDEX_CLUSTER *cluster[MAX_CLUSTER];
 extern NFS_MOUNT_OPT *opt_list;
 
+# define NFS_V3(ni)	((ni)->opt->flags & OPT_NFSV3)
 
-# define NFS_MOUNT_VERS  1
+
+# define NFS_MOUNT_VERS  2
 
 typedef struct
 {
-	long	version;	/* version of this structure, currently 1 */
+	long	version;	/* version of this structure, currently 2 */
 	nfs_fh	handle;		/* initial file handle from the server's mountd */
 	XATTR	mntattr;	/* not used yet */
 	long	flags;		/* same as NFS_MOUNT_OPT.flags */
@@ -225,6 +233,10 @@ typedef struct
 	
 	struct sockaddr_in server;	/* address of the server */
 	char hostname[256];
+	
+	/* version 2 of this structure, with OPT_NFSV3 */
+	ulong	fhlen3;		/* length of handle3 */
+	char	handle3[NFS3_FHSIZE];	/* initial file handle */
 } NFS_MOUNT_INFO;
 
 
@@ -235,6 +247,21 @@ typedef struct
 # define NFS_DUMPALL	(('N'<< 8) | 43)
 
 
+/* Psysctl() names below CTL_VFS.<nfs drive> */
+# define NFS_CTL_STATS	1	/* struct: the following, read only */
+
+typedef struct
+{
+	ulong	lookup_hits;	/* lookup cache */
+	ulong	lookup_misses;
+	ulong	attr_hits;	/* nfs_getxattr() without a GETATTR */
+	ulong	attr_misses;
+	ulong	data_hits;	/* data cache */
+	ulong	data_misses;
+	ulong	data_stale;	/* blocks dropped, the file has changed */
+} NFS_CACHE_STATS;
+
+
 /* the device number we have to deal with
  */
 extern int nfs_dev;
@@ -24,6 +24,8 @@
 
 # include "mint/emu_tos.h"
 
+# include "cache.h"
+
 
 INDEX_CLUSTER *cluster[MAX_CLUSTER];
 
@@ -124,7 +126,7 @@ get_mount_slot (const char *name, NFS_MOUNT_INFO *info)
 	
 	DEBUG(("get_mount_slot: for %s (server %s)", name, info->hostname));
 	
-	if (info->version != NFS_MOUNT_VERS)
+	if (info->version != 1 && info->version != NFS_MOUNT_VERS)
 	{
 		DEBUG(("get_mount_slot: wrong version of mount program!"
 		       " Got %ld, expected %d", info->version, NFS_MOUNT_VERS));
@@ -182,6 +184,14 @@ get_mount_slot (const char *name, NFS_MOUNT_INFO *info)
 	opt->flags = info->flags;
 	opt->server.flags = info->flags & SERVER_OPTS;
 	opt->server.addr = info->server;
+	opt->server.version = 0;
+	
+	/* version 1 of the mount info doesn't know about NFSv3 */
+	if (info->version == 1)
+		opt->flags &= ~OPT_NFSV3;
+	
+	if (opt->flags & OPT_NFSV3)
+		opt->server.version = NFS3_VERSION;
 
 	/* set default values */
 	opt->server.addr.sin_port = DEFAULT_PORT;
@@ -190,6 +200,10 @@ get_mount_slot (const char *name, NFS_MOUNT_INFO *info)
 	opt->actimeo = DEFAULT_ACTIMEO;
 	opt->rsize = DEFAULT_RSIZE;
 	opt->wsize = DEFAULT_WSIZE;
+	
+	/* NFSv3 takes what the server prefers, see nfs3_fsinfo() */
+	if (opt->flags & OPT_NFSV3)
+		opt->rsize = opt->wsize = 0;
 
 	/* look for the optional values from the mount command */
 	if (!(info->flags & OPT_USE_DEFAULTS))
@@ -563,6 +577,9 @@ free_slot (NFS_INDEX *ni)
 		if (newi)
 			newi->link -= 1;
 		
+		/* the slot may come back for another file */
+		nfs_data_inval (ni, 0, 0x7fffffffL);
+		
 		if (ni->name)
 		{
 			ni->name[0] = '$';
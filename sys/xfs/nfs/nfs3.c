@@ -0,0 +1,651 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * File : nfs3.c
+ *        requests of version 3 of the nfs protocol
+ *
+ * The file system and device functions hand over to these for mounts
+ * with OPT_NFSV3. They take the handles from the fh3 field of the
+ * index and leave the attributes they get along with the results in
+ * the index, as nfs_getxattr() would.
+ */
+
+# include "nfs3.h"
+
+# include "nfsutil.h"
+# include "sock_ipc.h"
+
+
+/* map an nfs status to a MiNT error code */
+long
+nfs3_error (long status)
+{
+	switch (status)
+	{
+		case NFS_OK:			return E_OK;
+		case NFSERR_PERM:		return EPERM;
+		case NFSERR_NOENT:		return ENOENT;
+		case NFSERR_IO:			return EIO;
+		case NFSERR_NXIO:		return ENXIO;
+		case NFSERR_ACCES:		return EACCES;
+		case NFSERR_EXIST:		return EEXIST;
+		case NFS3ERR_XDEV:		return EXDEV;
+		case NFSERR_NODEV:		return ENODEV;
+		case NFSERR_NOTDIR:		return ENOTDIR;
+		case NFSERR_ISDIR:		return EISDIR;
+		case NFS3ERR_INVAL:		return EINVAL;
+		case NFSERR_FBIG:		return EFBIG;
+		case NFSERR_NOSPC:		return ENOSPC;
+		case NFSERR_ROFS:		return EROFS;
+		case NFS3ERR_MLINK:		return EMLINK;
+		case NFSERR_NAMETOOLONG:	return ENAMETOOLONG;
+		case NFSERR_NOTEMPTY:		return ENOTEMPTY;
+		case NFSERR_DQUOT:		return EDQUOT;
+		case NFSERR_STALE:
+		case NFS3ERR_BADHANDLE:		return ESTALE;
+		case NFS3ERR_NOTSUPP:		return EOPNOTSUPP;
+	}
+	
+	return EACCES;
+}
+
+/* take the attributes that came along with a reply */
+void
+nfs3_attr (NFS_INDEX *ni, post_op_attr *ap)
+{
+	if (ap->present)
+	{
+		fattr32xattr (&ap->attr, &ni->attr);
+		ni->stamp = get_timestamp ();
+	}
+	else
+	{
+		/* the next nfs_getxattr() asks for them */
+		ni->stamp = get_timestamp () - ni->opt->actimeo - 1;
+	}
+}
+
+/* send the request that x has encoded into mreq and decode the
+ * status of the reply; if it is ok, x is left at the results and
+ * the reply has to be freed after use
+ */
+static long
+nfs3_call (NFS_INDEX *ni, ulong proc, MESSAGE *mreq, xdrs *x, MESSAGE **mrep)
+{
+	enum_t status;
+	long r;
+	
+	mreq->data_len = xdr_getpos (x);
+	
+	r = rpc_request (&ni->opt->server, mreq, proc, mrep);
+	if (r != 0)
+	{
+		DEBUG (("nfs3_call(%ld): couldn't contact server, -> EACCES", proc));
+		return EACCES;
+	}
+	
+	xdr_init (x, (*mrep)->data, (*mrep)->data_len, XDR_DECODE, NULL);
+	if (!xdr_enum (x, &status))
+	{
+		DEBUG (("nfs3_call(%ld): couldnt decode results, -> EACCES", proc));
+		free_message (*mrep);
+		return EACCES;
+	}
+	
+	if (status != NFS_OK)
+	{
+		DEBUG (("nfs3_call(%ld) rpc->%d", proc, status));
+		free_message (*mrep);
+		return nfs3_error (status);
+	}
+	
+	return E_OK;
+}
+
+/* requests with nothing but a file handle; the reply goes to m */
+static long
+nfs3_fhcall (NFS_INDEX *ni, ulong proc, MESSAGE *m, xdrs *x, MESSAGE **mrep)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq;
+	
+	mreq = alloc_message (m, req_buf, NFS3BUFSIZE, xdr_size_nfsfh3 (&ni->fh3));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	xdr_nfsfh3 (x, &ni->fh3);
+	
+	return nfs3_call (ni, proc, mreq, x, mrep);
+}
+
+
+/* rsize and wsize: what the user wants or else what the server
+ * prefers, but at most what the server can do and what fits into
+ * our socket buffer
+ */
+static long
+xfer_size (long want, ulong pref, ulong max, long def)
+{
+	if (want <= 0)
+		want = pref ? pref : def;
+	
+	if (max && want > max)
+		want = max;
+	
+	if (want > NFS3_MAXDATA)
+		want = NFS3_MAXDATA;
+	
+	if (want >= 1024)
+		want &= ~1023L;
+	
+	return want;
+}
+
+/* FSINFO for the root of a mount; a server without version 3 fails
+ * here already, so the mount program can fall back to version 2
+ */
+long
+nfs3_fsinfo (NFS_INDEX *ni)
+{
+	MESSAGE *mrep, m;
+	post_op_attr attr;
+	ulong rtmax, rtpref, rtmult, wtmax, wtpref;
+	xdrs x;
+	long r;
+	
+	r = nfs3_fhcall (ni, NFSPROC3_FSINFO, &m, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_post_op_attr (&x, &attr)
+		&& xdr_ulong (&x, &rtmax)
+		&& xdr_ulong (&x, &rtpref)
+		&& xdr_ulong (&x, &rtmult)
+		&& xdr_ulong (&x, &wtmax)
+		&& xdr_ulong (&x, &wtpref);
+	
+	free_message (mrep);
+	
+	if (!r)
+	{
+		DEBUG (("nfs3_fsinfo: couldnt decode results, -> EACCES"));
+		return EACCES;
+	}
+	
+	nfs3_attr (ni, &attr);
+	
+	ni->opt->rsize = xfer_size (ni->opt->rsize, rtpref, rtmax, DEFAULT_RSIZE);
+	ni->opt->wsize = xfer_size (ni->opt->wsize, wtpref, wtmax, DEFAULT_WSIZE);
+	
+	DEBUG (("nfs3_fsinfo: rsize %ld, wsize %ld", ni->opt->rsize, ni->opt->wsize));
+	return E_OK;
+}
+
+/* for Dfree(); the sizes are 64 bit, so the cluster size grows
+ * until the numbers fit
+ */
+long
+nfs3_fsstat (NFS_INDEX *ni, long *buf)
+{
+	MESSAGE *mrep, m;
+	post_op_attr attr;
+	ullong tbytes, fbytes, abytes;
+	int shift;
+	xdrs x;
+	long r;
+	
+	r = nfs3_fhcall (ni, NFSPROC3_FSSTAT, &m, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_post_op_attr (&x, &attr)
+		&& xdr_ullong (&x, &tbytes)
+		&& xdr_ullong (&x, &fbytes)
+		&& xdr_ullong (&x, &abytes);
+	
+	free_message (mrep);
+	
+	if (!r)
+		return EACCES;
+	
+	for (shift = 10; (tbytes >> shift) > 0x7fffffffUL; shift++)
+		;
+	
+	buf[0] = abytes >> shift;
+	buf[1] = tbytes >> shift;
+	buf[2] = 1L << shift;
+	buf[3] = 1;
+	
+	return E_OK;
+}
+
+long
+nfs3_getattr (NFS_INDEX *ni)
+{
+	MESSAGE *mrep, m;
+	post_op_attr attr;
+	xdrs x;
+	long r;
+	
+	r = nfs3_fhcall (ni, NFSPROC3_GETATTR, &m, &x, &mrep);
+	if (r)
+		return r;
+	
+	attr.present = xdr_fattr3 (&x, &attr.attr);
+	free_message (mrep);
+	
+	if (!attr.present)
+	{
+		DEBUG (("nfs3_getattr(%s): couldnt decode results, -> EACCES", ni->name));
+		return EACCES;
+	}
+	
+	nfs3_attr (ni, &attr);
+	return E_OK;
+}
+
+long
+nfs3_setattr (NFS_INDEX *ni, sattr *ap)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	post_op_attr attr;
+	bool_t guard = FALSE;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_nfsfh3 (&ni->fh3) + xdr_size_sattr3 (ap) + sizeof (ulong));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	xdr_nfsfh3 (&x, &ni->fh3);
+	xdr_sattr3 (&x, ap);
+	xdr_bool (&x, &guard);
+	
+	r = nfs3_call (ni, NFSPROC3_SETATTR, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	if (!xdr_wcc_data (&x, &attr))
+		attr.present = FALSE;
+	
+	free_message (mrep);
+	
+	nfs3_attr (ni, &attr);
+	return E_OK;
+}
+
+/* ask the server which of the ACCESS3_* bits in *access we have;
+ * the attributes come along with it
+ */
+long
+nfs3_access (NFS_INDEX *ni, ulong *access)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	post_op_attr attr;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE, xdr_size_nfsfh3 (&ni->fh3) + sizeof (ulong));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	xdr_nfsfh3 (&x, &ni->fh3);
+	xdr_ulong (&x, access);
+	
+	r = nfs3_call (ni, NFSPROC3_ACCESS, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_post_op_attr (&x, &attr) && xdr_ulong (&x, access);
+	free_message (mrep);
+	
+	if (!r)
+		return EACCES;
+	
+	nfs3_attr (ni, &attr);
+	return E_OK;
+}
+
+long
+nfs3_lookup (NFS_INDEX *dir, const char *name, nfs_fh3 *fh, post_op_attr *attr)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE, xdr_size_diropargs3 (&dir->fh3, name));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	if (!xdr_diropargs3 (&x, &dir->fh3, &name))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	r = nfs3_call (dir, NFSPROC3_LOOKUP, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_nfsfh3 (&x, fh) && xdr_post_op_attr (&x, attr);
+	free_message (mrep);
+	
+	return r ? E_OK : EACCES;
+}
+
+/* CREATE or MKDIR */
+long
+nfs3_create (long proc, NFS_INDEX *dir, const char *name, sattr *ap, nfs_fh3 *fh, post_op_attr *attr)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	post_op_fh3 newfh;
+	sattr sa = *ap;
+	enum_t how = UNCHECKED;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_diropargs3 (&dir->fh3, name) + sizeof (ulong) + xdr_size_sattr3 (ap));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	if (!xdr_diropargs3 (&x, &dir->fh3, &name))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	if (proc == NFSPROC3_CREATE)
+		xdr_enum (&x, &how);
+	else
+		/* a directory has no size to set */
+		sa.size = (ulong) -1L;
+	
+	xdr_sattr3 (&x, &sa);
+	
+	r = nfs3_call (dir, proc, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_post_op_fh3 (&x, &newfh) && xdr_post_op_attr (&x, attr);
+	free_message (mrep);
+	
+	if (!r)
+		return EACCES;
+	
+	/* the server doesn't have to tell us the new handle */
+	if (!newfh.present)
+		return nfs3_lookup (dir, name, fh, attr);
+	
+	*fh = newfh.fh;
+	return E_OK;
+}
+
+/* REMOVE or RMDIR */
+long
+nfs3_remove (long proc, NFS_INDEX *dir, const char *name)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE, xdr_size_diropargs3 (&dir->fh3, name));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	if (!xdr_diropargs3 (&x, &dir->fh3, &name))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	r = nfs3_call (dir, proc, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	free_message (mrep);
+	return E_OK;
+}
+
+long
+nfs3_rename (NFS_INDEX *olddir, const char *oldname, NFS_INDEX *newdir, const char *newname)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_diropargs3 (&olddir->fh3, oldname)
+			+ xdr_size_diropargs3 (&newdir->fh3, newname));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	if (!xdr_diropargs3 (&x, &olddir->fh3, &oldname)
+		|| !xdr_diropargs3 (&x, &newdir->fh3, &newname))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	r = nfs3_call (olddir, NFSPROC3_RENAME, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	free_message (mrep);
+	return E_OK;
+}
+
+long
+nfs3_link (NFS_INDEX *ni, NFS_INDEX *dir, const char *name)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	post_op_attr attr;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_nfsfh3 (&ni->fh3) + xdr_size_diropargs3 (&dir->fh3, name));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	xdr_nfsfh3 (&x, &ni->fh3);
+	if (!xdr_diropargs3 (&x, &dir->fh3, &name))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	r = nfs3_call (ni, NFSPROC3_LINK, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	/* the link count has changed */
+	if (!xdr_post_op_attr (&x, &attr))
+		attr.present = FALSE;
+	
+	free_message (mrep);
+	
+	nfs3_attr (ni, &attr);
+	return E_OK;
+}
+
+long
+nfs3_symlink (NFS_INDEX *dir, const char *name, const char *to, sattr *ap)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_diropargs3 (&dir->fh3, name) + xdr_size_sattr3 (ap)
+			+ sizeof (ulong) + ((strlen (to) + 3) & ~3L));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	if (!xdr_diropargs3 (&x, &dir->fh3, &name)
+		|| !xdr_sattr3 (&x, ap)
+		|| !xdr_string (&x, &to, MAXPATHLEN))
+	{
+		free_message (mreq);
+		return ENAMETOOLONG;
+	}
+	
+	r = nfs3_call (dir, NFSPROC3_SYMLINK, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	free_message (mrep);
+	return E_OK;
+}
+
+/* the link goes to buf, which has room for MAXPATHLEN + 1 bytes */
+long
+nfs3_readlink (NFS_INDEX *ni, char *buf)
+{
+	MESSAGE *mrep, m;
+	post_op_attr attr;
+	const char *path = buf;
+	xdrs x;
+	long r;
+	
+	r = nfs3_fhcall (ni, NFSPROC3_READLINK, &m, &x, &mrep);
+	if (r)
+		return r;
+	
+	r = xdr_post_op_attr (&x, &attr) && xdr_string (&x, &path, MAXPATHLEN);
+	free_message (mrep);
+	
+	return r ? E_OK : EACCES;
+}
+
+
+/* Ask for the next chunk of a directory. The entries are decoded
+ * one at a time by nfs3_direntry(), so the rest of the reply is
+ * kept as it is in a buffer allocated here, from *pos to *len.
+ * The cookie verifier in verf is updated.
+ */
+long
+nfs3_readdirplus (NFS_INDEX *dir, ullong cookie, char *verf, char **buf, long *pos, long *len)
+{
+	char req_buf[NFS3BUFSIZE];
+	MESSAGE *mreq, *mrep, m;
+	post_op_attr attr;
+	ulong dircount = MAX_READDIRPLUS_LEN / 4;
+	ulong maxcount = MAX_READDIRPLUS_LEN;
+	xdrs x;
+	long r;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE,
+			xdr_size_nfsfh3 (&dir->fh3) + 2 * sizeof (ullong) + 2 * sizeof (ulong));
+	if (!mreq)
+		return ENOMEM;
+	
+	xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+	xdr_nfsfh3 (&x, &dir->fh3);
+	xdr_ullong (&x, &cookie);
+	xdr_fixedopaq (&x, verf, NFS3_VERFSIZE);
+	xdr_ulong (&x, &dircount);
+	xdr_ulong (&x, &maxcount);
+	
+	r = nfs3_call (dir, NFSPROC3_READDIRPLUS, mreq, &x, &mrep);
+	if (r)
+		return r;
+	
+	if (!xdr_post_op_attr (&x, &attr) || !xdr_fixedopaq (&x, verf, NFS3_VERFSIZE))
+	{
+		free_message (mrep);
+		return EACCES;
+	}
+	
+	nfs3_attr (dir, &attr);
+	
+	*len = mrep->data_len - xdr_getpos (&x);
+	*pos = 0;
+	*buf = kmalloc (*len);
+	if (!*buf)
+	{
+		free_message (mrep);
+		return ENOMEM;
+	}
+	
+	memcpy (*buf, mrep->data + xdr_getpos (&x), *len);
+	free_message (mrep);
+	
+	return E_OK;
+}
+
+/* Decode the entry at *pos of a chunk from nfs3_readdirplus().
+ * Returns 1 and advances *pos if there is one, 0 at the end of the
+ * chunk, with *eof set if it is the end of the directory.
+ */
+long
+nfs3_direntry (char *buf, long len, long *pos, NFS3_DIRENT *e, short *eof)
+{
+	const char *name = e->name;
+	ullong fileid;
+	bool_t follows;
+	xdrs x;
+	
+	xdr_init (&x, buf + *pos, len - *pos, XDR_DECODE, NULL);
+	if (!xdr_bool (&x, &follows))
+		return EACCES;
+	
+	if (!follows)
+	{
+		if (!xdr_bool (&x, &follows))
+			return EACCES;
+		
+		*eof = follows;
+		return 0;
+	}
+	
+	if (!xdr_ullong (&x, &fileid)
+		|| !xdr_string (&x, &name, MAXNAMLEN)
+		|| !xdr_ullong (&x, &e->cookie)
+		|| !xdr_post_op_attr (&x, &e->attr)
+		|| !xdr_post_op_fh3 (&x, &e->fh))
+	{
+		return EACCES;
+	}
+	
+	e->fileid = fileid;
+	*pos += xdr_getpos (&x);
+	
+	return 1;
+}
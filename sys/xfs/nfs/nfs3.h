@@ -0,0 +1,59 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+# ifndef _nfs3_h
+# define _nfs3_h
+
+# include "global.h"
+
+
+/* one entry of a READDIRPLUS reply, see nfs3_direntry() */
+typedef struct nfs3_dirent NFS3_DIRENT;
+struct nfs3_dirent
+{
+	ulong		fileid;
+	ullong		cookie;
+	post_op_attr	attr;
+	post_op_fh3	fh;
+	char		name[MAXNAMLEN+1];
+};
+
+
+long	nfs3_error	(long status);
+void	nfs3_attr	(NFS_INDEX *ni, post_op_attr *ap);
+
+long	nfs3_fsinfo	(NFS_INDEX *ni);
+long	nfs3_fsstat	(NFS_INDEX *ni, long *buf);
+long	nfs3_getattr	(NFS_INDEX *ni);
+long	nfs3_setattr	(NFS_INDEX *ni, sattr *ap);
+long	nfs3_access	(NFS_INDEX *ni, ulong *access);
+long	nfs3_lookup	(NFS_INDEX *dir, const char *name, nfs_fh3 *fh, post_op_attr *attr);
+long	nfs3_create	(long proc, NFS_INDEX *dir, const char *name, sattr *ap, nfs_fh3 *fh, post_op_attr *attr);
+long	nfs3_remove	(long proc, NFS_INDEX *dir, const char *name);
+long	nfs3_rename	(NFS_INDEX *olddir, const char *oldname, NFS_INDEX *newdir, const char *newname);
+long	nfs3_link	(NFS_INDEX *ni, NFS_INDEX *dir, const char *name);
+long	nfs3_symlink	(NFS_INDEX *dir, const char *name, const char *to, sattr *ap);
+long	nfs3_readlink	(NFS_INDEX *ni, char *buf);
+
+long	nfs3_readdirplus (NFS_INDEX *dir, ullong cookie, char *verf, char **buf, long *pos, long *len);
+long	nfs3_direntry	(char *buf, long len, long *pos, NFS3_DIRENT *e, short *eof);
+
+
+# endif /* _nfs3_h */
@@ -0,0 +1,199 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * File : nfs3_xdr.c
+ *        xdr functions for the nfs version 3 types
+ */
+
+# include "global.h"
+
+
+bool_t
+xdr_nfsfh3 (xdrs *x, nfs_fh3 *fp)
+{
+	union { const opaque **cc; opaque **c; } p;
+	opaque *data = fp->data;
+	long len = fp->len;
+	
+	p.c = &data;
+	if (!xdr_opaque (x, p.cc, &len, NFS3_FHSIZE))
+		return FALSE;
+	
+	fp->len = len;
+	return TRUE;
+}
+
+bool_t
+xdr_fattr3 (xdrs *x, fattr3 *fp)
+{
+	long *buf;
+	
+	if (XDR_DECODE != x->op)
+		return FALSE;
+	
+	/* fattr3 has a fixed size, so we can always take it in one go */
+	buf = xdr_inline (x, 21 * BYTES_PER_XDR_UNIT);
+	if (!buf)
+		return FALSE;
+	
+	fp->type	= IXDR_GET_ENUM (buf);
+	fp->mode	= IXDR_GET_ULONG (buf);
+	fp->nlink	= IXDR_GET_ULONG (buf);
+	fp->uid		= IXDR_GET_ULONG (buf);
+	fp->gid		= IXDR_GET_ULONG (buf);
+	fp->size	= (ullong) IXDR_GET_ULONG (buf) << 32;
+	fp->size	|= IXDR_GET_ULONG (buf);
+	fp->used	= (ullong) IXDR_GET_ULONG (buf) << 32;
+	fp->used	|= IXDR_GET_ULONG (buf);
+	fp->rdev1	= IXDR_GET_ULONG (buf);
+	fp->rdev2	= IXDR_GET_ULONG (buf);
+	fp->fsid	= (ullong) IXDR_GET_ULONG (buf) << 32;
+	fp->fsid	|= IXDR_GET_ULONG (buf);
+	fp->fileid	= (ullong) IXDR_GET_ULONG (buf) << 32;
+	fp->fileid	|= IXDR_GET_ULONG (buf);
+	fp->atime.seconds	= IXDR_GET_ULONG (buf);
+	fp->atime.useconds	= IXDR_GET_ULONG (buf) / 1000;
+	fp->mtime.seconds	= IXDR_GET_ULONG (buf);
+	fp->mtime.useconds	= IXDR_GET_ULONG (buf) / 1000;
+	fp->ctime.seconds	= IXDR_GET_ULONG (buf);
+	fp->ctime.useconds	= IXDR_GET_ULONG (buf) / 1000;
+	
+	return TRUE;
+}
+
+bool_t
+xdr_post_op_attr (xdrs *x, post_op_attr *ap)
+{
+	if (!xdr_bool (x, &ap->present))
+		return FALSE;
+	
+	if (ap->present)
+		return xdr_fattr3 (x, &ap->attr);
+	
+	return TRUE;
+}
+
+bool_t
+xdr_wcc_data (xdrs *x, post_op_attr *ap)
+{
+	bool_t present;
+	
+	/* pre_op_attr: size, mtime and ctime */
+	if (!xdr_bool (x, &present))
+		return FALSE;
+	
+	if (present && !xdr_inline (x, 6 * BYTES_PER_XDR_UNIT))
+		return FALSE;
+	
+	return xdr_post_op_attr (x, ap);
+}
+
+bool_t
+xdr_post_op_fh3 (xdrs *x, post_op_fh3 *fhp)
+{
+	if (!xdr_bool (x, &fhp->present))
+		return FALSE;
+	
+	if (fhp->present)
+		return xdr_nfsfh3 (x, &fhp->fh);
+	
+	return TRUE;
+}
+
+static bool_t
+xdr_set_ulong (xdrs *x, ulong val)
+{
+	bool_t set = (val != (ulong) -1L);
+	
+	if (!xdr_bool (x, &set))
+		return FALSE;
+	
+	if (set)
+		return xdr_ulong (x, &val);
+	
+	return TRUE;
+}
+
+static bool_t
+xdr_set_time (xdrs *x, nfstime *tp)
+{
+	enum_t how = DONT_CHANGE;
+	nfstime t;
+	
+	if (tp->seconds != (ulong) -1L)
+		how = SET_TO_CLIENT_TIME;
+	
+	if (!xdr_enum (x, &how))
+		return FALSE;
+	
+	if (how == SET_TO_CLIENT_TIME)
+	{
+		/* nfstime3 has nanoseconds */
+		t.seconds = tp->seconds;
+		t.useconds = (tp->useconds == (ulong) -1L) ? 0 : tp->useconds * 1000;
+		
+		return xdr_nfstime (x, &t);
+	}
+	
+	return TRUE;
+}
+
+bool_t
+xdr_sattr3 (xdrs *x, sattr *sp)
+{
+	bool_t set;
+	
+	if (XDR_ENCODE != x->op)
+		return FALSE;
+	
+	if (!xdr_set_ulong (x, (sp->mode == (ulong) -1L) ? sp->mode : (sp->mode & 07777)))
+		return FALSE;
+	if (!xdr_set_ulong (x, sp->uid))
+		return FALSE;
+	if (!xdr_set_ulong (x, sp->gid))
+		return FALSE;
+	
+	set = (sp->size != (ulong) -1L);
+	if (!xdr_bool (x, &set))
+		return FALSE;
+	
+	if (set)
+	{
+		ullong size = sp->size;
+		
+		if (!xdr_ullong (x, &size))
+			return FALSE;
+	}
+	
+	if (!xdr_set_time (x, &sp->atime))
+		return FALSE;
+	
+	return xdr_set_time (x, &sp->mtime);
+}
+
+bool_t
+xdr_diropargs3 (xdrs *x, nfs_fh3 *dir, const char **name)
+{
+	if (!xdr_nfsfh3 (x, dir))
+		return FALSE;
+	
+	return xdr_string (x, name, MAXNAMLEN);
+}
@@ -0,0 +1,194 @@
+/*
+ * This file belongs to FreeMiNT. It's not in the original MiNT 1.12
+ * distribution. See the file CHANGES for a detailed log of changes.
+ *
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ *  File : nfs3_xdr.h
+ *         definitions for version 3 of the nfs protocol, see rfc 1813
+ */
+
+
+# ifndef _nfs3_xdr_h
+# define _nfs3_xdr_h
+
+
+# include "global.h"
+# include "nfs_xdr.h"
+# include "xdr.h"
+
+
+/* request numbers
+ */
+
+# define NFSPROC3_NULL		0
+# define NFSPROC3_GETATTR	1
+# define NFSPROC3_SETATTR	2
+# define NFSPROC3_LOOKUP	3
+# define NFSPROC3_ACCESS	4
+# define NFSPROC3_READLINK	5
+# define NFSPROC3_READ		6
+# define NFSPROC3_WRITE		7
+# define NFSPROC3_CREATE	8
+# define NFSPROC3_MKDIR		9
+# define NFSPROC3_SYMLINK	10
+# define NFSPROC3_MKNOD		11
+# define NFSPROC3_REMOVE	12
+# define NFSPROC3_RMDIR		13
+# define NFSPROC3_RENAME	14
+# define NFSPROC3_LINK		15
+# define NFSPROC3_READDIR	16
+# define NFSPROC3_READDIRPLUS	17
+# define NFSPROC3_FSSTAT	18
+# define NFSPROC3_FSINFO	19
+# define NFSPROC3_PATHCONF	20
+# define NFSPROC3_COMMIT	21
+
+# define NFS3_VERSION		3
+
+
+# define NFS3_MAXDATA	32768	/* max number of bytes for read and write we use;
+				 * the protocol has no limit, but the replies
+				 * have to fit into the socket buffer */
+# define NFS3_FHSIZE	64	/* max size in bytes of a file handle */
+# define NFS3_VERFSIZE	8	/* size of the cookie, create and write verifiers */
+
+
+/* status codes that are new in version 3, the others are the
+ * same as the nfsstat of version 2
+ */
+# define NFS3ERR_XDEV		18
+# define NFS3ERR_INVAL		22
+# define NFS3ERR_MLINK		31
+# define NFS3ERR_BADHANDLE	10001
+# define NFS3ERR_NOT_SYNC	10002
+# define NFS3ERR_BAD_COOKIE	10003
+# define NFS3ERR_NOTSUPP	10004
+# define NFS3ERR_TOOSMALL	10005
+# define NFS3ERR_SERVERFAULT	10006
+# define NFS3ERR_BADTYPE	10007
+# define NFS3ERR_JUKEBOX	10008
+
+
+/* ftype3 */
+# define NF3REG		1
+# define NF3DIR		2
+# define NF3BLK		3
+# define NF3CHR		4
+# define NF3LNK		5
+# define NF3SOCK	6
+# define NF3FIFO	7
+
+/* stable_how, for WRITE */
+# define UNSTABLE	0
+# define DATA_SYNC	1
+# define FILE_SYNC	2
+
+/* bits for ACCESS */
+# define ACCESS3_READ		0x0001
+# define ACCESS3_LOOKUP		0x0002
+# define ACCESS3_MODIFY		0x0004
+# define ACCESS3_EXTEND		0x0008
+# define ACCESS3_DELETE		0x0010
+# define ACCESS3_EXECUTE	0x0020
+
+/* createmode3 */
+# define UNCHECKED	0
+# define GUARDED	1
+# define EXCLUSIVE	2
+
+/* time_how, for sattr3 */
+# define DONT_CHANGE		0
+# define SET_TO_SERVER_TIME	1
+# define SET_TO_CLIENT_TIME	2
+
+
+/* data types for nfs version 3
+ */
+
+typedef struct nfs_fh3 nfs_fh3;
+struct nfs_fh3
+{
+	ulong	len;
+	opaque	data[NFS3_FHSIZE];
+};
+
+bool_t xdr_nfsfh3 (xdrs *x, nfs_fh3 *fhp);
+# define xdr_size_nfsfh3(fhp)	(sizeof (ulong) + (((fhp)->len + 3) & ~3L))
+
+
+typedef struct fattr3 fattr3;
+struct fattr3
+{
+	enum_t	type;
+	ulong	mode;
+	ulong	nlink;
+	ulong	uid;
+	ulong	gid;
+	ullong	size;
+	ullong	used;
+	ulong	rdev1;
+	ulong	rdev2;
+	ullong	fsid;
+	ullong	fileid;
+	nfstime	atime;
+	nfstime	mtime;
+	nfstime	ctime;
+};
+
+bool_t xdr_fattr3 (xdrs *x, fattr3 *fp);
+
+
+/* attributes that come along with the results of most requests */
+typedef struct post_op_attr post_op_attr;
+struct post_op_attr
+{
+	bool_t	present;
+	fattr3	attr;
+};
+
+bool_t xdr_post_op_attr (xdrs *x, post_op_attr *ap);
+
+/* the pre operation part is skipped, we only want the new attributes */
+bool_t xdr_wcc_data (xdrs *x, post_op_attr *ap);
+
+
+/* handles of created files are optional */
+typedef struct post_op_fh3 post_op_fh3;
+struct post_op_fh3
+{
+	bool_t	present;
+	nfs_fh3	fh;
+};
+
+bool_t xdr_post_op_fh3 (xdrs *x, post_op_fh3 *fhp);
+
+
+/* sattr3 is encoded from a version 2 sattr where (ulong) -1 means
+ * "don't set", as everywhere in this file system
+ */
+bool_t xdr_sattr3 (xdrs *x, sattr *sp);
+# define xdr_size_sattr3(sp)	(15 * sizeof (ulong))	/* at most */
+
+
+bool_t xdr_diropargs3 (xdrs *x, nfs_fh3 *dir, const char **name);
+# define xdr_size_diropargs3(dir, name)	\
+	(xdr_size_nfsfh3 (dir) + sizeof (ulong) + ((strlen (name) + 3) & ~3L))
+
+
+# endif /* _nfs3_xdr_h */
@@ -23,6 +23,8 @@
 
 # include "mint/ioctl.h"
 
+# include "cache.h"
+# include "nfs3.h"
 # include "nfssys.h"
 # include "nfsutil.h"
 # include "sock_ipc.h"
@@ -45,10 +47,92 @@ DEVDRV nfs_device =
 };
 
 
+/* Reads and writes are pipelined: a file keeps up to NFS_WINDOW READ
+ * or WRITE calls in flight instead of waiting for each reply before
+ * sending the next request.
+ *
+ * Reads go through a small window of rsize blocks that is filled
+ * ahead of the file position as long as the file is read
+ * sequentially (or a single read spans several blocks).
+ *
+ * Writes are sent behind: nfs_write returns as soon as the requests
+ * are on the wire, the replies are collected when the slot is needed
+ * again, before the file is read or its size is looked at, and on
+ * close. A failed write is reported by the next write or the close.
+ *
+ * An NFSv3 server may take the writes as UNSTABLE, that is it only
+ * keeps them in memory. We hold on to the data until a COMMIT, sent
+ * every NFS_COMMIT_LIMIT bytes and on close, tells that it is on
+ * disk; if the server has rebooted in the meantime (the verifier of
+ * the COMMIT is another than that of the write), it is written again.
+ *
+ * What the server gives us for a READ also goes into the data cache
+ * (cache.c), which is valid as long as the attributes of the file
+ * haven't changed; nfs_open refetches them unless the mount has nocto.
+ */
+
+typedef struct nfs_io NFS_IO;
+struct nfs_io
+{
+	long	offset;		/* file position of the block */
+	long	count;		/* number of bytes asked for */
+	long	len;		/* read: number of bytes got */
+	short	busy;		/* call is in flight */
+	short	valid;		/* read: data is valid */
+	char	*data;		/* read: the block */
+	MESSAGE	msg;		/* the request */
+	char	args[READBUFSIZE];
+	RPC_CALL call;
+};
+
+typedef struct nfs_unstable NFS_UNSTABLE;
+struct nfs_unstable
+{
+	NFS_UNSTABLE *next;
+	long	offset;		/* file position of the data */
+	long	count;		/* number of bytes */
+	char	*buf;		/* the request that has sent them */
+	char	*data;		/* the data within buf */
+	char	verf[NFS3_VERFSIZE];
+};
+
+typedef struct nfs_file NFS_FILE;
+struct nfs_file
+{
+	long	next;		/* file position after the last read */
+	long	error;		/* a write behind failed */
+	short	lock;
+	short	wnext;		/* next write slot, in order of issue */
+	NFS_IO	*rd;		/* NFS_WINDOW read slots */
+	long	rdsize;		/* size of the file, */
+	ushort	rdmtime;	/* modification time and */
+	ushort	rdmdate;	/* date when they were read */
+	NFS_IO	*wr;		/* NFS_WINDOW write slots */
+	NFS_UNSTABLE *unstable;	/* NFSv3 writes not yet committed */
+	long	uncommitted;	/* number of bytes in there */
+};
+
+static void
+nf_lock (NFS_FILE *nf)
+{
+	while (nf->lock)
+		s_yield ();
+	
+	nf->lock = 1;
+}
+
+static void
+nf_unlock (NFS_FILE *nf)
+{
+	nf->lock = 0;
+}
+
+
 static long _cdecl
 nfs_open (FILEPTR *f)
 {
 	NFS_INDEX *ni = (NFS_INDEX *) f->fc.index;
+	int created;
 	long r;
 	
 	DEBUG (("nfs_open(%s, 0x%x)", ni->name, f->flags));
@@ -59,66 +143,903 @@ nfs_open (FILEPTR *f)
 		return EACCES;
 	}
 	
-	if ((f->flags & O_TRUNC) && (ni->attr.size != 0))
+	created = (f->flags & O_CREAT) && (ni->flags & JUST_CREATED);
+	ni->flags &= ~JUST_CREATED;
+	
+	/* close-to-open consistency: another client may have changed
+	 * the file since we last looked, so don't trust cached
+	 * attributes (and with them cached data)
+	 */
+	if (!(ni->opt->flags & OPT_NOCTO))
+	{
+		ni->stamp = get_timestamp () - ni->opt->actimeo - 1;
+		
+		if (NFS_V3 (ni))
+		{
+			/* let the server decide, the attributes come along */
+			ulong want = 0;
+			ulong access;
+			
+			if ((f->flags & O_RWMODE) != O_WRONLY)
+				want |= ACCESS3_READ;
+			if ((f->flags & O_RWMODE) == O_WRONLY
+				|| (f->flags & O_RWMODE) == O_RDWR)
+				want |= ACCESS3_MODIFY | ACCESS3_EXTEND;
+			if ((f->flags & O_RWMODE) == O_EXEC)
+				want |= ACCESS3_EXECUTE;
+			
+			/* a file this open has created may be written
+			 * whatever its mode is
+			 */
+			access = want;
+			r = nfs3_access (ni, &access);
+			if (!r && (access & want) != want && !created)
+				r = EACCES;
+		}
+		else
+			r = nfs_getxattr (&f->fc, NULL);
+		
+		if (r)
+		{
+			DEBUG (("nfs_open: getting attributes failed, -> %ld", r));
+			return r;
+		}
+	}
+	
+	if ((f->flags & O_TRUNC) && (ni->attr.size != 0))
+	{
+		/* The file has to be truncated...
+		 * NOTE: if this file has been just created, the length field
+		 *       is set to 0, so we do not get here.
+		 */
+		sattr attr;
+		
+		DEBUG (("nfs_open: truncating file to 0 length"));
+		
+		attr.mode = (ulong) -1L;
+		attr.uid = (ulong) -1L;
+		attr.gid = (ulong) -1L;
+		attr.size = 0;
+		attr.atime.seconds = attr.atime.useconds = (ulong) -1L;
+		attr.mtime.seconds = attr.mtime.useconds = (ulong) -1L;
+		
+		r = do_sattr (&f->fc, &attr);
+		if (r != 0)
+		{
+			DEBUG (("nfs_open : truncation to 0 failed -> EACCES"));
+			return EACCES;
+		}
+	}
+	
+	if (ni->opt->flags & OPT_RO)
+	{
+		if (((f->flags & O_RWMODE) == O_RDWR)
+			|| ((f->flags & O_RWMODE) == O_WRONLY))
+		{
+			DEBUG(("nfs_open: mount is read-only ->EACCES"));
+			return EACCES;
+		}
+	}
+	
+	/* state for read ahead and write behind; without it we
+	 * simply do everything synchronously
+	 */
+	f->devinfo = (long) kmalloc (sizeof (NFS_FILE));
+	if (f->devinfo)
+		bzero ((void *) f->devinfo, sizeof (NFS_FILE));
+	
+	DEBUG (("nfs_open(%s) -> ok", ni->name));
+	return 0;
+}
+
+/* READ and WRITE in the protocol version of the mount; the replies
+ * are decoded to the nfs status, or -1 if they are garbage
+ */
+
+# define READ_PROC(ni)	(NFS_V3 (ni) ? NFSPROC3_READ : NFSPROC_READ)
+# define WRITE_PROC(ni)	(NFS_V3 (ni) ? NFSPROC3_WRITE : NFSPROC_WRITE)
+# define MAX_DATA(ni)	(NFS_V3 (ni) ? NFS3_MAXDATA : MAXDATA)
+
+static MESSAGE *
+read_request (NFS_INDEX *ni, MESSAGE *m, char *buf, long pos, long count)
+{
+	xdrs x;
+	
+	if (NFS_V3 (ni))
+	{
+		ullong offset = (ulong) pos;
+		ulong cnt = count;
+		
+		if (!alloc_message (m, buf, READBUFSIZE, xdr_size_nfsfh3 (&ni->fh3)
+						+ sizeof (ullong) + sizeof (ulong)))
+			return NULL;
+		
+		xdr_init (&x, m->data, m->data_len, XDR_ENCODE, NULL);
+		xdr_nfsfh3 (&x, &ni->fh3);
+		xdr_ullong (&x, &offset);
+		xdr_ulong (&x, &cnt);
+	}
+	else
+	{
+		readargs read_arg;
+		
+		read_arg.file = ni->handle;
+		read_arg.offset = pos;
+		read_arg.count = count;
+		read_arg.totalcount = count;
+		
+		if (!alloc_message (m, buf, READBUFSIZE, xdr_size_readargs (&read_arg)))
+			return NULL;
+		
+		xdr_init (&x, m->data, m->data_len, XDR_ENCODE, NULL);
+		if (!xdr_readargs (&x, &read_arg))
+		{
+			free_message (m);
+			return NULL;
+		}
+	}
+	
+	return m;
+}
+
+static long
+read_reply (NFS_INDEX *ni, MESSAGE *mrep, char *data, long count, long *len)
+{
+	xdrs x;
+	
+	xdr_init (&x, mrep->data, mrep->data_len, XDR_DECODE, NULL);
+	
+	if (NFS_V3 (ni))
+	{
+		const opaque *p = data;
+		post_op_attr attr;
+		enum_t status;
+		ulong cnt;
+		bool_t eof;
+		
+		if (!xdr_enum (&x, &status))
+			return -1;
+		
+		if (status != NFS_OK)
+			return status;
+		
+		if (!xdr_post_op_attr (&x, &attr)
+			|| !xdr_ulong (&x, &cnt)
+			|| !xdr_bool (&x, &eof)
+			|| !xdr_opaque (&x, &p, len, count))
+		{
+			return -1;
+		}
+		
+		nfs3_attr (ni, &attr);
+	}
+	else
+	{
+		readres read_res;
+		
+		read_res.readres_u.read_ok.data_val = data;
+		
+		if (!xdr_readres (&x, &read_res))
+			return -1;
+		
+		if (read_res.status != NFS_OK)
+			return read_res.status;
+		
+		*len = read_res.readres_u.read_ok.data_len;
+		
+		fattr2xattr (&read_res.readres_u.read_ok.attributes, &ni->attr);
+		ni->stamp = get_timestamp ();
+	}
+	
+	return NFS_OK;
+}
+
+/* the data ends up at the end of the encoded request; version 2
+ * doesn't know about stable, it always writes through
+ */
+static MESSAGE *
+write_request (NFS_INDEX *ni, MESSAGE *m, long pos, const char *data, long count, long stable)
+{
+	xdrs x;
+	
+	if (NFS_V3 (ni))
+	{
+		ullong offset = (ulong) pos;
+		ulong cnt = count;
+		enum_t how = stable;
+		long len = count;
+		
+		if (!alloc_message (m, NULL, 0, xdr_size_nfsfh3 (&ni->fh3)
+						+ sizeof (ullong) + 3 * sizeof (ulong)
+						+ ((count + 3) & ~3L)))
+			return NULL;
+		
+		xdr_init (&x, m->data, m->data_len, XDR_ENCODE, NULL);
+		xdr_nfsfh3 (&x, &ni->fh3);
+		xdr_ullong (&x, &offset);
+		xdr_ulong (&x, &cnt);
+		xdr_enum (&x, &how);
+		if (!xdr_opaque (&x, &data, &len, NFS3_MAXDATA))
+		{
+			free_message (m);
+			return NULL;
+		}
+	}
+	else
+	{
+		writeargs write_arg;
+		
+		write_arg.file = ni->handle;
+		write_arg.beginoffset = 0;
+		write_arg.offset = pos;
+		write_arg.totalcount = count;
+		write_arg.data_val = data;
+		write_arg.data_len = count;
+		
+		if (!alloc_message (m, NULL, 0, xdr_size_writeargs (&write_arg)))
+			return NULL;
+		
+		xdr_init (&x, m->data, m->data_len, XDR_ENCODE, NULL);
+		if (!xdr_writeargs (&x, &write_arg))
+		{
+			free_message (m);
+			return NULL;
+		}
+	}
+	
+	return m;
+}
+
+/* for version 3, stable says how the server has written the data and
+ * verf is what a COMMIT has to give back for it; a short write is
+ * taken as an I/O error, the caller writes again with smaller requests
+ */
+static long
+write_reply (NFS_INDEX *ni, MESSAGE *mrep, long count, long *stable, char *verf)
+{
+	xdrs x;
+	
+	xdr_init (&x, mrep->data, mrep->data_len, XDR_DECODE, NULL);
+	
+	if (NFS_V3 (ni))
+	{
+		post_op_attr attr;
+		enum_t status;
+		enum_t committed;
+		ulong cnt;
+		
+		if (!xdr_enum (&x, &status))
+			return -1;
+		
+		if (status != NFS_OK)
+			return status;
+		
+		if (!xdr_wcc_data (&x, &attr)
+			|| !xdr_ulong (&x, &cnt)
+			|| !xdr_enum (&x, &committed)
+			|| !xdr_fixedopaq (&x, verf, NFS3_VERFSIZE))
+		{
+			return -1;
+		}
+		
+		nfs3_attr (ni, &attr);
+		
+		if (cnt != count)
+			return NFSERR_IO;
+		
+		*stable = committed;
+	}
+	else
+	{
+		attrstat write_res;
+		
+		if (!xdr_attrstat (&x, &write_res))
+			return -1;
+		
+		if (write_res.status != NFS_OK)
+			return write_res.status;
+		
+		fattr2xattr (&write_res.attrstat_u.attributes, &ni->attr);
+		ni->stamp = get_timestamp ();
+		
+		*stable = FILE_SYNC;
+	}
+	
+	return NFS_OK;
+}
+
+
+/* BUG: should we really allways return EWRITE? Better might be the number of
+ *      already written bytes.
+ */
+static long
+write_sync (NFS_INDEX *ni, long pos, const char *buf, long bytes)
+{
+	long written;
+	
+	/* TL: If we get an NFSERR_IO we'll reduce the wsize for this request
+	 * and retry.
+	 * It would be better to adjust wsize dynamically but this is better
+	 * than nothing.
+	 */
+	long wsize = ni->opt->wsize;
+	
+	written = 0;
+	while (bytes > 0)
+	{
+		MESSAGE *mreq;
+		MESSAGE *mrep;
+		MESSAGE m;
+		
+		char verf[NFS3_VERFSIZE];
+		long count = (bytes > wsize) ? wsize : bytes;
+		long stable;
+		long r;
+		
+		mreq = write_request (ni, &m, pos, buf + written, count, FILE_SYNC);
+		if (!mreq)
+		{
+			DEBUG(("nfs_write: could not set up request -> EWRITE"));
+			return EWRITE;
+		}
+		
+		r = rpc_request (&ni->opt->server, mreq, WRITE_PROC (ni), &mrep);
+		if (r != 0)
+		{
+			DEBUG (("nfs_write: could not contact server -> EWRITE"));
+			return EWRITE;
+		}
+		
+		r = write_reply (ni, mrep, count, &stable, verf);
+		free_message (mrep);
+		
+		if (r < 0)
+		{
+			DEBUG (("nfs_write: failed to decode results -> EWRITE"));
+			return EWRITE;
+		}
+		
+		if (r != NFS_OK)
+		{
+			/* TL: Reduce the wsize and try again */
+			if ((r == NFSERR_IO) && (wsize > 1023))
+			{
+				wsize >>= 1;
+				continue;
+			}
+			
+			DEBUG(("nfs_write: write failed -> EWRITE"));
+			return EWRITE;
+		}
+		
+		written += count;
+		pos += count;
+		bytes -= count;
+	}
+	
+	return written;
+}
+
+static long
+start_write (NFS_INDEX *ni, NFS_IO *io, long pos, const char *buf, long count)
+{
+	/* NFSv3 servers may keep the data in memory, we COMMIT it later */
+	if (!write_request (ni, &io->msg, pos, buf, count, UNSTABLE))
+		return ENOMEM;
+	
+	if (rpc_start (&ni->opt->server, &io->msg, WRITE_PROC (ni), &io->call))
+		return EWRITE;
+	
+	io->offset = pos;
+	io->count = count;
+	io->busy = 1;
+	
+	return 0;
+}
+
+/* keep the data of an UNSTABLE write until it is committed; the record
+ * takes over the buffer of the request
+ */
+static long
+keep_unstable (NFS_FILE *nf, NFS_IO *io, MESSAGE *m, char *verf)
+{
+	NFS_UNSTABLE *u, **up;
+	
+	if (!(m->flags & FREE_BUFFER))
+		return ENOMEM;
+	
+	u = kmalloc (sizeof (*u));
+	if (!u)
+		return ENOMEM;
+	
+	u->next = NULL;
+	u->offset = io->offset;
+	u->count = io->count;
+	u->buf = m->buffer;
+	u->data = m->data + m->data_len - ((io->count + 3) & ~3L);
+	memcpy (u->verf, verf, NFS3_VERFSIZE);
+	
+	m->flags &= ~FREE_BUFFER;
+	free_message (m);
+	
+	/* in the order of the writes, they may overlap */
+	for (up = &nf->unstable; *up; up = &(*up)->next)
+		;
+	
+	*up = u;
+	nf->uncommitted += u->count;
+	
+	return 0;
+}
+
+/* collect the reply of a write behind */
+static long
+finish_write (NFS_INDEX *ni, NFS_FILE *nf, NFS_IO *io)
+{
+	char verf[NFS3_VERFSIZE];
+	MESSAGE *m, *mrep;
+	long stable;
+	long r;
+	
+	io->busy = 0;
+	
+	r = rpc_wait (&ni->opt->server, &io->call, &mrep);
+	if (r != 0)
+	{
+		DEBUG (("nfs_write: could not contact server -> EWRITE"));
+		goto error;
+	}
+	
+	r = write_reply (ni, mrep, io->count, &stable, verf);
+	free_message (mrep);
+	
+	m = io->call.mreq;
+	
+	if (r < 0)
+	{
+		DEBUG (("nfs_write: failed to decode results -> EWRITE"));
+		free_message (m);
+		goto error;
+	}
+	
+	if (r == NFS_OK && stable == UNSTABLE && keep_unstable (nf, io, m, verf) == 0)
+		return 0;
+	
+	if ((r == NFSERR_IO && ni->opt->wsize > 1023)
+		|| (r == NFS_OK && stable == UNSTABLE))
+	{
+		/* The data is still in the encoded request, at its end;
+		 * write_sync() does the smaller requests, and the
+		 * unstable write we have no memory to keep.
+		 */
+		r = write_sync (ni, io->offset,
+				m->data + m->data_len - ((io->count + 3) & ~3L),
+				io->count);
+		free_message (m);
+		
+		if (r != io->count)
+			goto error;
+		
+		return 0;
+	}
+	
+	free_message (m);
+	
+	if (r != NFS_OK)
+	{
+		DEBUG(("nfs_write: write failed -> EWRITE"));
+		goto error;
+	}
+	
+	return 0;
+	
+error:
+	nf->error = EWRITE;
+	return EWRITE;
+}
+
+/* collect the replies of all writes behind that overlap [from, to),
+ * in the order they were sent
+ */
+static long
+wait_writes (NFS_INDEX *ni, NFS_FILE *nf, long from, long to)
+{
+	long r = 0;
+	int i;
+	
+	if (!nf->wr)
+		return 0;
+	
+	for (i = 0; i < NFS_WINDOW; i++)
+	{
+		NFS_IO *io = &nf->wr[(nf->wnext + i) % NFS_WINDOW];
+		
+		if (io->busy && io->offset < to && io->offset + io->count > from)
+		{
+			if (finish_write (ni, nf, io))
+				r = EWRITE;
+		}
+	}
+	
+	return r;
+}
+
+# define flush_writes(ni, nf)	wait_writes (ni, nf, 0, 0x7fffffffL)
+
+/* make the unstable writes stable: all of them are on the server
+ * when the COMMIT for the whole file comes back with the verifier
+ * they were written with, the others are written again
+ */
+static long
+commit_writes (NFS_INDEX *ni, NFS_FILE *nf)
+{
+	char req_buf[NFS3BUFSIZE];
+	char verf[NFS3_VERFSIZE];
+	post_op_attr attr;
+	NFS_UNSTABLE *u;
+	MESSAGE *mreq, *mrep, m;
+	ullong offset = 0;
+	ulong count = 0;
+	enum_t status;
+	xdrs x;
+	long r;
+	
+	flush_writes (ni, nf);
+	
+	if (!nf->unstable)
+		return nf->error;
+	
+	r = EWRITE;
+	
+	mreq = alloc_message (&m, req_buf, NFS3BUFSIZE, xdr_size_nfsfh3 (&ni->fh3)
+						+ sizeof (ullong) + sizeof (ulong));
+	if (mreq)
+	{
+		xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
+		xdr_nfsfh3 (&x, &ni->fh3);
+		xdr_ullong (&x, &offset);
+		xdr_ulong (&x, &count);
+		
+		if (rpc_request (&ni->opt->server, mreq, NFSPROC3_COMMIT, &mrep) == 0)
+		{
+			xdr_init (&x, mrep->data, mrep->data_len, XDR_DECODE, NULL);
+			if (xdr_enum (&x, &status) && status == NFS_OK
+				&& xdr_wcc_data (&x, &attr)
+				&& xdr_fixedopaq (&x, verf, NFS3_VERFSIZE))
+			{
+				nfs3_attr (ni, &attr);
+				r = 0;
+			}
+			
+			free_message (mrep);
+		}
+	}
+	
+	if (r)
+		DEBUG (("nfs_commit: COMMIT failed, writing again"));
+	
+	while ((u = nf->unstable))
+	{
+		nf->unstable = u->next;
+		
+		if (r || memcmp (u->verf, verf, NFS3_VERFSIZE))
+		{
+			DEBUG (("nfs_commit: %ld bytes at %ld lost", u->count, u->offset));
+			
+			if (write_sync (ni, u->offset, u->data, u->count) != u->count)
+				nf->error = EWRITE;
+		}
+		
+		kfree (u->buf);
+		kfree (u);
+	}
+	
+	nf->uncommitted = 0;
+	
+	return nf->error;
+}
+
+
+/* BUG: should we really allways return EREAD? Better might be the number of
+ *      already read bytes.
+ */
+static long
+read_sync (NFS_INDEX *ni, long pos, char *buf, long bytes)
+{
+	long read;
+	
+	/* TL: If we get an NFSERR_IO try to reduce the rsize for this request
+	 * and retry.
+	 * It would be better to adjust rsize dynamically but this is better
+	 * than nothing.
+	 */
+	long rsize = ni->opt->rsize;
+	
+	read = 0;
+	while (bytes > 0)
+	{
+		char req_buf[READBUFSIZE];
+		
+		MESSAGE *mreq;
+		MESSAGE *mrep;
+		MESSAGE m;
+		
+		long count = (bytes > rsize) ? rsize : bytes;
+		long r, len;
+		
+		mreq = read_request (ni, &m, req_buf, pos, count);
+		if (!mreq)
+		{
+			DEBUG (("nfs_read: failed to set up request, -> EREAD"));
+			return EREAD;
+		}
+		
+		r = rpc_request (&ni->opt->server, mreq, READ_PROC (ni), &mrep);
+		if (r != 0)
+		{
+			DEBUG (("nfs_read: failed to contact server, -> EREAD"));
+			return EREAD;
+		}
+		
+		r = read_reply (ni, mrep, buf + read, count, &len);
+		free_message (mrep);
+		
+		if (r < 0)
+		{
+			DEBUG (("nfs_read: could not decode results, -> EREAD"));
+			return EREAD;
+		}
+		
+		if (r != NFS_OK)
+		{
+			/* TL: Try to reduce the rsize */
+			if ((r == NFSERR_IO) && (rsize > 1023))
+			{
+				rsize >>= 1;
+				continue;
+			}
+			
+			/* read failed for some reason */
+			DEBUG (("nfs_read: request failed, -> EREAD"));
+			return EREAD;
+		}
+		
+		r = len;
+		
+		nfs_data_fill (ni, pos, buf + read, r, count);
+		
+		read += r;
+		pos += r;
+		bytes -= r;
+		
+		if (r < count)
+		{
+			/* no more data */
+			
+			DEBUG (("nfs_read: read only %ld bytes, -> ok", r));
+			break;
+		}
+	}
+	
+	return read;
+}
+
+static void
+start_read (NFS_INDEX *ni, NFS_IO *io, long pos, long count)
+{
+	if (!read_request (ni, &io->msg, io->args, pos, count))
+		return;
+	
+	if (rpc_start (&ni->opt->server, &io->msg, READ_PROC (ni), &io->call))
+		return;
+	
+	io->offset = pos;
+	io->count = count;
+	io->len = 0;
+	io->busy = 1;
+	io->valid = 0;
+}
+
+/* collect the reply of a read ahead */
+static long
+finish_read (NFS_INDEX *ni, NFS_IO *io)
+{
+	MESSAGE *mrep;
+	long r;
+	
+	io->busy = 0;
+	
+	r = rpc_wait (&ni->opt->server, &io->call, &mrep);
+	if (r != 0)
+	{
+		DEBUG (("nfs_read: failed to contact server, -> EREAD"));
+		return EREAD;
+	}
+	
+	free_message (io->call.mreq);
+	
+	r = read_reply (ni, mrep, io->data, io->count, &io->len);
+	free_message (mrep);
+	
+	if (r != NFS_OK)
+	{
+		/* read_sync() takes care of a NFSERR_IO */
+		DEBUG (("nfs_read: read ahead failed"));
+		return EREAD;
+	}
+	
+	io->valid = 1;
+	
+	nfs_data_fill (ni, io->offset, io->data, io->len, io->count);
+	
+	return 0;
+}
+
+/* the read slot that holds (or will hold) pos */
+static NFS_IO *
+find_read (NFS_FILE *nf, long pos)
+{
+	int i;
+	
+	for (i = 0; i < NFS_WINDOW; i++)
+	{
+		NFS_IO *io = &nf->rd[i];
+		
+		if ((io->busy || io->valid) && io->offset <= pos && pos < io->offset + io->count)
+			return io;
+	}
+	
+	return NULL;
+}
+
+/* throw away read slots outside [from, to) */
+static void
+drop_reads (NFS_FILE *nf, long from, long to)
+{
+	int i;
+	
+	if (!nf->rd)
+		return;
+	
+	for (i = 0; i < NFS_WINDOW; i++)
+	{
+		NFS_IO *io = &nf->rd[i];
+		
+		if (io->offset < to && io->offset + io->count > from)
+			continue;
+		
+		if (io->busy)
+		{
+			rpc_cancel (&io->call);
+			io->busy = 0;
+		}
+		
+		io->valid = 0;
+	}
+}
+
+/* throw away the slots that stop short at the end of the file;
+ * the file may grow until the next read
+ */
+static void
+drop_eof_reads (NFS_FILE *nf)
+{
+	int i;
+	
+	for (i = 0; i < NFS_WINDOW; i++)
+	{
+		NFS_IO *io = &nf->rd[i];
+		
+		if (io->valid && io->len < io->count)
+			io->valid = 0;
+	}
+}
+
+/* send READs for the blocks of [from, to) that aren't there yet,
+ * reusing slots that have been consumed already; read ahead stops
+ * at the end of the file as far as we know it
+ */
+static void
+fill_reads (NFS_INDEX *ni, NFS_FILE *nf, long from, long to, long ahead)
+{
+	long rsize = ni->opt->rsize;
+	long pos;
+	int busy, i;
+	
+	for (busy = 0, i = 0; i < NFS_WINDOW; i++)
+		busy += nf->rd[i].busy;
+	
+	for (pos = from - from % rsize; pos < to; pos += rsize)
 	{
-		/* The file has to be truncated...
-		 * NOTE: if this file has been just created, the length field
-		 *       is set to 0, so we do not get here.
-		 */
-		sattr attr;
+		NFS_IO *io;
 		
-		DEBUG (("nfs_open: truncating file to 0 length"));
+		if (find_read (nf, pos) || nfs_data_cached (ni, pos, rsize))
+			continue;
 		
-		attr.mode = (ulong) -1L;
-		attr.uid = (ulong) -1L;
-		attr.gid = (ulong) -1L;
-		attr.size = 0;
-		attr.atime.seconds = attr.atime.useconds = (ulong) -1L;
-		attr.mtime.seconds = attr.mtime.useconds = (ulong) -1L;
+		if (ahead && pos >= ni->attr.size)
+			break;
 		
-		r = do_sattr (&f->fc, &attr);
-		if (r != 0)
+		/* the replies have to fit into the socket buffer, else
+		 * they are dropped and we wait for the retransmits
+		 */
+		if (busy && (busy + 1) * (rsize + RPC_HDRBUFSIZE) > NFS_SOCKBUF)
+			break;
+		
+		for (io = NULL, i = 0; i < NFS_WINDOW; i++)
 		{
-			DEBUG (("nfs_open : truncation to 0 failed -> EACCES"));
-			return EACCES;
+			NFS_IO *tmp = &nf->rd[i];
+			
+			if (tmp->busy)
+				continue;
+			
+			if (!tmp->valid || tmp->offset + tmp->count <= from)
+			{
+				io = tmp;
+				break;
+			}
 		}
+		
+		if (!io)
+			break;
+		
+		start_read (ni, io, pos, rsize);
+		if (!io->busy)
+			break;
+		
+		busy++;
 	}
+}
+
+static NFS_IO *
+alloc_slots (long datasize)
+{
+	NFS_IO *io;
+	int i;
 	
-	if (ni->opt->flags & OPT_RO)
+	io = kmalloc (NFS_WINDOW * (sizeof (*io) + datasize));
+	if (io)
 	{
-		if (((f->flags & O_RWMODE) == O_RDWR)
-			|| ((f->flags & O_RWMODE) == O_WRONLY))
+		char *data = (char *) (io + NFS_WINDOW);
+		
+		for (i = 0; i < NFS_WINDOW; i++)
 		{
-			DEBUG(("nfs_open: mount is read-only ->EACCES"));
-			return EACCES;
+			io[i].busy = 0;
+			io[i].valid = 0;
+			io[i].data = datasize ? data + i * datasize : NULL;
 		}
 	}
 	
-	DEBUG (("nfs_open(%s) -> ok", ni->name));
-	return 0;
+	return io;
+}
+
+/* before the size of the file is looked at */
+static void
+sync_writes (FILEPTR *f)
+{
+	NFS_FILE *nf = (NFS_FILE *) f->devinfo;
+	
+	if (nf)
+	{
+		nf_lock (nf);
+		flush_writes ((NFS_INDEX *) f->fc.index, nf);
+		nf_unlock (nf);
+	}
 }
 
-/* BUG: should we really allways return EWRITE? Better might be the number of
- *      already written bytes.
- */
 static long _cdecl
 nfs_write (FILEPTR *f, const char *buf, long bytes)
 {
 	NFS_INDEX *ni = (NFS_INDEX *) f->fc.index;
+	NFS_FILE *nf = (NFS_FILE *) f->devinfo;
 	
 	long pos;
 	long written;
-	
-	/* TL: If we get an NFSERR_IO we'll reduce the wsize for this request
-	 * and retry.
-	 * It would be better to adjust wsize dynamically but this is better
-	 * than nothing.
-	 */
 	long wsize = ni->opt->wsize;
+	long r;
 	
 	/* TL: If somehow mounted with too big wsize reduce it here. */
-	if (wsize > MAXDATA)
-		wsize = ni->opt->wsize = MAXDATA;
+	if (wsize > MAX_DATA (ni))
+		wsize = ni->opt->wsize = MAX_DATA (ni);
 	
 	if (ROOT_INDEX == ni)
 	{
@@ -134,112 +1055,103 @@ nfs_write (FILEPTR *f, const char *buf, long bytes)
 	
 	TRACE(("nfs_write: writing %ld bytes to file '%s'", bytes, ni->name));
 	
+	nfs_data_inval (ni, f->pos, f->pos + bytes);
+	
+	if (!nf)
+	{
+		r = write_sync (ni, f->pos, buf, bytes);
+		if (r > 0)
+			f->pos += r;
+		
+		return r;
+	}
+	
+	nf_lock (nf);
+	
+	if (!nf->wr)
+		nf->wr = alloc_slots (0);
+	
+	/* what we have read ahead may be overwritten now */
+	drop_reads (nf, 0, 0);
+	
+	r = nf->error;
+	nf->error = 0;
+	
 	written = 0;
 	pos = f->pos;
-	while (bytes > 0)
+	while (!r && bytes > 0)
 	{
-		writeargs write_arg;
-		attrstat write_res;
-		xdrs x;
-		
-		MESSAGE *mreq;
-		MESSAGE *mrep;
-		MESSAGE m;
-		
+		NFS_IO *io;
 		long count = (bytes > wsize) ? wsize : bytes;
-		long r;
-		
-		write_arg.file = ni->handle;
-		write_arg.beginoffset = 0;
-		write_arg.offset = pos;
-		write_arg.totalcount = count;
-		write_arg.data_val = buf + written;
-		write_arg.data_len = count;
-		
-		mreq = alloc_message (&m, NULL, 0, xdr_size_writeargs (&write_arg));
-		if (!mreq)
-		{
-			DEBUG(("nfs_write: could not allocate message buffer -> EWRITE"));
-			return EWRITE;
-		}
-		
-		xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
-		if (!xdr_writeargs (&x, &write_arg))
-		{
-			DEBUG (("nfs_write: failed to encode arguments -> EWRITE"));
-			return EWRITE;
-		}
-		
-		r = rpc_request (&ni->opt->server, mreq, NFSPROC_WRITE, &mrep);
-		if (r != 0)
-		{
-			DEBUG (("nfs_write: could not contact server -> EWRITE"));
-			return EWRITE;
-		}
 		
-		xdr_init (&x, mrep->data, mrep->data_len, XDR_DECODE, NULL);
-		if (!xdr_attrstat (&x, &write_res))
+		if (!nf->wr)
 		{
-			free_message (mrep);
+			r = write_sync (ni, pos, buf + written, bytes);
+			if (r != bytes)
+			{
+				r = EWRITE;
+				break;
+			}
 			
-			DEBUG (("nfs_write: failed to decode results -> EWRITE"));
-			return EWRITE;
+			count = bytes;
+			r = 0;
 		}
-		
-		free_message (mrep);
-		
-		if (write_res.status != NFS_OK)
+		else
 		{
-			/* TL: Reduce the wsize and try again */
-			if (write_res.status == NFSERR_IO)
+			/* writes to the same place must stay in order */
+			r = wait_writes (ni, nf, pos, pos + count);
+			
+			io = &nf->wr[nf->wnext];
+			if (!r && io->busy)
+				r = finish_write (ni, nf, io);
+			
+			if (r)
+				break;
+			
+			if (start_write (ni, io, pos, buf + written, count) == 0)
+				nf->wnext = (nf->wnext + 1) % NFS_WINDOW;
+			else if (write_sync (ni, pos, buf + written, count) != count)
 			{
-				if (wsize > 1023)
-				{
-					wsize >>= 1;
-					continue;
-				}
-				else
-				{
-					DEBUG(("nfs_write: write failed -> EWRITE"));
-					return EWRITE;
-				}
+				r = EWRITE;
+				break;
 			}
 		}
 		
-		fattr2xattr (&write_res.attrstat_u.attributes, &ni->attr);
-		ni->stamp = get_timestamp ();
-		
 		written += count;
 		pos += count;
 		bytes -= count;
 	}
 	
+	/* don't let the server pile up too much that isn't on disk */
+	if (!r && nf->uncommitted >= NFS_COMMIT_LIMIT)
+		r = commit_writes (ni, nf);
+	
 	f->pos = pos;
 	
+	nf->error = 0;
+	nf_unlock (nf);
+	
+	if (r)
+		return r;
+	
 	TRACE (("nfs_write(%s) -> %ld", ni->name, written));
 	return written;
 }
 
-/* BUG: should we really allways return EREAD? Better might be the number of
- *      already read bytes.
- */
 static long _cdecl
 nfs_read (FILEPTR *f, char *buf, long bytes)
 {
 	NFS_INDEX *ni = (NFS_INDEX *) f->fc.index;
+	NFS_FILE *nf = (NFS_FILE *) f->devinfo;
 	long pos;
 	long read;
-	
-	/* TL: If we get an NFSERR_IO try to reduce the rsize for this request
-	 * and retry.
-	 * It would be better to adjust rsize dynamically but this is better
-	 * than nothing.
-	 */
 	long rsize = ni->opt->rsize;
+	long r;
+	int seq;
 	
 	/* TL: If somehow mounted with too big rsize reduce it here */
-	if (rsize > MAXDATA)
-		rsize = ni->opt->rsize = MAXDATA;
+	if (rsize > MAX_DATA (ni))
+		rsize = ni->opt->rsize = MAX_DATA (ni);
 	
 	if (ROOT_INDEX == ni)
 	{
@@ -249,99 +1161,143 @@ nfs_read (FILEPTR *f, char *buf, long bytes)
 	
 	TRACE (("nfs_read: reading %ld bytes for file '%s'", bytes, ni->name));
 	
-	read = 0;
-	pos = f->pos;
-	while (bytes > 0)
+	if (!nf)
 	{
-		char req_buf[READBUFSIZE];
-		
-		readargs read_arg;
-		readres read_res;
-		xdrs x;
-		
-		MESSAGE *mreq;
-		MESSAGE *mrep;
-		MESSAGE m;
-		
-		long count = (bytes > ni->opt->rsize) ? ni->opt->rsize : bytes;
-		long r;
+		r = read_sync (ni, f->pos, buf, bytes);
+		if (r > 0)
+			f->pos += r;
 		
-		read_arg.file = ni->handle;
-		read_arg.offset = pos;
-		read_arg.count = count;
-		read_arg.totalcount = count;
+		return r;
+	}
+	
+	nf_lock (nf);
+	
+	/* make sure we read what we have written; the error,
+	 * if any, is reported by the next write or close
+	 */
+	flush_writes (ni, nf);
+	
+	/* with the attribute cache, cached data is good as long as
+	 * the attributes are
+	 */
+	if (!(ni->opt->flags & OPT_NOAC))
+		nfs_getxattr (&f->fc, NULL);
+	
+	/* the same goes for the window: somebody else has written */
+	if (nf->rd && (ni->attr.size != nf->rdsize
+		|| ni->attr.mtime != nf->rdmtime || ni->attr.mdate != nf->rdmdate))
+	{
+		drop_reads (nf, 0, 0);
+	}
+	
+	pos = f->pos;
+	seq = (pos == nf->next);
+	
+	/* a window only pays off when there is more than one block to read */
+	if (!nf->rd && ((seq && ni->attr.size > pos + bytes) || bytes > rsize))
+		nf->rd = alloc_slots (rsize);
+	
+	read = 0;
+	r = 0;
+	
+	if (nf->rd)
+	{
+		nf->rdsize = ni->attr.size;
+		nf->rdmtime = ni->attr.mtime;
+		nf->rdmdate = ni->attr.mdate;
 		
-		mreq = alloc_message (&m, req_buf, READBUFSIZE, xdr_size_readargs(&read_arg));
-		if (!mreq)
-		{
-			DEBUG (("nfs_read: failed to allocate message buffer, -> EREAD"));
-			return EREAD;
-		}
+		if (!seq)
+			drop_reads (nf, pos, pos + bytes);
 		
-		xdr_init (&x, mreq->data, mreq->data_len, XDR_ENCODE, NULL);
-		if (!xdr_readargs (&x, &read_arg))
-		{
-			DEBUG (("nfs_read: failed to encode arguments, -> EREAD"));
-			return EREAD;
-		}
+		fill_reads (ni, nf, pos, pos + bytes, 0);
+	}
+	
+	while (bytes > 0)
+	{
+		NFS_IO *io;
+		long n;
+		int eof;
 		
-		r = rpc_request (&ni->opt->server, mreq, NFSPROC_READ, &mrep);
-		if (r != 0)
+		n = nfs_data_read (ni, pos, buf + read, bytes);
+		if (n < 0)
 		{
-			DEBUG (("nfs_read: failed to contact server, -> EREAD"));
-			return EREAD;
+			/* end of file */
+			bytes = 0;
+			break;
 		}
-
-		read_res.readres_u.read_ok.data_val = buf + read;
 		
-		xdr_init (&x, mrep->data, mrep->data_len, XDR_DECODE, NULL);
-		if (!xdr_readres (&x, &read_res))
+		if (n > 0)
+			eof = 0;
+		else
 		{
-			free_message (mrep);
+			if (!nf->rd)
+				break;
 			
-			DEBUG (("nfs_read: could not decode results, -> EREAD"));
-			return EREAD;
-		}
-		
-		free_message (mrep);
-		
-		if (read_res.status != NFS_OK)
-		{
-			/* TL: Try to reduce the rsize */
-			if (read_res.status == NFSERR_IO)
+			io = find_read (nf, pos);
+			if (!io)
+				break;
+			
+			if (io->busy && finish_read (ni, io))
+				break;
+			
+			n = io->offset + io->len - pos;
+			if (n <= 0)
 			{
-				if (rsize > 1023)
-				{
-					rsize >>= 1;
-					continue;
-				}
-				else
-				{
-					/* read failed for some reason */
-					DEBUG (("nfs_read: request failed, -> EREAD"));
-					return EREAD;
-				}
+				/* end of file */
+				bytes = 0;
+				break;
 			}
+			
+			if (n > bytes)
+				n = bytes;
+			
+			memcpy (buf + read, io->data + (pos - io->offset), n);
+			eof = (pos + n == io->offset + io->len && io->len < io->count);
 		}
 		
-		r = read_res.readres_u.read_ok.data_len;
-		read += r;
-		pos += r;
-		bytes -= r;
-		
-		fattr2xattr (&read_res.readres_u.read_ok.attributes, &ni->attr);
-		ni->stamp = get_timestamp ();
+		read += n;
+		pos += n;
+		bytes -= n;
 		
-		if (r < count)
+		if (eof)
 		{
-			/* no more data */
-			
-			DEBUG (("nfs_read: read only %ld bytes, -> ok", r));
+			bytes = 0;
 			break;
 		}
+		
+		/* keep the window filled while we copy */
+		if (nf->rd)
+			fill_reads (ni, nf, pos, pos + bytes, 0);
+	}
+	
+	/* whatever the window didn't give us */
+	if (bytes > 0)
+	{
+		r = read_sync (ni, pos, buf + read, bytes);
+		if (r > 0)
+		{
+			read += r;
+			pos += r;
+		}
+	}
+	
+	/* read ahead for the next call */
+	if (nf->rd)
+	{
+		drop_eof_reads (nf);
+		
+		if (r >= 0)
+			fill_reads (ni, nf, pos, pos + NFS_WINDOW * rsize, 1);
 	}
 	
+	nf->next = pos;
 	f->pos = pos;
+	
+	nf_unlock (nf);
+	
+	if (r < 0 && read == 0)
+		return r;
+	
 	return read;
 }
 
@@ -371,8 +1327,11 @@ nfs_lseek (FILEPTR *f, long where, int whence)
 		case SEEK_END:
 		{
 			NFS_INDEX *ni;
+			long r;
 			
-			long r = nfs_getxattr (&f->fc, NULL);
+			sync_writes (f);
+			
+			r = nfs_getxattr (&f->fc, NULL);
 			if (r)
 			{
 				DEBUG (("nfs_lseek: nfs_getxattr failed while SEEK_END, -> %ld", r));
@@ -400,6 +1359,8 @@ nfs_ioctl (FILEPTR *f, int mode, void *arg)
 			NFS_INDEX *ni = (NFS_INDEX *) f->fc.index;
 			long r;
 			
+			sync_writes (f);
+			
 			r = nfs_getxattr (&f->fc, NULL);
 			if (r)
 			{
@@ -488,6 +1449,7 @@ nfs_datime (FILEPTR *f, ushort *timeptr, int flag)
 			long r;
 			
 			/* update cache if necessary */
+			sync_writes (f);
 			r = nfs_getxattr (&f->fc, NULL);
 			if (r != 0)
 			{
@@ -549,10 +1511,43 @@ nfs_datime (FILEPTR *f, ushort *timeptr, int flag)
 static long _cdecl
 nfs_close (FILEPTR *f, int pid)
 {
-	TRACE (("nfs_close -> ok"));
+	NFS_INDEX *ni = (NFS_INDEX *) f->fc.index;
+	NFS_FILE *nf = (NFS_FILE *) f->devinfo;
+	long r;
 	
-	/* nothing to do */
-	return 0;
+	if (!nf)
+	{
+		TRACE (("nfs_close -> ok"));
+		return 0;
+	}
+	
+	nf_lock (nf);
+	
+	/* all writes behind have to be on the server (and on its
+	 * disk) when the file is closed, the next open may be on
+	 * another client
+	 */
+	commit_writes (ni, nf);
+	r = nf->error;
+	nf->error = 0;
+	
+	if (f->links <= 0)
+	{
+		drop_reads (nf, 0, 0);
+		
+		if (nf->rd)
+			kfree (nf->rd);
+		if (nf->wr)
+			kfree (nf->wr);
+		
+		kfree (nf);
+		f->devinfo = 0;
+	}
+	else
+		nf_unlock (nf);
+	
+	TRACE (("nfs_close -> %ld", r));
+	return r;
 }
 
 static long _cdecl
@@ -28,6 +28,7 @@
 
 # include "cache.h"
 # include "index.h"
+# include "nfs3.h"
 # include "nfsutil.h"
 # include "sock_ipc.h"
 # include "version.h"
@@ -54,6 +55,7 @@ static long	_cdecl nfs_getname	(fcookie *root, fcookie *dir, char *pathname, int
 static long	_cdecl nfs_rename	(fcookie *olddir, char *oldname, fcookie *newdir, const char *newname);
 static long	_cdecl nfs_opendir	(DIR *dirh, int flags);
 static long	_cdecl nfs_readdir	(DIR *dirh, char *nm, int nmlen, fcookie *);
+static long	_cdecl nfs_readdirplus	(DIR *dirh, char *buf, long len);
 static long	_cdecl nfs_rewinddir	(DIR *dirh);
 static long	_cdecl nfs_closedir	(DIR *dirh);
 static long	_cdecl nfs_pathconf	(fcookie *dir, int which);
@@ -86,6 +88,7 @@ FILESYS nfs_filesys =
 	 * FS_EXT_1		extensions level 1 - mknod & unmount
 	 * FS_EXT_2		extensions level 2 - additional place at the end
 	 * FS_EXT_3		extensions level 3 - stat & native UTC timestamps
+	 * FS_EXT_4		extensions level 4 - readdirplus
 	 */
 	FS_CASESENSITIVE	|
 	FS_LONGPATH		|
@@ -94,7 +97,8 @@ FILESYS nfs_filesys =
 /*	FS_REENTRANT_L1		| */
 /*	FS_REENTRANT_L2		| */
 	FS_EXT_2		|
-	FS_EXT_3		,
+	FS_EXT_3		|
+	FS_EXT_4		,
 	
 	nfs_root,
 	nfs_lookup, nfs_creat, nfs_getdev, nfs_getxattr,
@@ -115,7 +119,10 @@ FILESYS nfs_filesys =
 	/* FS_EXT_3 */
 	nfs_stat64,
 	
-	0, 0, 0, 0, 0,
+	/* FS_EXT_4 */
+	nfs_readdirplus,
+	
+	0, 0, 0, 0,
 	NULL, NULL
 };
 
@@ -148,6 +155,7 @@ get_handle (NFS_INDEX *ni)
 		if (newi != ni)
 		{
 			ni->handle = newi->handle;
+			ni->fh3 = newi->fh3;
 			ni->attr = newi->attr;
 			ni->stamp = newi->stamp;
 		}
@@ -335,6 +343,31 @@ nfs_lookup (fcookie *dir, const char *name, fcookie *fc)
 		return ENOTDIR;
 	}
 	
+	if (NFS_V3 (ni))
+	{
+		nfs_fh3 fh;
+		post_op_attr attr;
+		
+		r = nfs3_lookup (ni, name, &fh, &attr);
+		if (r)
+		{
+			DEBUG (("nfs_lookup(%s) -> %ld", name, r));
+			return r;
+		}
+		
+		newi = get_slot (ni, name, dom);
+		if (!newi)
+			return EMFILE;
+		
+		newi->dir = ni;
+		newi->link += 1;
+		newi->flags &= ~NO_HANDLE;
+		newi->fh3 = fh;
+		nfs3_attr (newi, &attr);
+		
+		goto found;
+	}
+	
 	dirargs.dir = ni->handle;
 	dirargs.name = name;
 	
@@ -379,8 +412,9 @@ nfs_lookup (fcookie *dir, const char *name, fcookie *fc)
 	newi->link += 1;
 	newi->handle = dirres.diropres_u.diropok.file;
 	fattr2xattr (&dirres.diropres_u.diropok.attributes, &newi->attr);
-	
 	newi->stamp = get_timestamp ();
+	
+found:
 	fc->fs = &nfs_filesys;
 	fc->dev = nfs_dev;
 	fc->aux = 0;
@@ -431,6 +465,35 @@ do_create (long nfs_opcode, fcookie *dir, const char *name, unsigned mode, int a
 	createarg.attributes.mtime.seconds = createarg.attributes.atime.seconds;
 	createarg.attributes.mtime.useconds = 0;
 	
+	if (NFS_V3 (ni))
+	{
+		nfs_fh3 fh;
+		post_op_attr attr;
+		
+		r = nfs3_create ((nfs_opcode == NFSPROC_MKDIR) ? NFSPROC3_MKDIR : NFSPROC3_CREATE,
+				ni, name, &createarg.attributes, &fh, &attr);
+		if (r)
+		{
+			DEBUG (("do_create(%s) -> %ld", name, r));
+			return r;
+		}
+		
+		newi = get_slot (ni, name, p_domain (-1));
+		if (!newi)
+		{
+			DEBUG (("do_create: no slot found -> EACCES"));
+			return EACCES;
+		}
+		
+		newi->dir = ni;
+		newi->link += 1;
+		newi->flags &= ~NO_HANDLE;
+		newi->fh3 = fh;
+		nfs3_attr (newi, &attr);
+		
+		goto created;
+	}
+	
 	mreq = alloc_message (&m, req_buf, CREATEBUFSIZE, xdr_size_createargs(&createarg));
 	if (!mreq)
 	{
@@ -478,6 +541,7 @@ do_create (long nfs_opcode, fcookie *dir, const char *name, unsigned mode, int a
 	fattr2xattr (&dirres.diropres_u.diropok.attributes, &newi->attr);
 	newi->stamp = get_timestamp ();
 	
+created:
 	if (fc)
 	{
 		fc->fs = &nfs_filesys;
@@ -505,6 +569,9 @@ nfs_creat (fcookie *dir, const char *name, unsigned mode, int attrib, fcookie *f
 	}
 	
 	r = do_create (NFSPROC_CREATE, dir, name, mode, attrib, fc);
+	if (!r && fc)
+		((NFS_INDEX *) fc->index)->flags |= JUST_CREATED;
+	
 	return r;
 }
 
@@ -602,11 +669,26 @@ nfs_getxattr (fcookie *fc, XATTR *xattr)
 					++xattr->size;
 			}
 			
+			nfs_stats.attr_hits++;
 			DEBUG (("nfs_getxattr(%s): from cache -> mode 0%o, ok", ni->name, ni->attr.mode));
 			return E_OK;
 		}
 	}
 	
+	nfs_stats.attr_misses++;
+	
+	if (NFS_V3 (ni))
+	{
+		r = nfs3_getattr (ni);
+		if (r)
+		{
+			DEBUG (("nfs_getxattr(%s) -> %ld", ni->name, r));
+			return r;
+		}
+		
+		goto fetched;
+	}
+	
 	mreq = alloc_message (&m, req_buf, XATTRBUFSIZE, xdr_size_nfsfh (&ni->handle));
 	if (!mreq)
 	{
@@ -638,6 +720,7 @@ nfs_getxattr (fcookie *fc, XATTR *xattr)
 	fattr2xattr (&stat_res.attrstat_u.attributes, &ni->attr);
 	ni->stamp = get_timestamp ();
 	
+fetched:
 	if (xattr)
 	{
 		*xattr = ni->attr;
@@ -740,6 +823,9 @@ do_sattr (fcookie *fc, sattr *ap)
 		return ENOENT;
 	}
 	
+	if (NFS_V3 (ni))
+		return nfs3_setattr (ni, ap);
+	
 	s_arg.file = ni->handle;
 	s_arg.attributes = *ap;
 	
@@ -925,6 +1011,19 @@ do_remove (long nfs_opcode, fcookie *dir, const char *name)
 		DEBUG (("do_remove(%s): failed to get handle, -> ENOTDIR", name));
 		return ENOTDIR;
 	}
+	
+	if (NFS_V3 (ni))
+	{
+		r = nfs3_remove ((nfs_opcode == NFSPROC_RMDIR) ? NFSPROC3_RMDIR : NFSPROC3_REMOVE, ni, name);
+		if (r)
+		{
+			DEBUG (("do_remove(%s, %ld) -> %ld", name, nfs_opcode, r));
+			return r;
+		}
+		
+		goto removed;
+	}
+	
 	dirargs.dir = ni->handle;
 	dirargs.name = name;
 	mreq = alloc_message (&m, req_buf, REMBUFSIZE, xdr_size_diropargs(&dirargs));
@@ -956,6 +1055,7 @@ do_remove (long nfs_opcode, fcookie *dir, const char *name)
 		return EACCES;
 	}
 	
+removed:
 # ifdef USE_CACHE
 	nfs_cache_removebyname (ni, name);
 # endif
@@ -1114,6 +1214,18 @@ nfs_rename (fcookie *olddir, char *oldname, fcookie *newdir, const char *newname
 		DEBUG (("nfs_rename(%s): no handle for old dir, -> ENOTDIR", oldname));
 		return ENOTDIR;
 	}
+	
+	if (NFS_V3 (oldi))
+	{
+		r = nfs3_rename (oldi, oldname, newi, newname);
+		if (r)
+		{
+			DEBUG (("nfs_rename(%s) -> %ld", oldname, r));
+			return r;
+		}
+		
+		goto renamed;
+	}
 
 	renarg.from.dir = oldi->handle;
 	renarg.from.name = oldname;
@@ -1154,6 +1266,7 @@ nfs_rename (fcookie *olddir, char *oldname, fcookie *newdir, const char *newname
 		return EACCES;
 	}
 	
+renamed:
 	nfs_cache_removebyname (oldi, oldname);
 	
 	TRACE (("nfs_rename('%s' -> '%s') -> OK", oldname, newname));
@@ -1178,6 +1291,12 @@ typedef struct
 	entry *curr_entry;  /* this is the entry who is returned next */
 	nfscookie lastcookie;   /* this is for further requests to the server */
 	short eof;      /* if set, this buffer is the last in the dir */
+	
+	/* NFSv3: buffer holds the undecoded rest of a READDIRPLUS reply */
+	long pos;       /* next entry in buffer */
+	long len;       /* end of buffer */
+	ullong cookie3; /* the version 3 cookie and its verifier */
+	char verf3[NFS3_VERFSIZE];
 } NETFS_STUFF;
 
 
@@ -1196,16 +1315,25 @@ nfs_opendir (DIR *dirh, int flags)
 			return ENOTDIR;
 		}
 		
-		stuff.nf->buffer = kmalloc (MAX_READDIR_LEN + ADD_BUF_LEN);
-		if (!stuff.nf->buffer)
+		/* version 3 allocates it for each chunk */
+		if (NFS_V3 (ni))
+			stuff.nf->buffer = NULL;
+		else
 		{
-			DEBUG (("nfs_opendir: out of memory -> ENOMEM"));
-			return ENOMEM;
+			stuff.nf->buffer = kmalloc (MAX_READDIR_LEN + ADD_BUF_LEN);
+			if (!stuff.nf->buffer)
+			{
+				DEBUG (("nfs_opendir: out of memory -> ENOMEM"));
+				return ENOMEM;
+			}
 		}
 	}
 	else
 		stuff.nf->buffer = NULL;
 	
+	stuff.nf->pos = stuff.nf->len = 0;
+	stuff.nf->cookie3 = 0;
+	bzero (stuff.nf->verf3, NFS3_VERFSIZE);
 	stuff.nf->curr_entry = NULL;
 	ptr.v = &stuff.nf->lastcookie[0];
 	*ptr.l = 0L;
@@ -1221,13 +1349,24 @@ nfs_rewinddir (DIR *dirh)
 {
 	union { char *c; NETFS_STUFF *nf; long *l; } stuff; stuff.c = dirh->fsstuff;
 	union { long *l; void *v; } ptr;
+	NFS_INDEX *ni = (NFS_INDEX *) dirh->fc.index;
 	
-	if (ROOT_INDEX != (NFS_INDEX *) dirh->fc.index)
+	if (ROOT_INDEX != ni)
 	{
 		stuff.nf->curr_entry = NULL;
 		ptr.v = &stuff.nf->lastcookie[0];
 		*ptr.l = 0L;
 		stuff.nf->eof = 0;
+		
+		if (NFS_V3 (ni) && stuff.nf->buffer)
+		{
+			kfree (stuff.nf->buffer);
+			stuff.nf->buffer = NULL;
+		}
+		
+		stuff.nf->pos = stuff.nf->len = 0;
+		stuff.nf->cookie3 = 0;
+		bzero (stuff.nf->verf3, NFS3_VERFSIZE);
 	}
 	
 	dirh->index = 0;
@@ -1251,6 +1390,140 @@ nfs_closedir (DIR *dirh)
 	return 0;
 }
 
+/* Hand out an entry of a directory chunk: its name, the index if
+ * asked for, and a cookie for it. *slot is set to the index of the
+ * entry unless it is '.' or '..', so the caller can fill in what it
+ * knows about it.
+ */
+static long
+dir_entry (DIR *dirh, long fileid, const char *ename, char *name, int namelen, fcookie *fc, NFS_INDEX **slot)
+{
+	NFS_INDEX *ni = (NFS_INDEX *) dirh->fc.index;
+	NFS_INDEX *newi;
+
+	*slot = NULL;
+
+	if (dirh->flags == 0)
+	{
+		namelen -= sizeof(long);
+		if (namelen <= 0)
+			return EBADARG;
+		*((long *)name) = fileid;
+		name += sizeof(long);
+	}
+	strncpy(name, ename, namelen-1);
+	name[namelen-1] = '\0';
+	if (0 == p_domain (-1))    /* convert to upper case for TOS domain */
+		strupr (name);
+	if (strlen(ename) >= namelen)
+	{
+		DEBUG(("nfs_readdir(%s): name buffer (%d) too short",
+		                                          ni->name, namelen));
+		return EBADARG;
+	}
+
+	/* check for entries '.' and '..' which have already a local slot */
+	if (!strcmp(ename, "."))
+	{
+		newi = ni;  /* '.' does always mean the read directory */
+	}
+	else if (!strcmp(ename, ".."))
+	{
+		newi = ni->dir;   /* '..' means the parent of the read directory */
+	}
+	else
+	{
+		TRACE(("nfs_readdir: getting new slot for '%s'", ename));
+		newi = get_slot(ni, ename, (dirh->flags & TOS_SEARCH) ? 0 : 1);
+		if (!newi)
+		{
+			DEBUG(("nfs_readdir(%s): no index for entry, -> EMFILE", ni->name));
+			return EMFILE;
+		}
+		*slot = newi;
+	}
+	if (newi)
+	{
+		newi->link += 1;
+	}
+
+	fc->fs = &nfs_filesys;
+	fc->dev = nfs_dev;
+	fc->aux = 0;
+	fc->index = (long)newi;
+
+	return 0;
+}
+
+/* NFSv3: the entries of a READDIRPLUS chunk come with their handles
+ * and attributes, so the index is complete right away and neither
+ * a later lookup nor a stat has to go to the server.
+ */
+static long
+readdir3 (DIR *dirh, char *name, int namelen, fcookie *fc)
+{
+	NETFS_STUFF *stuff = (NETFS_STUFF *) dirh->fsstuff;
+	NFS_INDEX *ni = (NFS_INDEX *) dirh->fc.index;
+	NFS_INDEX *newi;
+	NFS3_DIRENT e;
+	long r;
+
+	for (;;)
+	{
+		if (stuff->buffer)
+		{
+			r = nfs3_direntry(stuff->buffer, stuff->len, &stuff->pos, &e, &stuff->eof);
+			if (r > 0)
+				break;
+
+			/* chunk used up */
+			kfree(stuff->buffer);
+			stuff->buffer = NULL;
+
+			if (r < 0)
+			{
+				DEBUG(("nfs_readdir(%s): could not decode entry, -> ENMFILES", ni->name));
+				return ENMFILES;
+			}
+		}
+
+		if (stuff->eof)
+		{
+			TRACE(("nfs_readdir(%s): end of dir reached, -> ENMFILES", ni->name));
+			return ENMFILES;
+		}
+
+		r = nfs3_readdirplus(ni, stuff->cookie3, stuff->verf3,
+		                     &stuff->buffer, &stuff->pos, &stuff->len);
+		if (r)
+		{
+			DEBUG(("nfs_readdir(%s): READDIRPLUS failed (%ld), -> ENMFILES", ni->name, r));
+			return ENMFILES;
+		}
+	}
+
+	stuff->cookie3 = e.cookie;
+
+	r = dir_entry(dirh, e.fileid, e.name, name, namelen, fc, &newi);
+	if (newi)
+	{
+		if (e.fh.present)
+		{
+			newi->flags &= ~NO_HANDLE;
+			newi->fh3 = e.fh.fh;
+			nfs3_attr(newi, &e.attr);
+		}
+		else
+		{
+			newi->flags |= NO_HANDLE;
+			newi->stamp = get_timestamp()-ni->opt->actimeo-1;  /* no attr yet */
+		}
+	}
+
+	DEBUG(("nfs_readdir(%s) -> %s", ni->name, e.name));
+	return r;
+}
+
 # define XDR_SIZE_READDIRRES	(3 * sizeof (long))
 # define MAX_XDR_BUF		(MAX_READDIR_LEN + XDR_SIZE_READDIRRES)
 
@@ -1331,69 +1604,23 @@ nfs_readdir (DIR *dirh, char *name, int namelen, fcookie *fc)
 		return 0;
 	}
 
+	if (NFS_V3 (ni))
+		return readdir3(dirh, name, namelen, fc);
+
 restart:
 	TRACE (("trying to get entry from buffer"));
 	if (stuff->curr_entry)
 	{
-		long res = 0;
+		long res;
 
 		entp = stuff->curr_entry;
-		if (giveindex)
-		{
-			namelen -= sizeof(long);
-			if (namelen <= 0)
-				return EBADARG;
-			*((long *)name) = entp->fileid;
-			name += sizeof(long);
-		}
-		strncpy(name, entp->name, namelen-1);
-		name[namelen-1] = '\0';
-		if (0 == dom)    /* convert to upper case for TOS domain */
-			strupr (name);
-		if (strlen(entp->name) >= namelen)
-		{
-			DEBUG(("nfs_readdir(%s): name buffer (%d) too short",
-			                                          ni->name, namelen));
-			res = EBADARG;
-			goto prep_next_entry;
-		}
-
-		/* check for entries '.' and '..' which have already a local slot */
-		if (!strcmp(entp->name, "."))
-		{
-			newi = ni;  /* '.' does always mean the read directory */
-		}
-		else if (!strcmp(entp->name, ".."))
-		{
-			newi = ni->dir;   /* '..' means the parent of the read directory */
-		}
-		else
+		res = dir_entry(dirh, entp->fileid, entp->name, name, namelen, fc, &newi);
+		if (newi)
 		{
-			TRACE(("nfs_readdir: getting new slot for '%s'", entp->name));
-			newi = get_slot(ni, entp->name, (dirh->flags & TOS_SEARCH) ? 0 : 1);
-			if (!newi)
-			{
-				DEBUG(("nfs_readdir(%s): no index for entry, -> EMFILE", ni->name));
-				res = EMFILE;
-				goto prep_next_entry;
-			}
 			newi->flags |= NO_HANDLE;
 			newi->stamp = get_timestamp()-ni->opt->actimeo-1;  /* no attr yet */
 		}
-		if (newi)
-		{
-			newi->link += 1;
-		}
-#ifdef USR_CACHE
-		nfs_cache_add(ni, newi);
-#endif
 
-		fc->fs = &nfs_filesys;
-		fc->dev = nfs_dev;
-		fc->aux = 0;
-		fc->index = (long)newi;
-
-prep_next_entry:
 		for (i = 0;  i < COOKIESIZE;  i++)
 			stuff->lastcookie[i] = entp->cookie[i];
 		stuff->curr_entry = entp->nextentry;
@@ -1463,6 +1690,33 @@ prep_next_entry:
 
 
 
+/* NFSv2 has no READDIRPLUS; the entries come out of the READDIR
+ * chunk buffered in the DIR, and the attributes of entries we
+ * don't know yet are fetched one by one here, inside the one
+ * system call, and stay in the index cache for later lookups.
+ * With NFSv3 the entries come with their attributes, so the
+ * nfs_stat64() is answered from the attribute cache.
+ */
+static long _cdecl
+nfs_dirplus_stat (fcookie *fc, STAT *st)
+{
+	long r = nfs_stat64 (fc, st);
+	
+	nfs_release (fc);
+	return r;
+}
+
+static long _cdecl
+nfs_readdirplus (DIR *dirh, char *buf, long len)
+{
+	long count;
+	
+	count = dirplus_read (dirh, buf, len, nfs_readdir, nfs_dirplus_stat);
+	
+	TRACE(("nfs_readdirplus -> %ld entries", count));
+	return count;
+}
+
 static long _cdecl
 nfs_pathconf (fcookie *dir, int which)
 {
@@ -1537,6 +1791,9 @@ nfs_dfree (fcookie *dir, long *buf)
 		return ENOTDIR;
 	}
 	
+	if (NFS_V3 (ni))
+		return nfs3_fsstat (ni, buf);
+	
 	mreq = alloc_message(&m, req_buf, DFREEBUFSIZE, xdr_size_nfsfh(&ni->handle));
 	if (!mreq)
 	{
@@ -1661,6 +1918,13 @@ nfs_symlink (fcookie *dir, const char *name, const char *to)
 	symarg.attributes.mtime.seconds = symarg.attributes.atime.seconds;
 	symarg.attributes.mtime.useconds = 0;
 	
+	if (NFS_V3 (ni))
+	{
+		r = nfs3_symlink (ni, name, to, &symarg.attributes);
+		TRACE (("nfs_symlink -> %ld", r));
+		return r;
+	}
+	
 	mreq = alloc_message (&m, req_buf, SYMLNBUFSIZE, xdr_size_symlinkargs (&symarg));
 	if (!mreq)
 	{
@@ -1721,6 +1985,16 @@ nfs_readlink (fcookie *dir, char *buf, int len)
 		DEBUG(("nfs_readlink: failed to get handle, -> ENOTDIR"));
 		return ENOTDIR;
 	}
+	if (NFS_V3 (ni))
+	{
+		r = nfs3_readlink (ni, databuf);
+		if (r)
+		{
+			DEBUG(("nfs_readlink -> %ld", r));
+			return r;
+		}
+		goto copy;
+	}
 	mreq = alloc_message(&m, req_buf, READLNBUFSIZE,
 	                               xdr_size_nfsfh(&ni->handle));
 	if (!mreq)
@@ -1750,6 +2024,7 @@ nfs_readlink (fcookie *dir, char *buf, int len)
 		DEBUG(("nfs_readlink -> ENOENT"));
 		return ENOENT;
 	}
+copy:
 	{
 		short i = len;
 		char *p = buf, *cp = databuf;
@@ -1806,6 +2081,14 @@ nfs_hardlink (fcookie *fromdir, const char *fromname, fcookie *todir, const char
 
 	fromi = (NFS_INDEX*)fc.index;
 	nfs_release(&fc);
+
+	if (NFS_V3 (toi))
+	{
+		r = nfs3_link (fromi, toi, toname);
+		TRACE(("nfs_hardlink -> %ld", r));
+		return r;
+	}
+
 	linkarg.to.dir = toi->handle;
 	linkarg.to.name = toname;
 	linkarg.from = fromi->handle;
@@ -1871,6 +2154,36 @@ nfs_fscntl (fcookie *dir, const char *name, int cmd, long arg)
 				strcpy (info->type_asc, "network filesystem");
 			}
 			
+			return E_OK;
+		}
+		case FS_SYSCTL:
+		{
+			struct fs_sysctl *args = (struct fs_sysctl *) arg;
+			
+			/* all names at this level are terminal and read only */
+			if (args->namelen != 1)
+				return ENOTDIR;
+			
+			if (args->name[0] != NFS_CTL_STATS)
+				return EOPNOTSUPP;
+			
+			if (args->newp)
+				return EPERM;
+			
+			if (args->oldp)
+			{
+				if (!args->oldlenp)
+					return EBADARG;
+				
+				if (*args->oldlenp < sizeof (nfs_stats))
+					return ENOMEM;
+				
+				memcpy (args->oldp, &nfs_stats, sizeof (nfs_stats));
+			}
+			
+			if (args->oldlenp)
+				*args->oldlenp = sizeof (nfs_stats);
+			
 			return E_OK;
 		}
 # if 0
@@ -1923,6 +2236,28 @@ nfs_fscntl (fcookie *dir, const char *name, int cmd, long arg)
 			ni->link = 1;
 			ni->handle = info->handle;
 			
+			if (ni->opt->flags & OPT_NFSV3)
+			{
+				long r = EBADARG;
+				
+				/* this also finds out whether the server
+				 * has version 3 at all
+				 */
+				ni->fh3.len = info->fhlen3;
+				if (ni->fh3.len <= NFS3_FHSIZE)
+				{
+					memcpy (ni->fh3.data, info->handle3, ni->fh3.len);
+					r = nfs3_fsinfo (ni);
+				}
+				
+				if (r)
+				{
+					DEBUG (("nfs_fscntl: NFSv3 mount failed -> %ld", r));
+					release_mount_slot (ni);
+					return r;
+				}
+			}
+			
 			DEBUG (("nfs_fscntl: mounting dir '%s'", ni->name));
 			return 0;
 		}
@@ -170,6 +170,63 @@ fattr2xattr (fattr *fa, XATTR *xa)
 	xa->reserved3 [1] = 0;
 }
 
+/* the same for the version 3 attributes; sizes beyond what fits
+ * into the XATTR are clamped
+ */
+void
+fattr32xattr (fattr3 *fa, XATTR *xa)
+{
+	ullong blocks;
+	
+	xa->mode = fa->mode & ~S_IFMT;
+	switch (fa->type)
+	{
+		case NF3DIR:	xa->mode |= S_IFDIR;	break;
+		case NF3BLK:	/* BUG: we should have a block device type */
+		case NF3CHR:	xa->mode |= S_IFCHR;	break;
+		case NF3LNK:	xa->mode |= S_IFLNK;	break;
+		case NF3SOCK:	xa->mode |= S_IFSOCK;	break;
+		case NF3FIFO:	xa->mode |= S_IFIFO;	break;
+		default:	xa->mode |= S_IFREG;	break;
+	}
+	
+	xa->attr = 0;
+	
+	if ((xa->mode & S_IFMT) == S_IFDIR)
+		xa->attr |= FA_DIR;
+	if ((xa->mode & (S_IWUSR | S_IWGRP | S_IWOTH)) == 0)
+		xa->attr |= FA_RDONLY;
+	
+	xa->index	= fa->fileid;
+	xa->dev		= fa->fsid;
+	xa->rdev	= fa->fsid;
+	xa->nlink	= fa->nlink;
+	xa->uid		= fa->uid;
+	xa->gid		= fa->gid;
+	xa->size	= (fa->size > 0x7fffffffUL) ? 0x7fffffffL : fa->size;
+	xa->blksize	= 1024;
+	
+	blocks = (fa->used + 1023) >> 10;
+	xa->nblocks	= (blocks > 0x7fffffffUL) ? 0x7fffffffL : blocks;
+	
+	if (native_utc)
+	{
+		SET_XATTR_TD(xa,m,fa->mtime.seconds);
+		SET_XATTR_TD(xa,a,fa->atime.seconds);
+		SET_XATTR_TD(xa,c,fa->ctime.seconds);
+	}
+	else
+	{
+		SET_XATTR_TD(xa,m,dostime(fa->mtime.seconds));
+		SET_XATTR_TD(xa,a,dostime(fa->atime.seconds));
+		SET_XATTR_TD(xa,c,dostime(fa->ctime.seconds));
+	}
+	
+	xa->reserved2 = 0;
+	xa->reserved3 [0] = 0;
+	xa->reserved3 [1] = 0;
+}
+
 # if 0
 void
 xattr2fattr (XATTR *xa, fattr *fa)
@@ -26,6 +26,7 @@ INLINE long	get_timestamp (void);
 int 		nfs_mode (int mode, int attrib);
 
 void fattr2xattr (fattr *fa, XATTR *xa);
+void fattr32xattr (fattr3 *fa, XATTR *xa);
 # if 0
 void xattr2fattr (XATTR *xa, fattr *fa);
 # endif
@@ -542,7 +542,7 @@ open_connection (struct socket **resultso)
 	/* Do some settings on the socket so that it becomes usable
 	 */
 	
-	arg = 10240;
+	arg = NFS_SOCKBUF;
 	ret = setsockopt (so, SOL_SOCKET, SO_RCVBUF, &arg, sizeof (arg));
 	if (ret < 0)
 	{
@@ -550,7 +550,7 @@ open_connection (struct socket **resultso)
 		goto error;
 	}
 	
-	arg = 10240;
+	arg = NFS_SOCKBUF;
 	ret = setsockopt (so, SOL_SOCKET, SO_SNDBUF, &arg, sizeof (arg));
 	if (ret < 0)
 	{
@@ -697,33 +697,21 @@ rpc_receivemessage (struct socket *so, MESSAGE *mrep, long toread)
 }
 
 
-/* this function does all the dirty work:
- *  - set up rpc header
- *  - link request into linked list, send it and go to sleep
- *  - receive reply
- *  - break down reply rpc header
- *  - return results of remote function or error message
- * the results (if valid) have to be freed after use
+/* Make the rpc header for a call and store it in buf, or in an
+ * allocated buffer if it doesn't fit. The program version is the
+ * one the server was mounted with.
  */
-long
-rpc_request (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, MESSAGE **mrep)
+static long
+rpc_header (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, ulong xid, char *buf, long buflen)
 {
-	char req_buf[MAX_RPC_HDR_SIZE];
 	rpc_msg hdr;
 	xdrs xhdr;
-	MESSAGE *reply, mbuf;
-	static volatile ulong xid = 0;
-	ulong our_xid;
-	long r;
-	
 	
-	/* make a header */
-	our_xid = xid++;
-	hdr.xid = our_xid;
+	hdr.xid = xid;
 	hdr.mtype = CALL;
 	hdr.cbody.rpcvers = RPC_VERSION;
 	hdr.cbody.prog = rpc_program;
-	hdr.cbody.vers = rpc_progversion;
+	hdr.cbody.vers = opt->version ? opt->version : rpc_progversion;
 	hdr.cbody.proc = proc;
 	
 	if (do_auth_init)
@@ -733,7 +721,7 @@ rpc_request (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, MESSAGE **mrep)
 		else
 			do_auth_init -= 1;
 	}
-	setup_auth (our_xid);
+	setup_auth (xid);
 	hdr.cbody.cred = unix_auth;
 	hdr.cbody.verf = null_auth;
 	
@@ -741,192 +729,265 @@ rpc_request (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, MESSAGE **mrep)
 	hdr.cbody.xproc = NULL;
 	
 	mreq->hdr_len = xdr_size_rpc_msg (&hdr);
-	if (mreq->hdr_len > MAX_RPC_HDR_SIZE)
+	if (mreq->hdr_len > buflen)
 	{
 		mreq->header = kmalloc (mreq->hdr_len);
 		if (!mreq->header)
 		{
-			DEBUG (("rpc_request: no memory for rpc header"));
-			free_message (mreq);
+			DEBUG (("rpc_header: no memory for rpc header"));
 			return ENOMEM;
 		}
 		
 		mreq->flags |= FREE_HEADER;
 	}
 	else
-		mreq->header = req_buf;
+		mreq->header = buf;
 	
 	xdr_init (&xhdr, mreq->header, mreq->hdr_len, XDR_ENCODE, NULL);
 	if (!xdr_rpc_msg (&xhdr, &hdr))
 	{
-		DEBUG (("rpc_request: failed to make rpc header"));
-		free_message (mreq);
+		DEBUG (("rpc_header: failed to make rpc header"));
 		return EBADARG;
 	}
 	
+	return 0;
+}
+
+/* Look for the reply to xid. Any reply for anybody can show up on
+ * the socket! So we first look whether another process has already
+ * received ours and stored it in the list of outstanding requests,
+ * then drain the socket: read messages from it until there is
+ * nothing more or we found the reply for our request. Replies for
+ * other outstanding requests are stored in the list, all others
+ * silently discarded.
+ * Returns 1 and the reply in *reply (either mbuf or the message
+ * from the list), 0 if it isn't there yet, or an error.
+ */
+static long
+rpc_poll (struct socket *so, ulong xid, MESSAGE *mbuf, MESSAGE **reply)
+{
+	REQUEST *rq;
+	MESSAGE *pm, *m;
+	long toread, r;
 	
-	/* This is the main send/resend code. We have to send the message, wait
-	 * for reply, and if it times out, resend the message. But make sure
-	 * that the code is reentrant at some points, as several processes can
-	 * use the nfs at the same time. It is also possible, that a process
-	 * receives a message that belongs to someone else. In that case, we
-	 * check against the list of outstanding requests and store it in a
-	 * list if it was waited for. Otherwise silently discard it.
-	 */
+	rq = search_request (xid);
+	if (rq && rq->have_answer)
 	{
-		struct socket *so = nfs_so;
-		long timeout, stamp, toread;
-		int retry;
+		TRACE (("rpc_poll: got reply from list"));
 		
-		if (!so)
+		/* Remove request from list so that delete_request
+		 * doesn't kfree it. The `rq' struct will be
+		 * kfreed when doing free_message_header(&rq->msg).
+		 * NOTE that this works because the `msg' is the
+		 * first member of the REQUEST structure.
+		 */
+		remove_request (xid);
+		*reply = &rq->msg;
+		return 1;
+	}
+	
+	while (1)
+	{
+		TRACE(("rpc_poll: checking socket for reply"));
+		toread = 0;
+		r = so_ioctl (so, FIONREAD, &toread);
+		if (r < 0)
 		{
-			DEBUG (("rpc_req: no open connection"));
-			free_message (mreq);
-			return EACCES;
+			DEBUG(("rpc_poll: so_ioctl(FIONREAD) failed -> %ld", r));
+			return r;
 		}
-		
-		/* Now send the message and wait for answer */
-		timeout = opt->timeo;
-		stamp = *_hz_200;
-		insert_request (our_xid);
-		/* TL: we have to increase the timeout by opt->timeo instead of just 
-                 *     multiplying it by 2
-		 */
-		for (retry = 0; retry < opt->retrans; retry++, timeout += opt->timeo)
+		if (toread == 0) break;
+		else if ((ulong) toread >= 0x7ffffffful)
 		{
-		    r = rpc_sendmessage (so, opt, mreq);
-		    if (r < 0)
-		    {
-			DEBUG (("rpc_request: could not write message -> %ld", (long)r));
+			char c;
 			
+			/* Fcntl tells us that an asynchronous error
+			 * is pending on the socket, caused eg. by
+			 * an ICMP error message. The Fread() returns
+			 * the error condition. */
+			r = so_read (so, &c, sizeof(c));
+			return (r < 0) ? r : EACCES;
+		}
+		
+		TRACE (("rpc_poll: socket has something"));
+		
+		mbuf->flags = 0;
+		m = rpc_receivemessage (so, mbuf, toread);
+		if (!m) break;
+		
+		if (get_xid(m) == xid)
+		{
+			TRACE(("rpc_poll: got a matching reply"));
+			*reply = m;
+			return 1;
+		}
+		
+		DEBUG(("rpc_poll: wrong xid"));
+		
+		rq = search_request (get_xid(m));
+		if (!rq || rq->have_answer)
+		{
+			DEBUG(("rpc_poll: no req/already answer for this xid"));
+			free_message (m);
+			continue;
+		}
+		
+		DEBUG(("rpc_poll: adding message to list"));
+		
+		/* TL: set have_answer AFTER storing the message! */
+		pm = &rq->msg;
+		r = pm->flags & ~DATA_FLAGS;
+		*pm = *m;
+		pm->flags &= DATA_FLAGS;
+		pm->flags |= r;
+		rq->have_answer = 1;
+	}
+	
+	return 0;
+}
+
+/* Start a call: set up the rpc header, link the request into the
+ * list of outstanding requests and send it, but don't wait for the
+ * reply. Several calls can be in flight at the same time this way;
+ * their replies are matched by xid.
+ * The request is kept in the call for retransmission until
+ * rpc_wait or rpc_cancel; if the call can't be started it is freed.
+ */
+long
+rpc_start (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, RPC_CALL *call)
+{
+	static volatile ulong xid = 0;
+	struct socket *so = nfs_so;
+	long r;
+	
+	call->mreq = NULL;
+	
+	if (!so)
+	{
+		DEBUG (("rpc_start: no open connection"));
+		free_message (mreq);
+		return EACCES;
+	}
+	
+	call->xid = xid++;
+	
+	r = rpc_header (opt, mreq, proc, call->xid, call->hdr, sizeof (call->hdr));
+	if (r)
+	{
+		free_message (mreq);
+		return r;
+	}
+	
+	if (insert_request (call->xid))
+	{
+		DEBUG (("rpc_start: no memory for request"));
+		free_message (mreq);
+		return ENOMEM;
+	}
+	
+	call->stamp = *_hz_200;
+	call->timeout = opt->timeo;
+	call->retry = 0;
+	
+	r = rpc_sendmessage (so, opt, mreq);
+	if (r < 0)
+	{
+		DEBUG (("rpc_start: could not write message -> %ld", r));
+		delete_request (call->xid);
+		free_message (mreq);
+		return r;
+	}
+	
+	call->mreq = mreq;
+	return 0;
+}
+
+/* Wait for the reply to a call started with rpc_start, resending the
+ * request when it times out. On success the results are in *mrep,
+ * which has to be freed after use; the request stays in the call,
+ * the caller frees it with free_message(call->mreq).
+ * On failure both are gone.
+ */
+long
+rpc_wait (SERVER_OPT *opt, RPC_CALL *call, MESSAGE **mrep)
+{
+	struct socket *so = nfs_so;
+	MESSAGE *mreq = call->mreq;
+	MESSAGE *reply = NULL;
+	rpc_msg hdr;
+	xdrs xhdr;
+	long r;
+	
+	call->mreq = NULL;
+	
+	if (!so)
+	{
+		DEBUG (("rpc_wait: no open connection"));
+		delete_request (call->xid);
+		free_message (mreq);
+		return EACCES;
+	}
+	
+	/* NOTE: the strange 'stamp + timeout - *_hz_200 > 0'
+	 * is the same as 'stamp + timeout > *_hz_200' except
+	 * that the first works also when *_hz_200 wraps around
+	 * while the second method waits `forever' when the
+	 * timer wraps around 2^32.
+	 * TL: we have to increase the timeout by opt->timeo instead
+	 *     of just multiplying it by 2
+	 */
+	for (;;)
+	{
+		/* give up CPU */
+		s_yield ();
+		
+		r = rpc_poll (so, call->xid, &call->rep, &reply);
+		if (r > 0)
+			break;
+		
+		if (r < 0)
+		{
+			delete_request (call->xid);
 			free_message (mreq);
-			delete_request (our_xid);
 			return r;
-		    }
+		}
 		
-		    /* Wait for reply. Any reply for anybody! So we have
-		     * to store the message somewhere when it is not for
-		     * us. Also we should look there to see if another
-		     * process has already received it.
-		     * NOTE: the strange 'stamp + timeout - *_hz_200 > 0'
-		     * is the same as 'stamp + timeout > *_hz_200' except
-		     * that the first works also when *_hz_200 wraps around
-		     * while the second method waits `forever' when the
-		     * timer wraps around 2^32.
-		     */
-		    while (stamp + timeout - *_hz_200 > 0)
-		    {
-			REQUEST *rq;
-			MESSAGE *pm;
-			
-			/* give up CPU */
-			s_yield ();
-			
-			rq = search_request (our_xid);
-			if (rq && rq->have_answer)
+		if (call->stamp + call->timeout - *_hz_200 <= 0)
+		{
+			if (++call->retry >= opt->retrans)
 			{
-			    TRACE (("rpc_req: got reply from list"));
-			    reply = &rq->msg;
-
-			    /* Remove request from list so that delete_request
-			     * doesn't kfree it. The `rq' struct will be
-			     * kfreed when doing free_message_header(&rq->msg)
-			     * at the end of the function.
-			     * NOTE that this works because the `msg' is the
-			     * first member of the REQUEST structure.
-			     */
-			    remove_request (our_xid);
-			    goto have_reply;
+				DEBUG (("rpc: RPC timed out, no reply"));
+				delete_request (call->xid);
+				free_message (mreq);
+				return EACCES;
 			}
-			/* Now try to drain the socket: read messages from
-			 * it until there is nothing more or we found a
-			 * reply for our request.
-			 */
-			while (1)
+			
+			call->timeout += opt->timeo;
+			
+			r = rpc_sendmessage (so, opt, mreq);
+			if (r < 0)
 			{
-			    TRACE(("rpc_req: checking socket for reply"));
-			    toread = 0;
-			    r = so_ioctl (so, FIONREAD, &toread);
-			    if (r < 0)
-			    {
-				DEBUG(("rpc_req: so_ioctl(FIONREAD) failed -> %ld", r));
-
-				free_message(mreq);
-				delete_request(our_xid);
-				return r;
-			    }
-			    if (toread == 0) break;
-			    else if ((ulong) toread >= 0x7ffffffful)
-			    {
-				char c;
-
-				/* Fcntl tells us that an asynchronous error
-				 * is pending on the socket, caused eg. by
-				 * an ICMP error message. The Fread() returns
-				 * the error condition. */
-				
+				DEBUG (("rpc_wait: could not write message -> %ld", r));
+				delete_request (call->xid);
 				free_message (mreq);
-				delete_request (our_xid);
-				return so_read (so, &c, sizeof(c));
-			    }
-
-			    TRACE (("rpc_req: socket has something"));
-
-			    mbuf.flags = 0;
-			    reply = rpc_receivemessage (so, &mbuf, toread);
-			    if (!reply) break;
-
-			    /* Here we know that reply points to mbuf which
-			     * holds a reply message. If we got already the
-			     * right xid in the reply, we are ready to finish
-			     * the request. Otherwise we have to store the
-			     * reply in the list and wait again.
-			     */
-			    if (get_xid(reply) == our_xid)
-			    {
-				TRACE(("rpc_req: got a matching reply"));
-				goto have_reply;
-			    }
-
-			    DEBUG(("rpc_req: wrong xid"));
-
-			    rq = search_request (get_xid(reply));
-			    if (!rq || rq->have_answer)
-			    {
-				DEBUG(("rpc_req: no req/already answer "
-					"for this xid"));
-				free_message(reply);
-				reply = NULL;
-				continue;
-			    }
-
-			    DEBUG(("rpc_req: adding message to list"));
-
-			    /* TL: set have_answer AFTER storing the message! */
-			    pm = &rq->msg;
-			    r = pm->flags & ~DATA_FLAGS;
-			    *pm = *reply;
-			    pm->flags &= DATA_FLAGS;
-			    pm->flags |= r;
-			    rq->have_answer = 1;
-			    reply = NULL;
-
-			} /* while data on socket */
-
-		    }  /* while not timed out */
-
-		}  /* for retry < max_retry */
-
-		DEBUG (("rpc: RPC timed out, no reply"));
-		delete_request (our_xid);
-		free_message (mreq);
-		return EACCES;
+				return r;
+			}
+		}
 	}
 	
-have_reply:
+	delete_request (call->xid);
+	call->mreq = mreq;
 	
-	delete_request (our_xid);
-	free_message_body (mreq);    /* for reusing the message header */
+	/* the reply is either in call->rep already or in the list
+	 * entry, which goes away now
+	 */
+	if (reply != &call->rep)
+	{
+		call->rep = *reply;
+		call->rep.flags &= DATA_FLAGS;
+		free_message_header (reply);
+		reply = &call->rep;
+	}
 	
 	/* SECURITY: here we might want to check for the correct sender address
 	 *           to not get faked answers.
@@ -939,10 +1000,9 @@ have_reply:
 	
 	if (!xdr_rpc_msg (&xhdr, &hdr))
 	{
-		DEBUG (("rpc_request: failed to break down rpc header"));
-		free_message_header (mreq);  /* free the rest of that */
-		free_message (reply);
-		return ERPC_GARBAGEARGS;
+		DEBUG (("rpc_wait: failed to break down rpc header"));
+		r = ERPC_GARBAGEARGS;
+		goto error;
 	}
 	
 	reply->data += xdr_getpos (&xhdr);
@@ -950,40 +1010,90 @@ have_reply:
 	
 	if (MSG_ACCEPTED != hdr.rbody.rb_stat)
 	{
-		free_message_header (mreq);  /* free the rest of that */
-		free_message (reply);
 		if (RPC_MISMATCH == hdr.rbody.rb_rrpl.rr_stat)
 		{
-			DEBUG (("rpc_request -> rpc mismatch"));
-			return ERPC_RPCMISMATCH;    /* this must be an internal error! */
+			DEBUG (("rpc_wait -> rpc mismatch"));
+			r = ERPC_RPCMISMATCH;    /* this must be an internal error! */
 		}
 		else
 		{
-			DEBUG (("rpc_request -> auth error"));
-			return ERPC_AUTHERROR;
+			DEBUG (("rpc_wait -> auth error"));
+			r = ERPC_AUTHERROR;
 		}
+		goto error;
 	}
 	
 	if (hdr.rbody.rb_arpl.ar_stat != SUCCESS)
 	{
-		free_message_header (mreq);  /* free the rest of that */
-		free_message (reply);
 		switch (hdr.rbody.rb_arpl.ar_stat)
 		{
 			case PROG_UNAVAIL:
-				DEBUG (("rpc_request -> prog unavail"));
-				return ERPC_PROGUNAVAIL;
+				DEBUG (("rpc_wait -> prog unavail"));
+				r = ERPC_PROGUNAVAIL;
+				break;
 			case PROG_MISMATCH:
-				DEBUG (("rpc_request -> prog mismatch"));
-				return ERPC_PROGMISMATCH;
+				DEBUG (("rpc_wait -> prog mismatch"));
+				r = ERPC_PROGMISMATCH;
+				break;
 			case PROC_UNAVAIL:
-				DEBUG (("rpc_request -> proc unavail"));
-				return ERPC_PROCUNAVAIL;
+				DEBUG (("rpc_wait -> proc unavail"));
+				r = ERPC_PROCUNAVAIL;
+				break;
 			default:
-				DEBUG (("rpc_request -> -1"));
-				return -1;
+				DEBUG (("rpc_wait -> -1"));
+				r = -1;
+				break;
 		}
+		goto error;
+	}
+	
+	*mrep = reply;
+	return 0;
+	
+error:
+	call->mreq = NULL;
+	free_message (mreq);
+	free_message (reply);
+	return r;
+}
+
+/* forget about a call; a reply that comes in later is discarded */
+void
+rpc_cancel (RPC_CALL *call)
+{
+	if (call->mreq)
+	{
+		delete_request (call->xid);
+		free_message (call->mreq);
+		call->mreq = NULL;
 	}
+}
+
+/* this function does all the dirty work:
+ *  - set up rpc header
+ *  - link request into linked list, send it and go to sleep
+ *  - receive reply
+ *  - break down reply rpc header
+ *  - return results of remote function or error message
+ * the results (if valid) have to be freed after use
+ */
+long
+rpc_request (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, MESSAGE **mrep)
+{
+	RPC_CALL call;
+	MESSAGE *reply;
+	long r;
+	
+	r = rpc_start (opt, mreq, proc, &call);
+	if (r)
+		return r;
+	
+	r = rpc_wait (opt, &call, &reply);
+	if (r)
+		return r;
+	
+	/* reuse the request message header for the reply */
+	free_message_body (mreq);
 	
 	r = mreq->flags & ~DATA_FLAGS;
 	*mreq = *reply;
@@ -991,9 +1101,6 @@ have_reply:
 	mreq->flags |= r;
 	*mrep = mreq;
 	
-	/* `reply' might or might not point to `mbuf'. So we have to do this
-	 */
-	free_message_header (reply);
 	return 0;
 }
 
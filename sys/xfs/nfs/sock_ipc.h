@@ -44,10 +44,28 @@ struct message
 	ulong	xid;		/* transaction id */
 };
 
+/* a call that is kept in flight while the caller does something
+ * else, see rpc_start() and rpc_wait()
+ */
+typedef struct rpc_call RPC_CALL;
+struct rpc_call
+{
+	MESSAGE	*mreq;		/* the request, kept for retransmission */
+	MESSAGE	rep;		/* the reply */
+	ulong	xid;		/* transaction id */
+	long	stamp;		/* time of the first transmission */
+	long	timeout;	/* current timeout relative to stamp */
+	int	retry;		/* number of retransmissions */
+	char	hdr[RPC_HDRBUFSIZE];	/* the rpc header of the request */
+};
+
 void		free_message (MESSAGE *m);
 MESSAGE *	alloc_message (MESSAGE *m, char *buf, long buf_len, long data_size);
 
 long	rpc_request (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, MESSAGE **mrep);
+long	rpc_start (SERVER_OPT *opt, MESSAGE *mreq, ulong proc, RPC_CALL *call);
+long	rpc_wait (SERVER_OPT *opt, RPC_CALL *call, MESSAGE **mrep);
+void	rpc_cancel (RPC_CALL *call);
 int	init_ipc (ulong prog, ulong version);
 
 
@@ -188,6 +188,29 @@ xdr_ulong (xdrs *x, ulong *val)
 	return TRUE;
 }
 
+/* 64 bit "hyper" integer, most significant word first */
+bool_t
+xdr_ullong (xdrs *x, unsigned long long *val)
+{
+	unsigned long hi = 0, lo = 0;
+	
+	if (XDR_ENCODE == x->op)
+	{
+		hi = *val >> 32;
+		lo = *val;
+	}
+	
+	if (!xdr_ulong (x, &hi))
+		return FALSE;
+	if (!xdr_ulong (x, &lo))
+		return FALSE;
+	
+	if (XDR_DECODE == x->op)
+		*val = ((unsigned long long) hi << 32) | lo;
+	
+	return TRUE;
+}
+
 bool_t
 xdr_string (xdrs *x, const char **cpp, long maxlen)
 {
@@ -76,6 +76,7 @@ bool_t	xdr_long	(xdrs *x, long *val);
 bool_t	xdr_enum	(xdrs *x, enum_t *val);
 bool_t	xdr_bool	(xdrs *x, bool_t *val);
 bool_t	xdr_ulong	(xdrs *x, unsigned long *val);
+bool_t	xdr_ullong	(xdrs *x, unsigned long long *val);
 bool_t	xdr_string	(xdrs *x, const char **cpp, long maxlen);
 bool_t	xdr_opaque	(xdrs *x, const opaque **opp, long *len, long maxlen);
 bool_t	xdr_fixedopaq	(xdrs *x, opaque *val, long fixedlen);
@@ -33,6 +33,7 @@
 # include "mint/file.h"
 # include "mint/stat.h"
 
+# include "filesys.h"
 # include "proc.h"
 # include "time.h"
 
@@ -84,6 +85,43 @@ getxattr(FILESYS *fs, fcookie *fc, XATTR *xattr)
 	return r;
 }
 
+void
+xattr2stat64(const XATTR *xattr, STAT *stat)
+{
+	stat->dev	= xattr->dev;
+	stat->ino	= xattr->index;
+	stat->mode	= xattr->mode;
+	stat->nlink	= xattr->nlink;
+	stat->uid	= xattr->uid;
+	stat->gid	= xattr->gid;
+	stat->rdev	= xattr->rdev;
+
+	/* no native UTC extension
+	 * -> convert to unix UTC
+	 */
+	stat->atime.high_time = 0;
+	stat->atime.time = unixtime (xattr->atime, xattr->adate) + timezone;
+	stat->atime.nanoseconds = 0;
+
+	stat->mtime.high_time = 0;
+	stat->mtime.time = unixtime (xattr->mtime, xattr->mdate) + timezone;
+	stat->mtime.nanoseconds = 0;
+
+	stat->ctime.high_time = 0;
+	stat->ctime.time = unixtime (xattr->ctime, xattr->cdate) + timezone;
+	stat->ctime.nanoseconds = 0;
+
+	stat->size	= xattr->size;
+	stat->blocks	= (xattr->blksize < 512) ? xattr->nblocks :
+				xattr->nblocks * (xattr->blksize >> 9);
+	stat->blksize	= xattr->blksize;
+
+	stat->flags	= 0;
+	stat->gen	= 0;
+
+	mint_bzero(stat->res, sizeof(stat->res));
+}
+
 long
 getstat64(FILESYS *fs, fcookie *fc, STAT *stat)
 {
@@ -94,44 +132,37 @@ getstat64(FILESYS *fs, fcookie *fc, STAT *stat)
 
 	r = xfs_getxattr(fs, fc, &xattr);
 	if (!r)
-	{
-		stat->dev	= xattr.dev;
-		stat->ino	= xattr.index;
-		stat->mode	= xattr.mode;
-		stat->nlink	= xattr.nlink;
-		stat->uid	= xattr.uid;
-		stat->gid	= xattr.gid;
-		stat->rdev	= xattr.rdev;
-
-		/* no native UTC extension
-		 * -> convert to unix UTC
-		 */
-		stat->atime.high_time = 0;
-		stat->atime.time = unixtime (xattr.atime, xattr.adate) + timezone;
-		stat->atime.nanoseconds = 0;
-
-		stat->mtime.high_time = 0;
-		stat->mtime.time = unixtime (xattr.mtime, xattr.mdate) + timezone;
-		stat->mtime.nanoseconds = 0;
-
-		stat->ctime.high_time = 0;
-		stat->ctime.time = unixtime (xattr.ctime, xattr.cdate) + timezone;
-		stat->ctime.nanoseconds = 0;
-
-		stat->size	= xattr.size;
-		stat->blocks	= (xattr.blksize < 512) ? xattr.nblocks :
-					xattr.nblocks * (xattr.blksize >> 9);
-		stat->blksize	= xattr.blksize;
-
-		stat->flags	= 0;
-		stat->gen	= 0;
-
-		mint_bzero(stat->res, sizeof(stat->res));
-	}
+		xattr2stat64(&xattr, stat);
+
+	return r;
+}
+
+/* generic readdirplus for filesystems without their own;
+ * still one readdir and stat per entry, but no longer a
+ * system call for each of them
+ */
+static long _cdecl
+generic_readdir(DIR *dirh, char *name, int namelen, fcookie *fc)
+{
+	return xfs_readdir(dirh->fc.fs, dirh, name, namelen, fc);
+}
+
+static long _cdecl
+generic_stat(fcookie *fc, STAT *st)
+{
+	long r = xfs_stat64(fc->fs, fc, st);
 
+	release_cookie(fc);
 	return r;
 }
 
+long
+readdirplus(FILESYS *fs, DIR *dirh, char *buf, long len)
+{
+	UNUSED(fs);
+	return dirplus_read(dirh, buf, len, generic_readdir, generic_stat);
+}
+
 
 # ifdef NONBLOCKING_DMA
 
@@ -444,6 +475,22 @@ xfs_readdir(FILESYS *fs, DIR *dirh, char *nm, int nmlen, fcookie *fc)
 	return r;
 }
 long _cdecl
+xfs_readdirplus(FILESYS *fs, DIR *dirh, char *buf, long len)
+{
+	if ((fs->fsflags & FS_EXT_4) && fs->readdirplus)
+	{
+		long r;
+		
+		xfs_lock(fs, dirh->fc.dev, "xfs_readdirplus");
+		r = (*fs->readdirplus)(dirh, buf, len);
+		xfs_unlock(fs, dirh->fc.dev, "xfs_readdirplus");
+		
+		return r;
+	}
+	
+	return readdirplus(fs, dirh, buf, len);
+}
+long _cdecl
 xfs_rewinddir(FILESYS *fs, DIR *dirh)
 {
 	long r;
@@ -34,6 +34,8 @@
 
 long getxattr (FILESYS *fs, fcookie *fc, XATTR *xattr);
 long getstat64 (FILESYS *fs, fcookie *fc, STAT *ptr);
+void xattr2stat64 (const XATTR *xattr, STAT *ptr);
+long readdirplus (FILESYS *fs, DIR *dirh, char *buf, long len);
 
 
 void _cdecl xfs_block (FILESYS *fs, ushort dev, const char *func);
@@ -60,6 +62,7 @@ long _cdecl xfs_rename(FILESYS *fs, fcookie *olddir, char *oldname, fcookie *new
 
 long _cdecl xfs_opendir(FILESYS *fs, DIR *dirh, int flags);
 long _cdecl xfs_readdir(FILESYS *fs, DIR *dirh, char *nm, int nmlen, fcookie *fc);
+long _cdecl xfs_readdirplus(FILESYS *fs, DIR *dirh, char *buf, long len);
 long _cdecl xfs_rewinddir(FILESYS *fs, DIR *dirh);
 long _cdecl xfs_closedir(FILESYS *fs, DIR *dirh);
 
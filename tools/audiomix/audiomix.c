@@ -0,0 +1,495 @@
+/*
+ * audiomix.c: runs sample files through the /dev/audio mixer code
+ * (sys/xdd/audio/afmts.c and resample.c) outside the kernel, to check
+ * the output and to see what the conversion costs on a given CPU.
+ *
+ * usage: audiomix [-r rate] [-c chans] [-b bits] [-o out] [-x ref [-e max]]
+ *                 [-n loops] file:format:chans:rate ...
+ *        audiomix -t
+ *
+ *	-r, -c, -b	hardware rate, channels and sample size to mix for
+ *			(default 25033 Hz, 2, 16 bit)
+ *	-o		write the mixed samples (raw, CPU byte order)
+ *	-x		compare the result with a reference file, fail if
+ *			a sample differs by more than -e (default 0)
+ *	-n		run the pipeline that often for the timing
+ *	-t		self test: format conversions and resampler quality
+ *
+ * format is one of u8, s8, ulaw, u16, s16 like in actrl.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "afmts.h"
+#include "resample.h"
+
+#define CVTFRAMES	256		/* MIX_CVTFRAMES in mixer.h */
+
+struct input
+{
+	const char *file;
+	afmt_cvt cvt;
+	int ssize;
+	int chans;
+	long rate;
+	unsigned char *data;
+	long frames;
+	short *out;			/* at the hardware rate */
+	long nout;
+};
+
+static const struct
+{
+	const char *name;
+	afmt_cvt cvt;
+	int ssize;
+}
+formats[] =
+{
+	{ "u8",   u8_s16,   1 },
+	{ "s8",   s8_s16,   1 },
+	{ "ulaw", ulaw_s16, 1 },
+	{ "u16",  u16_s16,  2 },
+	{ "s16",  s16_s16,  2 },
+};
+
+#define NFORMATS	(sizeof (formats) / sizeof (formats[0]))
+
+static long hwrate = 25033;
+static int hwchans = 2;
+static int hwbits = 16;
+
+static double
+seconds (clock_t c)
+{
+	return (double) c / CLOCKS_PER_SEC;
+}
+
+static void *
+xmalloc (size_t n)
+{
+	void *p = malloc (n ? n : 1);
+
+	if (!p)
+	{
+		fprintf (stderr, "audiomix: out of memory\n");
+		exit (2);
+	}
+	return p;
+}
+
+static int
+parse_input (struct input *in, char *spec)
+{
+	char *fmt, *chans, *rate;
+	unsigned int i;
+	long size;
+	FILE *fp;
+
+	fmt = strchr (spec, ':');
+	chans = fmt ? strchr (fmt + 1, ':') : NULL;
+	rate = chans ? strchr (chans + 1, ':') : NULL;
+	if (!rate)
+	{
+		fprintf (stderr, "audiomix: %s: want file:format:chans:rate\n", spec);
+		return -1;
+	}
+	*fmt++ = *chans++ = *rate++ = '\0';
+
+	in->file = spec;
+	in->chans = atoi (chans);
+	in->rate = atol (rate);
+
+	for (i = 0; i < NFORMATS; i++)
+		if (!strcmp (fmt, formats[i].name))
+			break;
+
+	if (i == NFORMATS || (in->chans != 1 && in->chans != 2)
+	    || in->rate < 1000 || in->rate > 100000L)
+	{
+		fprintf (stderr, "audiomix: %s: bad format, channels or rate\n", spec);
+		return -1;
+	}
+	in->cvt = formats[i].cvt;
+	in->ssize = formats[i].ssize;
+
+	fp = fopen (in->file, "rb");
+	if (!fp)
+	{
+		perror (in->file);
+		return -1;
+	}
+	fseek (fp, 0, SEEK_END);
+	size = ftell (fp);
+	rewind (fp);
+
+	in->data = xmalloc (size);
+	if (fread (in->data, 1, size, fp) != (size_t) size)
+	{
+		perror (in->file);
+		fclose (fp);
+		return -1;
+	}
+	fclose (fp);
+
+	in->frames = size / (in->ssize * in->chans);
+	return 0;
+}
+
+/*
+ * the write() side of the mixer: convert in blocks and resample,
+ * returns the number of output frames
+ */
+static long
+convert (struct input *in)
+{
+	static short cbuf[CVTFRAMES * 2];
+	struct resampler rs;
+	const unsigned char *src = in->data;
+	long left = in->frames, max, n;
+
+	max = (long) ((double) in->frames * hwrate / in->rate) + 2 * RS_TAPS;
+	in->out = xmalloc (max * hwchans * sizeof (short));
+	in->nout = 0;
+
+	rs_init (&rs, in->rate, hwrate, in->chans);
+
+	while (left > 0)
+	{
+		long got;
+
+		n = left < CVTFRAMES ? left : CVTFRAMES;
+		(*in->cvt) (cbuf, src, n * in->chans);
+
+		got = n;
+		in->nout += rs_run (&rs, in->out + in->nout * hwchans, max - in->nout,
+				    hwchans, cbuf, &got);
+		if (got == 0)
+			break;
+
+		src += got * in->chans * in->ssize;
+		left -= got;
+	}
+
+	return in->nout;
+}
+
+/* the mix_run() side: sum and clip to the hardware format */
+static long
+mix (struct input *ins, int nin, void *out)
+{
+	static long acc[512 * 2];
+	long total = 0, done, n;
+	int i;
+
+	for (i = 0; i < nin; i++)
+		if (ins[i].nout > total)
+			total = ins[i].nout;
+
+	for (done = 0; done < total; done += n)
+	{
+		n = total - done < 512 ? total - done : 512;
+
+		mix_clear (acc, n * hwchans);
+		for (i = 0; i < nin; i++)
+		{
+			long k = ins[i].nout - done;
+
+			if (k > n)
+				k = n;
+			if (k > 0)
+				mix_add (acc, ins[i].out + done * hwchans, k * hwchans);
+		}
+
+		if (hwbits == 16)
+			mix_s16 ((short *) out + done * hwchans, acc, n * hwchans);
+		else
+			mix_s8 ((char *) out + done * hwchans, acc, n * hwchans);
+	}
+
+	return total;
+}
+
+static int
+compare (const char *ref, const void *out, long samples, long maxdiff)
+{
+	long i, worst = 0, where = 0, size;
+	void *data;
+	FILE *fp;
+
+	fp = fopen (ref, "rb");
+	if (!fp)
+	{
+		perror (ref);
+		return 1;
+	}
+	fseek (fp, 0, SEEK_END);
+	size = ftell (fp);
+	rewind (fp);
+
+	if (size != samples * (hwbits / 8))
+	{
+		fprintf (stderr, "audiomix: %s: %ld bytes, expected %ld\n",
+			 ref, size, samples * (hwbits / 8));
+		fclose (fp);
+		return 1;
+	}
+
+	data = xmalloc (size);
+	if (fread (data, 1, size, fp) != (size_t) size)
+	{
+		perror (ref);
+		fclose (fp);
+		return 1;
+	}
+	fclose (fp);
+
+	for (i = 0; i < samples; i++)
+	{
+		long a, b, d;
+
+		if (hwbits == 16)
+			a = ((const short *) out)[i], b = ((short *) data)[i];
+		else
+			a = ((const signed char *) out)[i], b = ((signed char *) data)[i];
+
+		d = a > b ? a - b : b - a;
+		if (d > worst)
+			worst = d, where = i;
+	}
+
+	free (data);
+
+	printf ("reference: max difference %ld (sample %ld)\n", worst, where);
+	return worst > maxdiff;
+}
+
+/*
+ * self test
+ */
+
+static int
+check (int ok, const char *what)
+{
+	printf ("%-44s %s\n", what, ok ? "ok" : "FAILED");
+	return !ok;
+}
+
+static int
+test_formats (void)
+{
+	unsigned char b[4] = { 0x00, 0x80, 0xff, 0x7f };
+	short s[4], w[4] = { -32768, 32767, 1, -2 }, v[4];
+	int fail = 0;
+
+	u8_s16 (s, b, 4);
+	fail |= check (s[0] == -32768 && s[1] == 0 && s[2] == 32512 && s[3] == -256,
+		       "u8 -> s16");
+
+	s8_s16 (s, b, 4);
+	fail |= check (s[0] == 0 && s[1] == -32768 && s[2] == -256 && s[3] == 32512,
+		       "s8 -> s16");
+
+	ulaw_s16 (s, b, 4);
+	fail |= check (s[0] == -32124 && s[1] == 32124 && s[2] == 0 && s[3] == 0,
+		       "ulaw -> s16");
+
+	s16_s16 (s, w, 4);
+	fail |= check (!memcmp (s, w, sizeof (w)), "s16 -> s16");
+
+	/* odd aligned source, as write() may pass it */
+	{
+		unsigned char buf[sizeof (w) + 1];
+		int i;
+
+		memcpy (buf + 1, w, sizeof (w));
+		s16_s16 (s, buf + 1, 4);
+		fail |= check (!memcmp (s, w, sizeof (w)), "s16 -> s16, odd address");
+
+		for (i = 0; i < 4; i++)
+			v[i] = w[i] ^ (short) 0x8000;
+		memcpy (buf + 1, v, sizeof (v));
+		u16_s16 (s, buf + 1, 4);
+		fail |= check (!memcmp (s, w, sizeof (w)), "u16 -> s16, odd address");
+	}
+
+	return fail;
+}
+
+/* a sine through the resampler, against the exact one at the new rate */
+static double
+sine_snr (long inrate, long outrate, double freq, int inchans, int outchans)
+{
+	long n = inrate, nout, got, i, skip;
+	short *in, *out;
+	struct resampler rs;
+	double sig = 0, err = 0;
+
+	in = xmalloc (n * inchans * sizeof (short));
+	out = xmalloc ((outrate + 16) * outchans * sizeof (short));
+
+	for (i = 0; i < n * inchans; i++)
+		in[i] = (short) (16000 * sin (2 * M_PI * freq * (i / inchans) / inrate));
+
+	rs_init (&rs, inrate, outrate, inchans);
+
+	got = n;
+	nout = rs_run (&rs, out, outrate + 16, outchans, in, &got);
+
+	/* the filter starts from silence */
+	skip = RS_TAPS * outrate / inrate + 1;
+	for (i = skip; i < nout - skip; i++)
+	{
+		double t = (double) i * ((double) rs.step / 65536.0) / inrate;
+		double want = 16000 * sin (2 * M_PI * freq * t);
+		double d = out[i * outchans] - want;
+
+		sig += want * want;
+		err += d * d;
+	}
+
+	free (in);
+	free (out);
+
+	return err > 0 ? 10 * log10 (sig / err) : 200;
+}
+
+static int
+test_resampler (void)
+{
+	static const struct { long in, out; double freq; double min; } t[] =
+	{
+		{  8000, 12517,  440, 40 },
+		{  8000, 12517, 1000, 30 },
+		{ 11025, 25033, 1000, 35 },
+		{ 22050, 50066, 2000, 35 },
+		{ 44100, 49170, 1000, 45 },
+		{ 12517, 12517, 1000, 80 },
+	};
+	char what[64];
+	int fail = 0;
+	unsigned int i;
+
+	for (i = 0; i < sizeof (t) / sizeof (t[0]); i++)
+	{
+		double snr = sine_snr (t[i].in, t[i].out, t[i].freq, 1, 1);
+
+		sprintf (what, "%5ld -> %5ld Hz, %4.0f Hz sine: %5.1f dB", t[i].in, t[i].out, t[i].freq, snr);
+		fail |= check (snr >= t[i].min, what);
+	}
+
+	fail |= check (sine_snr (8000, 25033, 500, 1, 2) >= 40, "mono -> stereo");
+	fail |= check (sine_snr (8000, 25033, 500, 2, 1) >= 40, "stereo -> mono");
+
+	return fail;
+}
+
+int
+main (int argc, char **argv)
+{
+	struct input *ins;
+	const char *outfile = NULL, *ref = NULL;
+	long maxdiff = 0, loops = 1, total = 0, l;
+	clock_t tcvt = 0, tmix = 0, t;
+	double played;
+	void *out = NULL;
+	int nin, i, c, fail = 0;
+
+	while ((c = getopt (argc, argv, "r:c:b:o:x:e:n:t")) != -1)
+	{
+		switch (c)
+		{
+			case 'r': hwrate = atol (optarg); break;
+			case 'c': hwchans = atoi (optarg); break;
+			case 'b': hwbits = atoi (optarg); break;
+			case 'o': outfile = optarg; break;
+			case 'x': ref = optarg; break;
+			case 'e': maxdiff = atol (optarg); break;
+			case 'n': loops = atol (optarg); break;
+			case 't':
+				fail = test_formats ();
+				fail |= test_resampler ();
+				return fail;
+			default:
+				goto usage;
+		}
+	}
+
+	if (optind >= argc || (hwchans != 1 && hwchans != 2)
+	    || (hwbits != 8 && hwbits != 16) || hwrate < 1000 || loops < 1)
+		goto usage;
+
+	nin = argc - optind;
+	ins = xmalloc (nin * sizeof (*ins));
+	memset (ins, 0, nin * sizeof (*ins));
+
+	for (i = 0; i < nin; i++)
+		if (parse_input (&ins[i], argv[optind + i]))
+			return 2;
+
+	for (l = 0; l < loops; l++)
+	{
+		t = clock ();
+		for (i = 0; i < nin; i++)
+		{
+			free (ins[i].out);
+			convert (&ins[i]);
+		}
+		tcvt += clock () - t;
+
+		total = 0;
+		for (i = 0; i < nin; i++)
+			if (ins[i].nout > total)
+				total = ins[i].nout;
+
+		free (out);
+		out = xmalloc (total * hwchans * (hwbits / 8));
+
+		t = clock ();
+		mix (ins, nin, out);
+		tmix += clock () - t;
+	}
+
+	played = (double) total / hwrate;
+
+	for (i = 0; i < nin; i++)
+		printf ("%s: %ld frames at %ld Hz -> %ld frames\n",
+			ins[i].file, ins[i].frames, ins[i].rate, ins[i].nout);
+
+	printf ("%ld frames, %.2f s at %ld Hz, %d channels, %d bit\n",
+		total, played, hwrate, hwchans, hwbits);
+	printf ("convert+resample %.2f ms, mix %.2f ms per run",
+		1000 * seconds (tcvt) / loops, 1000 * seconds (tmix) / loops);
+	if (played > 0)
+		printf (" (%.1f%% of the playing time)",
+			100.0 * seconds (tcvt + tmix) / loops / played);
+	printf ("\n");
+
+	if (outfile)
+	{
+		FILE *fp = fopen (outfile, "wb");
+
+		if (!fp || fwrite (out, hwbits / 8, total * hwchans, fp) != (size_t) (total * hwchans))
+		{
+			perror (outfile);
+			return 2;
+		}
+		fclose (fp);
+	}
+
+	if (ref)
+		fail = compare (ref, out, total * hwchans, maxdiff);
+
+	return fail;
+
+usage:
+	fprintf (stderr, "usage: audiomix [-r rate] [-c chans] [-b bits] [-o out] [-x ref [-e max]]\n"
+			 "                [-n loops] file:format:chans:rate ...\n"
+			 "       audiomix -t\n");
+	return 2;
+}
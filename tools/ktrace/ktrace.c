@@ -0,0 +1,244 @@
+/*
+ * ktrace.c: decodes the kernel trace buffer.
+ *
+ * Tracing is switched on with sysctl:
+ *
+ *	sysctl -w kern.tracesize=4096	(records, optional)
+ *	sysctl -w kern.tracemask=15	(1 sched, 2 syscall, 4 block I/O, 8 net)
+ *
+ * and the buffer is read from /kern/trace. The file is big endian and
+ * can be copied elsewhere, the decoder builds on the host as well
+ * (make native).
+ *
+ * usage: ktrace [-a] [-m mask] [file]
+ *
+ *	-a	absolute times (since boot) instead of relative ones
+ *	-m	only show the event classes in mask
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* keep in sync with sys/mint/ktrace.h */
+#define KTRACE_MAGIC	0x4b545243UL	/* 'KTRC' */
+#define KTRACE_VERSION	1
+#define HDRSIZE		24
+
+#define KT_SLEEP	0x01
+#define KT_SWITCH	0x02
+#define KT_WAKE		0x03
+#define KT_PREEMPT	0x04
+#define KT_SYSENTER	0x11
+#define KT_SYSEXIT	0x12
+#define KT_BIOREAD	0x21
+#define KT_BIOWRITE	0x22
+#define KT_NETIN	0x31
+#define KT_NETOUT	0x32
+
+#define USEC_PER_TICK	5000UL		/* 200 Hz */
+#define SUB_PER_TICK	192UL		/* MFP timer C steps */
+
+static const char *queues[] =
+{
+	"CURPROC", "READY", "WAIT", "IO", "ZOMBIE", "TSR", "STOP", "SELECT"
+};
+
+static unsigned long
+get32 (const unsigned char *p)
+{
+	return ((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16)
+		| ((unsigned long) p[2] << 8) | p[3];
+}
+
+static unsigned int
+get16 (const unsigned char *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static long
+sget32 (const unsigned char *p)
+{
+	unsigned long v = get32 (p);
+
+	return (long) (v ^ 0x80000000UL) - 0x7fffffffL - 1;
+}
+
+static const char *
+queue (long q)
+{
+	static char buf[16];
+
+	q &= 0xff;
+	if (q >= 0 && q < (long) (sizeof (queues) / sizeof (queues[0])))
+		return queues[q];
+
+	sprintf (buf, "Q%ld", q);
+	return buf;
+}
+
+static const char *
+sysname (unsigned long id)
+{
+	static char buf[32];
+	const char *trap;
+
+	switch (id >> 16)
+	{
+		case 0x1: trap = "GEMDOS"; break;
+		case 0xd: trap = "BIOS"; break;
+		case 0xe: trap = "XBIOS"; break;
+		default:  trap = "?"; break;
+	}
+
+	sprintf (buf, "%s 0x%03lx", trap, id & 0xffff);
+	return buf;
+}
+
+static void
+print_event (int ev, long a1, long a2)
+{
+	switch (ev)
+	{
+		case KT_SLEEP:
+			printf ("sleep    %s%s cond 0x%08lx", queue (a1),
+				(a1 & 0x100) ? "+" : "", (unsigned long) a2);
+			break;
+		case KT_SWITCH:
+			printf ("switch   -> pid %ld (prev to %s)", a1, queue (a2));
+			break;
+		case KT_WAKE:
+			printf ("wake     %s cond 0x%08lx", queue (a1), (unsigned long) a2);
+			break;
+		case KT_PREEMPT:
+			printf ("preempt  pri %ld", a1);
+			break;
+		case KT_SYSENTER:
+			printf ("syscall  %s", sysname (a1));
+			break;
+		case KT_SYSEXIT:
+			printf ("sysret   %s = %ld", sysname (a1), a2);
+			break;
+		case KT_BIOREAD:
+		case KT_BIOWRITE:
+			printf ("%s %c: %lu sectors at %lu",
+				ev == KT_BIOREAD ? "bioread " : "biowrite",
+				'A' + (int) ((a1 >> 16) & 0x1f), a1 & 0xffffUL, (unsigned long) a2);
+			break;
+		case KT_NETIN:
+			printf ("netin    %ld bytes type %ld", a1, a2);
+			break;
+		case KT_NETOUT:
+			printf ("netout   %ld bytes to %lu.%lu.%lu.%lu", a1,
+				((unsigned long) a2 >> 24) & 0xff, ((unsigned long) a2 >> 16) & 0xff,
+				((unsigned long) a2 >> 8) & 0xff, (unsigned long) a2 & 0xff);
+			break;
+		default:
+			printf ("event    0x%02x 0x%08lx 0x%08lx", ev,
+				(unsigned long) a1, (unsigned long) a2);
+			break;
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *file = "/kern/trace";
+	unsigned char hdr[HDRSIZE];
+	unsigned char *rec;
+	unsigned long recsize, count, total, mask, show = ~0UL, i;
+	unsigned long long t, first = 0, last = 0;
+	int absolute = 0;
+	FILE *fp;
+	int c;
+
+	while ((c = getopt (argc, argv, "am:")) != -1)
+	{
+		switch (c)
+		{
+			case 'a': absolute = 1; break;
+			case 'm': show = strtoul (optarg, NULL, 0); break;
+			default:
+				fprintf (stderr, "usage: ktrace [-a] [-m mask] [file]\n");
+				return 1;
+		}
+	}
+
+	if (optind < argc)
+		file = argv[optind];
+
+	fp = fopen (file, "rb");
+	if (!fp)
+	{
+		perror (file);
+		return 1;
+	}
+
+	if (fread (hdr, HDRSIZE, 1, fp) != 1
+	    || get32 (hdr) != KTRACE_MAGIC || get16 (hdr + 4) != KTRACE_VERSION)
+	{
+		fprintf (stderr, "ktrace: %s: not a version %d kernel trace\n", file, KTRACE_VERSION);
+		return 1;
+	}
+
+	recsize = get16 (hdr + 6);
+	count = get32 (hdr + 12);
+	total = get32 (hdr + 16);
+	mask = get32 (hdr + 20);
+
+	if (recsize < 16)
+	{
+		fprintf (stderr, "ktrace: %s: bad record size %lu\n", file, recsize);
+		return 1;
+	}
+
+	printf ("# %lu records (%lu logged, %lu lost), mask 0x%lx\n",
+		count, total, total - count, mask);
+
+	rec = malloc (recsize);
+	if (!rec)
+		return 1;
+
+	for (i = 0; i < count; i++)
+	{
+		unsigned long ticks, sub;
+		int ev;
+
+		if (fread (rec, recsize, 1, fp) != 1)
+		{
+			fprintf (stderr, "ktrace: %s: truncated after %lu records\n", file, i);
+			break;
+		}
+
+		ticks = get32 (rec);
+		sub = rec[4];
+		ev = rec[5];
+
+		t = (unsigned long long) ticks * USEC_PER_TICK + sub * USEC_PER_TICK / SUB_PER_TICK;
+
+		/* timer C reloaded before the tick was counted */
+		if (i && t < last && last - t < USEC_PER_TICK)
+			t += USEC_PER_TICK;
+
+		if (i == 0)
+			first = t;
+		last = t;
+
+		if (!(show & (1UL << (ev >> 4))))
+			continue;
+
+		if (!absolute)
+			t -= first;
+
+		printf ("%6llu.%06llu %5d ", t / 1000000, t % 1000000, (short) get16 (rec + 6));
+		print_event (ev, sget32 (rec + 8), sget32 (rec + 12));
+		printf ("\n");
+	}
+
+	free (rec);
+	fclose (fp);
+
+	return 0;
+}
@@ -145,6 +145,12 @@ parse_option (char *s)
 			/* not supported yet */
 			strtol (&s[9], &p, 10);
 		}
+		else if (!strncmp (s, "vers=", 5))
+		{
+			nfsvers = strtol (&s[5], &p, 10);
+			strcat (optionstr, "vers=");
+			_ltoa (nfsvers, &optionstr[strlen (optionstr)], 10);
+		}
 		else if (!strncmp (s, "actimeo=", 8))
 		{
 			actimeo = strtol (&s[8], &p, 10);
@@ -64,6 +64,34 @@ xdr_size_fhstatus (fhstatus *fhsp)
 }
 
 
+bool_t
+xdr_mountres3 (XDR *x, mountres3 *resp)
+{
+	char *fh = resp->fhandle;
+	u_long n, flavor;
+	
+	if (!xdr_u_long (x, &resp->status))
+		return FALSE;
+	
+	if (0 != resp->status)
+		return TRUE;
+	
+	if (!xdr_bytes (x, &fh, &resp->fhlen, MNTFHSIZE3))
+		return FALSE;
+	
+	if (!xdr_u_long (x, &n))
+		return FALSE;
+	
+	while (n--)
+	{
+		if (!xdr_u_long (x, &flavor))
+			return FALSE;
+	}
+	
+	return TRUE;
+}
+
+
 bool_t
 xdr_mountlist (XDR *x, mountlist *mlp)
 {
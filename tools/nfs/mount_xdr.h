@@ -29,12 +29,14 @@
 
 #define MOUNT_PROGRAM   100005
 #define MOUNT_VERSION   1
+#define MOUNT_VERSION3  3	/* gives handles for NFSv3 */
 #define MOUNT_MAXPROC   5
 
 
 #define MNTPATHLEN   1024
 #define MNTNAMLEN     255
 #define MNTFHSIZE      32
+#define MNTFHSIZE3     64
 
 
 bool_t xdr_dirpath (XDR *x, char *s);
@@ -63,6 +65,17 @@ bool_t xdr_fhstatus (XDR *x, fhstatus *fhsp);
 long xdr_size_fhstatus (fhstatus *fhsp);
 
 
+/* result of MNT in version 3; the list of auth flavors is skipped */
+typedef struct mountres3
+{
+	u_long status;
+	u_int fhlen;
+	char fhandle[MNTFHSIZE3];
+} mountres3;
+
+bool_t xdr_mountres3 (XDR *x, mountres3 *resp);
+
+
 typedef struct mountlist
 {
 	char *ml_hostname;
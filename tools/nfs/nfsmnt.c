@@ -46,6 +46,7 @@ int intr = 0;
 int secure = 0;
 int noac = 0;
 int nosuid = 0;
+int nfsvers = 0; /* NFSv3 if the server can, else NFSv2 */
 
 
 #define OPT_DEFAULT 0x0000
@@ -60,10 +61,11 @@ int nosuid = 0;
 #define OPT_NOAC    0x0100
 #define OPT_NOCTO   0x0200
 #define OPT_POSIX   0x0400
+#define OPT_NFSV3   0x0800
 
 
 #define MOUNT_PORT  2050
-#define NFS_MOUNT_VERS 1
+#define NFS_MOUNT_VERS 2
 
 
 typedef struct myxattr MYXATTR;
@@ -105,6 +107,10 @@ typedef struct
 
 	struct sockaddr_in server;
 	char hostname[256];
+
+	/* version 2 of this structure, with OPT_NFSV3 */
+	u_long	fhlen3;
+	char	handle3[MNTFHSIZE3];
 } NFS_MOUNT_INFO;
 
 
@@ -151,6 +157,107 @@ make_socket (long maxmsgsize)
 
 #pragma GCC diagnostic ignored "-Wcast-qual"
 
+/* ask the mountd of the server for the handle of remote; version 3
+ * of the mount protocol gives a handle for NFSv3
+ */
+static long
+get_handle (struct sockaddr_in *server, int s, u_long version,
+            const char *remote, NFS_MOUNT_INFO *info)
+{
+	struct timeval retry_time = { 1, 0 };  /* every second */
+	struct timeval total_time = { 5, 0 };  /* total timeout */
+	enum clnt_stat res;
+	fhstatus fh;
+	mountres3 fh3;
+	u_long status;
+	CLIENT *cl;
+	
+	server->sin_port = htons (0);  /* ask the port mapper for that port */
+	
+	cl = clntudp_create (server, MOUNT_PROGRAM, version, retry_time, &s);
+	if (!cl)
+	{
+		/* also try a fallback method with a fixed port number */
+		server->sin_port = htons(MOUNT_PORT);
+		cl = clntudp_create (server, MOUNT_PROGRAM, version, retry_time, &s);
+		if (!cl)
+		{
+			fprintf (stderr, "do_nfs_mount: failed to create RPC client\n");
+			return 1;
+		}
+	}
+	
+	if (version == MOUNT_VERSION3)
+	{
+		res = clnt_call (cl, MOUNTPROC_MNT,
+		                (xdrproc_t) xdr_dirpath, (void *)remote,
+		                (xdrproc_t) xdr_mountres3, (void *)&fh3, total_time);
+		status = fh3.status;
+	}
+	else
+	{
+		res = clnt_call (cl, MOUNTPROC_MNT,
+		                (xdrproc_t) xdr_dirpath, (void *)remote,
+		                (xdrproc_t) xdr_fhstatus, (void *)&fh, total_time);
+		status = fh.status;
+	}
+	
+	if (res != RPC_SUCCESS)
+	{
+		clnt_perror (cl, "do_nfs_mount");
+		clnt_destroy (cl);
+		
+		return res;
+	}
+	
+	clnt_destroy (cl);
+	
+	if (status != 0)
+	{
+		fprintf (stderr, "do_nfs_mount: mount request failed with %ld\n", status);
+		return -1;
+	}
+	
+	if (version == MOUNT_VERSION3)
+	{
+		info->fhlen3 = fh3.fhlen;
+		memcpy (info->handle3, fh3.fhandle, fh3.fhlen);
+	}
+	else
+		info->handle = fh.fhstatus_u.directory;
+	
+	return 0;
+}
+
+/* tell the mountd of the server that remote isn't mounted (any more);
+ * no error checks here, the server may not be reachable
+ */
+static void
+put_handle (struct sockaddr_in *server, int s, u_long version,
+            const char *remote)
+{
+	struct timeval retry_time = { 1, 0 };  /* every second */
+	struct timeval total_time = { 5, 0 };  /* total timeout */
+	CLIENT *cl;
+	
+	server->sin_port = htons (0);  /* ask the port mapper for the port */
+	
+	cl = clntudp_create (server, MOUNT_PROGRAM, version, retry_time, &s);
+	if (!cl)
+	{
+		/* also try a fallback method with a fixed port number */
+		server->sin_port = htons (MOUNT_PORT);
+		cl = clntudp_create (server, MOUNT_PROGRAM, version, retry_time, &s);
+		if (!cl)
+			return;
+	}
+	
+	(void) clnt_call (cl, MOUNTPROC_UMNT,
+	                  (xdrproc_t)xdr_dirpath, (caddr_t)remote,
+	                  (xdrproc_t)xdr_void, (caddr_t)NULL, total_time);
+	clnt_destroy (cl);
+}
+
 long
 do_nfs_mount (const char *remote, const char *localdir)
 {
@@ -158,13 +265,8 @@ do_nfs_mount (const char *remote, const char *localdir)
 	NFS_MOUNT_INFO info;
 	char mountname[MNTPATHLEN+1];
 	char hostname[IPNAMELEN+1];
-	struct timeval retry_time = { 1, 0 };  /* every second */
-	struct timeval total_time = { 5, 0 };  /* total timeout */
 	long maxmsgsize = MNTPATHLEN+RPCSMALLMSGSIZE;
-	enum clnt_stat res;
-	fhstatus fh;
 	char *p;
-	CLIENT *cl;
 	int s;
 	struct sockaddr_in server;
 	struct hostent *hp;
@@ -227,50 +329,58 @@ do_nfs_mount (const char *remote, const char *localdir)
 	
 	server.sin_family = AF_INET;
 	memcpy ((char*) &server.sin_addr, hp->h_addr, hp->h_length);
-	server.sin_port = htons (0);  /* ask the port mapper for that port */
 	
-	cl = clntudp_create (&server, MOUNT_PROGRAM, MOUNT_VERSION, retry_time, &s);
-	if (!cl)
-	{
-		/* also try a fallback method with a fixed port number */
-		server.sin_port = htons(MOUNT_PORT);
-		cl = clntudp_create (&server, MOUNT_PROGRAM, MOUNT_VERSION, retry_time, &s);
-		if (!cl)
-		{
-			fprintf (stderr, "do_nfs_mount: failed to create RPC client\n");
-			return 1;
-		}
-	}
+	info.server.sin_family = AF_INET;
+	memcpy ((char*) &info.server.sin_addr, hp->h_addr, hp->h_length);
+	info.server.sin_port = htons (port);
 	
-	res = clnt_call (cl, MOUNTPROC_MNT,
-	                (xdrproc_t) xdr_dirpath, (void *)remote,
-	                (xdrproc_t) xdr_fhstatus, (void *)&fh, total_time);
+	r = -1;
 	
-	if (res != RPC_SUCCESS)
+	/* NFSv3 first; the kernel asks the server for FSINFO, so the
+	 * mount fails there if the server can't do version 3
+	 */
+	if (nfsvers != 2)
 	{
-		clnt_perror (cl, "do_nfs_mount");
-		clnt_destroy (cl);
+		info.flags |= OPT_NFSV3;
 		
-		return res;
+		r = get_handle (&server, s, MOUNT_VERSION3, remote, &info);
+		if (r == 0)
+		{
+			r = Dcntl (NFS_MOUNT, mountname, &info);
+			
+			/* the server has recorded the mount; forget it again */
+			if (r != 0)
+				put_handle (&server, s, MOUNT_VERSION3, remote);
+		}
+		
+		if (r != 0 && nfsvers == 3)
+		{
+			fprintf (stderr, "%s: NFSv3 mount failed\n", commandname);
+			return r;
+		}
+		
+		info.flags &= ~OPT_NFSV3;
 	}
 	
-	clnt_destroy (cl);
-	
-	if (fh.status != 0)
+	if (r != 0)
 	{
-		fprintf (stderr, "do_nfs_mount: mount request failed with %ld\n", fh.status);
-		return -1;
+		/* NFSv2; version 1 of the mount info is understood by
+		 * older kernels, too
+		 */
+		info.version = 1;
+		
+		r = get_handle (&server, s, MOUNT_VERSION, remote, &info);
+		if (r != 0)
+			return r;
+		
+		r = Dcntl (NFS_MOUNT, mountname, &info);
+		if (r != 0)
+		{
+			fprintf (stderr, "%s: mount request to kernel failed\n", commandname);
+			put_handle (&server, s, MOUNT_VERSION, remote);
+		}
 	}
 	
-	info.server.sin_family = AF_INET;
-	memcpy ((char*) &info.server.sin_addr, hp->h_addr, hp->h_length);
-	info.server.sin_port = htons (port);
-	info.handle = fh.fhstatus_u.directory;
-	
-	r = Dcntl (NFS_MOUNT, mountname, &info);
-	if (r != 0)
-		fprintf (stderr, "%s: mount request to kernel failed\n", commandname);
-	
 	return r;
 }
 
@@ -280,10 +390,7 @@ do_nfs_unmount (const char *remote, const char *local)
 	long r;
 	char mountname[MNTPATHLEN+1];
 	char hostname[IPNAMELEN+1];
-	struct timeval retry_time = { 1, 0 };  /* every second */
-	struct timeval total_time = { 5, 0 };  /* total timeout */
 	long maxmsgsize = MNTPATHLEN+RPCSMALLMSGSIZE;
-	CLIENT *cl;
 	int s;
 	char *p;
 	struct sockaddr_in server;
@@ -338,21 +445,7 @@ do_nfs_unmount (const char *remote, const char *local)
 	
 	server.sin_family = AF_INET;
 	memcpy ((char*) &server.sin_addr, hp->h_addr, hp->h_length);
-	server.sin_port = htons (0);  /* ask the port mapper for the port */
 	
-	cl = clntudp_create (&server, MOUNT_PROGRAM, MOUNT_VERSION, retry_time, &s);
-	if (!cl)
-	{
-		/* Also try a fallback method with a fixed port number */
-		server.sin_port = htons (MOUNT_PORT);
-		cl = clntudp_create (&server, MOUNT_PROGRAM, MOUNT_VERSION, retry_time, &s);
-		if (!cl)
-			return 0;
-	}
-	
-	(void) clnt_call (cl, MOUNTPROC_UMNT,
-	                  (xdrproc_t)xdr_dirpath, (caddr_t)remote,
-	                  (xdrproc_t)xdr_void, (caddr_t)NULL, total_time);
-	clnt_destroy (cl);
+	put_handle (&server, s, MOUNT_VERSION, remote);
 	return 0;
 }
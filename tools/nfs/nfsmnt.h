@@ -28,6 +28,7 @@ extern int intr;
 extern int secure;
 extern long actimeo;
 extern int noac;
+extern int nfsvers;
 
 
 
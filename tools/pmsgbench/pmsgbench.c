@@ -0,0 +1,193 @@
+/*
+ * pmsgbench.c: measures the cost of the MiNT rendezvous calls.
+ *
+ * - Pmsg round trip: the parent does a write/read (mode 2) on a
+ *   mailbox, a child reads the message and writes the reply to the
+ *   parent's 0xFFFF0000|pid mailbox
+ * - Psemaphore get/release of one semaphore
+ *
+ * Both are run with a number of extra idle processes and unrelated
+ * semaphores around, to show that the cost doesn't depend on them.
+ *
+ * usage: pmsgbench [-n loops] [-p idle processes] [-s semaphores]
+ */
+
+#include <mint/mintbind.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define MBOX	0x504d4230L	/* 'PMB0' */
+#define SEMA	0x504d5330L	/* 'PMS0' */
+
+static long
+usecs (struct timeval *start, struct timeval *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000L
+		+ (end->tv_usec - start->tv_usec);
+}
+
+static void
+report (const char *what, long loops, struct timeval *start, struct timeval *end)
+{
+	long us = usecs (start, end);
+
+	printf ("%-24s %8ld loops %10ld us %8ld.%02ld us/op\n", what, loops, us,
+		us / loops, (us % loops) * 100 / loops);
+}
+
+static int
+echo_server (long loops)
+{
+	long msg[3];
+	long i;
+
+	for (i = 0; i < loops; i++)
+	{
+		long reply;
+
+		if (Pmsg (0, MBOX, msg) < 0)
+			return 1;
+
+		/* the writer waits on its own pid mailbox */
+		reply = 0xffff0000L | (unsigned short) (msg[2] >> 16);
+		if (Pmsg (1, reply, msg) < 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+static void
+bench_pmsg (long loops)
+{
+	struct timeval start, end;
+	long msg[3];
+	long i;
+	int pid;
+
+	pid = fork ();
+	if (pid < 0)
+	{
+		perror ("pmsgbench: fork");
+		exit (1);
+	}
+
+	if (pid == 0)
+		_exit (echo_server (loops + 1));
+
+	/* one untimed round trip to get the child going */
+	msg[0] = msg[1] = 0;
+	Pmsg (2, MBOX, msg);
+
+	gettimeofday (&start, NULL);
+	for (i = 0; i < loops; i++)
+	{
+		msg[0] = i;
+		msg[1] = ~i;
+		if (Pmsg (2, MBOX, msg) < 0 || msg[0] != i)
+		{
+			fprintf (stderr, "pmsgbench: Pmsg round trip %ld failed\n", i);
+			break;
+		}
+	}
+	gettimeofday (&end, NULL);
+
+	waitpid (pid, NULL, 0);
+
+	report ("Pmsg round trip", i, &start, &end);
+}
+
+static void
+bench_psemaphore (long loops)
+{
+	struct timeval start, end;
+	long i;
+
+	if (Psemaphore (0, SEMA, 0) < 0 || Psemaphore (3, SEMA, 0) < 0)
+	{
+		fprintf (stderr, "pmsgbench: can't create semaphore\n");
+		return;
+	}
+
+	gettimeofday (&start, NULL);
+	for (i = 0; i < loops; i++)
+	{
+		Psemaphore (2, SEMA, -1);
+		Psemaphore (3, SEMA, 0);
+	}
+	gettimeofday (&end, NULL);
+
+	Psemaphore (1, SEMA, 0);
+
+	report ("Psemaphore get+release", loops, &start, &end);
+}
+
+int
+main (int argc, char **argv)
+{
+	long loops = 10000;
+	long nprocs = 0;
+	long nsemas = 0;
+	int *pids;
+	long i;
+	int c;
+
+	while ((c = getopt (argc, argv, "n:p:s:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n': loops = atol (optarg); break;
+			case 'p': nprocs = atol (optarg); break;
+			case 's': nsemas = atol (optarg); break;
+			default:
+				fprintf (stderr, "usage: pmsgbench [-n loops] [-p idle processes] [-s semaphores]\n");
+				return 1;
+		}
+	}
+
+	if (loops < 1)
+		loops = 1;
+
+	pids = malloc ((nprocs + 1) * sizeof (*pids));
+	if (!pids)
+		return 1;
+
+	/* idle processes sitting on other mailboxes */
+	for (i = 0; i < nprocs; i++)
+	{
+		long msg[3];
+
+		pids[i] = fork ();
+		if (pids[i] == 0)
+		{
+			Pmsg (0, 0x49444c00L + i, msg);
+			_exit (0);
+		}
+	}
+
+	for (i = 0; i < nsemas; i++)
+		Psemaphore (0, SEMA + 1 + i, 0);
+
+	printf ("%ld idle processes, %ld other semaphores\n", nprocs, nsemas);
+
+	bench_pmsg (loops);
+	bench_psemaphore (loops);
+
+	for (i = 0; i < nsemas; i++)
+		Psemaphore (1, SEMA + 1 + i, 0);
+
+	for (i = 0; i < nprocs; i++)
+	{
+		if (pids[i] > 0)
+		{
+			kill (pids[i], SIGTERM);
+			waitpid (pids[i], NULL, 0);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * sysstat.c: prints the system calls that cost the most time,
+ * system wide, from the kernel's per call statistics (/kern/syscalls).
+ *
+ * The latency is wall time, so calls that block (Fread on a pipe,
+ * Fselect, Pwait3, ...) show up with long times; the percentiles are
+ * the upper bounds of the log2 histogram buckets.
+ *
+ * usage: sysstat [-c] [-n top] [-f syscalls.master] [-z]
+ *
+ *	-c	sort by number of calls instead of total time
+ *	-n	number of calls to show (default 20)
+ *	-f	take the names from this syscalls.master
+ *	-z	reset the statistics (needs root)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../sys/mint/sysctl.h"
+
+#define BUCKETS		12	/* SYSSTAT_BUCKETS in sys/syscall_stat.h */
+#define STEP_US		26	/* one MFP timer C step, rounded */
+
+struct call
+{
+	char trap[8];
+	unsigned long func;
+	unsigned long calls;
+	double seconds;
+	unsigned long hist[BUCKETS];
+	const char *name;
+};
+
+struct name
+{
+	char trap[8];
+	unsigned long func;
+	char name[32];
+};
+
+static struct name *names;
+static long nnames;
+
+static int by_calls;
+
+static void
+load_names (const char *file)
+{
+	char line[256], trap[8] = "";
+	FILE *fp;
+
+	fp = fopen (file, "r");
+	if (!fp)
+	{
+		perror (file);
+		return;
+	}
+
+	while (fgets (line, sizeof (line), fp))
+	{
+		char *p, *e;
+
+		if (line[0] == '[')
+		{
+			/* [ GEMDOS ], [ BIOS ], [ XBIOS ] */
+			if (sscanf (line, "[ %7s", trap) != 1)
+				trap[0] = '\0';
+			continue;
+		}
+
+		if (strncmp (line, "0x", 2) != 0 || !trap[0])
+			continue;
+
+		/* opcode ret name (args) [status] */
+		p = strchr (line, '(');
+		if (!p)
+			continue;
+
+		while (p > line && (p[-1] == ' ' || p[-1] == '\t'))
+			p--;
+		e = p;
+		while (p > line && p[-1] != ' ' && p[-1] != '\t' && p[-1] != '*')
+			p--;
+
+		if (e - p <= 0 || e - p >= 32)
+			continue;
+
+		names = realloc (names, (nnames + 1) * sizeof (*names));
+		if (!names)
+			exit (1);
+
+		strcpy (names[nnames].trap, trap);
+		names[nnames].func = strtoul (line, NULL, 16);
+		memcpy (names[nnames].name, p, e - p);
+		names[nnames].name[e - p] = '\0';
+		nnames++;
+	}
+
+	fclose (fp);
+}
+
+static const char *
+lookup (const char *trap, unsigned long func)
+{
+	long i;
+
+	for (i = 0; i < nnames; i++)
+		if (names[i].func == func && !strcmp (names[i].trap, trap))
+			return names[i].name;
+
+	return NULL;
+}
+
+static int
+compare (const void *a, const void *b)
+{
+	const struct call *x = a, *y = b;
+
+	if (by_calls)
+		return (x->calls < y->calls) - (x->calls > y->calls);
+
+	return (x->seconds < y->seconds) - (x->seconds > y->seconds);
+}
+
+/* upper bound in us of the bucket holding the given fraction of calls */
+static const char *
+percentile (const struct call *c, unsigned long permille, char *buf)
+{
+	unsigned long want = (c->calls * permille + 999) / 1000;
+	unsigned long seen = 0;
+	int b;
+
+	for (b = 0; b < BUCKETS - 1; b++)
+	{
+		seen += c->hist[b];
+		if (seen >= want)
+			break;
+	}
+
+	/* the last bucket has no upper bound */
+	if (b == BUCKETS - 1)
+		sprintf (buf, ">%lu", (1UL << (b - 1)) * STEP_US);
+	else
+		sprintf (buf, "%lu", (1UL << b) * STEP_US);
+
+	return buf;
+}
+
+static void
+reset (void)
+{
+	int mib[2] = { CTL_KERN, KERN_SYSCALLSTAT };
+	long on = 1;
+
+	if (sysctl (mib, 2, NULL, NULL, &on, sizeof (on)) == -1)
+		perror ("sysstat: kern.syscallstat");
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *file = "/kern/syscalls";
+	struct call *calls = NULL;
+	long ncalls = 0, top = 20, i;
+	double total = 0;
+	char line[512];
+	FILE *fp;
+	int c;
+
+	while ((c = getopt (argc, argv, "cn:f:z")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': by_calls = 1; break;
+			case 'n': top = atol (optarg); break;
+			case 'f': load_names (optarg); break;
+			case 'z': reset (); return 0;
+			default:
+				fprintf (stderr, "usage: sysstat [-c] [-n top] [-f syscalls.master] [-z]\n");
+				return 1;
+		}
+	}
+
+	fp = fopen (file, "r");
+	if (!fp)
+	{
+		perror (file);
+		return 1;
+	}
+
+	while (fgets (line, sizeof (line), fp))
+	{
+		struct call *n;
+		char *p;
+		int b;
+
+		if (line[0] == '#')
+			continue;
+
+		calls = realloc (calls, (ncalls + 1) * sizeof (*calls));
+		if (!calls)
+			return 1;
+
+		n = &calls[ncalls];
+		memset (n, 0, sizeof (*n));
+
+		if (sscanf (line, "%7s %lx %lu %lf", n->trap, &n->func, &n->calls, &n->seconds) != 4)
+			continue;
+
+		/* skip the fixed columns, then the histogram */
+		p = line;
+		for (b = 0; b < 4; b++)
+		{
+			while (*p == ' ')
+				p++;
+			while (*p && *p != ' ')
+				p++;
+		}
+		for (b = 0; b < BUCKETS; b++)
+			n->hist[b] = strtoul (p, &p, 10);
+
+		n->name = lookup (n->trap, n->func);
+
+		total += n->seconds;
+		ncalls++;
+	}
+
+	fclose (fp);
+
+	qsort (calls, ncalls, sizeof (*calls), compare);
+
+	printf ("%-6s %-20s %10s %12s %5s %9s %9s %9s\n",
+		"trap", "call", "count", "seconds", "%time", "avg us", "p50 <us", "p99 <us");
+
+	for (i = 0; i < ncalls && i < top; i++)
+	{
+		struct call *n = &calls[i];
+		char buf[32], p50[16], p99[16];
+
+		if (n->name)
+			strcpy (buf, n->name);
+		else
+			sprintf (buf, "0x%03lx", n->func);
+
+		printf ("%-6s %-20s %10lu %12.6f %5.1f %9.0f %9s %9s\n",
+			n->trap, buf, n->calls, n->seconds,
+			total > 0 ? n->seconds * 100 / total : 0.0,
+			n->seconds * 1e6 / n->calls,
+			percentile (n, 500, p50), percentile (n, 990, p99));
+	}
+
+	free (calls);
+	free (names);
+
+	return 0;
+}
@@ -980,6 +980,9 @@ k_init(unsigned short dev, unsigned short mc)
 	 */
 	init_client_widget_theme(client);
 
+	/* the themes have what they need from the image cache */
+	image_cache_release();
+
 #if FILESELECTOR
 	/* Do some itialisation */
 	init_fsel();
@@ -375,6 +375,20 @@ do_winmesag(int lock,
 	}
 }
 
+/*
+ * Merging two redraw rectangles pays if their bounding box isn't
+ * bigger than the two of them together.
+ */
+static bool
+redraw_mergeable(const GRECT *a, const GRECT *b)
+{
+	GRECT u;
+
+	xa_rect_union(a, b, &u);
+
+	return (long)u.g_w * u.g_h <= (long)a->g_w * a->g_h + (long)b->g_w * b->g_h;
+}
+
 static void
 #if GENERATE_DIAGS
 add_msg_2_queue(struct xa_client *client, struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags)
@@ -387,7 +401,9 @@ add_msg_2_queue(struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags
 
 	if (new[0] == WM_REDRAW)
 	{
-		short *old;
+		union msg_buf m;
+		struct xa_aesmsg_list *spare = NULL;
+		short removed = 0;
 
 		DIAG((D_m, NULL, "WM_REDRAW for %s, rect %d/%d,%d/%d", client->name, new[4], new[5], new[6], new[7]));
 
@@ -395,26 +411,52 @@ add_msg_2_queue(struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags
 
 		if (qmflags & QMF_CHKDUP)
 		{
+			GRECT *nr;
+
+			/*
+			 * Keep the pending redraws of a window a small set of
+			 * rectangles (its damage region): queued rectangles that
+			 * the new one covers, or that are worth merging with it,
+			 * are taken out and merged into it. As it grows, it may
+			 * cover others, so start over then. If a queued rectangle
+			 * covers it, it isn't needed at all.
+			 */
+			m = *msg;
+			msg = &m;
+			nr = (GRECT *)&m.m[4];
+
 			while (*next)
 			{
-				old = (*next)->message.m;
+				struct xa_aesmsg_list *q = *next;
+				short *old = q->message.m;
+				GRECT *or = (GRECT *)&old[4];
 
-				if (old[3] == new[3] && old[0] == new[0] )
+				if (old[3] == m.m[3] && old[0] == WM_REDRAW)
 				{
-					if ( !memcmp((GRECT *)&(old[4]), (GRECT *)&(new[4]),sizeof(GRECT)) || is_inside((GRECT *)&(new[4]), (GRECT *)&(old[4])))
+					if (is_inside(nr, or))
 					{
 						msg = NULL;
 						break;
 					}
-					if (is_inside((GRECT *)&(old[4]), (GRECT *)&(new[4])))
+					if (is_inside(or, nr) || redraw_mergeable(or, nr))
 					{
-						/* old inside new: replace by new. */
-						(*next)->message.s = msg->s;
-						msg = NULL;
-						break;
+						DIAG((D_m, NULL, "merge WM_REDRAW %d/%d,%d/%d into %d/%d,%d/%d",
+							or->g_x, or->g_y, or->g_w, or->g_h, nr->g_x, nr->g_y, nr->g_w, nr->g_h));
+
+						xa_rect_union(or, nr, nr);
+						*next = q->next;
+						if (!(q->qmflags & QMF_NOCOUNT))
+							removed++;
+						if (spare)
+							kfree(q);
+						else
+							spare = q;
+
+						next = queue;
+						continue;
 					}
 				}
-				next = &((*next)->next);
+				next = &q->next;
 			}
 		}
 		else
@@ -425,12 +467,14 @@ add_msg_2_queue(struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags
 
 		if (msg)
 		{
-			new_msg = kmalloc(sizeof(*new_msg));
+			new_msg = spare ? spare : kmalloc(sizeof(*new_msg));
+			spare = NULL;
 			DIAG((D_m, NULL, "new WM_REDRAW message %lx for %s", (unsigned long)new_msg, client->name));
 			if (new_msg)
 			{
 				*next = new_msg;
 				new_msg->message = *msg;
+				new_msg->qmflags = qmflags;
 				new_msg->next = NULL;
 				/* BLOGif( new[3] < 50 && new[3] >= 0, (0, "add_msg_2_queue:WM_REDRAW added for %d rect %d/%d,%d/%d", new_msg->message.m[3], new_msg->message.m[4], new_msg->message.m[5], new_msg->message.m[6], new[7])); */
 				if (!(qmflags & QMF_NOCOUNT))
@@ -440,6 +484,11 @@ add_msg_2_queue(struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags
 				}
 			}
 		}
+		if (spare)
+			kfree(spare);
+
+		/* the merged messages that were counted are gone */
+		C.redraws -= removed;
 		return;
 	}
 
@@ -567,6 +616,7 @@ add_msg_2_queue(struct xa_aesmsg_list **queue, union msg_buf *msg, short qmflags
 		if (new_msg)
 		{
 			new_msg->message = *msg;
+			new_msg->qmflags = qmflags;
 			if (qmflags & QMF_PREPEND)
 			{
 				new_msg->next = *queue;
@@ -552,3 +552,18 @@ xa_rect_chk(const GRECT *s, const GRECT *d, GRECT *r)
 	}
 	return ret;
 }
+
+/*
+ * Bounding box of two rectangles; r may be the same as s or d.
+ */
+void
+xa_rect_union(const GRECT *s, const GRECT *d, GRECT *r)
+{
+	const short x2 = max(s->g_x + s->g_w, d->g_x + d->g_w);
+	const short y2 = max(s->g_y + s->g_h, d->g_y + d->g_h);
+
+	r->g_x = min(s->g_x, d->g_x);
+	r->g_y = min(s->g_y, d->g_y);
+	r->g_w = x2 - r->g_x;
+	r->g_h = y2 - r->g_y;
+}
@@ -47,6 +47,7 @@ struct build_rl_parms
 bool xa_rc_intersect(const GRECT s, GRECT *d);
 bool xa_rect_clip(const GRECT *s, const GRECT *d, GRECT *r);
 int xa_rect_chk(const GRECT *s, const GRECT *d, GRECT *r);
+void xa_rect_union(const GRECT *s, const GRECT *d, GRECT *r);
 
 //struct xa_rect_list *build_rect_list(struct build_rl_parms *p);
 struct xa_rect_list *make_rect_list(struct xa_window *w, bool swap, short which);
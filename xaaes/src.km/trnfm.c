@@ -43,6 +43,8 @@
 
 #include "trnfm.h"
 #include "util.h"
+
+#include "mint/stat.h"
 #if INCLUDE_UNUSED
 static short systempalette[] =
 {
@@ -1045,95 +1047,246 @@ static struct TrNfo from1_8[] =
 	{8 + 0, 127, 255},	/* 8 */
 };
 
+/*
+ * Conversion kernels.
+ *
+ * Calling a to*() function for every pixel costs an indirect call and
+ * three divisions each. Every to*() function puts the three channels in
+ * bits of their own, so a device pixel is the OR of its channels
+ * converted alone. The to*() function is therefore only used to build
+ * lookup tables, once per color index or channel value; the loops below
+ * just look up and store, with one loop per device pixel size.
+ */
+union devpixel
+{
+	unsigned long	l;
+	unsigned short	w;
+	unsigned char	b[4];
+};
+
+/* one per color index, or one per channel value for each channel */
+static union devpixel pix_lut[256];
+static union devpixel chan_lut[3][256];
+
+static short
+dev_pixelsize(MFDB *dst)
+{
+	switch (dst->fd_nplanes)
+	{
+		case 15:
+		case 16: return 2;
+		case 24: return 3;
+		case 32: return 4;
+	}
+	return 0;
+}
+
+static void
+dev_pixel(void *(*to)(struct rgb_1000 *, void *), struct rgb_1000 *col, union devpixel *p)
+{
+	p->l = 0;
+	(*to)(col, p);
+}
+
+/*
+ * Channel chan (0 = red, 1 = green, 2 = blue) for n channel values,
+ * scaled the way from24b() and from16b() always did.
+ */
+static void
+build_chan_lut(void *(*to)(struct rgb_1000 *, void *), short chan, short n)
+{
+	struct rgb_1000 c;
+	unsigned long val;
+	short i;
+
+	for (i = 0; i < n; i++)
+	{
+		val = (i * 1000L + 127) >> 8;
+		if (val > 1000)
+			val = 1000;
+
+		c.red = c.green = c.blue = 0;
+		if (chan == 0)
+			c.red = val;
+		else if (chan == 1)
+			c.green = val;
+		else
+			c.blue = val;
+
+		dev_pixel(to, &c, &chan_lut[chan][i]);
+	}
+}
+
+/*
+ * Store n pixels, color indexes in idx.
+ */
+static void *
+put_index_pixels(void *d, const unsigned char *idx, short n, short pixelsize)
+{
+	const union devpixel *lut = pix_lut;
+
+	switch (pixelsize)
+	{
+		case 2:
+		{
+			unsigned short *p = d;
+
+			for (; n >= 4; n -= 4, idx += 4, p += 4)
+			{
+				p[0] = lut[idx[0]].w;
+				p[1] = lut[idx[1]].w;
+				p[2] = lut[idx[2]].w;
+				p[3] = lut[idx[3]].w;
+			}
+			while (n--)
+				*p++ = lut[*idx++].w;
+			return p;
+		}
+		case 3:
+		{
+			unsigned char *p = d;
+
+			while (n--)
+			{
+				const union devpixel *c = lut + *idx++;
+
+				*p++ = c->b[0];
+				*p++ = c->b[1];
+				*p++ = c->b[2];
+			}
+			return p;
+		}
+		case 4:
+		{
+			unsigned long *p = d;
+
+			for (; n >= 4; n -= 4, idx += 4, p += 4)
+			{
+				p[0] = lut[idx[0]].l;
+				p[1] = lut[idx[1]].l;
+				p[2] = lut[idx[2]].l;
+				p[3] = lut[idx[3]].l;
+			}
+			while (n--)
+				*p++ = lut[*idx++].l;
+			return p;
+		}
+	}
+	return d;
+}
+
 static void
 from8b(void *(*to)(struct rgb_1000 *, void *), struct rgb_1000 *pal, MFDB *src, MFDB *dst)
 {
-	int i, j, k, psize, planes;
-	unsigned int palidx;
+	int i, j, k, psize, planes, pixelsize;
+	unsigned int palidx, ncols;
 	unsigned long val;
-	unsigned short *s_ptr, *src_ptr;
-	void *p, **d_ptr;
-	struct rgb_1000 *col;
+	unsigned short *s_ptr, *src_ptr, w[8];
+	unsigned char idx[16];
+	void *d;
 
-	d_ptr = &p;
-	*d_ptr = dst->fd_addr;
+	pixelsize = dev_pixelsize(dst);
+	planes = src->fd_nplanes;
+	ncols = 1 << planes;
 
+	/* device pixel of every color index */
+	for (palidx = 0; palidx < ncols; palidx++)
+	{
+		if (!pal)
+		{
+			struct rgb_1000 gp;
+			val = from1_8[planes].full - palidx;
+			val *= 1000;
+			val += from1_8[planes].half;
+			val /= from1_8[planes].full + 1;
+			gp.red = gp.green = gp.blue = (val > 1000) ? 1000 : val;
+			dev_pixel(to, &gp, &pix_lut[palidx]);
+		}
+		else
+		{
+			i = palidx;
+			if (src->fd_r1 && i < 15)
+				i = devtovdi8[i];
+
+			dev_pixel(to, pal + i, &pix_lut[palidx]);
+		}
+	}
+
+	d = dst->fd_addr;
 	psize = src->fd_wdwidth * src->fd_h;
 	src_ptr = src->fd_addr;
-	planes = src->fd_nplanes;
 
 	for (k = 0; k < psize; k++, src_ptr++)
 	{
+		s_ptr = src_ptr;
+		for (j = 0; j < planes; j++, s_ptr += psize)
+			w[j] = *s_ptr;
+
+		/* plane 0 is the lowest bit of the color index */
 		for (i = 0; i < 16; i++)
 		{
 			palidx = 0;
-			s_ptr = src_ptr;
-			for (j = 0; j < planes; j++)
-			{
-				palidx >>= 1;
-				palidx |= (*s_ptr & 0x8000);
-				*s_ptr <<= 1;
-				s_ptr += psize;
-			}
-			palidx >>= from1_8[planes].shift;
-			if (!pal)
+			for (j = planes - 1; j >= 0; j--)
 			{
-				struct rgb_1000 gp;
-				val = from1_8[planes].full - palidx;
-				val *= 1000;
-				val += from1_8[planes].half;
-				val /= from1_8[planes].full + 1;
-				gp.red = gp.green = gp.blue = (val > 1000) ? 1000 : val;
-				*d_ptr = (*to)(&gp, *d_ptr);
-			}
-			else
-			{
-				if (src->fd_r1 && palidx < 15)
-					palidx = devtovdi8[palidx];
-
-				col = pal + palidx;
-				*d_ptr = (*to)(col, *d_ptr);
+				palidx = (palidx << 1) | (w[j] >> 15);
+				w[j] <<= 1;
 			}
+			idx[i] = palidx;
 		}
+		d = put_index_pixels(d, idx, 16, pixelsize);
 	}
 }
 
 static void
 from24b(void *(*to)(struct rgb_1000 *, void *), struct rgb_1000 *pal, MFDB *src, MFDB *dst)
 {
-	int i, j;
-	unsigned long val;
-	unsigned char *src_ptr;
-	void *p, **d_ptr;
-	struct rgb_1000 ppal;
+	const union devpixel *rl = chan_lut[0], *gl = chan_lut[1], *bl = chan_lut[2];
+	const unsigned char *s = src->fd_addr;
+	long n = (long)src->fd_w * src->fd_h;
 
-	d_ptr = &p;
-	*d_ptr = dst->fd_addr;
-	src_ptr = src->fd_addr;
+	build_chan_lut(to, 0, 256);
+	build_chan_lut(to, 1, 256);
+	build_chan_lut(to, 2, 256);
 
-	for (i = 0; i < src->fd_h; i++)
+	switch (dev_pixelsize(dst))
 	{
-		for (j = 0; j < src->fd_w; j++)
+		case 2:
 		{
-			val = *(unsigned char *)src_ptr++;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.red = val > 1000 ? 1000 : val;
+			unsigned short *p = dst->fd_addr;
 
-			val = *(unsigned char *)src_ptr++;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.green = val > 1000 ? 1000 : val;
+			for (; n >= 2; n -= 2, s += 6)
+			{
+				*p++ = rl[s[0]].w | gl[s[1]].w | bl[s[2]].w;
+				*p++ = rl[s[3]].w | gl[s[4]].w | bl[s[5]].w;
+			}
+			if (n)
+				*p = rl[s[0]].w | gl[s[1]].w | bl[s[2]].w;
+			break;
+		}
+		case 3:
+		{
+			unsigned char *p = dst->fd_addr;
 
-			val = *(unsigned char *)src_ptr++;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.blue = val > 1000 ? 1000 : val;
+			for (; n > 0; n--, s += 3)
+			{
+				*p++ = rl[s[0]].b[0] | gl[s[1]].b[0] | bl[s[2]].b[0];
+				*p++ = rl[s[0]].b[1] | gl[s[1]].b[1] | bl[s[2]].b[1];
+				*p++ = rl[s[0]].b[2] | gl[s[1]].b[2] | bl[s[2]].b[2];
+			}
+			break;
+		}
+		case 4:
+		{
+			unsigned long *p = dst->fd_addr;
 
-			*d_ptr = (*to)(&ppal, *d_ptr);
+			for (; n >= 2; n -= 2, s += 6)
+			{
+				*p++ = rl[s[0]].l | gl[s[1]].l | bl[s[2]].l;
+				*p++ = rl[s[3]].l | gl[s[4]].l | bl[s[5]].l;
+			}
+			if (n)
+				*p = rl[s[0]].l | gl[s[1]].l | bl[s[2]].l;
+			break;
 		}
 	}
 }
@@ -1141,42 +1294,61 @@ from24b(void *(*to)(struct rgb_1000 *, void *), struct rgb_1000 *pal, MFDB *src,
 static void
 from16b(void *(*to)(struct rgb_1000 *, void *), struct rgb_1000 *pal, MFDB *src, MFDB *dst)
 {
-	int i, j;
-	unsigned long val;
-	unsigned short *src_ptr, pix;
-	void *p, **d_ptr;
-	struct rgb_1000 ppal;
+	const union devpixel *rl = chan_lut[0], *gl = chan_lut[1], *bl = chan_lut[2];
+	const unsigned short *s = src->fd_addr;
+	long n = (long)src->fd_w * src->fd_h;
+	unsigned short pix;
 
-	d_ptr = &p;
-	*d_ptr = dst->fd_addr;
-	src_ptr = src->fd_addr;
+	build_chan_lut(to, 0, 32);
+	build_chan_lut(to, 1, 64);
+	build_chan_lut(to, 2, 32);
+
+#define R16(p)	rl[((p) >> 11) & 31]
+#define G16(p)	gl[((p) >> 6) & 63]
+#define B16(p)	bl[(p) & 31]
 
-	for (i = 0; i < src->fd_h; i++)
+	switch (dev_pixelsize(dst))
 	{
-		for (j = 0; j < src->fd_w; j++)
+		case 2:
 		{
-			pix = *src_ptr++;
-			val = (pix >> 11) & 31;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.red = val > 1000 ? 1000 : val;
+			unsigned short *p = dst->fd_addr;
 
-			val = (pix >> 6) & 63;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.green = val > 1000 ? 1000 : val;
+			while (n--)
+			{
+				pix = *s++;
+				*p++ = R16(pix).w | G16(pix).w | B16(pix).w;
+			}
+			break;
+		}
+		case 3:
+		{
+			unsigned char *p = dst->fd_addr;
 
-			val = pix & 31;
-			val *= 1000;
-			val += 127;
-			val >>= 8;
-			ppal.blue = val > 1000 ? 1000 : val;
+			while (n--)
+			{
+				pix = *s++;
+				*p++ = R16(pix).b[0] | G16(pix).b[0] | B16(pix).b[0];
+				*p++ = R16(pix).b[1] | G16(pix).b[1] | B16(pix).b[1];
+				*p++ = R16(pix).b[2] | G16(pix).b[2] | B16(pix).b[2];
+			}
+			break;
+		}
+		case 4:
+		{
+			unsigned long *p = dst->fd_addr;
 
-			*d_ptr = (*to)(&ppal, *d_ptr);
+			while (n--)
+			{
+				pix = *s++;
+				*p++ = R16(pix).l | G16(pix).l | B16(pix).l;
+			}
+			break;
 		}
 	}
+
+#undef R16
+#undef G16
+#undef B16
 }
 #endif
 
@@ -1636,61 +1808,376 @@ create_gradient(XAMFDB *pm, struct rgb_1000 *c, short method, short n_steps, sho
 #endif	/* ST_ONLY */
 #endif	/* WITH_GRADIENTS */
 
+/*
+ * Image cache
+ *
+ * Converted images are kept in <home>cache\ as XAMFDB + bitmap, one
+ * file per image. cache\images.idx records for each of them the source
+ * image it was made from (full path, modification time and size), the
+ * screen format it was converted to and the name of the cache file,
+ * made up from a hash of the path; a cached bitmap is only used if all
+ * of these still match.
+ *
+ * When the index is first needed, it is read and all the bitmaps it
+ * lists are checked and loaded in one go, before the themes ask for
+ * them one by one; load_image() then only hands them over.
+ * image_cache_release() frees those nobody asked for.
+ */
+#define ICACHE_MAGIC	0x58414943L	/* 'XAIC' */
+#define ICACHE_NAMELEN	16
+#define ICACHE_PATHLEN	256
+#define ICACHE_MAX	64
+
+struct icache_entry
+{
+	char	src[ICACHE_PATHLEN];	/* source image, the key */
+	char	file[ICACHE_NAMELEN];	/* in the cache directory */
+	long	mtime;
+	long	size;
+	short	planes;			/* screen format converted to */
+	short	pixel_fmt;
+};
+
+struct icache_head
+{
+	long	magic;
+	short	entsize;
+	short	count;
+};
+
+static struct icache_entry *icache;
+static XAMFDB *icache_img[ICACHE_MAX];	/* loaded in advance */
+static short icache_count;
+static bool icache_loaded;
+
 static void
-image_cache_get(char *name, XAMFDB *mimg)
+icache_path(char *path, const char *file)
+{
+	sprintf(path, PATH_MAX-1, "%scache\\%s", C.Aes->home_path, file);
+}
+
+static void
+icache_save(void)
 {
+	struct icache_head h;
 	struct file *f;
+	char path[PATH_MAX];
+	long size = icache_count * sizeof(*icache);
 
-	mimg->mfdb.fd_addr = NULL;
-	f = kernel_open(name, O_RDONLY, NULL, NULL);
+	icache_path(path, "images.idx");
+	f = kernel_open(path, O_RDWR|O_CREAT|O_TRUNC, NULL, NULL);
 	if (f)
 	{
-		long bmread, bmsize;
-		bmread = kernel_read(f, mimg, sizeof(XAMFDB));
-		bmsize = (long)((long)mimg->mfdb.fd_wdwidth * (mimg->mfdb.fd_nplanes == 15 ? 16 : mimg->mfdb.fd_nplanes) * mimg->mfdb.fd_h) << 1;
-		if ((mimg->mfdb.fd_addr = kmalloc(bmsize)))
-			bmread += kernel_read(f, mimg->mfdb.fd_addr, bmsize);
-		else
-			BLOG((0,"Not enough memory for %s (%ld bytes)", name, bmsize));
+		h.magic = ICACHE_MAGIC;
+		h.entsize = sizeof(*icache);
+		h.count = icache_count;
 
+		if (kernel_write(f, &h, sizeof(h)) != sizeof(h) || kernel_write(f, icache, size) != size)
+		{
+			BLOG((0,"image cache: write error for %s", path));
+			kernel_close(f);
+			_f_delete(path);
+			return;
+		}
 		kernel_close(f);
-		if (bmread != (sizeof(XAMFDB)+bmsize))
+	}
+}
+
+static struct icache_entry *
+icache_find(const char *name)
+{
+	short i;
+
+	for (i = 0; i < icache_count; i++)
+	{
+		if (!strcmp(icache[i].src, name))
+			return &icache[i];
+	}
+	return NULL;
+}
+
+/* drop an entry and its file */
+static void
+icache_remove(struct icache_entry *e)
+{
+	char path[PATH_MAX];
+	short i = e - icache;
+
+	icache_path(path, e->file);
+	_f_delete(path);
+
+	if (icache_img[i])
+	{
+		kfree(icache_img[i]->mfdb.fd_addr);
+		kfree(icache_img[i]);
+	}
+
+	icache_count--;
+	if (i < icache_count)
+	{
+		memcpy(e, e + 1, (icache_count - i) * sizeof(*e));
+		memcpy(&icache_img[i], &icache_img[i + 1], (icache_count - i) * sizeof(*icache_img));
+	}
+	icache_img[icache_count] = NULL;
+}
+
+/* the state of the source image and screen an entry has to match */
+static bool
+icache_source(const char *name, struct icache_entry *e)
+{
+	struct stat st;
+
+	if (strlen(name) >= ICACHE_PATHLEN || f_stat64(0, name, &st))
+		return false;
+
+	strcpy(e->src, name);
+	e->mtime = st.mtime.time;
+	e->size = st.size;
+	e->planes = screen.planes;
+	e->pixel_fmt = screen.pixel_fmt;
+	return true;
+}
+
+static bool
+icache_valid(struct icache_entry *e)
+{
+	struct icache_entry cur;
+
+	return icache_source(e->src, &cur)
+	    && e->mtime == cur.mtime && e->size == cur.size
+	    && e->planes == cur.planes && e->pixel_fmt == cur.pixel_fmt;
+}
+
+/* a cache file name for the source image, one no other entry has */
+static void
+icache_name(struct icache_entry *e)
+{
+	unsigned long h = 0;
+	const char *p;
+	short i;
+
+	for (p = e->src; *p; p++)
+		h = h * 31 + (unsigned char)*p;
+
+	for (;;)
+	{
+		sprintf(e->file, ICACHE_NAMELEN, "%08lx.%d", h, e->planes);
+
+		for (i = 0; i < icache_count; i++)
 		{
-			BLOG((0,"Read error for %s: read %ld bytes (must be %ld)", name, bmread, sizeof(XAMFDB)+bmsize));
-			if (mimg->mfdb.fd_addr)
-			{
-				kfree(mimg->mfdb.fd_addr);
-				mimg->mfdb.fd_addr = NULL;
-			}
-			_f_delete(name);
+			if (&icache[i] != e && !strcmp(icache[i].file, e->file))
+				break;
 		}
+		if (i == icache_count)
+			break;
+		h++;
 	}
+}
+
+static bool
+icache_read(struct icache_entry *e, XAMFDB *mimg)
+{
+	struct file *f;
+	char path[PATH_MAX];
+	long bmread, bmsize;
+
+	mimg->mfdb.fd_addr = NULL;
+
+	icache_path(path, e->file);
+	f = kernel_open(path, O_RDONLY, NULL, NULL);
+	if (!f)
+	{
+		BLOG((0,"File %s not found", path));
+		return false;
+	}
+
+	bmread = kernel_read(f, mimg, sizeof(XAMFDB));
+	bmsize = (long)((long)mimg->mfdb.fd_wdwidth * (mimg->mfdb.fd_nplanes == 15 ? 16 : mimg->mfdb.fd_nplanes) * mimg->mfdb.fd_h) << 1;
+	mimg->mfdb.fd_addr = NULL;
+	if (bmread != sizeof(XAMFDB) || mimg->mfdb.fd_nplanes != screen.planes)
+		bmsize = -1;
+	else if ((mimg->mfdb.fd_addr = kmalloc(bmsize)))
+		bmread += kernel_read(f, mimg->mfdb.fd_addr, bmsize);
 	else
+		BLOG((0,"Not enough memory for %s (%ld bytes)", path, bmsize));
+
+	kernel_close(f);
+	if (bmread != (sizeof(XAMFDB)+bmsize))
+	{
+		BLOG((0,"Read error for %s: read %ld bytes (must be %ld)", path, bmread, sizeof(XAMFDB)+bmsize));
+		if (mimg->mfdb.fd_addr)
+		{
+			kfree(mimg->mfdb.fd_addr);
+			mimg->mfdb.fd_addr = NULL;
+		}
+		return false;
+	}
+	return true;
+}
+
+/* read the index, check all entries and load their bitmaps */
+static void
+icache_load(void)
+{
+	struct icache_head h;
+	struct file *f;
+	char path[PATH_MAX];
+	short i, loaded = 0;
+	bool changed = false;
+
+	icache_loaded = true;
+
+	icache = kmalloc(ICACHE_MAX * sizeof(*icache));
+	if (!icache)
+		return;
+
+	icache_path(path, "images.idx");
+	f = kernel_open(path, O_RDONLY, NULL, NULL);
+	if (f)
 	{
-		BLOG((0,"File %s not found", name));
+		if (kernel_read(f, &h, sizeof(h)) == sizeof(h)
+		    && h.magic == ICACHE_MAGIC
+		    && h.entsize == sizeof(*icache)
+		    && h.count >= 0 && h.count <= ICACHE_MAX
+		    && kernel_read(f, icache, h.count * sizeof(*icache)) == h.count * sizeof(*icache))
+		{
+			icache_count = h.count;
+		}
+		kernel_close(f);
+	}
+
+	for (i = 0; i < icache_count; )
+	{
+		XAMFDB *img;
+
+		if (!icache_valid(&icache[i]))
+		{
+			BLOG((0,"image cache: %s is stale", icache[i].src));
+			icache_remove(&icache[i]);
+			changed = true;
+			continue;
+		}
+
+		img = kmalloc(sizeof(*img));
+		if (!img)
+			break;
+
+		if (!icache_read(&icache[i], img))
+		{
+			kfree(img);
+			icache_remove(&icache[i]);
+			changed = true;
+			continue;
+		}
+
+		icache_img[i++] = img;
+		loaded++;
+	}
+
+	if (changed)
+		icache_save();
+
+	BLOG((0,"image cache: %d entries, %d loaded", icache_count, loaded));
+}
+
+static void
+image_cache_get(char *name, XAMFDB *mimg)
+{
+	struct icache_entry *e;
+	short i;
+
+	mimg->mfdb.fd_addr = NULL;
+
+	if (!icache_loaded)
+		icache_load();
+
+	e = icache_find(name);
+	if (!e)
+		return;
+
+	/* checked by icache_load() just now */
+	i = e - icache;
+	if (icache_img[i])
+	{
+		*mimg = *icache_img[i];
+		kfree(icache_img[i]);
+		icache_img[i] = NULL;
+		return;
+	}
+
+	if (!icache_valid(e))
+	{
+		BLOG((0,"image cache: %s is stale", name));
+		icache_remove(e);
+		icache_save();
+		return;
+	}
+
+	if (!icache_read(e, mimg))
+	{
+		icache_remove(e);
+		icache_save();
 	}
 }
 
 static void
 image_cache_put(char *name, XAMFDB *mimg)
 {
+	struct icache_entry *e, cur;
 	struct file *f;
+	char path[PATH_MAX];
+	bool added = false;
 
-	f = kernel_open(name, O_RDWR|O_CREAT|O_TRUNC, NULL, NULL);
+	if (!icache_loaded)
+		icache_load();
+	if (!icache || !icache_source(name, &cur))
+		return;
+
+	e = icache_find(name);
+	if (e)
+	{
+		short i = e - icache;
+
+		strcpy(cur.file, e->file);
+		if (icache_img[i])
+		{
+			kfree(icache_img[i]->mfdb.fd_addr);
+			kfree(icache_img[i]);
+			icache_img[i] = NULL;
+		}
+	}
+	else
+	{
+		if (icache_count == ICACHE_MAX)
+		{
+			/* drop the oldest */
+			icache_remove(icache);
+		}
+		e = &icache[icache_count++];
+		*e = cur;
+		icache_name(e);
+		strcpy(cur.file, e->file);
+		added = true;
+	}
+
+	icache_path(path, cur.file);
+	f = kernel_open(path, O_RDWR|O_CREAT|O_TRUNC, NULL, NULL);
 	if (!f)
 	{
-		char path[PATH_MAX];
+		char dir[PATH_MAX];
 		long err;
 
-		sprintf(path, PATH_MAX-1, "%scache", C.Aes->home_path);
-		err = _d_create( path );
+		sprintf(dir, PATH_MAX-1, "%scache", C.Aes->home_path);
+		err = _d_create( dir );
 		if (err)	/* could not mkdir */
 		{
-			BLOG((0,"image_cache_put: could not create %s", path ));
+			BLOG((0,"image_cache_put: could not create %s", dir ));
+			if (added)
+				icache_count--;
 			return;
 		}
 		/* Retry */
-		f = kernel_open(name, O_RDWR|O_CREAT|O_TRUNC, NULL, NULL);
+		f = kernel_open(path, O_RDWR|O_CREAT|O_TRUNC, NULL, NULL);
 	}
 	if (f)
 	{
@@ -1700,8 +2187,34 @@ image_cache_put(char *name, XAMFDB *mimg)
 		kernel_close(f);
 		if (bmwrite != (sizeof(XAMFDB)+bmsize))
 		{
-			BLOG((0,"Write error for %s: write %ld bytes (must be %ld)", name, bmwrite, sizeof(XAMFDB)+bmsize));
-			_f_delete(name);
+			BLOG((0,"Write error for %s: write %ld bytes (must be %ld)", path, bmwrite, sizeof(XAMFDB)+bmsize));
+			icache_remove(e);
+			icache_save();
+			return;
+		}
+
+		*e = cur;
+		icache_save();
+	}
+	else
+		icache_remove(e);
+}
+
+/*
+ * Free the bitmaps loaded in advance that no theme has asked for.
+ */
+void
+image_cache_release(void)
+{
+	short i;
+
+	for (i = 0; i < icache_count; i++)
+	{
+		if (icache_img[i])
+		{
+			kfree(icache_img[i]->mfdb.fd_addr);
+			kfree(icache_img[i]);
+			icache_img[i] = NULL;
 		}
 	}
 }
@@ -1712,14 +2225,10 @@ load_image(char *name, XAMFDB *mimg)
 	XA_XIMG_HEAD xa_img;
 	struct ximg_header *ximg = &xa_img.ximg;
 	long bmsize;
-	char cache_path[PATH_MAX];
 
 	if (cfg.textures_cache)
 	{
-		sprintf(cache_path, PATH_MAX-1, "%scache\\", C.Aes->home_path);
-		strip_fname(name, 0, cache_path+strlen(cache_path));
-		sprintf(strrchr(cache_path, '.')+1, 4, "%d", screen.planes);
-		image_cache_get(cache_path, mimg);
+		image_cache_get(name, mimg);
 		if (mimg->mfdb.fd_addr)                      /* Cache hit! */
 			return;
 	}
@@ -1852,7 +2361,7 @@ load_image(char *name, XAMFDB *mimg)
 		 * - If cache is ON and .img successfully loaded, write file
 		 */
 		if (cfg.textures_cache && mimg->mfdb.fd_addr)
-			image_cache_put(cache_path, mimg);
+			image_cache_put(name, mimg);
 	}
 }
 
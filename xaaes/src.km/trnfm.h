@@ -32,6 +32,7 @@ void create_gradient(XAMFDB *pm, struct rgb_1000 *c, short method, short n_steps
 
 //void depack_img(char *name, XA_XIMG_HEAD *pic);
 void load_image(char *name, XAMFDB *mimg);
+void image_cache_release(void);
 
 //void remap_bitmap_colindexes(MFDB *map, unsigned char *cref);
 //void build_pal_xref(struct rgb_1000 *src_palette, struct rgb_1000 *dst_palette, unsigned char *cref, int pens);
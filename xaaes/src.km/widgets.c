@@ -821,6 +821,85 @@ remove_wt(XA_TREE *wt, bool force)
 	return false;
 }
 
+/*
+ * Get the part of rectangle rl the widget has to be drawn in.
+ */
+static bool
+widget_clip(struct xa_window *wind, XA_WIDGET *widg, struct xa_rect_list *rl, GRECT *r)
+{
+	if (widg->m.properties & WIP_WACLIP)
+		return xa_rect_clip(&rl->r, &wind->wa, r);
+
+	if( wind == root_window || !cfg.menu_bar || cfg.menu_layout != 0 || ( rl->r.g_y > get_menu_height() || !clip_off_menu( &rl->r )) )
+		return xa_rect_clip(&rl->r, &widg->ar, r);
+
+	return false;
+}
+
+/*
+ * Context independent widgets that are visible in more than one
+ * rectangle are drawn once into the display list of the vdi settings,
+ * which is then replayed for every rectangle.
+ * The list is recorded under a clip covering the whole widget, so that
+ * clip changes done by the draw function don't depend on the rectangle;
+ * the draw function gets the first rectangle, as in the usual loop, and
+ * each replay is clipped to the rectangle being redrawn.
+ * Returns false if that isn't possible; draw the usual way then.
+ */
+static bool
+draw_widget_dl(struct xa_window *wind, XA_WIDGET *widg, struct xa_rect_list *rl)
+{
+	struct xa_vdi_settings *v = wind->vdi_settings;
+	struct xa_rect_list *l, *first = NULL;
+	GRECT r, r1, ext;
+	short n = 0;
+
+	if (widg->m.r.xaw_idx >= XAW_TOOLBAR || !rl->next)
+		return false;
+
+	for (l = rl; l; l = l->next)
+	{
+		if (widget_clip(wind, widg, l, &r) && !n++)
+		{
+			first = l;
+			r1 = r;
+		}
+	}
+	if (n < 2)
+		return false;
+
+	if (widg->m.properties & WIP_WACLIP)
+	{
+		if (!xa_rect_clip(&widg->ar, &wind->wa, &ext))
+			return false;
+	}
+	else
+		ext = widg->ar;
+
+	if (!(*v->api->dl_begin)(v))
+		return false;
+
+	(*v->api->set_clip)(v, &ext);
+	widg->m.r.draw(wind, widg, (widg->m.properties & WIP_WACLIP) ? &r1 : &first->r);
+
+	if (!(*v->api->dl_end)(v))
+		return false;
+
+	for (l = rl; l; l = l->next)
+	{
+		if (widget_clip(wind, widg, l, &r))
+		{
+			(*v->api->set_clip)(v, &r);
+			if( !(widg->m.properties & WIP_WACLIP) && !cfg.menu_ontop && l->r.g_y < get_menu_height() && l->r.g_x < get_menu_widg()->r.g_w )
+			{
+				C.rdm = 1;
+			}
+			(*v->api->dl_replay)(v);
+		}
+	}
+	return true;
+}
+
 /*
  * If rl is not NULL, we use that rectangle list instead of the rectlist
  * of the window containing the widget. Used when redrawing widgets of
@@ -843,6 +922,9 @@ draw_widget(struct xa_window *wind, XA_WIDGET *widg, struct xa_rect_list *rl)
 	{
 		hidem();
 
+		if (draw_widget_dl(wind, widg, rl))
+			rl = NULL;
+
 		while (rl)
 		{
 			if (widg->m.properties & WIP_WACLIP)
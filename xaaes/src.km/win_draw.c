@@ -1879,9 +1879,25 @@ draw_widget_text(struct xa_vdi_settings *v, struct xa_widget *widg, struct xa_wt
 	(*v->api->wtxt_output)(v, wtxti, txt, widg->state, &widg->ar, xoff, yoff);
 }
 
+struct widg_icon
+{
+	XA_TREE *wt;
+	struct xa_aes_object ob;
+	short x, y;
+};
+
+static void _cdecl
+render_widg_icon(struct xa_vdi_settings *v, void *arg)
+{
+	struct widg_icon *i = arg;
+
+	(*api->render_object)(i->wt, v, i->ob, i->x, i->y);
+}
+
 static void
 draw_widg_icon(struct xa_vdi_settings *v, struct xa_widget *widg, XA_TREE *wt, short ind)
 {
+	struct widg_icon i;
 	short x, y, w, h;
 	struct xa_aes_object ob;
 
@@ -1897,7 +1913,13 @@ draw_widg_icon(struct xa_vdi_settings *v, struct xa_widget *widg, XA_TREE *wt, s
 	(*api->object_spec_wh)(aesobj_ob(&ob), &w, &h);
 	x += (widg->ar.g_w - w) >> 1;
 	y += (widg->ar.g_h - h) >> 1;
-	(*api->render_object)(wt, v, ob, x, y);
+
+	/* the object renderer does its own VDI output */
+	i.wt = wt;
+	i.ob = ob;
+	i.x = x;
+	i.y = y;
+	(*v->api->dl_call)(v, render_widg_icon, &i, sizeof(i));
 }
 
 #include "widgets.h"
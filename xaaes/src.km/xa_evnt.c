@@ -68,6 +68,46 @@ pending_critical_msgs(int lock, struct xa_client *client, union msg_buf *buf)
 	return rtn;
 }
 
+/*
+ * Shrink a WM_REDRAW to the part of the window that is visible now.
+ * It may have been queued long ago; the client clips against the
+ * rectangle list anyway, but doesn't need to walk it for parts that
+ * got covered meanwhile. Returns false if nothing of it is visible.
+ */
+static bool
+clip_redraw_msg(int lock, struct xa_client *client, union msg_buf *buf)
+{
+	struct xa_window *wind;
+	struct xa_rect_list *rl;
+	GRECT *r = (GRECT *)&buf->m[4];
+	GRECT c, u;
+	bool visible = false;
+
+	if (buf->m[0] != WM_REDRAW)
+		return true;
+
+	wind = get_wind_by_handle(lock, buf->m[3]);
+	if (!wind || wind->owner != client || !(rl = wind->rect_list.start))
+		return true;
+
+	for (; rl; rl = rl->next)
+	{
+		if (xa_rect_clip(&rl->r, r, &c))
+		{
+			if (visible)
+				xa_rect_union(&u, &c, &u);
+			else
+				u = c;
+			visible = true;
+		}
+	}
+
+	if (visible)
+		*r = u;
+
+	return visible;
+}
+
 static int
 pending_redraw_msgs(int lock, struct xa_client *client, union msg_buf *buf)
 {
@@ -75,8 +115,7 @@ pending_redraw_msgs(int lock, struct xa_client *client, union msg_buf *buf)
 	int rtn = 0;
 
 	Sema_Up(LOCK_CLIENTS);
-	msg = client->rdrw_msg;
-	if (msg)
+	while ((msg = client->rdrw_msg))
 	{
 		/* dequeue */
 		client->rdrw_msg = msg->next;
@@ -84,17 +123,22 @@ pending_redraw_msgs(int lock, struct xa_client *client, union msg_buf *buf)
 		/* write to client */
 		*buf = msg->message;
 
-		DIAG((D_m, NULL, "Got pending WM_REDRAW (%lx (wind=%d, %d/%d/%d/%d)) for %s",
-			(unsigned long)msg, buf->m[3], buf->m[4], buf->m[5], buf->m[6], buf->m[7], c_owner(client) ));
-
 		kfree(msg);
-		rtn = 1;
 		kick_mousemove_timeout();
+
+		if (clip_redraw_msg(lock, client, buf))
+		{
+			DIAG((D_m, NULL, "Got pending WM_REDRAW (%lx (wind=%d, %d/%d/%d/%d)) for %s",
+				(unsigned long)msg, buf->m[3], buf->m[4], buf->m[5], buf->m[6], buf->m[7], c_owner(client) ));
+			rtn = 1;
+			break;
+		}
+
+		DIAG((D_m, NULL, "WM_REDRAW for covered area of window %d dropped", buf->m[3]));
 	}
-	else{
-		if (C.redraws )
-			yield();
-	}
+
+	if (!rtn && C.redraws)
+		yield();
 
 	Sema_Dn(LOCK_CLIENTS);
 	return rtn;
@@ -445,6 +445,7 @@ struct xa_aesmsg_list
 {
 	struct xa_aesmsg_list *next;
 	union msg_buf message;
+	short qmflags;			/* QMF_ flags it was queued with */
 };
 
 union conkey
@@ -27,6 +27,7 @@
 #include "xa_types.h"
 #include "xa_global.h"
 #include "trnfm.h"
+#include "rectlist.h"
 
 static void _cdecl
 r2pxy(short *p, short d, const GRECT *r)
@@ -929,6 +930,480 @@ xa_form_copy(const GRECT *fr, const GRECT *to)
 	vro_cpyfm(C.P_handle, S_ONLY, pnt, &Mscreen, &Mscreen);
 }
 
+/*
+ * Display lists
+ *
+ * Window widgets are drawn once for every rectangle of the window's
+ * rectangle list, redoing all geometry, text clipping and attribute
+ * setup each time. Between dl_begin() and dl_end() the api of a
+ * vdi_settings is replaced by one that records the output primitives
+ * and their arguments instead. dl_replay() plays them back within the
+ * current clip rectangle; clip changes recorded are intersected with it.
+ *
+ * Consecutive settings of the same attribute are merged while recording,
+ * and on replay the normal setters filter out what is already set.
+ * Text metrics are needed while recording, so fonts are really set.
+ * Anything that can't be recorded (screen save/restore, a full list)
+ * marks the list broken and the caller has to draw the usual way.
+ */
+#define DL_SIZE		4096L
+
+#define DL_STATE	0	/* attribute setting */
+#define DL_CLIP		1	/* clip change, argument is the GRECT */
+#define DL_DRAW		2	/* output */
+
+struct dl_op
+{
+	dl_callback	*f;
+	short		kind;
+	short		size;		/* bytes of arguments following */
+};
+
+struct xa_vdi_dlist
+{
+	struct xa_vdi_api *api;		/* the real api while recording */
+	bool	broken;
+	long	used;
+	struct dl_op *last;		/* the preceding op */
+	struct xa_vdi_settings start;	/* attributes and clip at dl_begin() */
+	long	buf[DL_SIZE / sizeof(long)];
+};
+
+/* the vdi_settings being recorded, there's only ever one */
+static struct xa_vdi_settings *dl_rec;
+
+static struct xa_vdi_api dlapi;
+
+/*
+ * Append an op with room for size bytes of arguments,
+ * returns where they go or NULL if the list is full.
+ */
+static void *
+dl_alloc(struct xa_vdi_settings *v, dl_callback *f, short kind, long size)
+{
+	struct xa_vdi_dlist *dl = v->dl;
+	struct dl_op *op;
+	long need;
+
+	if (dl->broken)
+		return NULL;
+
+	need = sizeof(*op) + ((size + 3) & ~3);
+	if (dl->used + need > DL_SIZE)
+	{
+		DIAG((D_v, NULL, "dl_alloc: display list full"));
+		dl->broken = true;
+		return NULL;
+	}
+
+	op = (struct dl_op *)((char *)dl->buf + dl->used);
+	op->f = f;
+	op->kind = kind;
+	op->size = need - sizeof(*op);
+
+	dl->used += need;
+	dl->last = op;
+	return op + 1;
+}
+
+static void
+dl_add(struct xa_vdi_settings *v, dl_callback *f, short kind, const void *arg, short size)
+{
+	struct dl_op *op = v->dl->last;
+	void *a;
+
+	/* a new setting replaces the previous one if nothing happened since */
+	if (op && !v->dl->broken && kind != DL_DRAW && op->kind == kind && op->f == f)
+	{
+		memcpy(op + 1, arg, size);
+		return;
+	}
+
+	a = dl_alloc(v, f, kind, size);
+	if (a)
+		memcpy(a, arg, size);
+}
+
+/*
+ * Replay functions; arg points to the recorded arguments.
+ */
+struct dl_rect
+{
+	GRECT	r;
+	short	d;
+	short	col;
+};
+
+struct dl_text
+{
+	struct xa_wtxt_inf inf;
+	GRECT	r;
+	short	state, xoff, yoff;
+	/* the text follows */
+};
+
+struct dl_texture
+{
+	XAMFDB	*texture;
+	GRECT	r, anchor;
+};
+
+static void _cdecl dl_wr_mode(struct xa_vdi_settings *v, void *a)	{ xa_wr_mode(v, *(short *)a); }
+static void _cdecl dl_l_color(struct xa_vdi_settings *v, void *a)	{ xa_l_color(v, *(short *)a); }
+static void _cdecl dl_l_type(struct xa_vdi_settings *v, void *a)	{ xa_l_type(v, *(short *)a); }
+static void _cdecl dl_l_width(struct xa_vdi_settings *v, void *a)	{ xa_l_width(v, *(short *)a); }
+static void _cdecl dl_t_color(struct xa_vdi_settings *v, void *a)	{ xa_t_color(v, *(short *)a); }
+static void _cdecl dl_t_effects(struct xa_vdi_settings *v, void *a)	{ xa_t_effects(v, *(short *)a); }
+static void _cdecl dl_f_color(struct xa_vdi_settings *v, void *a)	{ xa_f_color(v, *(short *)a); }
+static void _cdecl dl_f_interior(struct xa_vdi_settings *v, void *a)	{ xa_f_interior(v, *(short *)a); }
+static void _cdecl dl_f_style(struct xa_vdi_settings *v, void *a)	{ xa_f_style(v, *(short *)a); }
+static void _cdecl dl_f_perimeter(struct xa_vdi_settings *v, void *a)	{ xa_f_perimeter(v, *(short *)a); }
+
+static void _cdecl
+dl_l_udsty(struct xa_vdi_settings *v, void *a)
+{
+	if (v->line_udsty != *(unsigned short *)a)
+		xa_l_udsty(v, *(unsigned short *)a);
+}
+
+static void _cdecl
+dl_l_ends(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+	xa_l_ends(v, p[0], p[1]);
+}
+
+static void _cdecl
+dl_t_alignment(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+	xa_t_alignment(v, p[0], p[1]);
+}
+
+/* recorded as the resulting size and id, so vst_point() is only done when needed */
+static void _cdecl
+dl_t_font(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+
+	if (v->font_rsize != p[0] || v->font_rid != p[1])
+		xa_t_font(v, p[0], p[1]);
+}
+
+static void _cdecl
+dl_line(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+	xa_line(v, p[0], p[1], p[2], p[3], p[4]);
+}
+
+static void _cdecl
+dl_box(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+	xa_box(v, p[0], p[1], p[2], p[3], p[4]);
+}
+
+static void _cdecl
+dl_bar(struct xa_vdi_settings *v, void *a)
+{
+	short *p = a;
+	xa_bar(v, p[0], p[1], p[2], p[3], p[4]);
+}
+
+static void _cdecl dl_gbox(struct xa_vdi_settings *v, void *a)		{ struct dl_rect *p = a; xa_gbox(v, p->d, &p->r); }
+static void _cdecl dl_rgbox(struct xa_vdi_settings *v, void *a)		{ struct dl_rect *p = a; xa_rgbox(v, p->d, p->col, &p->r); }
+static void _cdecl dl_gbar(struct xa_vdi_settings *v, void *a)		{ struct dl_rect *p = a; xa_gbar(v, p->d, &p->r); }
+static void _cdecl dl_p_gbar(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_p_gbar(v, p->d, &p->r); }
+static void _cdecl dl_top_line(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_top_line(v, p->d, &p->r, p->col); }
+static void _cdecl dl_bottom_line(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_bottom_line(v, p->d, &p->r, p->col); }
+static void _cdecl dl_left_line(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_left_line(v, p->d, &p->r, p->col); }
+static void _cdecl dl_right_line(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_right_line(v, p->d, &p->r, p->col); }
+static void _cdecl dl_tl_hook(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_tl_hook(v, p->d, &p->r, p->col); }
+static void _cdecl dl_br_hook(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_br_hook(v, p->d, &p->r, p->col); }
+static void _cdecl dl_write_disable(struct xa_vdi_settings *v, void *a)	{ struct dl_rect *p = a; xa_write_disable(v, &p->r, p->col); }
+
+static void _cdecl
+dl_draw_texture(struct xa_vdi_settings *v, void *a)
+{
+	struct dl_texture *p = a;
+	GRECT r = p->r;		/* xa_draw_texture() changes it */
+
+	xa_draw_texture(v, p->texture, &r, &p->anchor);
+}
+
+static void _cdecl
+dl_wtxt_output(struct xa_vdi_settings *v, void *a)
+{
+	struct dl_text *p = a;
+	xa_wtxt_output(v, &p->inf, (char *)(p + 1), p->state, &p->r, p->xoff, p->yoff);
+}
+
+/*
+ * The recording api
+ */
+static void _cdecl rec_wr_mode(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_wr_mode, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_l_color(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_l_color, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_l_type(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_l_type, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_l_udsty(struct xa_vdi_settings *v, unsigned short m) { dl_add(v, dl_l_udsty, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_l_width(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_l_width, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_t_color(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_t_color, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_t_effects(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_t_effects, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_f_color(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_f_color, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_f_interior(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_f_interior, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_f_style(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_f_style, DL_STATE, &m, sizeof(m)); }
+static void _cdecl rec_f_perimeter(struct xa_vdi_settings *v, short m)	{ dl_add(v, dl_f_perimeter, DL_STATE, &m, sizeof(m)); }
+
+static void _cdecl
+rec_l_ends(struct xa_vdi_settings *v, short beg, short end)
+{
+	short p[2] = { beg, end };
+	dl_add(v, dl_l_ends, DL_STATE, p, sizeof(p));
+}
+
+static void _cdecl
+rec_t_alignment(struct xa_vdi_settings *v, short halign, short valign)
+{
+	short p[2] = { halign, valign };
+	dl_add(v, dl_t_alignment, DL_STATE, p, sizeof(p));
+}
+
+static void _cdecl
+rec_t_font(struct xa_vdi_settings *v, short point, short id)
+{
+	short p[2];
+
+	xa_t_font(v, point, id);
+
+	p[0] = v->font_rsize;
+	p[1] = v->font_rid;
+	dl_add(v, dl_t_font, DL_STATE, p, sizeof(p));
+}
+
+static void _cdecl
+rec_set_clip(struct xa_vdi_settings *v, const GRECT *clip)
+{
+	if (!clip)
+		clip = &v->clip;
+
+	if (clip->g_w > 0 && clip->g_h > 0)
+		v->clip = *clip;
+	else
+		v->clip = v->screen;
+
+	dl_add(v, NULL, DL_CLIP, &v->clip, sizeof(GRECT));
+}
+
+static void _cdecl
+rec_restore_clip(struct xa_vdi_settings *v, const GRECT *s)
+{
+	v->clip = *s;
+	dl_add(v, NULL, DL_CLIP, &v->clip, sizeof(GRECT));
+}
+
+static void _cdecl
+rec_clear_clip(struct xa_vdi_settings *v)
+{
+	dl_add(v, NULL, DL_CLIP, &v->screen, sizeof(GRECT));
+}
+
+static void _cdecl
+rec_line(struct xa_vdi_settings *v, short x, short y, short x1, short y1, short col)
+{
+	short p[5] = { x, y, x1, y1, col };
+	dl_add(v, dl_line, DL_DRAW, p, sizeof(p));
+}
+
+static void _cdecl
+rec_box(struct xa_vdi_settings *v, short d, short x, short y, short w, short h)
+{
+	short p[5] = { d, x, y, w, h };
+	dl_add(v, dl_box, DL_DRAW, p, sizeof(p));
+}
+
+static void _cdecl
+rec_bar(struct xa_vdi_settings *v, short d, short x, short y, short w, short h)
+{
+	short p[5] = { d, x, y, w, h };
+	dl_add(v, dl_bar, DL_DRAW, p, sizeof(p));
+}
+
+static void
+rec_rect(struct xa_vdi_settings *v, dl_callback *f, short d, const GRECT *r, short col)
+{
+	struct dl_rect p;
+
+	p.r = *r;
+	p.d = d;
+	p.col = col;
+	dl_add(v, f, DL_DRAW, &p, sizeof(p));
+}
+
+static void _cdecl rec_gbox(struct xa_vdi_settings *v, short d, const GRECT *r)		{ rec_rect(v, dl_gbox, d, r, 0); }
+static void _cdecl rec_rgbox(struct xa_vdi_settings *v, short d, short rnd, const GRECT *r)	{ rec_rect(v, dl_rgbox, d, r, rnd); }
+static void _cdecl rec_gbar(struct xa_vdi_settings *v, short d, const GRECT *r)		{ rec_rect(v, dl_gbar, d, r, 0); }
+static void _cdecl rec_p_gbar(struct xa_vdi_settings *v, short d, const GRECT *r)		{ rec_rect(v, dl_p_gbar, d, r, 0); }
+static void _cdecl rec_top_line(struct xa_vdi_settings *v, short d, const GRECT *r, short col)	{ rec_rect(v, dl_top_line, d, r, col); }
+static void _cdecl rec_bottom_line(struct xa_vdi_settings *v, short d, const GRECT *r, short col) { rec_rect(v, dl_bottom_line, d, r, col); }
+static void _cdecl rec_left_line(struct xa_vdi_settings *v, short d, const GRECT *r, short col)	{ rec_rect(v, dl_left_line, d, r, col); }
+static void _cdecl rec_right_line(struct xa_vdi_settings *v, short d, const GRECT *r, short col) { rec_rect(v, dl_right_line, d, r, col); }
+static void _cdecl rec_tl_hook(struct xa_vdi_settings *v, short d, const GRECT *r, short col)	{ rec_rect(v, dl_tl_hook, d, r, col); }
+static void _cdecl rec_br_hook(struct xa_vdi_settings *v, short d, const GRECT *r, short col)	{ rec_rect(v, dl_br_hook, d, r, col); }
+static void _cdecl rec_write_disable(struct xa_vdi_settings *v, GRECT *r, short colour)	{ rec_rect(v, dl_write_disable, 0, r, colour); }
+
+static void _cdecl
+rec_draw_texture(struct xa_vdi_settings *v, XAMFDB *texture, GRECT *r, GRECT *anchor)
+{
+	struct dl_texture p;
+
+	p.texture = texture;
+	p.r = *r;
+	p.anchor = *anchor;
+	dl_add(v, dl_draw_texture, DL_DRAW, &p, sizeof(p));
+}
+
+static void _cdecl
+rec_wtxt_output(struct xa_vdi_settings *v, struct xa_wtxt_inf *wtxti, char *txt, short state, const GRECT *r, short xoff, short yoff)
+{
+	struct dl_text *p;
+	long len = strlen(txt) + 1;
+
+	/* text that doesn't fit breaks the list */
+	p = dl_alloc(v, dl_wtxt_output, DL_DRAW, sizeof(*p) + len);
+	if (!p)
+		return;
+
+	p->inf = *wtxti;
+	p->r = *r;
+	p->state = state;
+	p->xoff = xoff;
+	p->yoff = yoff;
+	memcpy(p + 1, txt, len);
+}
+
+/* these work on the screen directly and can't be deferred */
+static void _cdecl
+rec_form_save(short d, GRECT r, void **area)
+{
+	dl_rec->dl->broken = true;
+}
+
+static void _cdecl
+rec_form_restore(short d, GRECT r, void **area)
+{
+	dl_rec->dl->broken = true;
+}
+
+static void _cdecl
+rec_form_copy(const GRECT *from, const GRECT *to)
+{
+	dl_rec->dl->broken = true;
+}
+
+static bool _cdecl
+xa_dl_begin(struct xa_vdi_settings *v)
+{
+	struct xa_vdi_dlist *dl = v->dl;
+
+	if (dl_rec)
+		return false;
+
+	if (!dl)
+	{
+		dl = kmalloc(sizeof(*dl));
+		if (!dl)
+			return false;
+		v->dl = dl;
+	}
+
+	dl->api = v->api;
+	dl->broken = false;
+	dl->used = 0;
+	dl->last = NULL;
+	dl->start = *v;
+
+	v->api = &dlapi;
+	dl_rec = v;
+	return true;
+}
+
+static bool _cdecl
+xa_dl_end(struct xa_vdi_settings *v)
+{
+	struct xa_vdi_dlist *dl = v->dl;
+
+	if (dl_rec != v)
+		return false;
+
+	dl_rec = NULL;
+	v->api = dl->api;
+	v->clip = dl->start.clip;
+
+	return !dl->broken;
+}
+
+static void _cdecl
+xa_dl_replay(struct xa_vdi_settings *v)
+{
+	struct xa_vdi_dlist *dl = v->dl;
+	struct xa_vdi_settings *s;
+	struct dl_op *op;
+	GRECT pass, r;
+	bool visible = true, clipped = false;
+	long pos;
+
+	if (!dl || dl->broken || dl_rec == v)
+		return;
+
+	s = &dl->start;
+	pass = v->clip;
+
+	/* every pass starts with the attributes the list was recorded with */
+	xa_wr_mode(v, s->wr_mode);
+	xa_l_color(v, s->line_color);
+	xa_l_type(v, s->line_style);
+	dl_l_udsty(v, &s->line_udsty);
+	xa_l_ends(v, s->line_beg, s->line_end);
+	xa_l_width(v, s->line_width);
+	xa_t_color(v, s->text_color);
+	xa_t_effects(v, s->text_effects);
+	if (v->font_rsize != s->font_rsize || v->font_rid != s->font_rid)
+		xa_t_font(v, s->font_rsize, s->font_rid);
+	xa_f_color(v, s->fill_color);
+	xa_f_interior(v, s->fill_interior);
+	xa_f_style(v, s->fill_style);
+	xa_f_perimeter(v, s->fill_perimeter);
+
+	for (pos = 0; pos < dl->used; pos += sizeof(*op) + op->size)
+	{
+		op = (struct dl_op *)((char *)dl->buf + pos);
+
+		if (op->kind == DL_CLIP)
+		{
+			visible = xa_rect_clip((GRECT *)(op + 1), &pass, &r);
+			if (visible)
+			{
+				xa_set_clip(v, &r);
+				clipped = true;
+			}
+		}
+		else if (visible || op->kind == DL_STATE)
+			(*op->f)(v, op + 1);
+	}
+
+	if (clipped)
+		xa_set_clip(v, &pass);
+}
+
+static void _cdecl
+xa_dl_call(struct xa_vdi_settings *v, dl_callback *f, const void *arg, short argsize)
+{
+	if (dl_rec == v)
+		dl_add(v, f, DL_DRAW, arg, argsize);
+	else
+		(*f)(v, (void *)arg);
+}
+
 static struct xa_vdi_api vdiapi =
 {
 	xa_wr_mode,
@@ -990,6 +1465,77 @@ static struct xa_vdi_api vdiapi =
 #if WITH_GRADIENTS
 	create_gradient,
 #endif
+	xa_dl_begin,
+	xa_dl_end,
+	xa_dl_replay,
+	xa_dl_call,
+};
+
+static struct xa_vdi_api dlapi =
+{
+	rec_wr_mode,
+	xa_load_fonts,
+	xa_unload_fonts,
+
+	rec_set_clip,
+	rec_clear_clip,
+	rec_restore_clip,
+	xa_save_clip,
+
+	rec_line,
+	rec_l_color,
+	rec_l_type,
+	rec_l_udsty,
+	rec_l_ends,
+	rec_l_width,
+
+	rec_t_color,
+	rec_t_effects,
+	rec_t_font,
+	rec_t_alignment,
+	xa_t_extent,
+	xa_text_extent,
+
+	rec_f_color,
+	rec_f_interior,
+	rec_f_style,
+	rec_f_perimeter,
+	rec_draw_texture,
+
+	rec_box,
+	rec_gbox,
+	rec_rgbox,
+	rec_bar,
+	rec_gbar,
+	rec_p_gbar,
+
+	rec_top_line,
+	rec_bottom_line,
+	rec_left_line,
+	rec_right_line,
+	rec_tl_hook,
+	rec_br_hook,
+
+	rec_write_disable,
+
+	xa_prop_clipped_name,
+	rec_wtxt_output,
+
+	rec_form_save,
+	rec_form_restore,
+	rec_form_copy,
+
+	r2pxy,
+	rtopxy,
+	ri2pxy,
+	ritopxy,
+#if WITH_GRADIENTS
+	create_gradient,
+#endif
+	xa_dl_begin,
+	xa_dl_end,
+	xa_dl_replay,
+	xa_dl_call,
 };
 
 struct xa_vdi_api *
@@ -27,6 +27,12 @@
 
 #include "xa_types.h"
 
+struct xa_vdi_settings;
+struct xa_vdi_dlist;
+
+/* deferred output function, see dl_call */
+typedef void _cdecl dl_callback(struct xa_vdi_settings *v, void *arg);
+
 struct xa_vdi_settings
 {
 	struct	xa_vdi_api *api;
@@ -61,6 +67,8 @@ struct xa_vdi_settings
 	short	max_w;
 	short	dists[6];
 	short	efx[3];
+
+	struct	xa_vdi_dlist *dl;		/* display list, allocated on first use */
 };
 
 struct xa_mfdb
@@ -162,6 +170,15 @@ struct xa_vdi_api
 #if WITH_GRADIENTS
 	void _cdecl (*create_gradient)	(struct xa_mfdb *pm, struct rgb_1000 *c, short method, short n_steps, short *steps, short w, short h );
 #endif
+	/*
+	 * Display lists: between dl_begin() and dl_end() output is recorded
+	 * instead of drawn; dl_replay() draws it within the current clip.
+	 * dl_call() defers a function doing output on its own.
+	 */
+	bool _cdecl (*dl_begin)		(struct xa_vdi_settings *v);
+	bool _cdecl (*dl_end)		(struct xa_vdi_settings *v);
+	void _cdecl (*dl_replay)	(struct xa_vdi_settings *v);
+	void _cdecl (*dl_call)		(struct xa_vdi_settings *v, dl_callback *f, const void *arg, short argsize);
 };
 
 struct xa_vdi_api * init_xavdi_module(void);